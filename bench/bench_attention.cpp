@@ -0,0 +1,135 @@
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "jennifer/layer/attention.hpp"
+#include "jennifer/layer/gemm_kernel.hpp"
+#include "jennifer/layer/softmax.hpp"
+
+// Multi head attention per sequence length as three operators, a matmul into the
+// full seq x seq scores of every head, softmax and a matmul with the values,
+// against the tiled AttentionKernel that never holds more than one block of scores.
+
+DEFINE_int32(iterations, 3, "timed runs per variant");
+DEFINE_int32(min_seq, 128, "shortest sequence length");
+DEFINE_int32(max_seq, 4096, "longest sequence length, doubled from min_seq");
+DEFINE_int32(heads, 8, "attention heads");
+DEFINE_int32(head_dim, 64, "dims of every head");
+DEFINE_bool(causal, false, "mask the keys after every query");
+DEFINE_int32(threads, 0, "threads of the kernels, 0 for every hardware thread");
+
+using namespace jennifer;
+
+template <typename F>
+static double TimeMs(int iterations, const F &f)
+{
+    f();
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+    {
+        f();
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+}
+
+static layer::AttentionView<const float> RowMajor(const float *data, int64_t len, int64_t dim)
+{
+    layer::AttentionView<const float> view;
+    view.data = data;
+    view.head_stride = len * dim;
+    view.row_stride = dim;
+    view.col_stride = 1;
+    return view;
+}
+
+int main(int argc, char *argv[])
+{
+    gflags::ParseCommandLineFlags(&argc, &argv, true);
+    google::InitGoogleLogging(argv[0]);
+
+    const int64_t heads = FLAGS_heads;
+    const int64_t dim = FLAGS_head_dim;
+    fprintf(stdout, "%6s %12s %12s %8s %14s %10s\n", "seq", "unfused ms", "fused ms", "speedup", "scores MB", "max diff");
+    for (int64_t seq = FLAGS_min_seq; seq <= FLAGS_max_seq; seq *= 2)
+    {
+        std::vector<float> q(heads * seq * dim);
+        std::vector<float> k(q.size());
+        std::vector<float> v(q.size());
+        for (size_t i = 0; i < q.size(); ++i)
+        {
+            q[i] = std::sin(static_cast<float>(i) * 0.13f);
+            k[i] = std::cos(static_cast<float>(i) * 0.07f);
+            v[i] = std::sin(static_cast<float>(i) * 0.29f + 1.f);
+        }
+        const float scale = 1.f / std::sqrt(static_cast<float>(dim));
+
+        // the unfused path transposes k once, as torch.transpose would
+        std::vector<float> key_t(k.size());
+        std::vector<float> query(q.size());
+        std::vector<float> scores(heads * seq * seq);
+        std::vector<float> reference(q.size());
+        const double unfused_ms = TimeMs(FLAGS_iterations, [&]() {
+            for (int64_t h = 0; h < heads; ++h)
+            {
+                for (int64_t j = 0; j < seq; ++j)
+                {
+                    for (int64_t c = 0; c < dim; ++c)
+                    {
+                        key_t[(h * dim + c) * seq + j] = k[(h * seq + j) * dim + c];
+                        query[(h * seq + j) * dim + c] = q[(h * seq + j) * dim + c] * scale;
+                    }
+                }
+                float *s = scores.data() + h * seq * seq;
+                layer::GemmTiled<4, 8>(seq, seq, dim, query.data() + h * seq * dim, key_t.data() + h * dim * seq,
+                                       nullptr, s);
+                if (FLAGS_causal)
+                {
+                    for (int64_t i = 0; i < seq; ++i)
+                    {
+                        std::fill(s + i * seq + i + 1, s + (i + 1) * seq, -INFINITY);
+                    }
+                }
+            }
+            layer::SoftmaxKernel(scores.data(), scores.data(), heads * seq, seq, 1, FLAGS_threads);
+            for (int64_t h = 0; h < heads; ++h)
+            {
+                layer::GemmTiled<4, 8>(seq, dim, seq, scores.data() + h * seq * seq, v.data() + h * seq * dim,
+                                       nullptr, reference.data() + h * seq * dim);
+            }
+        });
+
+        layer::AttentionShape shape;
+        shape.heads = heads;
+        shape.kv_heads = heads;
+        shape.q_len = seq;
+        shape.kv_len = seq;
+        shape.head_dim = dim;
+        shape.value_dim = dim;
+        shape.scale = scale;
+        shape.causal = FLAGS_causal;
+        std::vector<float> output(q.size());
+        layer::AttentionView<float> output_view;
+        output_view.data = output.data();
+        output_view.head_stride = seq * dim;
+        output_view.row_stride = dim;
+        output_view.col_stride = 1;
+        const double fused_ms = TimeMs(FLAGS_iterations, [&]() {
+            layer::AttentionKernel(shape, RowMajor(q.data(), seq, dim), RowMajor(k.data(), seq, dim),
+                                   RowMajor(v.data(), seq, dim), layer::AttentionView<const float>(), output_view,
+                                   FLAGS_threads);
+        });
+
+        float max_diff = 0.f;
+        for (size_t i = 0; i < output.size(); ++i)
+        {
+            max_diff = std::max(max_diff, std::fabs(output[i] - reference[i]));
+        }
+        fprintf(stdout, "%6ld %12.3f %12.3f %7.2fx %14.1f %10.2e\n", static_cast<long>(seq), unfused_ms, fused_ms,
+                unfused_ms / fused_ms, scores.size() * sizeof(float) / (1024.0 * 1024.0), max_diff);
+    }
+    return 0;
+}
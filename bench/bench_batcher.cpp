@@ -0,0 +1,164 @@
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "jennifer/runtime/batcher.hpp"
+
+// Load generator for DynamicBatcher: open-loop clients issue single-sample requests
+// with exponential inter-arrival times against a synthetic model whose cost is a
+// fixed per-launch overhead plus a per-sample part, reporting throughput and latency.
+
+DEFINE_int32(clients, 8, "number of submitting threads");
+DEFINE_int32(requests, 2000, "requests per client");
+DEFINE_double(qps, 4000.0, "target aggregate request rate, 0 for closed loop");
+DEFINE_int32(max_batch_size, 16, "batcher max batch size");
+DEFINE_int32(max_delay_us, 2000, "batcher flush deadline in microseconds");
+DEFINE_int32(launch_us, 800, "synthetic model fixed cost per batch in microseconds");
+DEFINE_int32(sample_us, 50, "synthetic model cost per sample in microseconds");
+DEFINE_int32(channels, 3, "input channels");
+DEFINE_int32(height, 64, "input height");
+DEFINE_int32(width, 64, "input width");
+
+using namespace jennifer::data;
+using namespace jennifer::runtime;
+using jennifer::utils::StatusCode;
+
+static void BusyWait(std::chrono::microseconds duration)
+{
+    const auto end = std::chrono::steady_clock::now() + duration;
+    while (std::chrono::steady_clock::now() < end)
+    {
+    }
+}
+
+static StatusCode SyntheticModel(const std::shared_ptr<Operand<float>> &inputs, std::shared_ptr<Operand<float>> &outputs)
+{
+    const uint32_t batch_size = inputs->data.size();
+    BusyWait(std::chrono::microseconds(FLAGS_launch_us + FLAGS_sample_us * batch_size));
+
+    outputs = std::make_shared<Operand<float>>("output", std::vector<int32_t>{static_cast<int32_t>(batch_size), 10},
+                                               batch_size, AttributeType::Float32);
+    for (uint32_t i = 0; i < batch_size; ++i)
+    {
+        auto logits = std::make_shared<Tensor<float>>(10);
+        logits->Fill(inputs->data[i]->index(0));
+        outputs->data[i] = logits;
+    }
+    return StatusCode::Success;
+}
+
+static double Percentile(const std::vector<double> &sorted, double p)
+{
+    if (sorted.empty())
+    {
+        return 0.0;
+    }
+    size_t index = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+int main(int argc, char *argv[])
+{
+    gflags::ParseCommandLineFlags(&argc, &argv, true);
+    google::InitGoogleLogging(argv[0]);
+
+    BatcherOptions options;
+    options.max_batch_size = FLAGS_max_batch_size;
+    options.max_delay = std::chrono::microseconds(FLAGS_max_delay_us);
+    options.max_queue_size = std::max<uint32_t>(options.max_batch_size, FLAGS_clients * FLAGS_requests);
+    DynamicBatcher batcher(SyntheticModel, options);
+
+    std::vector<std::vector<double>> latencies(FLAGS_clients);
+    std::vector<std::thread> clients;
+
+    const double client_qps = FLAGS_qps / FLAGS_clients;
+    const auto start = std::chrono::steady_clock::now();
+    for (int c = 0; c < FLAGS_clients; ++c)
+    {
+        clients.emplace_back([&, c] {
+            std::mt19937 rng(c);
+            std::exponential_distribution<double> interval(client_qps > 0 ? client_qps : 1.0);
+
+            std::vector<std::chrono::steady_clock::time_point> submit_times(FLAGS_requests);
+            std::vector<std::future<std::shared_ptr<Tensor<float>>>> futures(FLAGS_requests);
+            std::atomic<int> submitted(0);
+            std::atomic<int> completed(0);
+
+            // the batcher completes same-shape requests in FIFO order, so waiting on the
+            // futures in submission order observes each completion as it happens
+            latencies[c].resize(FLAGS_requests);
+            std::thread waiter([&] {
+                for (int i = 0; i < FLAGS_requests; ++i)
+                {
+                    while (submitted.load(std::memory_order_acquire) <= i)
+                    {
+                        std::this_thread::yield();
+                    }
+                    futures[i].get();
+                    latencies[c][i] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - submit_times[i]).count();
+                    completed.store(i + 1, std::memory_order_release);
+                }
+            });
+
+            auto next = std::chrono::steady_clock::now();
+            for (int i = 0; i < FLAGS_requests; ++i)
+            {
+                auto input = std::make_shared<Tensor<float>>(FLAGS_channels, FLAGS_height, FLAGS_width);
+                input->Fill(static_cast<float>(i));
+
+                if (client_qps > 0)
+                {
+                    next += std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(interval(rng)));
+                    std::this_thread::sleep_until(next);
+                }
+
+                submit_times[i] = std::chrono::steady_clock::now();
+                futures[i] = batcher.Submit(input);
+                submitted.store(i + 1, std::memory_order_release);
+
+                if (client_qps <= 0)
+                {
+                    // closed loop: wait for each response before the next request
+                    while (completed.load(std::memory_order_acquire) <= i)
+                    {
+                        std::this_thread::yield();
+                    }
+                }
+            }
+
+            waiter.join();
+        });
+    }
+
+    for (std::thread &client : clients)
+    {
+        client.join();
+    }
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<double> all;
+    for (const auto &l : latencies)
+    {
+        all.insert(all.end(), l.begin(), l.end());
+    }
+    std::sort(all.begin(), all.end());
+
+    const BatcherStats stats = batcher.stats();
+    fprintf(stdout, "requests      %lu\n", static_cast<unsigned long>(all.size()));
+    fprintf(stdout, "batches       %lu (full %lu, deadline %lu)\n", static_cast<unsigned long>(stats.batches),
+            static_cast<unsigned long>(stats.full_flushes), static_cast<unsigned long>(stats.deadline_flushes));
+    fprintf(stdout, "mean batch    %.2f\n", stats.mean_batch_size());
+    fprintf(stdout, "throughput    %.1f req/s\n", all.size() / elapsed);
+    fprintf(stdout, "latency p50   %.3f ms\n", Percentile(all, 0.50));
+    fprintf(stdout, "latency p99   %.3f ms\n", Percentile(all, 0.99));
+    fprintf(stdout, "latency max   %.3f ms\n", all.empty() ? 0.0 : all.back());
+
+    return 0;
+}
@@ -0,0 +1,123 @@
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "jennifer/layer/conv2d_kernel.hpp"
+#include "jennifer/layer/gemm_kernel.hpp"
+
+// Shape specialized conv and gemm kernels against the generic kernels on the fixed
+// configurations they are instantiated for. Both run the same tiling, the gain is
+// what the compile time kernel size, stride and reduction length buy.
+
+DEFINE_int32(iterations, 5, "timed runs per kernel");
+
+using namespace jennifer::layer;
+
+static std::vector<float> RandomValues(size_t count)
+{
+    std::mt19937 rng(static_cast<uint32_t>(count));
+    std::uniform_real_distribution<float> uniform(-1.f, 1.f);
+    std::vector<float> values(count);
+    for (float &v : values)
+    {
+        v = uniform(rng);
+    }
+    return values;
+}
+
+template <typename F>
+static double TimeMs(int iterations, const F &f)
+{
+    f();
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+    {
+        f();
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+}
+
+static double MaxDifference(const std::vector<float> &a, const std::vector<float> &b)
+{
+    double diff = 0.0;
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+        diff = std::max(diff, static_cast<double>(std::fabs(a[i] - b[i])));
+    }
+    return diff;
+}
+
+static void BenchConv2d(const char *name, int channels, int size, int out_channels, int kernel, int stride,
+                        Conv2dKernel fixed)
+{
+    Conv2dShape shape;
+    shape.in_channels = channels;
+    shape.in_h = shape.in_w = size;
+    shape.out_channels = out_channels;
+    shape.kernel_h = shape.kernel_w = kernel;
+    shape.stride_h = shape.stride_w = stride;
+    shape.pad_h = shape.pad_w = kernel / 2;
+    shape.out_h = shape.out_w = (size + 2 * shape.pad_h - kernel) / stride + 1;
+
+    const std::vector<float> weight = RandomValues(static_cast<size_t>(out_channels) * channels * kernel * kernel);
+    const std::vector<float> bias = RandomValues(out_channels);
+    const std::vector<float> input = RandomValues(static_cast<size_t>(channels) * size * size);
+    std::vector<float> generic_output(static_cast<size_t>(out_channels) * shape.out_h * shape.out_w);
+    std::vector<float> fixed_output(generic_output.size());
+    std::vector<float> padded;
+
+    const double generic_ms = TimeMs(FLAGS_iterations, [&]() {
+        Conv2dDirect<0, 0, 0, 0>(shape, weight.data(), bias.data(), input.data(), generic_output.data(), padded);
+    });
+    const double fixed_ms = TimeMs(FLAGS_iterations, [&]() {
+        fixed(shape, weight.data(), bias.data(), input.data(), fixed_output.data(), padded);
+    });
+    CHECK_LT(MaxDifference(generic_output, fixed_output), 1e-3) << name << " results differ";
+
+    const double gflop = 2.0 * out_channels * shape.out_h * shape.out_w * channels * kernel * kernel * 1e-9;
+    fprintf(stdout, "%-26s generic %8.3f ms %6.2f GFLOP/s  fixed %8.3f ms %6.2f GFLOP/s  %.2fx\n", name, generic_ms,
+            gflop / generic_ms * 1e3, fixed_ms, gflop / fixed_ms * 1e3, generic_ms / fixed_ms);
+}
+
+static void BenchGemm(const char *name, int m, int n, int k, GemmKernel fixed)
+{
+    const std::vector<float> a = RandomValues(static_cast<size_t>(m) * k);
+    const std::vector<float> b = RandomValues(static_cast<size_t>(k) * n);
+    const std::vector<float> bias = RandomValues(m);
+    std::vector<float> generic_output(static_cast<size_t>(m) * n);
+    std::vector<float> fixed_output(generic_output.size());
+
+    const double generic_ms = TimeMs(FLAGS_iterations, [&]() {
+        GemmGeneric(m, n, k, a.data(), b.data(), bias.data(), generic_output.data());
+    });
+    const double fixed_ms = TimeMs(FLAGS_iterations, [&]() {
+        fixed(m, n, k, a.data(), b.data(), bias.data(), fixed_output.data());
+    });
+    CHECK_LT(MaxDifference(generic_output, fixed_output), 1e-2) << name << " results differ";
+
+    const double gflop = 2.0 * m * n * k * 1e-9;
+    fprintf(stdout, "%-26s generic %8.3f ms %6.2f GFLOP/s  fixed %8.3f ms %6.2f GFLOP/s  %.2fx\n", name, generic_ms,
+            gflop / generic_ms * 1e3, fixed_ms, gflop / fixed_ms * 1e3, generic_ms / fixed_ms);
+}
+
+int main(int argc, char *argv[])
+{
+    gflags::ParseCommandLineFlags(&argc, &argv, true);
+    google::InitGoogleLogging(argv[0]);
+
+    BenchConv2d("conv 1x1s1 64x56x56->64", 64, 56, 64, 1, 1, Conv2dDirect<1, 1, 1, 1>);
+    BenchConv2d("conv 3x3s1 64x56x56->64", 64, 56, 64, 3, 1, Conv2dDirect<3, 3, 1, 1>);
+    BenchConv2d("conv 3x3s2 64x56x56->128", 64, 56, 128, 3, 2, Conv2dDirect<3, 3, 2, 2>);
+    BenchConv2d("conv 5x5s1 32x28x28->32", 32, 28, 32, 5, 1, Conv2dDirect<5, 5, 1, 1>);
+    BenchConv2d("conv 7x7s2 3x224x224->64", 3, 224, 64, 7, 2, Conv2dDirect<7, 7, 2, 2>);
+
+    BenchGemm("gemv 1000x1024", 1000, 1, 1024, Gemv<8>);
+    BenchGemm("gemm 4x8 768x128x768", 768, 128, 768, GemmTiled<4, 8>);
+    BenchGemm("gemm 4x8 k=768 768x128", 768, 128, 768, GemmTiled<4, 8, 768>);
+    return 0;
+}
@@ -0,0 +1,138 @@
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "jennifer/runtime/kv_cache.hpp"
+#include "jennifer/runtime/runtime_graph.hpp"
+
+// Tokens per second of an autoregressive decoder of stacked causal attention
+// layers per context length: recomputing the whole prefix for every new token
+// against one RuntimeGraph::Decode step over the keys and values in a KVCache.
+
+DEFINE_int32(iterations, 8, "generated tokens per variant");
+DEFINE_int32(min_context, 64, "shortest context length");
+DEFINE_int32(max_context, 1024, "longest context length, doubled from min_context");
+DEFINE_int32(layers, 4, "stacked attention layers");
+DEFINE_int32(heads, 8, "attention heads");
+DEFINE_int32(head_dim, 64, "dims of every head");
+
+using namespace jennifer;
+using namespace jennifer::runtime;
+
+static std::string DecoderGraph(int layers, int heads, int dim)
+{
+    const std::string shape = "(1," + std::to_string(heads) + ",?," + std::to_string(dim) + ")f32";
+    std::string text = "7767517\n" + std::to_string(layers + 4) + " " + std::to_string(layers + 3) + "\n";
+    text += "pnnx.Input q 0 1 0 #0=" + shape + "\n";
+    text += "pnnx.Input k 0 1 1 #1=" + shape + "\n";
+    text += "pnnx.Input v 0 1 2 #2=" + shape + "\n";
+    for (int l = 0; l < layers; ++l)
+    {
+        const std::string out = std::to_string(l + 3);
+        const std::string in = l == 0 ? "0 1 2" : std::to_string(l + 2) + " " + std::to_string(l + 2) + " " +
+                                                      std::to_string(l + 2);
+        text += "F.scaled_dot_product_attention attn" + std::to_string(l) + " 3 1 " + in + " " + out +
+                " dropout_p=0.0 is_causal=True #" + out + "=" + shape + "\n";
+    }
+    text += "pnnx.Output out0 1 0 " + std::to_string(layers + 2) + "\n";
+    return text;
+}
+
+// tokens [begin, end) of the (heads, max_len, dim) token values as q, k and v
+static std::vector<std::shared_ptr<Operand<float>>> Tokens(const std::vector<float> &tokens, int64_t max_len,
+                                                           int heads, int dim, int32_t begin, int32_t end)
+{
+    std::vector<std::shared_ptr<Operand<float>>> inputs;
+    for (int n = 0; n < 3; ++n)
+    {
+        auto input = std::make_shared<Operand<float>>(std::string(1, "qkv"[n]),
+                                                      std::vector<int32_t>{1, heads, end - begin, dim}, 1,
+                                                      AttributeType::Float32);
+        std::vector<float> rows;
+        for (int h = 0; h < heads; ++h)
+        {
+            const float *head = tokens.data() + (n * heads + h) * max_len * dim;
+            rows.insert(rows.end(), head + begin * dim, head + end * dim);
+        }
+        input->data[0] = std::make_shared<data::Tensor<float>>(heads, end - begin, dim);
+        input->data[0]->Fill(rows, true);
+        inputs.push_back(input);
+    }
+    return inputs;
+}
+
+int main(int argc, char *argv[])
+{
+    gflags::ParseCommandLineFlags(&argc, &argv, true);
+    google::InitGoogleLogging(argv[0]);
+
+    const int heads = FLAGS_heads;
+    const int dim = FLAGS_head_dim;
+    const int64_t max_len = FLAGS_max_context + FLAGS_iterations;
+    std::unique_ptr<pnnx::Graph> graph(new pnnx::Graph);
+    CHECK_EQ(graph->parse(DecoderGraph(FLAGS_layers, heads, dim)), 0) << "Can not parse the decoder graph";
+    RuntimeGraph runtime_graph;
+    CHECK(runtime_graph.Init(std::move(graph)));
+
+    std::vector<float> tokens(3 * heads * max_len * dim);
+    for (size_t i = 0; i < tokens.size(); ++i)
+    {
+        tokens[i] = std::sin(static_cast<float>(i) * 0.13f);
+    }
+
+    KVCacheConfig config;
+    config.max_pages = 2 * FLAGS_layers * ((max_len + config.page_tokens - 1) / config.page_tokens);
+    KVCache cache(config);
+
+    fprintf(stdout, "%8s %14s %14s %8s %10s\n", "context", "recompute t/s", "cached t/s", "speedup", "max diff");
+    for (int32_t context = FLAGS_min_context; context <= FLAGS_max_context; context *= 2)
+    {
+        // without a cache every token runs the graph over the whole prefix again
+        std::vector<std::shared_ptr<Operand<float>>> outputs;
+        std::vector<float> recomputed;
+        const auto recompute_start = std::chrono::steady_clock::now();
+        for (int32_t t = context; t < context + FLAGS_iterations; ++t)
+        {
+            CHECK(runtime_graph.Forward(Tokens(tokens, max_len, heads, dim, 0, t + 1), outputs) ==
+                  utils::StatusCode::Success);
+        }
+        const double recompute_s =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - recompute_start).count();
+        recomputed = outputs[0]->data[0]->values(true);
+
+        // the cache is filled by one prefill, then every token is a single row step
+        const std::vector<int64_t> sequences = {cache.AddSequence()};
+        CHECK(runtime_graph.Decode(Tokens(tokens, max_len, heads, dim, 0, context), sequences, cache, outputs) ==
+              utils::StatusCode::Success);
+        const auto cached_start = std::chrono::steady_clock::now();
+        for (int32_t t = context; t < context + FLAGS_iterations; ++t)
+        {
+            CHECK(runtime_graph.Decode(Tokens(tokens, max_len, heads, dim, t, t + 1), sequences, cache, outputs) ==
+                  utils::StatusCode::Success);
+        }
+        const double cached_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - cached_start).count();
+        cache.RemoveSequence(sequences[0]);
+
+        // the last generated token of both variants
+        const std::vector<float> cached = outputs[0]->data[0]->values(true);
+        const int64_t last = context + FLAGS_iterations - 1;
+        float max_diff = 0.f;
+        for (int h = 0; h < heads; ++h)
+        {
+            for (int c = 0; c < dim; ++c)
+            {
+                const float expect = recomputed[(h * (last + 1) + last) * dim + c];
+                max_diff = std::max(max_diff, std::fabs(cached[h * dim + c] - expect));
+            }
+        }
+        fprintf(stdout, "%8d %14.1f %14.1f %7.2fx %10.2e\n", context, FLAGS_iterations / recompute_s,
+                FLAGS_iterations / cached_s, recompute_s / cached_s, max_diff);
+    }
+    return 0;
+}
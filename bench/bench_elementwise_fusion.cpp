@@ -0,0 +1,109 @@
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "jennifer/layer/elementwise.hpp"
+
+// Chains of cheap pointwise ops run one op per pass over memory, as separate
+// operators do, against the fused program that runs the whole chain per tile.
+// The unfused chain reads and writes the activation once per op, so on tensors
+// larger than the cache the fused run should gain about the chain length.
+
+DEFINE_int32(iterations, 10, "timed runs per chain");
+DEFINE_int32(channels, 64, "channels of the activation");
+DEFINE_int32(size, 224, "height and width of the activation");
+
+using namespace jennifer::layer;
+
+template <typename F>
+static double TimeMs(int iterations, const F &f)
+{
+    f();
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+    {
+        f();
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+}
+
+static ElementwiseOperand Contiguous(const float *data, const int64_t dims[3])
+{
+    ElementwiseOperand operand;
+    operand.data = data;
+    operand.strides[0] = dims[1] * dims[2];
+    operand.strides[1] = dims[2];
+    operand.strides[2] = 1;
+    return operand;
+}
+
+static void BenchChain(int length)
+{
+    static const char *kOps[] = {"add(@0,0.5)", "mul(@0,1.5)", "max(@0,0)", "sub(@0,0.25)"};
+
+    const int64_t dims[3] = {FLAGS_channels, FLAGS_size, FLAGS_size};
+    const size_t count = static_cast<size_t>(dims[0] * dims[1] * dims[2]);
+    std::vector<float> input(count);
+    std::mt19937 rng(static_cast<uint32_t>(count));
+    std::uniform_real_distribution<float> uniform(-1.f, 1.f);
+    for (float &v : input)
+    {
+        v = uniform(rng);
+    }
+
+    // one program and one activation per op, the fused expr nests them all
+    std::vector<ElementwiseProgram> ops(length);
+    std::vector<std::vector<float>> activations(length, std::vector<float>(count));
+    std::string expr = "@0";
+    for (int i = 0; i < length; ++i)
+    {
+        const std::string op = kOps[i % 4];
+        CHECK(ops[i].Compile(op));
+        expr = op.substr(0, op.find('(') + 1) + expr + op.substr(op.find(','));
+    }
+    ElementwiseProgram fused;
+    CHECK(fused.Compile(expr)) << expr;
+    std::vector<float> fused_output(count);
+    std::vector<float> scratch;
+
+    const double unfused_ms = TimeMs(FLAGS_iterations, [&]() {
+        const float *x = input.data();
+        for (int i = 0; i < length; ++i)
+        {
+            ops[i].Run({Contiguous(x, dims)}, dims, activations[i].data(), scratch);
+            x = activations[i].data();
+        }
+    });
+    const double fused_ms = TimeMs(FLAGS_iterations, [&]() {
+        fused.Run({Contiguous(input.data(), dims)}, dims, fused_output.data(), scratch);
+    });
+
+    double diff = 0.0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        diff = std::max(diff, static_cast<double>(std::fabs(fused_output[i] - activations.back()[i])));
+    }
+    CHECK_LT(diff, 1e-5) << "chain of " << length << " results differ";
+
+    const double megabytes = 2.0 * count * sizeof(float) / (1024.0 * 1024.0);
+    fprintf(stdout, "chain %d  unfused %8.3f ms  fused %8.3f ms  %6.0f MB/s  %.2fx\n", length, unfused_ms, fused_ms,
+            megabytes / fused_ms * 1e3, unfused_ms / fused_ms);
+}
+
+int main(int argc, char *argv[])
+{
+    gflags::ParseCommandLineFlags(&argc, &argv, true);
+    google::InitGoogleLogging(argv[0]);
+
+    for (int length : {1, 2, 4, 8})
+    {
+        BenchChain(length);
+    }
+    return 0;
+}
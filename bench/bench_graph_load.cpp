@@ -0,0 +1,106 @@
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "jennifer/runtime/binary_graph.hpp"
+
+// Graph load time of the text .param format against the binary graph format: text
+// parsing into pnnx::Graph, binary mapping alone and binary mapping plus conversion
+// into pnnx::Graph. Attribute weights are not loaded, they are the same zip for both.
+
+DEFINE_string(param, "", "pnnx .param to load, a synthetic graph when empty");
+DEFINE_int32(ops, 4000, "operators of the synthetic graph");
+DEFINE_int32(iterations, 20, "timed loads per format");
+DEFINE_string(binary, "/tmp/bench_graph_load.jbg", "where the converted binary graph is written");
+
+using jennifer::runtime::BinaryGraph;
+
+// conv, batchnorm and activation blocks with parameters and attribute shapes like a
+// real export
+static std::string SyntheticParam(int ops)
+{
+    const int blocks = ops / 3;
+    std::ostringstream param;
+    param << "7767517\n" << blocks * 3 + 2 << " " << blocks * 3 + 1 << "\n";
+    param << "pnnx.Input input 0 1 0 #0=(1,64,56,56)f32\n";
+    int operand = 0;
+    for (int b = 0; b < blocks; ++b)
+    {
+        param << "nn.Conv2d conv_" << b << " 1 1 " << operand << " " << operand + 1
+              << " bias=True dilation=(1,1) groups=1 in_channels=64 kernel_size=(3,3) out_channels=64 padding=(1,1) "
+                 "padding_mode=zeros stride=(1,1) @bias=(64)f32 @weight=(64,64,3,3)f32 #"
+              << operand << "=(1,64,56,56)f32 #" << operand + 1 << "=(1,64,56,56)f32\n";
+        param << "nn.BatchNorm2d bn_" << b << " 1 1 " << operand + 1 << " " << operand + 2
+              << " affine=True eps=1.000000e-05 num_features=64 @running_mean=(64)f32 @running_var=(64)f32 "
+                 "@bias=(64)f32 @weight=(64)f32 #"
+              << operand + 1 << "=(1,64,56,56)f32 #" << operand + 2 << "=(1,64,56,56)f32\n";
+        param << "nn.ReLU relu_" << b << " 1 1 " << operand + 2 << " " << operand + 3 << " #" << operand + 2
+              << "=(1,64,56,56)f32 #" << operand + 3 << "=(1,64,56,56)f32\n";
+        operand += 3;
+    }
+    param << "pnnx.Output output 1 0 " << operand << " #" << operand << "=(1,64,56,56)f32\n";
+    return param.str();
+}
+
+template <typename F>
+static double TimeMs(int iterations, const F &f)
+{
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+    {
+        f();
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+}
+
+int main(int argc, char *argv[])
+{
+    gflags::ParseCommandLineFlags(&argc, &argv, true);
+    google::InitGoogleLogging(argv[0]);
+
+    std::string text;
+    if (FLAGS_param.empty())
+    {
+        text = SyntheticParam(FLAGS_ops);
+    }
+    else
+    {
+        std::ifstream file(FLAGS_param, std::ios::in | std::ios::binary);
+        CHECK(file.good()) << "Can not open " << FLAGS_param;
+        std::stringstream ss;
+        ss << file.rdbuf();
+        text = ss.str();
+    }
+
+    {
+        pnnx::Graph graph;
+        CHECK_EQ(graph.parse(text), 0) << "Can not parse the text graph";
+        CHECK(BinaryGraph::Save(graph, FLAGS_binary)) << "Can not write " << FLAGS_binary;
+        fprintf(stdout, "operators     %d\n", static_cast<int>(graph.ops.size()));
+    }
+
+    const double text_ms = TimeMs(FLAGS_iterations, [&]() {
+        pnnx::Graph graph;
+        CHECK_EQ(graph.parse(text), 0);
+    });
+    const double map_ms = TimeMs(FLAGS_iterations, [&]() {
+        BinaryGraph binary;
+        CHECK(binary.Open(FLAGS_binary));
+    });
+    const double binary_ms = TimeMs(FLAGS_iterations, [&]() {
+        BinaryGraph binary;
+        pnnx::Graph graph;
+        CHECK(binary.Open(FLAGS_binary) && binary.ToGraph(graph));
+    });
+
+    fprintf(stdout, "text size     %lu bytes\n", static_cast<unsigned long>(text.size()));
+    fprintf(stdout, "text parse    %.3f ms\n", text_ms);
+    fprintf(stdout, "binary map    %.3f ms (%.1fx)\n", map_ms, text_ms / map_ms);
+    fprintf(stdout, "binary graph  %.3f ms (%.1fx)\n", binary_ms, text_ms / binary_ms);
+    return 0;
+}
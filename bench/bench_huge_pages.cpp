@@ -0,0 +1,103 @@
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "jennifer/layer/gemm_kernel.hpp"
+#include "jennifer/utils/huge_pages.hpp"
+
+// Linear layers whose weights span many pages, with the weight and activation
+// buffers on 4 KB heap pages against 2 MB aligned buffers in every huge page mode.
+// Reports how much of the buffers the kernel actually backed with huge pages.
+
+DEFINE_int32(iterations, 5, "timed runs per variant");
+
+using namespace jennifer;
+
+template <typename F>
+static double TimeMs(int iterations, const F &f)
+{
+    f();
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+    {
+        f();
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+}
+
+template <typename Vector>
+static double BenchLinear(int m, int n, int k)
+{
+    Vector weight(static_cast<size_t>(m) * k);
+    Vector input(static_cast<size_t>(k) * n);
+    Vector output(static_cast<size_t>(m) * n);
+    for (size_t i = 0; i < weight.size(); ++i)
+    {
+        weight[i] = std::sin(static_cast<float>(i) * 0.01f);
+    }
+    for (size_t i = 0; i < input.size(); ++i)
+    {
+        input[i] = std::cos(static_cast<float>(i) * 0.02f);
+    }
+    return TimeMs(FLAGS_iterations, [&]() {
+        if (n == 1)
+        {
+            layer::Gemv<8>(m, n, k, weight.data(), input.data(), nullptr, output.data());
+        }
+        else
+        {
+            layer::GemmTiled<4, 8>(m, n, k, weight.data(), input.data(), nullptr, output.data());
+        }
+    });
+}
+
+int main(int argc, char *argv[])
+{
+    gflags::ParseCommandLineFlags(&argc, &argv, true);
+    google::InitGoogleLogging(argv[0]);
+
+    struct Case
+    {
+        const char *name;
+        int m, n, k;
+    };
+    const Case cases[] = {
+        {"gemv 8192x4096", 8192, 1, 4096},
+        {"gemm 4096x64x4096", 4096, 64, 4096},
+    };
+    const std::pair<const char *, utils::HugePageMode> modes[] = {
+        {"transparent", utils::HugePageMode::Transparent},
+        {"explicit", utils::HugePageMode::Explicit},
+    };
+
+    fprintf(stdout, "%-20s %-12s %10s %10s %8s %10s %10s\n", "case", "mode", "4k ms", "huge ms", "speedup",
+            "mapped MB", "huge MB");
+    for (const Case &c : cases)
+    {
+        utils::SetHugePageMode(utils::HugePageMode::Off);
+        const double base_ms = BenchLinear<std::vector<float>>(c.m, c.n, c.k);
+        for (const auto &mode : modes)
+        {
+            utils::SetHugePageMode(mode.second);
+            // the usage is sampled while the buffers of a run are still mapped
+            utils::HugePageStats usage;
+            const double huge_ms = [&]() {
+                utils::HugeVector<float> probe(static_cast<size_t>(c.m) * c.k);
+                for (size_t i = 0; i < probe.size(); i += 1024)
+                {
+                    probe[i] = 1.f;
+                }
+                usage = utils::HugePageUsage();
+                return BenchLinear<utils::HugeVector<float>>(c.m, c.n, c.k);
+            }();
+            fprintf(stdout, "%-20s %-12s %10.3f %10.3f %7.2fx %10.1f %10.1f\n", c.name, mode.first, base_ms, huge_ms,
+                    base_ms / huge_ms, usage.mapped_bytes / 1048576.0, usage.huge_bytes / 1048576.0);
+        }
+    }
+    utils::SetHugePageMode(utils::HugePageMode::Off);
+    return 0;
+}
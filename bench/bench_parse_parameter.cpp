@@ -0,0 +1,102 @@
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "jennifer/runtime/pnnx/ir.h"
+
+// Parameter::parse_from_string against the stringstream based legacy parser on the
+// tokens a .param file is made of: shape lists, float lists, scalars and strings.
+
+DEFINE_int32(tokens, 100000, "parameter values per iteration");
+DEFINE_int32(iterations, 10, "timed passes over the tokens");
+
+static std::vector<std::string> SyntheticTokens(int count)
+{
+    std::mt19937 rng(0);
+    std::uniform_int_distribution<int> dim(1, 512);
+    std::normal_distribution<float> value(0.f, 1.f);
+
+    std::vector<std::string> tokens;
+    tokens.reserve(count);
+    char buffer[32];
+    for (int i = 0; i < count; ++i)
+    {
+        std::string token;
+        switch (i % 5)
+        {
+        case 0:
+            token = "(" + std::to_string(dim(rng)) + "," + std::to_string(dim(rng)) + ")";
+            break;
+        case 1:
+            token = "(";
+            for (int k = 0; k < 4; ++k)
+            {
+                snprintf(buffer, sizeof(buffer), "%e", value(rng));
+                token += (k ? "," : "") + std::string(buffer);
+            }
+            token += ")";
+            break;
+        case 2:
+            token = std::to_string(dim(rng));
+            break;
+        case 3:
+            snprintf(buffer, sizeof(buffer), "%e", value(rng));
+            token = buffer;
+            break;
+        default:
+            token = i % 2 ? "zeros" : "False";
+            break;
+        }
+        tokens.push_back(token);
+    }
+    return tokens;
+}
+
+template <typename F>
+static double TimeMs(int iterations, const F &f)
+{
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+    {
+        f();
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+}
+
+int main(int argc, char *argv[])
+{
+    gflags::ParseCommandLineFlags(&argc, &argv, true);
+    google::InitGoogleLogging(argv[0]);
+
+    const std::vector<std::string> tokens = SyntheticTokens(FLAGS_tokens);
+    for (const std::string &token : tokens)
+    {
+        CHECK(pnnx::Parameter::parse_from_string(token) == pnnx::Parameter::parse_from_string_legacy(token))
+            << "Parsers disagree on " << token;
+    }
+
+    size_t checksum = 0;
+    const double legacy_ms = TimeMs(FLAGS_iterations, [&]() {
+        for (const std::string &token : tokens)
+        {
+            checksum += pnnx::Parameter::parse_from_string_legacy(token).type;
+        }
+    });
+    const double fast_ms = TimeMs(FLAGS_iterations, [&]() {
+        for (const std::string &token : tokens)
+        {
+            checksum += pnnx::Parameter::parse_from_string(token).type;
+        }
+    });
+
+    fprintf(stdout, "tokens        %d (checksum %lu)\n", FLAGS_tokens, static_cast<unsigned long>(checksum));
+    fprintf(stdout, "legacy        %.3f ms, %.1f ns/token\n", legacy_ms, legacy_ms * 1e6 / FLAGS_tokens);
+    fprintf(stdout, "from_chars    %.3f ms, %.1f ns/token (%.1fx)\n", fast_ms, fast_ms * 1e6 / FLAGS_tokens,
+            legacy_ms / fast_ms);
+    return 0;
+}
@@ -0,0 +1,127 @@
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <future>
+#include <string>
+#include <vector>
+
+#include "jennifer/runtime/pipeline.hpp"
+#include "jennifer/runtime/runtime_graph.hpp"
+#include "jennifer/utils/parallel.hpp"
+
+// Frames per second of a stream through a stack of nn.Linear layers, one frame at
+// a time with every thread on each layer against a pipeline of stages that keeps
+// several frames in flight. The pipeline pays off where layers scale poorly over
+// many threads; with a single hardware thread it only adds the stage hops.
+
+DEFINE_int32(frames, 64, "frames in the stream");
+DEFINE_int32(layers, 8, "stacked linear layers");
+DEFINE_int32(features, 1024, "in and out features of every layer");
+DEFINE_int32(tokens, 4, "rows of every frame");
+DEFINE_int32(queue_depth, 2, "frames waiting in front of every stage");
+
+using namespace jennifer;
+using namespace jennifer::runtime;
+
+static std::unique_ptr<RuntimeGraph> LoadMlp(int layers, int features)
+{
+    const std::string f = std::to_string(features);
+    const std::string shape = "(1,?," + f + ")f32";
+    std::string text = "7767517\n" + std::to_string(layers + 2) + " " + std::to_string(layers + 1) + "\n";
+    text += "pnnx.Input in0 0 1 0 #0=" + shape + "\n";
+    for (int l = 0; l < layers; ++l)
+    {
+        text += "nn.Linear fc" + std::to_string(l) + " 1 1 " + std::to_string(l) + " " + std::to_string(l + 1) +
+                " bias=True in_features=" + f + " out_features=" + f + " @bias=(" + f + ")f32 @weight=(" + f + "," +
+                f + ")f32 #" + std::to_string(l + 1) + "=" + shape + "\n";
+    }
+    text += "pnnx.Output out0 1 0 " + std::to_string(layers) + "\n";
+
+    std::unique_ptr<pnnx::Graph> graph(new pnnx::Graph);
+    CHECK_EQ(graph->parse(text), 0) << "Can not parse the mlp graph";
+    std::vector<float> weight(static_cast<size_t>(features) * features);
+    for (size_t i = 0; i < weight.size(); ++i)
+    {
+        weight[i] = std::sin(static_cast<float>(i) * 0.11f) / features;
+    }
+    for (int l = 0; l < layers; ++l)
+    {
+        graph->ops[l + 1]->attrs["weight"].set_float32_data(weight);
+        graph->ops[l + 1]->attrs["bias"].set_float32_data(std::vector<float>(features, 0.01f));
+    }
+    std::unique_ptr<RuntimeGraph> runtime_graph(new RuntimeGraph);
+    return runtime_graph->Init(std::move(graph)) ? std::move(runtime_graph) : nullptr;
+}
+
+static std::shared_ptr<Operand<float>> MakeFrame(int index)
+{
+    auto input = std::make_shared<Operand<float>>("in0", std::vector<int32_t>{1, FLAGS_tokens, FLAGS_features}, 1,
+                                                  AttributeType::Float32);
+    input->data[0] = std::make_shared<data::Tensor<float>>(1, FLAGS_tokens, FLAGS_features);
+    input->data[0]->Fill(static_cast<float>(index) * 0.01f);
+    return input;
+}
+
+int main(int argc, char *argv[])
+{
+    gflags::ParseCommandLineFlags(&argc, &argv, true);
+    google::InitGoogleLogging(argv[0]);
+
+    std::unique_ptr<RuntimeGraph> graph = LoadMlp(FLAGS_layers, FLAGS_features);
+    CHECK(graph != nullptr) << "Can not load the mlp graph";
+    std::vector<std::shared_ptr<Operand<float>>> frames;
+    for (int i = 0; i < FLAGS_frames; ++i)
+    {
+        frames.push_back(MakeFrame(i));
+    }
+
+    std::vector<std::shared_ptr<Operand<float>>> outputs;
+    CHECK(graph->Forward({frames[0]}, outputs) == utils::StatusCode::Success);
+    auto start = std::chrono::steady_clock::now();
+    for (const auto &frame : frames)
+    {
+        CHECK(graph->Forward({frame}, outputs) == utils::StatusCode::Success);
+    }
+    const double serial_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    fprintf(stdout, "hardware threads %d, %d frames of %dx%d through %d layers\n", utils::ResolveThreads(0),
+            FLAGS_frames, FLAGS_tokens, FLAGS_features, FLAGS_layers);
+    fprintf(stdout, "%-10s %10s %10s %8s %s\n", "mode", "fps", "slowest ms", "speedup", "stage ms");
+    fprintf(stdout, "%-10s %10.1f %10s %8s\n", "serial", FLAGS_frames / serial_s, "-", "-");
+    for (uint32_t stages : {2u, 4u})
+    {
+        PipelineOptions options;
+        options.stages = stages;
+        options.queue_depth = FLAGS_queue_depth;
+        Pipeline pipeline(*graph, options);
+        CHECK(pipeline.Init({frames[0]}) == utils::StatusCode::Success);
+
+        std::vector<std::future<AsyncResult>> futures;
+        futures.reserve(frames.size());
+        start = std::chrono::steady_clock::now();
+        for (const auto &frame : frames)
+        {
+            futures.push_back(pipeline.Submit({frame}));
+        }
+        for (auto &future : futures)
+        {
+            CHECK(future.get().status == utils::StatusCode::Success);
+        }
+        const double pipeline_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        double slowest = 0.0;
+        std::string costs;
+        for (double cost : pipeline.stage_costs())
+        {
+            slowest = std::max(slowest, cost);
+            costs += " " + std::to_string(cost).substr(0, 5);
+        }
+        const std::string mode = std::to_string(stages) + " stages";
+        fprintf(stdout, "%-10s %10.1f %10.3f %7.2fx%s\n", mode.c_str(), FLAGS_frames / pipeline_s, slowest,
+                serial_s / pipeline_s, costs.c_str());
+    }
+    return 0;
+}
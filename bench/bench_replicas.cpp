@@ -0,0 +1,131 @@
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "jennifer/runtime/numa.hpp"
+#include "jennifer/runtime/replica_set.hpp"
+#include "jennifer/runtime/runtime_graph.hpp"
+
+// Requests per second of an MLP of stacked nn.Linear layers served to concurrent
+// clients by one RuntimeGraph loaded on the main thread, against a ReplicaSet with
+// a graph per NUMA node or a single graph interleaved over the nodes. On a single
+// node machine the replica set only adds the executor hop.
+
+DEFINE_int32(clients, 8, "threads submitting requests");
+DEFINE_int32(requests, 32, "requests per client");
+DEFINE_int32(layers, 6, "stacked linear layers");
+DEFINE_int32(features, 1024, "in and out features of every layer");
+DEFINE_int32(tokens, 16, "rows of every request");
+
+using namespace jennifer;
+using namespace jennifer::runtime;
+
+static std::unique_ptr<RuntimeGraph> LoadMlp(int layers, int features)
+{
+    const std::string f = std::to_string(features);
+    const std::string shape = "(1,?," + f + ")f32";
+    std::string text = "7767517\n" + std::to_string(layers + 2) + " " + std::to_string(layers + 1) + "\n";
+    text += "pnnx.Input in0 0 1 0 #0=" + shape + "\n";
+    for (int l = 0; l < layers; ++l)
+    {
+        text += "nn.Linear fc" + std::to_string(l) + " 1 1 " + std::to_string(l) + " " + std::to_string(l + 1) +
+                " bias=True in_features=" + f + " out_features=" + f + " @bias=(" + f + ")f32 @weight=(" + f + "," +
+                f + ")f32 #" + std::to_string(l + 1) + "=" + shape + "\n";
+    }
+    text += "pnnx.Output out0 1 0 " + std::to_string(layers) + "\n";
+
+    std::unique_ptr<pnnx::Graph> graph(new pnnx::Graph);
+    CHECK_EQ(graph->parse(text), 0) << "Can not parse the mlp graph";
+    std::vector<float> weight(static_cast<size_t>(features) * features);
+    for (size_t i = 0; i < weight.size(); ++i)
+    {
+        weight[i] = std::sin(static_cast<float>(i) * 0.11f) / features;
+    }
+    for (int l = 0; l < layers; ++l)
+    {
+        graph->ops[l + 1]->attrs["weight"].set_float32_data(weight);
+        graph->ops[l + 1]->attrs["bias"].set_float32_data(std::vector<float>(features, 0.01f));
+    }
+    std::unique_ptr<RuntimeGraph> runtime_graph(new RuntimeGraph);
+    return runtime_graph->Init(std::move(graph)) ? std::move(runtime_graph) : nullptr;
+}
+
+template <typename F>
+static double RequestsPerSecond(const F &forward)
+{
+    std::atomic<int> failures{0};
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> clients;
+    for (int c = 0; c < FLAGS_clients; ++c)
+    {
+        clients.emplace_back([&forward, &failures, c]() {
+            auto input = std::make_shared<Operand<float>>("in0", std::vector<int32_t>{1, FLAGS_tokens, FLAGS_features},
+                                                          1, AttributeType::Float32);
+            input->data[0] = std::make_shared<data::Tensor<float>>(1, FLAGS_tokens, FLAGS_features);
+            input->data[0]->Fill(static_cast<float>(c) * 0.01f);
+            for (int r = 0; r < FLAGS_requests; ++r)
+            {
+                std::vector<std::shared_ptr<Operand<float>>> outputs;
+                if (forward({input}, outputs) != utils::StatusCode::Success)
+                {
+                    failures += 1;
+                }
+            }
+        });
+    }
+    for (std::thread &client : clients)
+    {
+        client.join();
+    }
+    CHECK_EQ(failures, 0) << "Requests failed";
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return FLAGS_clients * FLAGS_requests / seconds;
+}
+
+int main(int argc, char *argv[])
+{
+    gflags::ParseCommandLineFlags(&argc, &argv, true);
+    google::InitGoogleLogging(argv[0]);
+
+    const std::vector<NumaNode> topology = DetectNumaTopology();
+    fprintf(stdout, "%zu numa nodes:", topology.size());
+    for (const NumaNode &node : topology)
+    {
+        fprintf(stdout, " node%d %zu cpus", node.id, node.cpus.size());
+    }
+    fprintf(stdout, "\n%-22s %10s %12s %8s\n", "deployment", "replicas", "requests/s", "speedup");
+
+    std::unique_ptr<RuntimeGraph> shared = LoadMlp(FLAGS_layers, FLAGS_features);
+    CHECK(shared != nullptr) << "Can not load the mlp";
+    const double base = RequestsPerSecond([&](const std::vector<std::shared_ptr<Operand<float>>> &inputs,
+                                              std::vector<std::shared_ptr<Operand<float>>> &outputs) {
+        return shared->Forward(inputs, outputs);
+    });
+    fprintf(stdout, "%-22s %10d %12.1f %7.2fx\n", "single graph", 1, base, 1.0);
+    shared.reset();
+
+    const std::pair<const char *, NumaPolicy> policies[] = {
+        {"replica per node", NumaPolicy::Replicate},
+        {"interleaved", NumaPolicy::Interleave},
+    };
+    for (const auto &policy : policies)
+    {
+        ReplicaOptions options;
+        options.policy = policy.second;
+        ReplicaSet replicas([]() { return LoadMlp(FLAGS_layers, FLAGS_features); }, options);
+        CHECK(replicas.Init()) << "Can not load the replicas";
+        const double rate = RequestsPerSecond([&](const std::vector<std::shared_ptr<Operand<float>>> &inputs,
+                                                  std::vector<std::shared_ptr<Operand<float>>> &outputs) {
+            return replicas.Forward(inputs, outputs);
+        });
+        fprintf(stdout, "%-22s %10zu %12.1f %7.2fx\n", policy.first, replicas.size(), rate, rate / base);
+    }
+    return 0;
+}
@@ -0,0 +1,79 @@
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "jennifer/data/tensor_expression.hpp"
+
+// a * b + c over tensors larger than the cache: one pass of hand written loops
+// per operator with a temporary in between, Armadillo on the underlying cubes and
+// the expression templates on one and on every hardware thread.
+
+DEFINE_int32(iterations, 20, "timed runs per variant");
+DEFINE_int32(channels, 64, "channels of the tensors");
+DEFINE_int32(size, 224, "height and width of the tensors");
+DEFINE_int32(threads, 0, "threads of the parallel run, 0 for every hardware thread");
+
+using namespace jennifer::data;
+
+template <typename F>
+static double TimeMs(int iterations, const F &f)
+{
+    f();
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+    {
+        f();
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+}
+
+int main(int argc, char *argv[])
+{
+    gflags::ParseCommandLineFlags(&argc, &argv, true);
+    google::InitGoogleLogging(argv[0]);
+
+    Tensor<float> a(FLAGS_channels, FLAGS_size, FLAGS_size);
+    Tensor<float> b(FLAGS_channels, FLAGS_size, FLAGS_size);
+    Tensor<float> c(FLAGS_channels, FLAGS_size, FLAGS_size);
+    a.RandomNormal();
+    b.RandomNormal();
+    c.RandomNormal();
+    Tensor<float> temporary(FLAGS_channels, FLAGS_size, FLAGS_size);
+    Tensor<float> reference(FLAGS_channels, FLAGS_size, FLAGS_size);
+    Tensor<float> output(FLAGS_channels, FLAGS_size, FLAGS_size);
+    const uint32_t count = a.size();
+
+    const double loops_ms = TimeMs(FLAGS_iterations, [&]() {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            temporary.index(i) = a.index(i) * b.index(i);
+        }
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            reference.index(i) = temporary.index(i) + c.index(i);
+        }
+    });
+    const double arma_ms = TimeMs(FLAGS_iterations, [&]() {
+        output.get_data() = a.get_data() % b.get_data() + c.get_data();
+    });
+    const double expression_ms = TimeMs(FLAGS_iterations, [&]() { Assign(output, a * b + c); });
+    const double parallel_ms = TimeMs(FLAGS_iterations, [&]() { Assign(output, a * b + c, FLAGS_threads); });
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        CHECK_LT(std::fabs(output.index(i) - reference.index(i)), 1e-5f) << "results differ at " << i;
+    }
+
+    const double megabytes = 4.0 * count * sizeof(float) / (1024.0 * 1024.0);
+    fprintf(stdout, "loops      %8.3f ms\n", loops_ms);
+    fprintf(stdout, "armadillo  %8.3f ms\n", arma_ms);
+    fprintf(stdout, "expression %8.3f ms  %6.0f MB/s  %.2fx\n", expression_ms, megabytes / expression_ms * 1e3,
+            loops_ms / expression_ms);
+    fprintf(stdout, "parallel   %8.3f ms  %6.0f MB/s  %.2fx\n", parallel_ms, megabytes / parallel_ms * 1e3,
+            loops_ms / parallel_ms);
+    return 0;
+}
@@ -0,0 +1,179 @@
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#include "jennifer/layer/elementwise.hpp"
+#include "jennifer/layer/layer_norm.hpp"
+#include "jennifer/layer/softmax.hpp"
+
+// The normalization kernels of a transformer block per sequence length: softmax
+// over the last dim of the seq x seq attention scores, layer norm and GELU over
+// seq x hidden activations. Each is timed against a plain two or three pass loop
+// with std::exp, std::sqrt and std::erf.
+
+DEFINE_int32(iterations, 10, "timed runs per variant");
+DEFINE_int32(min_seq, 128, "shortest sequence length");
+DEFINE_int32(max_seq, 4096, "longest sequence length, doubled from min_seq");
+DEFINE_int32(hidden, 768, "hidden size of the layer norm and GELU inputs");
+DEFINE_int32(threads, 0, "threads of the kernels, 0 for every hardware thread");
+
+using namespace jennifer;
+
+template <typename F>
+static double TimeMs(int iterations, const F &f)
+{
+    f();
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+    {
+        f();
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+}
+
+// element a of softmax i at x[a * inner + i] like SoftmaxKernel
+static void NaiveSoftmax(const float *x, float *y, int64_t count, int64_t axis, int64_t inner)
+{
+    for (int64_t i = 0; i < count; ++i)
+    {
+        const int64_t offset = i / inner * axis * inner + i % inner;
+        const float *xi = x + offset;
+        float *yi = y + offset;
+        float max = xi[0];
+        for (int64_t a = 1; a < axis; ++a)
+        {
+            max = std::max(max, xi[a * inner]);
+        }
+        float sum = 0.f;
+        for (int64_t a = 0; a < axis; ++a)
+        {
+            yi[a * inner] = std::exp(xi[a * inner] - max);
+            sum += yi[a * inner];
+        }
+        for (int64_t a = 0; a < axis; ++a)
+        {
+            yi[a * inner] /= sum;
+        }
+    }
+}
+
+static void NaiveLayerNorm(const float *x, float *y, int64_t rows, int64_t axis, const float *weight,
+                           const float *bias)
+{
+    for (int64_t r = 0; r < rows; ++r, x += axis, y += axis)
+    {
+        float mean = 0.f;
+        for (int64_t a = 0; a < axis; ++a)
+        {
+            mean += x[a];
+        }
+        mean /= axis;
+        float var = 0.f;
+        for (int64_t a = 0; a < axis; ++a)
+        {
+            var += (x[a] - mean) * (x[a] - mean);
+        }
+        const float rstd = 1.f / std::sqrt(var / axis + 1e-5f);
+        for (int64_t a = 0; a < axis; ++a)
+        {
+            y[a] = (x[a] - mean) * rstd * weight[a] + bias[a];
+        }
+    }
+}
+
+static float MaxDifference(const std::vector<float> &a, const std::vector<float> &b)
+{
+    float max = 0.f;
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+        max = std::max(max, std::fabs(a[i] - b[i]));
+    }
+    return max;
+}
+
+int main(int argc, char *argv[])
+{
+    gflags::ParseCommandLineFlags(&argc, &argv, true);
+    google::InitGoogleLogging(argv[0]);
+
+    const int64_t hidden = FLAGS_hidden;
+    std::vector<float> weight(hidden);
+    std::vector<float> bias(hidden);
+    for (int64_t a = 0; a < hidden; ++a)
+    {
+        weight[a] = 1.f + 0.001f * static_cast<float>(a % 17);
+        bias[a] = 0.01f * static_cast<float>(a % 5);
+    }
+
+    layer::ElementwiseProgram gelu;
+    CHECK(gelu.Compile("gelu(@0)"));
+
+    fprintf(stdout, "%6s %-10s %10s %10s %8s %10s\n", "seq", "kernel", "naive ms", "kernel ms", "speedup", "max diff");
+    for (int64_t seq = FLAGS_min_seq; seq <= FLAGS_max_seq; seq *= 2)
+    {
+        auto scores = std::make_shared<data::Tensor<float>>(1, seq, seq);
+        scores->RandomNormal();
+        std::vector<float> scores_values(scores->data_ptr(), scores->data_ptr() + scores->size());
+        std::vector<float> reference(scores->size());
+        std::vector<float> output(scores->size());
+
+        // the last dim of the scores has inner = seq in the memory order of data::Tensor,
+        // the contiguous rows are the other view of the same matrix
+        for (const int64_t inner : {seq, int64_t(1)})
+        {
+            const double naive_ms = TimeMs(FLAGS_iterations, [&]() {
+                NaiveSoftmax(scores_values.data(), reference.data(), seq, seq, inner);
+            });
+            const double kernel_ms = TimeMs(FLAGS_iterations, [&]() {
+                layer::SoftmaxKernel(scores_values.data(), output.data(), seq / inner, seq, inner, FLAGS_threads);
+            });
+            fprintf(stdout, "%6ld %-10s %10.3f %10.3f %7.2fx %10.2e\n", static_cast<long>(seq),
+                    inner == 1 ? "softmax_r" : "softmax_c", naive_ms, kernel_ms, naive_ms / kernel_ms,
+                    MaxDifference(output, reference));
+        }
+
+        std::vector<float> activations(seq * hidden);
+        for (size_t i = 0; i < activations.size(); ++i)
+        {
+            activations[i] = std::sin(static_cast<float>(i) * 0.37f) * 3.f + 0.5f;
+        }
+        reference.assign(activations.size(), 0.f);
+        output.assign(activations.size(), 0.f);
+
+        const double naive_norm_ms = TimeMs(FLAGS_iterations, [&]() {
+            NaiveLayerNorm(activations.data(), reference.data(), seq, hidden, weight.data(), bias.data());
+        });
+        const double norm_ms = TimeMs(FLAGS_iterations, [&]() {
+            layer::LayerNormKernel(activations.data(), output.data(), seq, hidden, 1, weight.data(), bias.data(),
+                                   1e-5f, FLAGS_threads);
+        });
+        fprintf(stdout, "%6ld %-10s %10.3f %10.3f %7.2fx %10.2e\n", static_cast<long>(seq), "layer_norm",
+                naive_norm_ms, norm_ms, naive_norm_ms / norm_ms, MaxDifference(output, reference));
+
+        const double naive_gelu_ms = TimeMs(FLAGS_iterations, [&]() {
+            for (size_t i = 0; i < activations.size(); ++i)
+            {
+                const float x = activations[i];
+                reference[i] = 0.5f * x * (1.f + std::erf(x * 0.70710678f));
+            }
+        });
+        // a fused elementwise layer as the runtime builds it for nn.GELU
+        layer::ElementwiseLayer gelu_layer("gelu", gelu,
+                                           {{1, static_cast<int32_t>(seq), static_cast<int32_t>(hidden)}});
+        std::vector<std::shared_ptr<data::Tensor<float>>> gelu_inputs = {
+            std::make_shared<data::Tensor<float>>(1, seq, hidden)};
+        std::vector<std::shared_ptr<data::Tensor<float>>> gelu_outputs = {
+            std::make_shared<data::Tensor<float>>(1, seq, hidden)};
+        std::copy(activations.begin(), activations.end(), gelu_inputs[0]->data_ptr());
+        const double gelu_ms = TimeMs(FLAGS_iterations, [&]() { gelu_layer.Forward(gelu_inputs, gelu_outputs); });
+        output.assign(gelu_outputs[0]->data_ptr(), gelu_outputs[0]->data_ptr() + activations.size());
+        fprintf(stdout, "%6ld %-10s %10.3f %10.3f %7.2fx %10.2e\n", static_cast<long>(seq), "gelu", naive_gelu_ms,
+                gelu_ms, naive_gelu_ms / gelu_ms, MaxDifference(output, reference));
+    }
+    return 0;
+}
@@ -0,0 +1,115 @@
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "jennifer/layer/transpose.hpp"
+
+// Permutes and pixel shuffles as the per-element index math of Tensor::Review, a
+// div and mod per dim for every element, against the blocked TransposeKernel.
+
+DEFINE_int32(iterations, 10, "timed runs per variant");
+DEFINE_int32(threads, 0, "threads of the kernel, 0 for every hardware thread");
+
+using namespace jennifer;
+
+template <typename F>
+static double TimeMs(int iterations, const F &f)
+{
+    f();
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+    {
+        f();
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+}
+
+static void NaiveTranspose(const float *input, float *output, int32_t rank, const int64_t *shape,
+                           const int64_t *input_strides, const int64_t *output_strides)
+{
+    int64_t count = 1;
+    for (int32_t k = 0; k < rank; ++k)
+    {
+        count *= shape[k];
+    }
+    for (int64_t n = 0; n < count; ++n)
+    {
+        int64_t rest = n;
+        int64_t from = 0;
+        int64_t to = 0;
+        for (int32_t k = rank - 1; k >= 0; --k)
+        {
+            from += rest % shape[k] * input_strides[k];
+            to += rest % shape[k] * output_strides[k];
+            rest /= shape[k];
+        }
+        output[to] = input[from];
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    gflags::ParseCommandLineFlags(&argc, &argv, true);
+    google::InitGoogleLogging(argv[0]);
+
+    struct Case
+    {
+        const char *name;
+        std::vector<int64_t> shape;
+        std::vector<int64_t> input_strides;
+        std::vector<int64_t> output_strides;
+    };
+    // dims are given in output order, data::Tensor planes are stored col by col
+    const Case cases[] = {
+        // (C, H, W) to (H, W, C): output (h, w, c) reads c at a plane stride
+        {"nchw to nhwc 64x56x56", {56, 56, 64}, {1, 56, 56 * 56}, {56 * 64, 64, 1}},
+        // swap of the last two dims of 256 planes of 64 x 64
+        {"transpose 256x64x64", {256, 64, 64}, {64 * 64, 64, 1}, {64 * 64, 1, 64}},
+        // pixel shuffle (256, 32, 32) to (64, 64, 64), dims (c, h, i, w, j)
+        {"pixel shuffle x2", {64, 32, 2, 32, 2}, {4 * 32 * 32, 1, 2 * 32 * 32, 32, 32 * 32},
+         {64 * 64, 2, 1, 2 * 64, 64}},
+        // row-major reshape of (512, 49) planes into (25088) through Review's order
+        {"planes to row-major", {1, 512, 49}, {512 * 49, 1, 512}, {512 * 49, 49, 1}},
+    };
+
+    fprintf(stdout, "%-24s %10s %10s %8s %10s\n", "case", "naive ms", "kernel ms", "speedup", "max diff");
+    for (const Case &c : cases)
+    {
+        const int32_t rank = static_cast<int32_t>(c.shape.size());
+        int64_t count = 1;
+        for (int64_t d : c.shape)
+        {
+            count *= d;
+        }
+        std::vector<float> input(count);
+        for (size_t i = 0; i < input.size(); ++i)
+        {
+            input[i] = std::sin(static_cast<float>(i) * 0.37f);
+        }
+        std::vector<float> reference(count);
+        std::vector<float> output(count);
+
+        const double naive_ms = TimeMs(FLAGS_iterations, [&]() {
+            NaiveTranspose(input.data(), reference.data(), rank, c.shape.data(), c.input_strides.data(),
+                           c.output_strides.data());
+        });
+        const double kernel_ms = TimeMs(FLAGS_iterations, [&]() {
+            layer::TransposeKernel(input.data(), output.data(), rank, c.shape.data(), c.input_strides.data(),
+                                   c.output_strides.data(), FLAGS_threads);
+        });
+
+        float max_diff = 0.f;
+        for (size_t i = 0; i < output.size(); ++i)
+        {
+            max_diff = std::max(max_diff, std::fabs(output[i] - reference[i]));
+        }
+        fprintf(stdout, "%-24s %10.3f %10.3f %7.2fx %10.2e\n", c.name, naive_ms, kernel_ms, naive_ms / kernel_ms,
+                max_diff);
+    }
+    return 0;
+}
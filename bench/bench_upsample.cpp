@@ -0,0 +1,121 @@
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "jennifer/layer/interpolate.hpp"
+
+// FPN and segmentation style upsampling as a scalar gather that computes the
+// source coordinates and weights of every output element, against the tabulated
+// InterpolateKernel.
+
+DEFINE_int32(iterations, 10, "timed runs per variant");
+DEFINE_int32(threads, 0, "threads of the kernel, 0 for every hardware thread");
+
+using namespace jennifer;
+
+template <typename F>
+static double TimeMs(int iterations, const F &f)
+{
+    f();
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+    {
+        f();
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+}
+
+// planes with rows contiguous like data::Tensor, half pixel centers and no align_corners
+static void NaiveInterpolate(const float *input, float *output, int64_t channels, int64_t in_rows, int64_t in_cols,
+                             int64_t out_rows, int64_t out_cols, bool bilinear)
+{
+    const float row_scale = static_cast<float>(in_rows) / out_rows;
+    const float col_scale = static_cast<float>(in_cols) / out_cols;
+    for (int64_t ch = 0; ch < channels; ++ch)
+    {
+        const float *in = input + ch * in_rows * in_cols;
+        float *out = output + ch * out_rows * out_cols;
+        for (int64_t r = 0; r < out_rows; ++r)
+        {
+            for (int64_t c = 0; c < out_cols; ++c)
+            {
+                if (!bilinear)
+                {
+                    const int64_t ir = std::min<int64_t>(static_cast<int64_t>(r * row_scale), in_rows - 1);
+                    const int64_t ic = std::min<int64_t>(static_cast<int64_t>(c * col_scale), in_cols - 1);
+                    out[c * out_rows + r] = in[ic * in_rows + ir];
+                    continue;
+                }
+                const float fr = std::max((r + 0.5f) * row_scale - 0.5f, 0.f);
+                const float fc = std::max((c + 0.5f) * col_scale - 0.5f, 0.f);
+                const int64_t r0 = std::min<int64_t>(static_cast<int64_t>(fr), in_rows - 1);
+                const int64_t c0 = std::min<int64_t>(static_cast<int64_t>(fc), in_cols - 1);
+                const int64_t r1 = std::min(r0 + 1, in_rows - 1);
+                const int64_t c1 = std::min(c0 + 1, in_cols - 1);
+                const float lr = fr - r0;
+                const float lc = fc - c0;
+                out[c * out_rows + r] = (1 - lr) * ((1 - lc) * in[c0 * in_rows + r0] + lc * in[c1 * in_rows + r0]) +
+                                        lr * ((1 - lc) * in[c0 * in_rows + r1] + lc * in[c1 * in_rows + r1]);
+            }
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    gflags::ParseCommandLineFlags(&argc, &argv, true);
+    google::InitGoogleLogging(argv[0]);
+
+    struct Case
+    {
+        const char *name;
+        int64_t channels, in_rows, in_cols, factor;
+        bool bilinear;
+    };
+    const Case cases[] = {
+        {"fpn nearest x2", 256, 50, 50, 2, false},
+        {"fpn nearest x2 small", 256, 13, 13, 2, false},
+        {"nearest x3", 64, 40, 40, 3, false},
+        {"fpn bilinear x2", 256, 50, 50, 2, true},
+        {"seg bilinear x8", 21, 64, 64, 8, true},
+    };
+
+    fprintf(stdout, "%-22s %10s %10s %8s %10s\n", "case", "naive ms", "kernel ms", "speedup", "max diff");
+    for (const Case &c : cases)
+    {
+        const int64_t out_rows = c.in_rows * c.factor;
+        const int64_t out_cols = c.in_cols * c.factor;
+        std::vector<float> input(c.channels * c.in_rows * c.in_cols);
+        for (size_t i = 0; i < input.size(); ++i)
+        {
+            input[i] = std::sin(static_cast<float>(i) * 0.37f);
+        }
+        std::vector<float> reference(c.channels * out_rows * out_cols);
+        std::vector<float> output(reference.size());
+
+        const double naive_ms = TimeMs(FLAGS_iterations, [&]() {
+            NaiveInterpolate(input.data(), reference.data(), c.channels, c.in_rows, c.in_cols, out_rows, out_cols,
+                             c.bilinear);
+        });
+        const layer::InterpolateMode mode = c.bilinear ? layer::InterpolateMode::Bilinear
+                                                       : layer::InterpolateMode::Nearest;
+        const double kernel_ms = TimeMs(FLAGS_iterations, [&]() {
+            layer::InterpolateKernel(input.data(), output.data(), c.channels, c.in_rows, c.in_cols, out_rows,
+                                     out_cols, mode, false, 0.f, 0.f, FLAGS_threads);
+        });
+
+        float max_diff = 0.f;
+        for (size_t i = 0; i < output.size(); ++i)
+        {
+            max_diff = std::max(max_diff, std::fabs(output[i] - reference[i]));
+        }
+        fprintf(stdout, "%-22s %10.3f %10.3f %7.2fx %10.2e\n", c.name, naive_ms, kernel_ms, naive_ms / kernel_ms,
+                max_diff);
+    }
+    return 0;
+}
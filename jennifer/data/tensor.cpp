@@ -488,7 +488,13 @@ void Tensor<T>::Reshape(const std::vector<uint32_t> &shapes, bool row_major)
     const size_t src_size = data_.size();
     const size_t dst_size = std::accumulate(shapes.begin(), shapes.end(), size_t(1), std::multiplies<size_t>());
     CHECK(src_size == dst_size);
-    if (!row_major)
+    // the buffer already holds the row-major order of the target when the planes
+    // match, or when neither plane has more than one row or col
+    const uint32_t target_rows = shapes.size() == 1 ? 1 : shapes[shapes.size() - 2];
+    const uint32_t target_cols = shapes.back();
+    const bool same_order = (target_rows == data_.n_rows && target_cols == data_.n_cols)
+                            || ((target_rows == 1 || target_cols == 1) && (data_.n_rows == 1 || data_.n_cols == 1));
+    if (!row_major || same_order)
     {
         if (shapes.size() == 3)
         {
@@ -0,0 +1,578 @@
+#ifndef JENNIFER_DATA_TENSOR_EXPRESSION_HPP_
+#define JENNIFER_DATA_TENSOR_EXPRESSION_HPP_
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#include "jennifer/utils/parallel.hpp"
+
+#include "tensor.hpp"
+
+namespace jennifer
+{
+namespace data
+{
+
+// Lazy elementwise arithmetic over Tensor. An expression like a * b + c only
+// builds a tree of small nodes that point at their operands, Assign then walks
+// the destination once and evaluates the whole tree per element, so composite
+// expressions allocate no temporaries. Nodes keep pointers to the tensors they
+// read, an expression has to be evaluated while its operands are alive.
+//
+// Operands broadcast over (channels, rows, cols), a dim of 1 repeats. The walk
+// follows memory order: channels, then cols, with rows innermost.
+template <typename E>
+class TensorExpression
+{
+public:
+    const E &self() const
+    {
+        return static_cast<const E &>(*this);
+    }
+}; // class TensorExpression
+
+// Merges the extent of an operand into dims, both ordered (channels, cols, rows)
+// like memory. False when the two neither match nor broadcast.
+inline bool MergeExtent(const int64_t extent[3], int64_t dims[3])
+{
+    for (int d = 0; d < 3; ++d)
+    {
+        if (extent[d] == dims[d] || extent[d] == 1)
+        {
+            continue;
+        }
+        if (dims[d] != 1)
+        {
+            return false;
+        }
+        dims[d] = extent[d];
+    }
+    return true;
+}
+
+template <typename T>
+class TensorTerm : public TensorExpression<TensorTerm<T>>
+{
+public:
+    using value_type = T;
+
+    // one run of rows elements, a zero stride repeats a broadcast element
+    struct Row
+    {
+        const T *data;
+        int64_t stride;
+
+        T operator[](int64_t row) const
+        {
+            return data[row * stride];
+        }
+    }; // struct Row
+
+    explicit TensorTerm(const Tensor<T> &tensor) :
+        data_(tensor.data_ptr()), extent_{tensor.channels(), tensor.cols(), tensor.rows()}
+    {
+    }
+
+    bool Extent(int64_t dims[3]) const
+    {
+        return MergeExtent(extent_, dims);
+    }
+
+    bool Contiguous(const int64_t dims[3]) const
+    {
+        return extent_[0] == dims[0] && extent_[1] == dims[1] && extent_[2] == dims[2];
+    }
+
+    T operator[](int64_t index) const
+    {
+        return data_[index];
+    }
+
+    Row row(int64_t channel, int64_t col) const
+    {
+        const int64_t c = extent_[0] == 1 ? 0 : channel;
+        const int64_t x = extent_[1] == 1 ? 0 : col;
+        return Row{data_ + (c * extent_[1] + x) * extent_[2], extent_[2] == 1 ? 0 : 1};
+    }
+
+private:
+    const T *data_;
+    int64_t extent_[3];
+}; // class TensorTerm
+
+template <typename T>
+class ScalarTerm : public TensorExpression<ScalarTerm<T>>
+{
+public:
+    using value_type = T;
+
+    explicit ScalarTerm(T value) :
+        value_(value)
+    {
+    }
+
+    bool Extent(int64_t /*dims*/[3]) const
+    {
+        return true;
+    }
+
+    bool Contiguous(const int64_t /*dims*/[3]) const
+    {
+        return true;
+    }
+
+    T operator[](int64_t /*index*/) const
+    {
+        return value_;
+    }
+
+    ScalarTerm row(int64_t /*channel*/, int64_t /*col*/) const
+    {
+        return *this;
+    }
+
+private:
+    T value_;
+}; // class ScalarTerm
+
+template <typename Op, typename E>
+class UnaryExpression : public TensorExpression<UnaryExpression<Op, E>>
+{
+public:
+    using value_type = typename E::value_type;
+
+    struct Row
+    {
+        decltype(std::declval<const E &>().row(0, 0)) a;
+
+        value_type operator[](int64_t row) const
+        {
+            return Op::Apply(a[row]);
+        }
+    }; // struct Row
+
+    explicit UnaryExpression(const E &a) :
+        a_(a)
+    {
+    }
+
+    bool Extent(int64_t dims[3]) const
+    {
+        return a_.Extent(dims);
+    }
+
+    bool Contiguous(const int64_t dims[3]) const
+    {
+        return a_.Contiguous(dims);
+    }
+
+    value_type operator[](int64_t index) const
+    {
+        return Op::Apply(a_[index]);
+    }
+
+    Row row(int64_t channel, int64_t col) const
+    {
+        return Row{a_.row(channel, col)};
+    }
+
+private:
+    E a_;
+}; // class UnaryExpression
+
+template <typename Op, typename L, typename R>
+class BinaryExpression : public TensorExpression<BinaryExpression<Op, L, R>>
+{
+public:
+    using value_type = typename L::value_type;
+    static_assert(std::is_same<value_type, typename R::value_type>::value, "Tensor operands differ in type");
+
+    struct Row
+    {
+        decltype(std::declval<const L &>().row(0, 0)) a;
+        decltype(std::declval<const R &>().row(0, 0)) b;
+
+        value_type operator[](int64_t row) const
+        {
+            return Op::Apply(a[row], b[row]);
+        }
+    }; // struct Row
+
+    BinaryExpression(const L &a, const R &b) :
+        a_(a), b_(b)
+    {
+    }
+
+    bool Extent(int64_t dims[3]) const
+    {
+        return a_.Extent(dims) && b_.Extent(dims);
+    }
+
+    bool Contiguous(const int64_t dims[3]) const
+    {
+        return a_.Contiguous(dims) && b_.Contiguous(dims);
+    }
+
+    value_type operator[](int64_t index) const
+    {
+        return Op::Apply(a_[index], b_[index]);
+    }
+
+    Row row(int64_t channel, int64_t col) const
+    {
+        return Row{a_.row(channel, col), b_.row(channel, col)};
+    }
+
+private:
+    L a_;
+    R b_;
+}; // class BinaryExpression
+
+// a * b + c in one node, contracted to a fused multiply add where the target has one
+template <typename A, typename B, typename C>
+class FmaExpression : public TensorExpression<FmaExpression<A, B, C>>
+{
+public:
+    using value_type = typename A::value_type;
+    static_assert(std::is_same<value_type, typename B::value_type>::value
+                      && std::is_same<value_type, typename C::value_type>::value,
+                  "Tensor operands differ in type");
+
+    struct Row
+    {
+        decltype(std::declval<const A &>().row(0, 0)) a;
+        decltype(std::declval<const B &>().row(0, 0)) b;
+        decltype(std::declval<const C &>().row(0, 0)) c;
+
+        value_type operator[](int64_t row) const
+        {
+            return a[row] * b[row] + c[row];
+        }
+    }; // struct Row
+
+    FmaExpression(const A &a, const B &b, const C &c) :
+        a_(a), b_(b), c_(c)
+    {
+    }
+
+    bool Extent(int64_t dims[3]) const
+    {
+        return a_.Extent(dims) && b_.Extent(dims) && c_.Extent(dims);
+    }
+
+    bool Contiguous(const int64_t dims[3]) const
+    {
+        return a_.Contiguous(dims) && b_.Contiguous(dims) && c_.Contiguous(dims);
+    }
+
+    value_type operator[](int64_t index) const
+    {
+        return a_[index] * b_[index] + c_[index];
+    }
+
+    Row row(int64_t channel, int64_t col) const
+    {
+        return Row{a_.row(channel, col), b_.row(channel, col), c_.row(channel, col)};
+    }
+
+private:
+    A a_;
+    B b_;
+    C c_;
+}; // class FmaExpression
+
+namespace expression
+{
+
+struct Negate
+{
+    template <typename T>
+    static T Apply(T a)
+    {
+        return -a;
+    }
+};
+
+struct Add
+{
+    template <typename T>
+    static T Apply(T a, T b)
+    {
+        return a + b;
+    }
+};
+
+struct Subtract
+{
+    template <typename T>
+    static T Apply(T a, T b)
+    {
+        return a - b;
+    }
+};
+
+struct Multiply
+{
+    template <typename T>
+    static T Apply(T a, T b)
+    {
+        return a * b;
+    }
+};
+
+struct Divide
+{
+    template <typename T>
+    static T Apply(T a, T b)
+    {
+        return a / b;
+    }
+};
+
+struct Maximum
+{
+    template <typename T>
+    static T Apply(T a, T b)
+    {
+        return a > b ? a : b;
+    }
+};
+
+struct Minimum
+{
+    template <typename T>
+    static T Apply(T a, T b)
+    {
+        return a < b ? a : b;
+    }
+};
+
+// Tensor and expression operands, numbers mix with them as scalars
+template <typename X>
+struct IsTensorOperand : std::is_base_of<TensorExpression<X>, X>
+{
+};
+
+template <typename T>
+struct IsTensorOperand<Tensor<T>> : std::true_type
+{
+};
+
+template <typename X>
+struct ValueType
+{
+    using type = typename X::value_type;
+};
+
+template <typename T>
+struct ValueType<Tensor<T>>
+{
+    using type = T;
+};
+
+// the node an operand becomes in an expression over elements of type T
+template <typename X, typename T, typename = void>
+struct Node
+{
+    using type = X;
+
+    static const X &Make(const X &x)
+    {
+        return x;
+    }
+};
+
+template <typename U, typename T>
+struct Node<Tensor<U>, T>
+{
+    using type = TensorTerm<U>;
+
+    static TensorTerm<U> Make(const Tensor<U> &x)
+    {
+        return TensorTerm<U>(x);
+    }
+};
+
+template <typename X, typename T>
+struct Node<X, T, typename std::enable_if<std::is_arithmetic<X>::value>::type>
+{
+    using type = ScalarTerm<T>;
+
+    static ScalarTerm<T> Make(X x)
+    {
+        return ScalarTerm<T>(static_cast<T>(x));
+    }
+};
+
+template <typename X>
+constexpr bool IsOperand()
+{
+    return IsTensorOperand<X>::value || std::is_arithmetic<X>::value;
+}
+
+// element type of the first tensor operand
+template <typename X, typename... Rest>
+struct FirstValue
+{
+    using type = typename std::conditional<IsTensorOperand<X>::value, ValueType<X>, FirstValue<Rest...>>::type::type;
+};
+
+template <typename X>
+struct FirstValue<X>
+{
+    using type = typename ValueType<X>::type;
+};
+
+template <typename... X>
+using EnableIfExpression = typename std::enable_if<(IsOperand<X>() && ...) && (IsTensorOperand<X>::value || ...)>::type;
+
+template <typename Op, typename A, typename B>
+BinaryExpression<Op, typename Node<A, typename FirstValue<A, B>::type>::type,
+                 typename Node<B, typename FirstValue<A, B>::type>::type>
+MakeBinary(const A &a, const B &b)
+{
+    using T = typename FirstValue<A, B>::type;
+    return {Node<A, T>::Make(a), Node<B, T>::Make(b)};
+}
+
+} // namespace expression
+
+template <typename A, typename = expression::EnableIfExpression<A>>
+UnaryExpression<expression::Negate, typename expression::Node<A, typename expression::ValueType<A>::type>::type>
+operator-(const A &a)
+{
+    return UnaryExpression<expression::Negate,
+                           typename expression::Node<A, typename expression::ValueType<A>::type>::type>(
+        expression::Node<A, typename expression::ValueType<A>::type>::Make(a));
+}
+
+template <typename A, typename B, typename = expression::EnableIfExpression<A, B>>
+auto operator+(const A &a, const B &b)
+{
+    return expression::MakeBinary<expression::Add>(a, b);
+}
+
+template <typename A, typename B, typename = expression::EnableIfExpression<A, B>>
+auto operator-(const A &a, const B &b)
+{
+    return expression::MakeBinary<expression::Subtract>(a, b);
+}
+
+template <typename A, typename B, typename = expression::EnableIfExpression<A, B>>
+auto operator*(const A &a, const B &b)
+{
+    return expression::MakeBinary<expression::Multiply>(a, b);
+}
+
+template <typename A, typename B, typename = expression::EnableIfExpression<A, B>>
+auto operator/(const A &a, const B &b)
+{
+    return expression::MakeBinary<expression::Divide>(a, b);
+}
+
+template <typename A, typename B, typename = expression::EnableIfExpression<A, B>>
+auto Maximum(const A &a, const B &b)
+{
+    return expression::MakeBinary<expression::Maximum>(a, b);
+}
+
+template <typename A, typename B, typename = expression::EnableIfExpression<A, B>>
+auto Minimum(const A &a, const B &b)
+{
+    return expression::MakeBinary<expression::Minimum>(a, b);
+}
+
+template <typename A, typename B, typename C, typename = expression::EnableIfExpression<A, B, C>>
+auto Fma(const A &a, const B &b, const C &c)
+{
+    using T = typename expression::FirstValue<A, B, C>::type;
+    return FmaExpression<typename expression::Node<A, T>::type, typename expression::Node<B, T>::type,
+                         typename expression::Node<C, T>::type>(
+        expression::Node<A, T>::Make(a), expression::Node<B, T>::Make(b), expression::Node<C, T>::Make(c));
+}
+
+namespace expression
+{
+
+// elements per unrolled block, computed into a local array so that the loop
+// vectorizes without runtime alias checks against the output
+constexpr int64_t kBlock = 8;
+// elements below which an evaluation stays on the calling thread
+constexpr int64_t kParallelGrain = 1 << 15;
+
+template <typename T, typename R>
+inline void EvaluateRun(const R &run, int64_t begin, int64_t end, T *out)
+{
+    int64_t i = begin;
+    for (; i + kBlock <= end; i += kBlock)
+    {
+        T block[kBlock];
+        for (int64_t k = 0; k < kBlock; ++k)
+        {
+            block[k] = run[i + k];
+        }
+        std::copy(block, block + kBlock, out + i);
+    }
+    for (; i < end; ++i)
+    {
+        out[i] = run[i];
+    }
+}
+
+} // namespace expression
+
+// Evaluates expression into output in one pass. The expression has to broadcast
+// to the shape of output, which may also be one of its operands. num_threads
+// splits large outputs across threads, 0 takes every hardware thread.
+template <typename T, typename E>
+void Assign(Tensor<T> &output, const TensorExpression<E> &expression, int num_threads = 1)
+{
+    static_assert(std::is_same<T, typename E::value_type>::value, "Output and expression differ in type");
+    const E &e = expression.self();
+    const int64_t dims[3] = {output.channels(), output.cols(), output.rows()};
+    int64_t extent[3] = {1, 1, 1};
+    bool broadcast = e.Extent(extent);
+    for (int d = 0; d < 3; ++d)
+    {
+        broadcast = broadcast && (extent[d] == 1 || extent[d] == dims[d]);
+    }
+    CHECK(broadcast) << "Expression can not be broadcast to the output";
+
+    T *out = output.data_ptr();
+    if (e.Contiguous(dims))
+    {
+        utils::ParallelFor(dims[0] * dims[1] * dims[2], num_threads, expression::kParallelGrain,
+                           [&](int64_t begin, int64_t end) { expression::EvaluateRun(e, begin, end, out); });
+        return;
+    }
+
+    // a broadcast operand is resolved once per run of rows, the rows stay contiguous
+    const int64_t grain = std::max<int64_t>(expression::kParallelGrain / dims[2], 1);
+    utils::ParallelFor(dims[0] * dims[1], num_threads, grain, [&](int64_t begin, int64_t end) {
+        for (int64_t r = begin; r < end; ++r)
+        {
+            const auto row = e.row(r / dims[1], r % dims[1]);
+            expression::EvaluateRun(row, 0, dims[2], out + r * dims[2]);
+        }
+    });
+}
+
+// a new tensor of the broadcast shape of expression
+template <typename E>
+Tensor<typename E::value_type> Evaluate(const TensorExpression<E> &expression, int num_threads = 1)
+{
+    int64_t extent[3] = {1, 1, 1};
+    CHECK(expression.self().Extent(extent)) << "Expression operands can not be broadcast";
+    Tensor<typename E::value_type> output(extent[0], extent[2], extent[1]);
+    Assign(output, expression, num_threads);
+    return output;
+}
+
+} // namespace data
+} // namespace jennifer
+
+#endif // JENNIFER_DATA_TENSOR_EXPRESSION_HPP_
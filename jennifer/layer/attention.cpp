@@ -0,0 +1,367 @@
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#include "jennifer/runtime/kv_cache.hpp"
+#include "jennifer/utils/parallel.hpp"
+
+#include "attention.hpp"
+#include "gemm_kernel.hpp"
+#include "layer_factory.hpp"
+#include "vector_math.hpp"
+
+namespace jennifer
+{
+namespace layer
+{
+
+using utils::StatusCode;
+
+// query rows and key rows of one tile, lanes of a vectorized block and the
+// multiply adds below which the work stays on one thread
+static constexpr int64_t kQueryBlock = 32;
+static constexpr int64_t kKeyBlock = 64;
+static constexpr int64_t kLanes = 8;
+static constexpr int64_t kParallelGrain = 1 << 16;
+
+// packed blocks of one thread
+struct AttentionScratch
+{
+    std::vector<float> query;
+    std::vector<float> key;
+    std::vector<float> value;
+    std::vector<float> scores;
+    std::vector<float> product;
+    std::vector<float> output;
+    std::vector<float> max;
+    std::vector<float> sum;
+    std::vector<float> rescale;
+}; // struct AttentionScratch
+
+template <typename T>
+static inline T &At(const AttentionView<T> &view, int64_t head, int64_t row, int64_t col)
+{
+    return RowPointer(view, head, row)[col * view.col_stride];
+}
+
+// row = exp(row - max), returns the sum of the row
+static float ExpRow(float *row, int64_t n, float max)
+{
+    float partial[kLanes] = {};
+    int64_t j = 0;
+    for (; j + kLanes <= n; j += kLanes)
+    {
+        float block[kLanes];
+        for (int64_t k = 0; k < kLanes; ++k)
+        {
+            block[k] = VectorExp(row[j + k] - max);
+            partial[k] += block[k];
+        }
+        std::copy(block, block + kLanes, row + j);
+    }
+    float sum = 0.f;
+    for (; j < n; ++j)
+    {
+        row[j] = VectorExp(row[j] - max);
+        sum += row[j];
+    }
+    for (int64_t k = 0; k < kLanes; ++k)
+    {
+        sum += partial[k];
+    }
+    return sum;
+}
+
+// output = output * scale + product for n elements
+static void RescaleAdd(float *output, const float *product, int64_t n, float scale)
+{
+    int64_t c = 0;
+    for (; c + kLanes <= n; c += kLanes)
+    {
+        float block[kLanes];
+        for (int64_t k = 0; k < kLanes; ++k)
+        {
+            block[k] = output[c + k] * scale + product[c + k];
+        }
+        std::copy(block, block + kLanes, output + c);
+    }
+    for (; c < n; ++c)
+    {
+        output[c] = output[c] * scale + product[c];
+    }
+}
+
+// query rows [row0, row0 + rows) of one head
+static void AttentionTile(const AttentionShape &shape, const AttentionView<const float> &q,
+                          const AttentionView<const float> &k, const AttentionView<const float> &v,
+                          const AttentionView<const float> &mask, const AttentionView<float> &output, int64_t head,
+                          int64_t row0, int64_t rows, AttentionScratch &scratch)
+{
+    const int64_t dim = shape.head_dim;
+    const int64_t value_dim = shape.value_dim;
+    const int64_t kv_head = head / (shape.heads / shape.kv_heads);
+
+    float *query = scratch.query.data();
+    for (int64_t r = 0; r < rows; ++r)
+    {
+        for (int64_t c = 0; c < dim; ++c)
+        {
+            query[r * dim + c] = At(q, head, row0 + r, c) * shape.scale;
+        }
+    }
+    std::fill(scratch.output.begin(), scratch.output.begin() + rows * value_dim, 0.f);
+    std::fill(scratch.max.begin(), scratch.max.begin() + rows, -FLT_MAX);
+    std::fill(scratch.sum.begin(), scratch.sum.begin() + rows, 0.f);
+
+    int64_t kv_end = shape.kv_len;
+    if (shape.causal)
+    {
+        kv_end = std::max<int64_t>(std::min(kv_end, row0 + rows + shape.causal_offset), 0);
+    }
+    for (int64_t col0 = 0; col0 < kv_end; col0 += kKeyBlock)
+    {
+        const int64_t cols = std::min(kKeyBlock, kv_end - col0);
+        // key transposed to dim x cols and value as cols x value_dim, both row major
+        float *key = scratch.key.data();
+        float *value = scratch.value.data();
+        for (int64_t j = 0; j < cols; ++j)
+        {
+            const float *key_row = RowPointer(k, kv_head, col0 + j);
+            const float *value_row = RowPointer(v, kv_head, col0 + j);
+            for (int64_t c = 0; c < dim; ++c)
+            {
+                key[c * cols + j] = key_row[c * k.col_stride];
+            }
+            for (int64_t c = 0; c < value_dim; ++c)
+            {
+                value[j * value_dim + c] = value_row[c * v.col_stride];
+            }
+        }
+
+        float *scores = scratch.scores.data();
+        GemmTiled<4, 8>(static_cast<int>(rows), static_cast<int>(cols), static_cast<int>(dim), query, key, nullptr,
+                        scores);
+        for (int64_t r = 0; r < rows; ++r)
+        {
+            float *row = scores + r * cols;
+            if (mask.data != nullptr)
+            {
+                for (int64_t j = 0; j < cols; ++j)
+                {
+                    row[j] += At(mask, head, row0 + r, col0 + j);
+                }
+            }
+            if (shape.causal)
+            {
+                const int64_t allowed = std::max<int64_t>(row0 + r + shape.causal_offset + 1 - col0, 0);
+                std::fill(row + std::min(allowed, cols), row + cols, -INFINITY);
+            }
+
+            const float block_max = *std::max_element(row, row + cols);
+            const float max = std::max(scratch.max[r], block_max);
+            scratch.rescale[r] = VectorExp(scratch.max[r] - max);
+            scratch.sum[r] = scratch.sum[r] * scratch.rescale[r] + ExpRow(row, cols, max);
+            scratch.max[r] = max;
+        }
+
+        float *product = scratch.product.data();
+        GemmTiled<4, 8>(static_cast<int>(rows), static_cast<int>(value_dim), static_cast<int>(cols), scores, value,
+                        nullptr, product);
+        for (int64_t r = 0; r < rows; ++r)
+        {
+            RescaleAdd(scratch.output.data() + r * value_dim, product + r * value_dim, value_dim, scratch.rescale[r]);
+        }
+    }
+
+    for (int64_t r = 0; r < rows; ++r)
+    {
+        const float inverse = 1.f / scratch.sum[r];
+        for (int64_t c = 0; c < value_dim; ++c)
+        {
+            At(output, head, row0 + r, c) = scratch.output[r * value_dim + c] * inverse;
+        }
+    }
+}
+
+void AttentionKernel(const AttentionShape &shape, const AttentionView<const float> &q,
+                     const AttentionView<const float> &k, const AttentionView<const float> &v,
+                     const AttentionView<const float> &mask, const AttentionView<float> &output, int num_threads)
+{
+    CHECK(shape.kv_heads > 0 && shape.heads % shape.kv_heads == 0)
+        << shape.heads << " query heads can not share " << shape.kv_heads << " key heads";
+
+    const int64_t blocks = (shape.q_len + kQueryBlock - 1) / kQueryBlock;
+    const int64_t tile_work = std::min(kQueryBlock, shape.q_len) * shape.kv_len * (shape.head_dim + shape.value_dim);
+    utils::ParallelFor(shape.heads * blocks, num_threads, kParallelGrain / std::max<int64_t>(tile_work, 1) + 1,
+                       [&](int64_t begin, int64_t end) {
+                           AttentionScratch scratch;
+                           scratch.query.resize(kQueryBlock * shape.head_dim);
+                           scratch.key.resize(kKeyBlock * shape.head_dim);
+                           scratch.value.resize(kKeyBlock * shape.value_dim);
+                           scratch.scores.resize(kQueryBlock * kKeyBlock);
+                           scratch.product.resize(kQueryBlock * shape.value_dim);
+                           scratch.output.resize(kQueryBlock * shape.value_dim);
+                           scratch.max.resize(kQueryBlock);
+                           scratch.sum.resize(kQueryBlock);
+                           scratch.rescale.resize(kQueryBlock);
+                           for (int64_t t = begin; t < end; ++t)
+                           {
+                               const int64_t row0 = t % blocks * kQueryBlock;
+                               AttentionTile(shape, q, k, v, mask, output, t / blocks, row0,
+                                             std::min(kQueryBlock, shape.q_len - row0), scratch);
+                           }
+                       });
+}
+
+AttentionLayer::AttentionLayer(std::string layer_name, float scale, bool causal) :
+    Layer(std::move(layer_name)), scale_(scale), causal_(causal)
+{
+}
+
+// (channels, rows, cols) of a data::Tensor as (heads, rows, cols), rows contiguous
+template <typename T>
+static AttentionView<T> TensorView(T *data, const data::Tensor<float> &tensor)
+{
+    AttentionView<T> view;
+    view.data = data;
+    view.head_stride = static_cast<int64_t>(tensor.rows()) * tensor.cols();
+    view.row_stride = 1;
+    view.col_stride = tensor.rows();
+    return view;
+}
+
+// the shape of one sample, false when query, key, value and output do not match
+static bool SampleShape(const data::Tensor<float> &query, const data::Tensor<float> &key,
+                        const data::Tensor<float> &value, const data::Tensor<float> &output, AttentionShape &shape)
+{
+    shape.heads = query.channels();
+    shape.kv_heads = key.channels();
+    shape.q_len = query.rows();
+    shape.kv_len = key.rows();
+    shape.head_dim = query.cols();
+    shape.value_dim = value.cols();
+    return shape.kv_heads != 0 && shape.heads % shape.kv_heads == 0 && key.cols() == shape.head_dim
+           && value.channels() == shape.kv_heads && value.rows() == shape.kv_len && output.channels() == shape.heads
+           && output.rows() == shape.q_len && output.cols() == shape.value_dim;
+}
+
+StatusCode AttentionLayer::Forward(const std::vector<std::shared_ptr<data::Tensor<float>>> &inputs,
+                                   std::vector<std::shared_ptr<data::Tensor<float>>> &outputs)
+{
+    const size_t batch = outputs.size();
+    if (batch == 0 || inputs.size() % batch != 0 || inputs.size() / batch < 3 || inputs.size() / batch > 4)
+    {
+        LOG(ERROR) << "Attention " << layer_name << " has " << inputs.size() << " inputs and " << batch << " outputs";
+        return StatusCode::InferInputsEmpty;
+    }
+
+    for (size_t b = 0; b < batch; ++b)
+    {
+        const data::Tensor<float> &query = *inputs[b];
+        const data::Tensor<float> &key = *inputs[batch + b];
+        const data::Tensor<float> &value = *inputs[2 * batch + b];
+        data::Tensor<float> &output = *outputs[b];
+
+        AttentionShape shape;
+        if (!SampleShape(query, key, value, output, shape))
+        {
+            LOG(ERROR) << "Attention " << layer_name << " query, key, value and output shapes do not match";
+            return StatusCode::InferDimMismatch;
+        }
+        shape.scale = scale_ > 0.f ? scale_ : 1.f / std::sqrt(static_cast<float>(shape.head_dim));
+        shape.causal = causal_;
+
+        AttentionView<const float> mask;
+        if (inputs.size() == 4 * batch)
+        {
+            const data::Tensor<float> &mask_tensor = *inputs[3 * batch + b];
+            if ((mask_tensor.channels() != 1 && mask_tensor.channels() != shape.heads)
+                || (mask_tensor.rows() != 1 && mask_tensor.rows() != shape.q_len) || mask_tensor.cols() != shape.kv_len)
+            {
+                LOG(ERROR) << "Attention " << layer_name << " mask does not broadcast to the scores";
+                return StatusCode::InferDimMismatch;
+            }
+            mask = TensorView(mask_tensor.data_ptr(), mask_tensor);
+            mask.head_stride = mask_tensor.channels() == 1 ? 0 : mask.head_stride;
+            mask.row_stride = mask_tensor.rows() == 1 ? 0 : 1;
+        }
+
+        AttentionKernel(shape, TensorView(query.data_ptr(), query), TensorView(key.data_ptr(), key),
+                        TensorView(value.data_ptr(), value), mask, TensorView(output.data_ptr(), output), 0);
+    }
+    return StatusCode::Success;
+}
+
+StatusCode AttentionLayer::Decode(const std::vector<std::shared_ptr<data::Tensor<float>>> &inputs,
+                                  std::vector<std::shared_ptr<data::Tensor<float>>> &outputs, runtime::KVCache &cache,
+                                  int cache_layer, const std::vector<int64_t> &sequences)
+{
+    const size_t batch = outputs.size();
+    if (batch == 0 || inputs.size() != 3 * batch || sequences.size() != batch)
+    {
+        LOG(ERROR) << "Attention " << layer_name << " decodes " << sequences.size() << " sequences with "
+                   << inputs.size() << " inputs and " << batch << " outputs, masks are not supported";
+        return StatusCode::InferInputsEmpty;
+    }
+
+    for (size_t b = 0; b < batch; ++b)
+    {
+        const data::Tensor<float> &query = *inputs[b];
+        const data::Tensor<float> &key = *inputs[batch + b];
+        const data::Tensor<float> &value = *inputs[2 * batch + b];
+        data::Tensor<float> &output = *outputs[b];
+
+        // the new rows continue the cached ones, so the causal diagonal moves by the past length
+        AttentionShape shape;
+        if (!SampleShape(query, key, value, output, shape) || shape.kv_len != shape.q_len)
+        {
+            LOG(ERROR) << "Attention " << layer_name << " query, key, value and output shapes do not match";
+            return StatusCode::InferDimMismatch;
+        }
+        const int64_t past = cache.length(sequences[b], cache_layer);
+        if (!cache.Append(sequences[b], cache_layer, TensorView(key.data_ptr(), key),
+                          TensorView(value.data_ptr(), value), shape.kv_heads, shape.kv_len, shape.head_dim,
+                          shape.value_dim))
+        {
+            LOG(ERROR) << "Attention " << layer_name << " can not cache sequence " << sequences[b];
+            return StatusCode::InferParamError;
+        }
+        shape.kv_len += past;
+        shape.scale = scale_ > 0.f ? scale_ : 1.f / std::sqrt(static_cast<float>(shape.head_dim));
+        shape.causal = true;
+        shape.causal_offset = past;
+
+        AttentionKernel(shape, TensorView(query.data_ptr(), query), cache.keys(sequences[b], cache_layer),
+                        cache.values(sequences[b], cache_layer), AttentionView<const float>(),
+                        TensorView(output.data_ptr(), output), 0);
+    }
+    return StatusCode::Success;
+}
+
+StatusCode AttentionLayer::Create(const std::shared_ptr<runtime::Operator<float>> &op,
+                                  std::shared_ptr<Layer<float>> &layer)
+{
+    CHECK(op != nullptr) << "Attention operator is empty";
+
+    const size_t input_count = op->input_operands_seq.size();
+    if (input_count != 3 && input_count != 4)
+    {
+        LOG(ERROR) << "Attention " << op->name << " has " << input_count << " inputs";
+        return StatusCode::ParseParamError;
+    }
+
+    // dropout_p only applies in training, scale None is the default 1 / sqrt(head_dim)
+    bool causal = false;
+    GetParameter(*op, "is_causal", causal);
+    float scale = 0.f;
+    GetParameter(*op, "scale", scale);
+    layer = std::make_shared<AttentionLayer>(op->name, scale, causal);
+    return StatusCode::Success;
+}
+
+static LayerRegistererWrapper kAttentionLayer("F.scaled_dot_product_attention", AttentionLayer::Create);
+
+} // namespace layer
+} // namespace jennifer
@@ -0,0 +1,103 @@
+#ifndef JENNIFER_LAYER_ATTENTION_HPP_
+#define JENNIFER_LAYER_ATTENTION_HPP_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "layer.hpp"
+
+namespace jennifer
+{
+namespace runtime
+{
+class KVCache;
+} // namespace runtime
+
+namespace layer
+{
+
+// A [heads, rows, cols] float view, element (h, r, c) at
+// data[h * head_stride + r * row_stride + c * col_stride]; zero strides broadcast.
+// With pages the rows are split into pages of page_rows rows, row r is row
+// r % page_rows of pages[r / page_rows] and data is unused.
+template <typename T>
+struct AttentionView
+{
+    T *data = nullptr;
+    int64_t head_stride = 0;
+    int64_t row_stride = 0;
+    int64_t col_stride = 0;
+    T *const *pages = nullptr;
+    int64_t page_rows = 0;
+}; // struct AttentionView
+
+// the address of element (head, row, 0) of view
+template <typename T>
+inline T *RowPointer(const AttentionView<T> &view, int64_t head, int64_t row)
+{
+    if (view.pages != nullptr)
+    {
+        return view.pages[row / view.page_rows] + head * view.head_stride + row % view.page_rows * view.row_stride;
+    }
+    return view.data + head * view.head_stride + row * view.row_stride;
+}
+
+struct AttentionShape
+{
+    int64_t heads = 1;
+    // key and value heads, every heads / kv_heads query heads share one
+    int64_t kv_heads = 1;
+    int64_t q_len = 0;
+    int64_t kv_len = 0;
+    int64_t head_dim = 0;
+    int64_t value_dim = 0;
+    float scale = 1.f;
+    // query row i attends to key rows j <= i + causal_offset
+    bool causal = false;
+    int64_t causal_offset = 0;
+}; // struct AttentionShape
+
+// softmax(q k^T * scale + mask) v without the q_len x kv_len score matrix. Every
+// block of 32 query rows walks the keys in blocks of 64: the block scores come
+// from GemmTiled, an online softmax keeps the running max and sum of every row and
+// rescales the output accumulated so far, so memory stays linear in the sequence
+// length. Causal blocks stop at the diagonal. mask is additive and optional, a
+// row whose scores are all masked gives NaN like torch. (head, query block) tiles
+// are split across num_threads, 0 takes every hardware thread.
+void AttentionKernel(const AttentionShape &shape, const AttentionView<const float> &q,
+                     const AttentionView<const float> &k, const AttentionView<const float> &v,
+                     const AttentionView<const float> &mask, const AttentionView<float> &output, int num_threads);
+
+// F.scaled_dot_product_attention over query (heads, q_len, head_dim), key and value
+// samples of data::Tensor; a rank 3 input has a single head. The optional fourth
+// input is a float mask of (1 or heads, 1 or q_len, kv_len).
+class AttentionLayer : public Layer<float>
+{
+public:
+    // a scale that is not positive means 1 / sqrt(head_dim)
+    AttentionLayer(std::string layer_name, float scale, bool causal);
+
+    utils::StatusCode Forward(const std::vector<std::shared_ptr<data::Tensor<float>>> &inputs,
+                              std::vector<std::shared_ptr<data::Tensor<float>>> &outputs) override;
+
+    // a decode step: sample b holds the new positions of sequences[b], whose key
+    // and value rows are appended to layer cache_layer of cache before the queries
+    // attend causally over every cached row. A mask input is not supported.
+    utils::StatusCode Decode(const std::vector<std::shared_ptr<data::Tensor<float>>> &inputs,
+                             std::vector<std::shared_ptr<data::Tensor<float>>> &outputs, runtime::KVCache &cache,
+                             int cache_layer, const std::vector<int64_t> &sequences);
+
+    static utils::StatusCode Create(const std::shared_ptr<runtime::Operator<float>> &op,
+                                    std::shared_ptr<Layer<float>> &layer);
+
+private:
+    float scale_;
+    bool causal_;
+}; // class AttentionLayer
+
+} // namespace layer
+} // namespace jennifer
+
+#endif // JENNIFER_LAYER_ATTENTION_HPP_
@@ -0,0 +1,106 @@
+#include <glog/logging.h>
+
+#include <algorithm>
+
+#include "concat.hpp"
+#include "layer_factory.hpp"
+
+namespace jennifer
+{
+namespace layer
+{
+
+using utils::StatusCode;
+
+static uint32_t AxisSize(const data::Tensor<float> &tensor, int32_t axis)
+{
+    return axis == 0 ? tensor.channels() : (axis == 1 ? tensor.rows() : tensor.cols());
+}
+
+ConcatLayer::ConcatLayer(std::string layer_name, int32_t axis) :
+    Layer(std::move(layer_name)), axis_(axis)
+{
+}
+
+StatusCode ConcatLayer::Forward(const std::vector<std::shared_ptr<data::Tensor<float>>> &inputs,
+                                std::vector<std::shared_ptr<data::Tensor<float>>> &outputs)
+{
+    const size_t batch = outputs.size();
+    if (batch == 0 || inputs.empty() || inputs.size() % batch != 0)
+    {
+        LOG(ERROR) << "Concat " << layer_name << " has " << inputs.size() << " inputs and " << batch << " outputs";
+        return StatusCode::InferInputsEmpty;
+    }
+
+    const size_t count = inputs.size() / batch;
+    for (size_t b = 0; b < batch; ++b)
+    {
+        data::Tensor<float> &output = *outputs[b];
+        // a plane is stored col by col, so an output step along the axis is a
+        // contiguous block of inner floats repeated outer times
+        const int64_t rows = output.rows();
+        const int64_t cols = output.cols();
+        const int64_t outer = axis_ == 0 ? 1 : (axis_ == 1 ? output.channels() * cols : output.channels());
+        const int64_t inner = axis_ == 0 ? rows * cols : (axis_ == 1 ? 1 : rows);
+        const int64_t extent = AxisSize(output, axis_);
+
+        int64_t position = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            const data::Tensor<float> &input = *inputs[i * batch + b];
+            const int64_t size = AxisSize(input, axis_);
+            if (input.size() != static_cast<size_t>(outer * size * inner) || position + size > extent)
+            {
+                LOG(ERROR) << "Concat " << layer_name << " input " << i << " does not fit its slice of the output";
+                return StatusCode::InferDimMismatch;
+            }
+            const float *src = input.data_ptr();
+            float *dst = output.data_ptr() + position * inner;
+            position += size;
+            if (src == dst && outer == 1)
+            {
+                continue;
+            }
+            for (int64_t o = 0; o < outer; ++o)
+            {
+                std::copy(src + o * size * inner, src + (o + 1) * size * inner, dst + o * extent * inner);
+            }
+        }
+        if (position != extent)
+        {
+            LOG(ERROR) << "Concat " << layer_name << " inputs fill " << position << " of " << extent;
+            return StatusCode::InferDimMismatch;
+        }
+    }
+    return StatusCode::Success;
+}
+
+StatusCode ConcatLayer::Create(const std::shared_ptr<runtime::Operator<float>> &op,
+                               std::shared_ptr<Layer<float>> &layer)
+{
+    CHECK(op != nullptr) << "Concat operator is empty";
+
+    int32_t dim = 0;
+    if (!GetParameter(*op, "dim", dim) || op->input_operands_seq.empty())
+    {
+        LOG(ERROR) << "Concat " << op->name << " misses its dim";
+        return StatusCode::ParseParamError;
+    }
+    // the batch is split into samples, dims beyond three fold into the channels
+    const int32_t rank = static_cast<int32_t>(op->input_operands_seq[0]->shapes.size());
+    const int32_t sample_rank = rank - 1;
+    dim = dim < 0 ? dim + rank : dim;
+    if (dim < 1 || dim >= rank || sample_rank > 4 || (sample_rank == 4 && dim == 2))
+    {
+        LOG(ERROR) << "Concat " << op->name << " along dim " << dim << " of rank " << rank << " is not supported";
+        return StatusCode::ParseParamError;
+    }
+    const int32_t axis = sample_rank == 4 ? std::max(dim - 2, 0) : dim - 1 + 3 - sample_rank;
+    layer = std::make_shared<ConcatLayer>(op->name, axis);
+    return StatusCode::Success;
+}
+
+static LayerRegistererWrapper kConcatLayer("torch.cat", ConcatLayer::Create);
+
+} // namespace layer
+} // namespace jennifer
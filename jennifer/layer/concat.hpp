@@ -0,0 +1,39 @@
+#ifndef JENNIFER_LAYER_CONCAT_HPP_
+#define JENNIFER_LAYER_CONCAT_HPP_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "layer.hpp"
+
+namespace jennifer
+{
+namespace layer
+{
+
+// torch.cat of samples of up to three dims, a sample of rank 4 may only be joined
+// along its first dim. Every input is copied in contiguous blocks into its slice of
+// the output; an input the memory plan already placed in that slice is skipped, so
+// a cat whose inputs were all written in place by their producers copies nothing.
+class ConcatLayer : public Layer<float>
+{
+public:
+    // axis of the (channels, rows, cols) of data::Tensor the inputs are joined along
+    ConcatLayer(std::string layer_name, int32_t axis);
+
+    utils::StatusCode Forward(const std::vector<std::shared_ptr<data::Tensor<float>>> &inputs,
+                              std::vector<std::shared_ptr<data::Tensor<float>>> &outputs) override;
+
+    static utils::StatusCode Create(const std::shared_ptr<runtime::Operator<float>> &op,
+                                    std::shared_ptr<Layer<float>> &layer);
+
+private:
+    int32_t axis_;
+}; // class ConcatLayer
+
+} // namespace layer
+} // namespace jennifer
+
+#endif // JENNIFER_LAYER_CONCAT_HPP_
@@ -0,0 +1,252 @@
+#include <glog/logging.h>
+
+#include "conv2d.hpp"
+#include "layer_factory.hpp"
+
+namespace jennifer
+{
+namespace layer
+{
+
+using utils::StatusCode;
+
+// The shape specialized instantiations. Template arguments are in plane order
+// (kernel_w, kernel_h, stride_w, stride_h) because the planes are transposed.
+struct FixedConv2dKernel
+{
+    const char *key;
+    int kernel_h;
+    int kernel_w;
+    int stride_h;
+    int stride_w;
+    Conv2dKernel kernel;
+};
+
+static const FixedConv2dKernel kFixedConv2dKernels[] = {
+    {"nn.Conv2d.1x1s1", 1, 1, 1, 1, Conv2dDirect<1, 1, 1, 1>},
+    {"nn.Conv2d.3x3s1", 3, 3, 1, 1, Conv2dDirect<3, 3, 1, 1>},
+    {"nn.Conv2d.3x3s2", 3, 3, 2, 2, Conv2dDirect<3, 3, 2, 2>},
+    {"nn.Conv2d.5x5s1", 5, 5, 1, 1, Conv2dDirect<5, 5, 1, 1>},
+    {"nn.Conv2d.7x7s2", 7, 7, 2, 2, Conv2dDirect<7, 7, 2, 2>},
+};
+
+// kernel_size, stride, padding and dilation as (h, w) pairs
+static bool GetPair(const runtime::Operator<float> &op, const std::string &key, int32_t default_value,
+                    std::vector<int32_t> &value)
+{
+    value.assign(2, default_value);
+    std::vector<int32_t> array;
+    int32_t scalar = 0;
+    if (GetParameter(op, key, array) && array.size() == 2)
+    {
+        value = array;
+    }
+    else if (GetParameter(op, key, scalar))
+    {
+        value.assign(2, scalar);
+    }
+    else if (op.params.count(key) != 0)
+    {
+        return false;
+    }
+    return true;
+}
+
+Conv2dLayer::Conv2dLayer(std::string layer_name, const Conv2dShape &geometry, std::vector<float> weight,
+                         std::vector<float> bias, Conv2dKernel kernel) :
+    Layer(std::move(layer_name)), geometry_(geometry), weight_(weight.begin(), weight.end()), bias_(std::move(bias)),
+    kernel_(kernel)
+{
+}
+
+StatusCode Conv2dLayer::Forward(const std::vector<std::shared_ptr<data::Tensor<float>>> &inputs,
+                                std::vector<std::shared_ptr<data::Tensor<float>>> &outputs)
+{
+    if (inputs.empty() || inputs.size() != outputs.size())
+    {
+        LOG(ERROR) << "Conv2d " << layer_name << " has " << inputs.size() << " inputs and " << outputs.size() << " outputs";
+        return StatusCode::InferInputsEmpty;
+    }
+
+    for (size_t i = 0; i < inputs.size(); ++i)
+    {
+        const std::shared_ptr<data::Tensor<float>> &input = inputs[i];
+        const std::shared_ptr<data::Tensor<float>> &output = outputs[i];
+
+        Conv2dShape shape = geometry_;
+        shape.in_h = static_cast<int>(input->cols());
+        shape.in_w = static_cast<int>(input->rows());
+        shape.out_h = static_cast<int>(output->cols());
+        shape.out_w = static_cast<int>(output->rows());
+
+        const int expected_h = (shape.in_h + 2 * shape.pad_h - shape.dilation_h * (shape.kernel_h - 1) - 1) / shape.stride_h + 1;
+        const int expected_w = (shape.in_w + 2 * shape.pad_w - shape.dilation_w * (shape.kernel_w - 1) - 1) / shape.stride_w + 1;
+        if (static_cast<int>(input->channels()) != shape.in_channels || static_cast<int>(output->channels()) != shape.out_channels
+            || shape.out_h != expected_h || shape.out_w != expected_w)
+        {
+            LOG(ERROR) << "Conv2d " << layer_name << " input or output shape does not match the kernel";
+            return StatusCode::InferDimMismatch;
+        }
+
+        kernel_(shape, weight_.data(), bias_.empty() ? nullptr : bias_.data(), input->data_ptr(), output->data_ptr(), padded_);
+    }
+    return StatusCode::Success;
+}
+
+StatusCode Conv2dLayer::Create(const std::shared_ptr<runtime::Operator<float>> &op, Conv2dKernel kernel,
+                               std::shared_ptr<Layer<float>> &layer)
+{
+    CHECK(op != nullptr) << "Conv2d operator is empty";
+
+    int32_t in_channels = 0;
+    int32_t out_channels = 0;
+    int32_t groups = 1;
+    std::vector<int32_t> kernel_size;
+    std::vector<int32_t> stride;
+    std::vector<int32_t> dilation;
+    std::vector<int32_t> padding;
+    if (!GetParameter(*op, "in_channels", in_channels) || !GetParameter(*op, "out_channels", out_channels)
+        || !GetPair(*op, "kernel_size", 1, kernel_size) || !GetPair(*op, "stride", 1, stride)
+        || !GetPair(*op, "dilation", 1, dilation))
+    {
+        LOG(ERROR) << "Conv2d " << op->name << " misses channels, kernel_size, stride or dilation";
+        return StatusCode::ParseParamError;
+    }
+    GetParameter(*op, "groups", groups);
+
+    std::string padding_mode;
+    if (GetParameter(*op, "padding_mode", padding_mode) && padding_mode != "zeros")
+    {
+        LOG(ERROR) << "Conv2d " << op->name << " supports zeros padding only, got " << padding_mode;
+        return StatusCode::ParseParamError;
+    }
+
+    std::string padding_string;
+    if (GetParameter(*op, "padding", padding_string))
+    {
+        // same keeps the size for unit stride, valid is no padding
+        padding.assign(2, 0);
+        if (padding_string == "same")
+        {
+            padding[0] = dilation[0] * (kernel_size[0] - 1) / 2;
+            padding[1] = dilation[1] * (kernel_size[1] - 1) / 2;
+        }
+    }
+    else if (!GetPair(*op, "padding", 0, padding))
+    {
+        LOG(ERROR) << "Conv2d " << op->name << " has an unsupported padding";
+        return StatusCode::ParseParamError;
+    }
+
+    if (groups <= 0 || in_channels % groups != 0 || out_channels % groups != 0)
+    {
+        LOG(ERROR) << "Conv2d " << op->name << " channels are not divisible by groups " << groups;
+        return StatusCode::ParseParamError;
+    }
+
+    auto weight_it = op->attrs.find("weight");
+    if (weight_it == op->attrs.end() || weight_it->second->weight.empty())
+    {
+        LOG(ERROR) << "Conv2d " << op->name << " has no weight";
+        return StatusCode::ParseWeightError;
+    }
+    const std::vector<float> weight = weight_it->second->get<float>(false);
+    const int kh = kernel_size[0];
+    const int kw = kernel_size[1];
+    const size_t plane_count = static_cast<size_t>(out_channels) * (in_channels / groups);
+    if (weight.size() != plane_count * kh * kw)
+    {
+        LOG(ERROR) << "Conv2d " << op->name << " weight size " << weight.size() << " does not match its shape";
+        return StatusCode::ParseWeightError;
+    }
+
+    // transpose every kernel plane to follow the transposed input planes
+    std::vector<float> transposed(weight.size());
+    for (size_t p = 0; p < plane_count; ++p)
+    {
+        for (int i = 0; i < kh; ++i)
+        {
+            for (int j = 0; j < kw; ++j)
+            {
+                transposed[(p * kw + j) * kh + i] = weight[(p * kh + i) * kw + j];
+            }
+        }
+    }
+
+    std::vector<float> bias;
+    auto bias_it = op->attrs.find("bias");
+    if (bias_it != op->attrs.end() && !bias_it->second->weight.empty())
+    {
+        bias = bias_it->second->get<float>(false);
+        if (bias.size() != static_cast<size_t>(out_channels))
+        {
+            LOG(ERROR) << "Conv2d " << op->name << " bias size " << bias.size() << " does not match out channels";
+            return StatusCode::ParseWeightError;
+        }
+    }
+
+    Conv2dShape geometry;
+    geometry.in_channels = in_channels;
+    geometry.out_channels = out_channels;
+    geometry.kernel_h = kw;
+    geometry.kernel_w = kh;
+    geometry.stride_h = stride[1];
+    geometry.stride_w = stride[0];
+    geometry.pad_h = padding[1];
+    geometry.pad_w = padding[0];
+    geometry.dilation_h = dilation[1];
+    geometry.dilation_w = dilation[0];
+    geometry.groups = groups;
+
+    layer = std::make_shared<Conv2dLayer>(op->name, geometry, std::move(transposed), std::move(bias), kernel);
+    return StatusCode::Success;
+}
+
+std::string Conv2dLayer::SelectKernel(const std::shared_ptr<runtime::Operator<float>> &op,
+                                      const std::vector<std::vector<int32_t>> &/*input_shapes*/,
+                                      const std::vector<std::vector<int32_t>> &/*output_shapes*/)
+{
+    std::vector<int32_t> kernel_size;
+    std::vector<int32_t> stride;
+    std::vector<int32_t> dilation;
+    if (!GetPair(*op, "kernel_size", 1, kernel_size) || !GetPair(*op, "stride", 1, stride)
+        || !GetPair(*op, "dilation", 1, dilation) || dilation != std::vector<int32_t>{1, 1})
+    {
+        return op->type;
+    }
+
+    for (const FixedConv2dKernel &fixed : kFixedConv2dKernels)
+    {
+        if (kernel_size[0] == fixed.kernel_h && kernel_size[1] == fixed.kernel_w && stride[0] == fixed.stride_h
+            && stride[1] == fixed.stride_w)
+        {
+            return fixed.key;
+        }
+    }
+    return op->type;
+}
+
+static LayerRegistererWrapper kConv2dSelector("nn.Conv2d", LayerRegisterer::KernelSelector(Conv2dLayer::SelectKernel));
+
+static LayerRegistererWrapper kConv2dLayer("nn.Conv2d",
+                                           [](const std::shared_ptr<runtime::Operator<float>> &op, std::shared_ptr<Layer<float>> &layer) {
+                                               return Conv2dLayer::Create(op, Conv2dDirect<0, 0, 0, 0>, layer);
+                                           });
+
+static bool RegisterFixedConv2dKernels()
+{
+    for (const FixedConv2dKernel &fixed : kFixedConv2dKernels)
+    {
+        const Conv2dKernel kernel = fixed.kernel;
+        LayerRegisterer::RegisterCreator(fixed.key, [kernel](const std::shared_ptr<runtime::Operator<float>> &op,
+                                                             std::shared_ptr<Layer<float>> &layer) {
+            return Conv2dLayer::Create(op, kernel, layer);
+        });
+    }
+    return true;
+}
+
+static const bool kFixedConv2dRegistered = RegisterFixedConv2dKernels();
+
+} // namespace layer
+} // namespace jennifer
@@ -0,0 +1,53 @@
+#ifndef JENNIFER_LAYER_CONV2D_HPP_
+#define JENNIFER_LAYER_CONV2D_HPP_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "jennifer/utils/huge_pages.hpp"
+
+#include "conv2d_kernel.hpp"
+#include "layer.hpp"
+
+namespace jennifer
+{
+namespace layer
+{
+
+// nn.Conv2d over the column major planes of data::Tensor. A plane of H rows and W
+// cols is laid out as a row major W x H array, so the kernel runs on transposed
+// planes with the kernel, stride, padding and dilation transposed to match.
+class Conv2dLayer : public Layer<float>
+{
+public:
+    Conv2dLayer(std::string layer_name, const Conv2dShape &geometry, std::vector<float> weight,
+                std::vector<float> bias, Conv2dKernel kernel);
+
+    utils::StatusCode Forward(const std::vector<std::shared_ptr<data::Tensor<float>>> &inputs,
+                              std::vector<std::shared_ptr<data::Tensor<float>>> &outputs) override;
+
+    static utils::StatusCode Create(const std::shared_ptr<runtime::Operator<float>> &op, Conv2dKernel kernel,
+                                    std::shared_ptr<Layer<float>> &layer);
+
+    // nn.Conv2d.<kh>x<kw>s<s> for the shape specialized kernels, nn.Conv2d otherwise
+    static std::string SelectKernel(const std::shared_ptr<runtime::Operator<float>> &op,
+                                    const std::vector<std::vector<int32_t>> &input_shapes,
+                                    const std::vector<std::vector<int32_t>> &output_shapes);
+
+private:
+    // channels, kernel, stride, padding, dilation and groups in plane order, the
+    // spatial sizes are filled per Forward
+    Conv2dShape geometry_;
+    utils::HugeVector<float> weight_;
+    std::vector<float> bias_;
+    Conv2dKernel kernel_;
+
+    // Forward calls are serialized by RuntimeGraph
+    std::vector<float> padded_;
+}; // class Conv2dLayer
+
+} // namespace layer
+} // namespace jennifer
+
+#endif // JENNIFER_LAYER_CONV2D_HPP_
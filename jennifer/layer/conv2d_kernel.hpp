@@ -0,0 +1,184 @@
+#ifndef JENNIFER_LAYER_CONV2D_KERNEL_HPP_
+#define JENNIFER_LAYER_CONV2D_KERNEL_HPP_
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace jennifer
+{
+namespace layer
+{
+
+// Geometry of one sample of a direct 2d convolution over row major planes, the
+// weight is [out_channels][in_channels / groups][kernel_h][kernel_w]
+struct Conv2dShape
+{
+    int in_channels = 0;
+    int in_h = 0;
+    int in_w = 0;
+    int out_channels = 0;
+    int out_h = 0;
+    int out_w = 0;
+    int kernel_h = 1;
+    int kernel_w = 1;
+    int stride_h = 1;
+    int stride_w = 1;
+    int pad_h = 0;
+    int pad_w = 0;
+    int dilation_h = 1;
+    int dilation_w = 1;
+    int groups = 1;
+}; // struct Conv2dShape
+
+// padded is scratch owned by the caller, it holds the zero padded input planes
+using Conv2dKernel = void (*)(const Conv2dShape &shape, const float *weight, const float *bias, const float *input,
+                              float *output, std::vector<float> &padded);
+
+// Computes an oc_tile x ow_tile block of output row oh starting at channel oc and
+// column ow from the padded input. A positive KH, KW, SH or SW replaces the runtime
+// value with a compile time constant, so the kernel loops unroll and every offset
+// folds; zero keeps it a runtime value for the generic kernel.
+template <int KH, int KW, int SH, int SW, int OC_TILE, int OW_TILE>
+inline void Conv2dBlock(const Conv2dShape &shape, const float *weight, const float *bias, const float *input,
+                        int padded_h, int padded_w, int oc, int oh, int ow, float *output)
+{
+    const int kernel_h = KH > 0 ? KH : shape.kernel_h;
+    const int kernel_w = KW > 0 ? KW : shape.kernel_w;
+    const int stride_h = SH > 0 ? SH : shape.stride_h;
+    const int stride_w = SW > 0 ? SW : shape.stride_w;
+    const int dilation_h = KH > 0 ? 1 : shape.dilation_h;
+    const int dilation_w = KW > 0 ? 1 : shape.dilation_w;
+
+    const int group_channels = shape.in_channels / shape.groups;
+    const int group = oc / (shape.out_channels / shape.groups);
+    const int weight_stride = group_channels * kernel_h * kernel_w;
+
+    float acc[OC_TILE][OW_TILE];
+    for (int o = 0; o < OC_TILE; ++o)
+    {
+        for (int t = 0; t < OW_TILE; ++t)
+        {
+            acc[o][t] = bias != nullptr ? bias[oc + o] : 0.f;
+        }
+    }
+
+    for (int c = 0; c < group_channels; ++c)
+    {
+        const float *x = input + (group * group_channels + c) * padded_h * padded_w + oh * stride_h * padded_w
+                         + ow * stride_w;
+        const float *w = weight + oc * weight_stride + c * kernel_h * kernel_w;
+        for (int i = 0; i < kernel_h; ++i)
+        {
+            for (int j = 0; j < kernel_w; ++j)
+            {
+                const float *xp = x + i * dilation_h * padded_w + j * dilation_w;
+                float xv[OW_TILE];
+                for (int t = 0; t < OW_TILE; ++t)
+                {
+                    xv[t] = xp[t * stride_w];
+                }
+                for (int o = 0; o < OC_TILE; ++o)
+                {
+                    const float k = w[o * weight_stride + i * kernel_w + j];
+                    for (int t = 0; t < OW_TILE; ++t)
+                    {
+                        acc[o][t] += k * xv[t];
+                    }
+                }
+            }
+        }
+    }
+
+    for (int o = 0; o < OC_TILE; ++o)
+    {
+        float *out = output + (oc + o) * shape.out_h * shape.out_w + oh * shape.out_w + ow;
+        for (int t = 0; t < OW_TILE; ++t)
+        {
+            out[t] = acc[o][t];
+        }
+    }
+}
+
+// returns the input itself when there is no padding, otherwise the zero padded copy
+inline const float *PadConv2dInput(const Conv2dShape &shape, const float *input, std::vector<float> &padded,
+                                   int &padded_h, int &padded_w)
+{
+    padded_h = shape.in_h + 2 * shape.pad_h;
+    padded_w = shape.in_w + 2 * shape.pad_w;
+    if (shape.pad_h == 0 && shape.pad_w == 0)
+    {
+        return input;
+    }
+
+    padded.assign(static_cast<size_t>(shape.in_channels) * padded_h * padded_w, 0.f);
+    for (int c = 0; c < shape.in_channels; ++c)
+    {
+        for (int h = 0; h < shape.in_h; ++h)
+        {
+            memcpy(padded.data() + (c * padded_h + h + shape.pad_h) * padded_w + shape.pad_w,
+                   input + (c * shape.in_h + h) * shape.in_w, shape.in_w * sizeof(float));
+        }
+    }
+    return padded.data();
+}
+
+// Direct convolution tiled over 4 output channels and a row of output columns, the
+// column tile is 8 for the specialized kernels and 4 for the generic one.
+// Conv2dDirect<0, 0, 0, 0> is the generic kernel for any kernel, stride and dilation.
+template <int KH, int KW, int SH, int SW>
+void Conv2dDirect(const Conv2dShape &shape, const float *weight, const float *bias, const float *input,
+                  float *output, std::vector<float> &padded)
+{
+    constexpr int OC_TILE = 4;
+    constexpr int OW_TILE = SW > 0 ? 8 : 4;
+
+    int padded_h = 0;
+    int padded_w = 0;
+    const float *x = PadConv2dInput(shape, input, padded, padded_h, padded_w);
+
+    const int group_out_channels = shape.out_channels / shape.groups;
+    for (int g = 0; g < shape.groups; ++g)
+    {
+        const int oc_end = (g + 1) * group_out_channels;
+        int oc = g * group_out_channels;
+        for (; oc + OC_TILE <= oc_end; oc += OC_TILE)
+        {
+            for (int oh = 0; oh < shape.out_h; ++oh)
+            {
+                int ow = 0;
+                for (; ow + OW_TILE <= shape.out_w; ow += OW_TILE)
+                {
+                    Conv2dBlock<KH, KW, SH, SW, OC_TILE, OW_TILE>(shape, weight, bias, x, padded_h, padded_w, oc, oh,
+                                                                  ow, output);
+                }
+                for (; ow < shape.out_w; ++ow)
+                {
+                    Conv2dBlock<KH, KW, SH, SW, OC_TILE, 1>(shape, weight, bias, x, padded_h, padded_w, oc, oh, ow,
+                                                            output);
+                }
+            }
+        }
+        for (; oc < oc_end; ++oc)
+        {
+            for (int oh = 0; oh < shape.out_h; ++oh)
+            {
+                int ow = 0;
+                for (; ow + OW_TILE <= shape.out_w; ow += OW_TILE)
+                {
+                    Conv2dBlock<KH, KW, SH, SW, 1, OW_TILE>(shape, weight, bias, x, padded_h, padded_w, oc, oh, ow,
+                                                            output);
+                }
+                for (; ow < shape.out_w; ++ow)
+                {
+                    Conv2dBlock<KH, KW, SH, SW, 1, 1>(shape, weight, bias, x, padded_h, padded_w, oc, oh, ow, output);
+                }
+            }
+        }
+    }
+}
+
+} // namespace layer
+} // namespace jennifer
+
+#endif // JENNIFER_LAYER_CONV2D_KERNEL_HPP_
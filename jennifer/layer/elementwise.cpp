@@ -0,0 +1,958 @@
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#include "jennifer/utils/parallel.hpp"
+
+#include "elementwise.hpp"
+#include "layer_factory.hpp"
+#include "vector_math.hpp"
+
+namespace jennifer
+{
+namespace layer
+{
+
+using utils::StatusCode;
+
+// every function takes two arguments, unary ones ignore the second. They are
+// instantiated for float tiles and for double scalars.
+template <typename T> static T Identity(T x, T) { return x; }
+template <typename T> static T Neg(T x, T) { return -x; }
+template <typename T> static T Abs(T x, T) { return std::fabs(x); }
+template <typename T> static T Sign(T x, T) { return static_cast<T>((x > T(0)) - (x < T(0))); }
+template <typename T> static T Square(T x, T) { return x * x; }
+template <typename T> static T Sqrt(T x, T) { return std::sqrt(x); }
+template <typename T> static T Rsqrt(T x, T) { return T(1) / std::sqrt(x); }
+template <typename T> static T Reciprocal(T x, T) { return T(1) / x; }
+template <typename T> static T Exp(T x, T) { return std::exp(x); }
+template <typename T> static T Log(T x, T) { return std::log(x); }
+template <typename T> static T Log10(T x, T) { return std::log10(x); }
+template <typename T> static T Sin(T x, T) { return std::sin(x); }
+template <typename T> static T Cos(T x, T) { return std::cos(x); }
+template <typename T> static T Tan(T x, T) { return std::tan(x); }
+template <typename T> static T Asin(T x, T) { return std::asin(x); }
+template <typename T> static T Acos(T x, T) { return std::acos(x); }
+template <typename T> static T Atan(T x, T) { return std::atan(x); }
+template <typename T> static T Sinh(T x, T) { return std::sinh(x); }
+template <typename T> static T Cosh(T x, T) { return std::cosh(x); }
+template <typename T> static T Tanh(T x, T) { return std::tanh(x); }
+template <typename T> static T Asinh(T x, T) { return std::asinh(x); }
+template <typename T> static T Acosh(T x, T) { return std::acosh(x); }
+template <typename T> static T Atanh(T x, T) { return std::atanh(x); }
+template <typename T> static T Erf(T x, T) { return std::erf(x); }
+template <typename T> static T Floor(T x, T) { return std::floor(x); }
+template <typename T> static T Ceil(T x, T) { return std::ceil(x); }
+// torch rounds half to even
+template <typename T> static T Round(T x, T) { return std::nearbyint(x); }
+template <typename T> static T Trunc(T x, T) { return std::trunc(x); }
+
+template <typename T> static T Relu(T x, T) { return x > T(0) ? x : T(0); }
+template <typename T> static T Sigmoid(T x, T) { return T(1) / (T(1) + std::exp(-x)); }
+template <typename T> static T Silu(T x, T) { return x / (T(1) + std::exp(-x)); }
+template <typename T> static T Gelu(T x, T) { return T(0.5) * x * (T(1) + std::erf(x * T(0.70710678118654752))); }
+template <typename T> static T GeluTanh(T x, T)
+{
+    return T(0.5) * x * (T(1) + std::tanh(T(0.79788456080286536) * (x + T(0.044715) * x * x * x)));
+}
+// the float tiles of the activations take the vectorizable approximations
+template <> float Sigmoid(float x, float) { return 1.f / (1.f + VectorExp(-x)); }
+template <> float Silu(float x, float) { return x / (1.f + VectorExp(-x)); }
+template <> float Gelu(float x, float) { return 0.5f * x * (1.f + VectorErf(x * 0.70710678118654752f)); }
+template <> float GeluTanh(float x, float)
+{
+    return 0.5f * x * (1.f + VectorTanh(0.79788456080286536f * (x + 0.044715f * x * x * x)));
+}
+template <typename T> static T Hardswish(T x, T) { return x * std::min(std::max(x + T(3), T(0)), T(6)) / T(6); }
+template <typename T> static T Hardsigmoid(T x, T) { return std::min(std::max(x / T(6) + T(0.5), T(0)), T(1)); }
+// beta 1 and threshold 20 as nn.Softplus defaults
+template <typename T> static T Softplus(T x, T) { return x > T(20) ? x : std::log1p(std::exp(x)); }
+template <typename T> static T Mish(T x, T) { return x * std::tanh(Softplus(x, T(0))); }
+
+template <typename T> static T Add(T a, T b) { return a + b; }
+template <typename T> static T Sub(T a, T b) { return a - b; }
+template <typename T> static T Mul(T a, T b) { return a * b; }
+template <typename T> static T Div(T a, T b) { return a / b; }
+template <typename T> static T FloorDivide(T a, T b) { return std::floor(a / b); }
+template <typename T> static T Fmod(T a, T b) { return std::fmod(a, b); }
+// python modulo, the result takes the sign of the divisor
+template <typename T> static T Remainder(T a, T b)
+{
+    const T r = std::fmod(a, b);
+    return (r != T(0) && (r < T(0)) != (b < T(0))) ? r + b : r;
+}
+template <typename T> static T Max(T a, T b) { return std::max(a, b); }
+template <typename T> static T Min(T a, T b) { return std::min(a, b); }
+template <typename T> static T Pow(T a, T b) { return std::pow(a, b); }
+template <typename T> static T Atan2(T a, T b) { return std::atan2(a, b); }
+template <typename T> static T LogAddExp(T a, T b)
+{
+    return std::max(a, b) + std::log1p(std::exp(-std::fabs(a - b)));
+}
+template <typename T> static T LeakyRelu(T x, T slope) { return x > T(0) ? x : x * slope; }
+template <typename T> static T Elu(T x, T alpha) { return x > T(0) ? x : alpha * (std::exp(x) - T(1)); }
+
+using TileFunction = void (*)(const float *a, float a_value, const float *b, float b_value, float *out, int n);
+
+// F is a compile time constant, so it inlines into the loop. Blocks of 8 are
+// computed into a local array before they are stored, out may alias a or b and the
+// fixed trip count lets the block vectorize without alias checks.
+template <float (*F)(float, float)>
+static void TileApply(const float *a, float a_value, const float *b, float b_value, float *out, int n)
+{
+    constexpr int kBlock = 8;
+    const int a_step = a != nullptr ? 1 : 0;
+    const int b_step = b != nullptr ? 1 : 0;
+    const float *a_ptr = a != nullptr ? a : &a_value;
+    const float *b_ptr = b != nullptr ? b : &b_value;
+
+    int i = 0;
+    if (a_step == 1 && b_step == 1)
+    {
+        for (; i + kBlock <= n; i += kBlock)
+        {
+            float block[kBlock];
+            for (int j = 0; j < kBlock; ++j)
+            {
+                block[j] = F(a[i + j], b[i + j]);
+            }
+            for (int j = 0; j < kBlock; ++j)
+            {
+                out[i + j] = block[j];
+            }
+        }
+    }
+    else if (a_step == 1)
+    {
+        for (; i + kBlock <= n; i += kBlock)
+        {
+            float block[kBlock];
+            for (int j = 0; j < kBlock; ++j)
+            {
+                block[j] = F(a[i + j], b_value);
+            }
+            for (int j = 0; j < kBlock; ++j)
+            {
+                out[i + j] = block[j];
+            }
+        }
+    }
+    else if (b_step == 1)
+    {
+        for (; i + kBlock <= n; i += kBlock)
+        {
+            float block[kBlock];
+            for (int j = 0; j < kBlock; ++j)
+            {
+                block[j] = F(a_value, b[i + j]);
+            }
+            for (int j = 0; j < kBlock; ++j)
+            {
+                out[i + j] = block[j];
+            }
+        }
+    }
+    for (; i < n; ++i)
+    {
+        out[i] = F(a_ptr[i * a_step], b_ptr[i * b_step]);
+    }
+}
+
+struct ElementwiseFunction
+{
+    const char *name;
+    int arity;
+    double (*scalar)(double, double);
+    TileFunction tile;
+};
+
+static const ElementwiseFunction kElementwiseFunctions[] = {
+    {"neg", 1, Neg<double>, TileApply<Neg<float>>},
+    {"abs", 1, Abs<double>, TileApply<Abs<float>>},
+    {"sign", 1, Sign<double>, TileApply<Sign<float>>},
+    {"square", 1, Square<double>, TileApply<Square<float>>},
+    {"sqrt", 1, Sqrt<double>, TileApply<Sqrt<float>>},
+    {"rsqrt", 1, Rsqrt<double>, TileApply<Rsqrt<float>>},
+    {"reciprocal", 1, Reciprocal<double>, TileApply<Reciprocal<float>>},
+    {"exp", 1, Exp<double>, TileApply<Exp<float>>},
+    {"log", 1, Log<double>, TileApply<Log<float>>},
+    {"log10", 1, Log10<double>, TileApply<Log10<float>>},
+    {"sin", 1, Sin<double>, TileApply<Sin<float>>},
+    {"cos", 1, Cos<double>, TileApply<Cos<float>>},
+    {"tan", 1, Tan<double>, TileApply<Tan<float>>},
+    {"asin", 1, Asin<double>, TileApply<Asin<float>>},
+    {"acos", 1, Acos<double>, TileApply<Acos<float>>},
+    {"atan", 1, Atan<double>, TileApply<Atan<float>>},
+    {"sinh", 1, Sinh<double>, TileApply<Sinh<float>>},
+    {"cosh", 1, Cosh<double>, TileApply<Cosh<float>>},
+    {"tanh", 1, Tanh<double>, TileApply<Tanh<float>>},
+    {"asinh", 1, Asinh<double>, TileApply<Asinh<float>>},
+    {"acosh", 1, Acosh<double>, TileApply<Acosh<float>>},
+    {"atanh", 1, Atanh<double>, TileApply<Atanh<float>>},
+    {"erf", 1, Erf<double>, TileApply<Erf<float>>},
+    {"floor", 1, Floor<double>, TileApply<Floor<float>>},
+    {"ceil", 1, Ceil<double>, TileApply<Ceil<float>>},
+    {"round", 1, Round<double>, TileApply<Round<float>>},
+    {"trunc", 1, Trunc<double>, TileApply<Trunc<float>>},
+    {"int", 1, Trunc<double>, TileApply<Trunc<float>>},
+    {"relu", 1, Relu<double>, TileApply<Relu<float>>},
+    {"sigmoid", 1, Sigmoid<double>, TileApply<Sigmoid<float>>},
+    {"silu", 1, Silu<double>, TileApply<Silu<float>>},
+    {"gelu", 1, Gelu<double>, TileApply<Gelu<float>>},
+    {"gelu_tanh", 1, GeluTanh<double>, TileApply<GeluTanh<float>>},
+    {"hardswish", 1, Hardswish<double>, TileApply<Hardswish<float>>},
+    {"hardsigmoid", 1, Hardsigmoid<double>, TileApply<Hardsigmoid<float>>},
+    {"softplus", 1, Softplus<double>, TileApply<Softplus<float>>},
+    {"mish", 1, Mish<double>, TileApply<Mish<float>>},
+    {"add", 2, Add<double>, TileApply<Add<float>>},
+    {"sub", 2, Sub<double>, TileApply<Sub<float>>},
+    {"mul", 2, Mul<double>, TileApply<Mul<float>>},
+    {"div", 2, Div<double>, TileApply<Div<float>>},
+    {"floor_divide", 2, FloorDivide<double>, TileApply<FloorDivide<float>>},
+    {"fmod", 2, Fmod<double>, TileApply<Fmod<float>>},
+    {"remainder", 2, Remainder<double>, TileApply<Remainder<float>>},
+    {"max", 2, Max<double>, TileApply<Max<float>>},
+    {"maximum", 2, Max<double>, TileApply<Max<float>>},
+    {"min", 2, Min<double>, TileApply<Min<float>>},
+    {"minimum", 2, Min<double>, TileApply<Min<float>>},
+    {"pow", 2, Pow<double>, TileApply<Pow<float>>},
+    {"atan2", 2, Atan2<double>, TileApply<Atan2<float>>},
+    {"logaddexp", 2, LogAddExp<double>, TileApply<LogAddExp<float>>},
+    {"leaky_relu", 2, LeakyRelu<double>, TileApply<LeakyRelu<float>>},
+    {"elu", 2, Elu<double>, TileApply<Elu<float>>},
+};
+
+static const ElementwiseFunction *FindElementwiseFunction(const std::string &name)
+{
+    for (const ElementwiseFunction &function : kElementwiseFunctions)
+    {
+        if (name == function.name)
+        {
+            return &function;
+        }
+    }
+    return nullptr;
+}
+
+namespace
+{
+
+enum class NodeKind
+{
+    Function,
+    Input,
+    Number,
+    Size,
+    List,
+};
+
+// one node of the parsed expr, args index earlier nodes
+struct ExpressionNode
+{
+    NodeKind kind = NodeKind::Number;
+    const ElementwiseFunction *function = nullptr;
+    int input = -1;
+    int dim = 0;
+    double value = 0.0;
+    std::vector<int> args;
+};
+
+enum class ValueKind
+{
+    Tensor,
+    Scalar,
+    Constant,
+};
+
+// a tensor register, a scalar register or a folded constant
+struct EmittedValue
+{
+    ValueKind kind;
+    int index;
+    double value;
+};
+
+} // namespace
+
+static void SkipSpaces(const std::string &expr, size_t &pos)
+{
+    while (pos < expr.size() && expr[pos] == ' ')
+    {
+        pos++;
+    }
+}
+
+static bool ParseInteger(const std::string &expr, size_t &pos, int &value)
+{
+    SkipSpaces(expr, pos);
+    char *end = nullptr;
+    const long parsed = strtol(expr.c_str() + pos, &end, 10);
+    if (end == expr.c_str() + pos)
+    {
+        return false;
+    }
+    value = static_cast<int>(parsed);
+    pos = end - expr.c_str();
+    return true;
+}
+
+// parses comma separated nodes up to the closing character
+static bool ParseArguments(const std::string &expr, size_t &pos, char close, std::vector<ExpressionNode> &nodes,
+                           std::vector<int> &args);
+
+// returns the node index, -1 on a syntax error or an unknown function
+static int ParseExpressionNode(const std::string &expr, size_t &pos, std::vector<ExpressionNode> &nodes)
+{
+    SkipSpaces(expr, pos);
+    if (pos >= expr.size())
+    {
+        return -1;
+    }
+
+    ExpressionNode node;
+    const char c = expr[pos];
+    if (c == '@')
+    {
+        pos++;
+        if (pos >= expr.size() || !isdigit(static_cast<unsigned char>(expr[pos])) || !ParseInteger(expr, pos, node.input))
+        {
+            return -1;
+        }
+        node.kind = NodeKind::Input;
+    }
+    else if (c == '[')
+    {
+        pos++;
+        node.kind = NodeKind::List;
+        if (!ParseArguments(expr, pos, ']', nodes, node.args))
+        {
+            return -1;
+        }
+    }
+    else if (isdigit(static_cast<unsigned char>(c)) || c == '-' || c == '+' || c == '.')
+    {
+        char *end = nullptr;
+        node.value = strtod(expr.c_str() + pos, &end);
+        if (end == expr.c_str() + pos)
+        {
+            return -1;
+        }
+        pos = end - expr.c_str();
+    }
+    else
+    {
+        const size_t begin = pos;
+        while (pos < expr.size() && (isalnum(static_cast<unsigned char>(expr[pos])) || expr[pos] == '_'))
+        {
+            pos++;
+        }
+        const std::string name = expr.substr(begin, pos - begin);
+        SkipSpaces(expr, pos);
+        if (pos >= expr.size() || expr[pos] != '(')
+        {
+            return -1;
+        }
+        pos++;
+
+        if (name == "size")
+        {
+            // size(@n,dim)
+            node.kind = NodeKind::Size;
+            SkipSpaces(expr, pos);
+            if (pos >= expr.size() || expr[pos] != '@' || !ParseInteger(expr, ++pos, node.input) || node.input < 0)
+            {
+                return -1;
+            }
+            SkipSpaces(expr, pos);
+            if (pos >= expr.size() || expr[pos] != ',' || !ParseInteger(expr, ++pos, node.dim))
+            {
+                return -1;
+            }
+            SkipSpaces(expr, pos);
+            if (pos >= expr.size() || expr[pos] != ')')
+            {
+                return -1;
+            }
+            pos++;
+        }
+        else
+        {
+            node.kind = NodeKind::Function;
+            node.function = FindElementwiseFunction(name);
+            if (node.function == nullptr || !ParseArguments(expr, pos, ')', nodes, node.args)
+                || static_cast<int>(node.args.size()) != node.function->arity)
+            {
+                return -1;
+            }
+        }
+    }
+
+    nodes.push_back(std::move(node));
+    return static_cast<int>(nodes.size()) - 1;
+}
+
+static bool ParseArguments(const std::string &expr, size_t &pos, char close, std::vector<ExpressionNode> &nodes,
+                           std::vector<int> &args)
+{
+    for (;;)
+    {
+        const int arg = ParseExpressionNode(expr, pos, nodes);
+        if (arg < 0)
+        {
+            return false;
+        }
+        args.push_back(arg);
+
+        SkipSpaces(expr, pos);
+        if (pos < expr.size() && expr[pos] == ',')
+        {
+            pos++;
+            continue;
+        }
+        if (pos < expr.size() && expr[pos] == close)
+        {
+            pos++;
+            return true;
+        }
+        return false;
+    }
+}
+
+bool ElementwiseProgram::Compile(const std::string &expr)
+{
+    instructions_.clear();
+    scalar_instructions_.clear();
+    size_loads_.clear();
+    constants_.clear();
+    results_.clear();
+    tensor_inputs_.clear();
+    list_ = false;
+    input_count_ = 0;
+    register_count_ = 0;
+
+    std::vector<ExpressionNode> nodes;
+    size_t pos = 0;
+    const int root = ParseExpressionNode(expr, pos, nodes);
+    SkipSpaces(expr, pos);
+    if (root < 0 || pos != expr.size())
+    {
+        return false;
+    }
+
+    for (const ExpressionNode &node : nodes)
+    {
+        input_count_ = std::max(input_count_, node.input + 1);
+    }
+    register_count_ = input_count_;
+    tensor_inputs_.assign(input_count_, false);
+
+    auto new_scalar = [this](double value) {
+        constants_.push_back(value);
+        return static_cast<int>(constants_.size()) - 1;
+    };
+    auto scalar_of = [&new_scalar](const EmittedValue &v) {
+        return v.kind == ValueKind::Constant ? new_scalar(v.value) : v.index;
+    };
+
+    // Children come before their parent in nodes, so emitting in node order is a
+    // post order walk. A temporary is released as soon as its consumer is emitted
+    // and the consumer may take the same register since it works index by index.
+    std::vector<EmittedValue> emitted(nodes.size());
+    std::vector<int> free_registers;
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+        const ExpressionNode &node = nodes[i];
+        if (node.kind == NodeKind::Input)
+        {
+            tensor_inputs_[node.input] = true;
+            emitted[i] = EmittedValue{ValueKind::Tensor, node.input, 0.0};
+            continue;
+        }
+        if (node.kind == NodeKind::Number)
+        {
+            emitted[i] = EmittedValue{ValueKind::Constant, -1, node.value};
+            continue;
+        }
+        if (node.kind == NodeKind::Size)
+        {
+            const int dst = new_scalar(0.0);
+            size_loads_.push_back(SizeLoad{dst, node.input, node.dim});
+            emitted[i] = EmittedValue{ValueKind::Scalar, dst, 0.0};
+            continue;
+        }
+        if (node.kind == NodeKind::List)
+        {
+            // lists hold shape values and only appear as the whole expression
+            if (static_cast<int>(i) != root)
+            {
+                return false;
+            }
+            for (int arg : node.args)
+            {
+                if (emitted[arg].kind == ValueKind::Tensor)
+                {
+                    return false;
+                }
+                results_.push_back(scalar_of(emitted[arg]));
+            }
+            list_ = true;
+            continue;
+        }
+
+        const bool unary = node.args.size() == 1;
+        const EmittedValue a = emitted[node.args[0]];
+        const EmittedValue b = unary ? EmittedValue{ValueKind::Constant, -1, 0.0} : emitted[node.args[1]];
+        if (a.kind == ValueKind::Constant && b.kind == ValueKind::Constant)
+        {
+            emitted[i] = EmittedValue{ValueKind::Constant, -1, node.function->scalar(a.value, b.value)};
+            continue;
+        }
+        if (a.kind != ValueKind::Tensor && b.kind != ValueKind::Tensor)
+        {
+            const int sa = scalar_of(a);
+            const int sb = unary ? -1 : scalar_of(b);
+            const int dst = new_scalar(0.0);
+            scalar_instructions_.push_back(ScalarInstruction{node.function->scalar, dst, sa, sb});
+            emitted[i] = EmittedValue{ValueKind::Scalar, dst, 0.0};
+            continue;
+        }
+
+        Instruction ins{node.function->tile, -1, -1, -1, -1, -1};
+        if (a.kind == ValueKind::Tensor)
+        {
+            ins.a = a.index;
+        }
+        else
+        {
+            ins.a_scalar = scalar_of(a);
+        }
+        if (b.kind == ValueKind::Tensor)
+        {
+            ins.b = b.index;
+        }
+        else if (!unary)
+        {
+            ins.b_scalar = scalar_of(b);
+        }
+
+        for (int reg : {ins.a, ins.b})
+        {
+            if (reg >= input_count_ && std::find(free_registers.begin(), free_registers.end(), reg) == free_registers.end())
+            {
+                free_registers.push_back(reg);
+            }
+        }
+        if (!free_registers.empty())
+        {
+            ins.dst = free_registers.back();
+            free_registers.pop_back();
+        }
+        else
+        {
+            ins.dst = register_count_++;
+        }
+        instructions_.push_back(ins);
+        emitted[i] = EmittedValue{ValueKind::Tensor, ins.dst, 0.0};
+    }
+
+    if (list_)
+    {
+        return true;
+    }
+
+    // the last instruction writes the output, a bare input or a scalar is copied
+    const EmittedValue result = emitted[root];
+    if (result.kind != ValueKind::Tensor)
+    {
+        results_.push_back(scalar_of(result));
+        instructions_.push_back(Instruction{TileApply<Identity<float>>, register_count_++, -1, -1, results_[0], -1});
+    }
+    else if (result.index < input_count_)
+    {
+        instructions_.push_back(Instruction{TileApply<Identity<float>>, register_count_++, result.index, -1, -1, -1});
+    }
+    return true;
+}
+
+int ElementwiseProgram::input_count() const
+{
+    return input_count_;
+}
+
+int ElementwiseProgram::register_count() const
+{
+    return register_count_;
+}
+
+size_t ElementwiseProgram::instruction_count() const
+{
+    return instructions_.size();
+}
+
+bool ElementwiseProgram::uses_tensor(int input) const
+{
+    return input >= 0 && input < input_count_ && tensor_inputs_[input];
+}
+
+bool ElementwiseProgram::is_list() const
+{
+    return list_;
+}
+
+bool ElementwiseProgram::EvaluateScalars(const std::vector<std::vector<int32_t>> &shapes,
+                                         std::vector<double> &scalars) const
+{
+    scalars = constants_;
+    for (const SizeLoad &load : size_loads_)
+    {
+        if (load.input >= static_cast<int>(shapes.size()))
+        {
+            return false;
+        }
+        const std::vector<int32_t> &shape = shapes[load.input];
+        const int rank = static_cast<int>(shape.size());
+        const int dim = load.dim < 0 ? load.dim + rank : load.dim;
+        if (dim < 0 || dim >= rank)
+        {
+            return false;
+        }
+        scalars[load.dst] = shape[dim];
+    }
+
+    for (const ScalarInstruction &ins : scalar_instructions_)
+    {
+        scalars[ins.dst] = ins.function(scalars[ins.a], ins.b >= 0 ? scalars[ins.b] : 0.0);
+    }
+    return true;
+}
+
+bool ElementwiseProgram::EvaluateShape(const std::vector<std::vector<int32_t>> &shapes,
+                                       std::vector<double> &values) const
+{
+    std::vector<double> scalars;
+    if (results_.empty() || !EvaluateScalars(shapes, scalars))
+    {
+        return false;
+    }
+
+    values.clear();
+    for (int result : results_)
+    {
+        values.push_back(scalars[result]);
+    }
+    return true;
+}
+
+// copies elements [start, start + n) of a broadcast operand, one innermost run at a time
+static void GatherTile(const ElementwiseOperand &operand, const int64_t dims[3], int64_t start, int n, float *out)
+{
+    int64_t i2 = start % dims[2];
+    int64_t i1 = (start / dims[2]) % dims[1];
+    int64_t i0 = start / (dims[2] * dims[1]);
+    int done = 0;
+    while (done < n)
+    {
+        const int run = static_cast<int>(std::min<int64_t>(n - done, dims[2] - i2));
+        const float *p = operand.data + i0 * operand.strides[0] + i1 * operand.strides[1] + i2 * operand.strides[2];
+        if (operand.strides[2] == 0)
+        {
+            std::fill(out + done, out + done + run, *p);
+        }
+        else if (operand.strides[2] == 1)
+        {
+            memcpy(out + done, p, run * sizeof(float));
+        }
+        else
+        {
+            for (int t = 0; t < run; ++t)
+            {
+                out[done + t] = p[t * operand.strides[2]];
+            }
+        }
+
+        done += run;
+        i2 = 0;
+        if (++i1 == dims[1])
+        {
+            i1 = 0;
+            i0++;
+        }
+    }
+}
+
+void ElementwiseProgram::Run(const std::vector<ElementwiseOperand> &inputs, const int64_t dims[3], float *output,
+                             std::vector<float> &scratch, const std::vector<double> &scalars) const
+{
+    CHECK_GE(inputs.size(), static_cast<size_t>(input_count_)) << "Elementwise program misses inputs";
+    CHECK(scalars.size() == constants_.size() || (scalars.empty() && size_loads_.empty()))
+        << "Elementwise program needs the scalars of its input shapes";
+    const std::vector<double> &scalar_registers = scalars.empty() ? constants_ : scalars;
+
+    const int64_t count = dims[0] * dims[1] * dims[2];
+    if (list_)
+    {
+        CHECK_EQ(count, static_cast<int64_t>(results_.size())) << "Elementwise list has another length";
+        for (size_t i = 0; i < results_.size(); ++i)
+        {
+            output[i] = static_cast<float>(scalar_registers[results_[i]]);
+        }
+        return;
+    }
+    RunRange(inputs, dims, 0, count, output, scratch, scalars);
+}
+
+void ElementwiseProgram::RunRange(const std::vector<ElementwiseOperand> &inputs, const int64_t dims[3],
+                                  int64_t begin, int64_t end, float *output, std::vector<float> &scratch,
+                                  const std::vector<double> &scalars) const
+{
+    CHECK(!list_ && !instructions_.empty()) << "Elementwise program is not compiled to tensor code";
+    CHECK_GE(inputs.size(), static_cast<size_t>(input_count_)) << "Elementwise program misses inputs";
+    const std::vector<double> &scalar_registers = scalars.empty() ? constants_ : scalars;
+
+    const int64_t natural[3] = {dims[1] * dims[2], dims[2], 1};
+    std::vector<bool> contiguous(input_count_, true);
+    for (int i = 0; i < input_count_; ++i)
+    {
+        for (int d = 0; d < 3; ++d)
+        {
+            if (dims[d] > 1 && inputs[i].strides[d] != natural[d])
+            {
+                contiguous[i] = false;
+            }
+        }
+    }
+
+    scratch.resize(static_cast<size_t>(register_count_) * kTileSize);
+    std::vector<const float *> registers(register_count_, nullptr);
+    for (int64_t start = begin; start < end; start += kTileSize)
+    {
+        const int n = static_cast<int>(std::min<int64_t>(kTileSize, end - start));
+
+        // contiguous inputs are read in place, broadcast ones are expanded into their register
+        for (int i = 0; i < input_count_; ++i)
+        {
+            if (!tensor_inputs_[i])
+            {
+                continue;
+            }
+            if (contiguous[i])
+            {
+                registers[i] = inputs[i].data + start;
+            }
+            else
+            {
+                float *buffer = scratch.data() + static_cast<size_t>(i) * kTileSize;
+                GatherTile(inputs[i], dims, start, n, buffer);
+                registers[i] = buffer;
+            }
+        }
+
+        for (size_t k = 0; k < instructions_.size(); ++k)
+        {
+            const Instruction &ins = instructions_[k];
+            float *out = k + 1 == instructions_.size() ? output + start
+                                                        : scratch.data() + static_cast<size_t>(ins.dst) * kTileSize;
+            const float a_value = ins.a_scalar >= 0 ? static_cast<float>(scalar_registers[ins.a_scalar]) : 0.f;
+            const float b_value = ins.b_scalar >= 0 ? static_cast<float>(scalar_registers[ins.b_scalar]) : 0.f;
+            ins.function(ins.a >= 0 ? registers[ins.a] : nullptr, a_value, ins.b >= 0 ? registers[ins.b] : nullptr,
+                         b_value, out, n);
+            registers[ins.dst] = out;
+        }
+    }
+}
+
+ElementwiseLayer::ElementwiseLayer(std::string layer_name, ElementwiseProgram program,
+                                   std::vector<std::vector<int32_t>> input_shapes) :
+    Layer(std::move(layer_name)), program_(std::move(program)), input_shapes_(std::move(input_shapes))
+{
+}
+
+// tiles below which a sample stays on the calling thread
+static constexpr int64_t kParallelTiles = 32;
+
+// strides of input over the (channels, cols, rows) memory order of output
+static bool BroadcastStrides(const data::Tensor<float> &input, const int64_t dims[3], ElementwiseOperand &operand)
+{
+    const int64_t input_dims[3] = {input.channels(), input.cols(), input.rows()};
+    const int64_t input_strides[3] = {static_cast<int64_t>(input.rows()) * input.cols(), input.rows(), 1};
+    for (int d = 0; d < 3; ++d)
+    {
+        if (input_dims[d] == dims[d])
+        {
+            operand.strides[d] = input_strides[d];
+        }
+        else if (input_dims[d] == 1)
+        {
+            operand.strides[d] = 0;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Full shape of an operand in its exported rank. The batch is the number of
+// distinct sample tensors, a constant repeated over the batch has one. The sample
+// dims are right aligned on (channels, rows, cols); dims folded into the channels
+// beyond that are taken from the exported shape.
+static std::vector<int32_t> LogicalShape(const std::vector<int32_t> &exported,
+                                         const std::shared_ptr<data::Tensor<float>> *samples, size_t batch_size)
+{
+    const size_t rank = exported.size();
+    if (rank == 0)
+    {
+        return {};
+    }
+
+    const bool repeated = std::all_of(samples, samples + batch_size,
+                                      [&](const std::shared_ptr<data::Tensor<float>> &t) { return t == samples[0]; });
+    std::vector<int32_t> shape(rank, 1);
+    shape[0] = repeated ? 1 : static_cast<int32_t>(batch_size);
+
+    const data::Tensor<float> &sample = *samples[0];
+    const int32_t dims[3] = {static_cast<int32_t>(sample.channels()), static_cast<int32_t>(sample.rows()),
+                             static_cast<int32_t>(sample.cols())};
+    int64_t folded = 1;
+    for (size_t i = 1; i < rank; ++i)
+    {
+        const size_t from_end = rank - 1 - i;
+        if (from_end < 3)
+        {
+            shape[i] = dims[2 - from_end];
+        }
+        else
+        {
+            shape[i] = std::max(exported[i], 1);
+            folded *= shape[i];
+        }
+    }
+    if (rank > 4)
+    {
+        shape[rank - 3] = static_cast<int32_t>(dims[0] / folded);
+    }
+    return shape;
+}
+
+StatusCode ElementwiseLayer::Forward(const std::vector<std::shared_ptr<data::Tensor<float>>> &inputs,
+                                     std::vector<std::shared_ptr<data::Tensor<float>>> &outputs)
+{
+    const size_t operand_count = input_shapes_.size();
+    if (outputs.empty() || (operand_count != 0 && inputs.size() % operand_count != 0)
+        || (!program_.is_list() && inputs.size() != operand_count * outputs.size()))
+    {
+        LOG(ERROR) << "Elementwise " << layer_name << " has " << inputs.size() << " inputs and " << outputs.size()
+                   << " outputs";
+        return StatusCode::InferInputsEmpty;
+    }
+
+    // a list spreads over the output elements, its inputs all have the same batch
+    const size_t batch_size = operand_count == 0 ? 0 : inputs.size() / operand_count;
+    std::vector<std::vector<int32_t>> shapes(operand_count);
+    for (size_t k = 0; k < operand_count; ++k)
+    {
+        shapes[k] = LogicalShape(input_shapes_[k], inputs.data() + k * batch_size, batch_size);
+    }
+    if (!program_.EvaluateScalars(shapes, scalars_))
+    {
+        LOG(ERROR) << "Elementwise " << layer_name << " reads a size beyond the rank of its input";
+        return StatusCode::InferDimMismatch;
+    }
+
+    if (program_.is_list())
+    {
+        std::vector<double> values;
+        program_.EvaluateShape(shapes, values);
+        size_t written = 0;
+        for (const std::shared_ptr<data::Tensor<float>> &output : outputs)
+        {
+            for (size_t i = 0; i < output->size() && written < values.size(); ++i)
+            {
+                output->data_ptr()[i] = static_cast<float>(values[written++]);
+            }
+        }
+        if (written != values.size())
+        {
+            LOG(ERROR) << "Elementwise " << layer_name << " output can not hold " << values.size() << " values";
+            return StatusCode::InferDimMismatch;
+        }
+        return StatusCode::Success;
+    }
+
+    std::vector<ElementwiseOperand> operands(operand_count);
+    for (size_t b = 0; b < batch_size; ++b)
+    {
+        const std::shared_ptr<data::Tensor<float>> &output = outputs[b];
+        const int64_t dims[3] = {output->channels(), output->cols(), output->rows()};
+        for (size_t k = 0; k < operand_count; ++k)
+        {
+            if (!program_.uses_tensor(static_cast<int>(k)))
+            {
+                continue;
+            }
+            const std::shared_ptr<data::Tensor<float>> &input = inputs[k * batch_size + b];
+            operands[k].data = input->data_ptr();
+            if (!BroadcastStrides(*input, dims, operands[k]))
+            {
+                LOG(ERROR) << "Elementwise " << layer_name << " input " << k << " can not be broadcast to the output";
+                return StatusCode::InferDimMismatch;
+            }
+        }
+        // whole tiles per thread, the calling thread takes the first range and scratch_
+        const int64_t tiles = (dims[0] * dims[1] * dims[2] + ElementwiseProgram::kTileSize - 1)
+                              / ElementwiseProgram::kTileSize;
+        utils::ParallelFor(tiles, 0, kParallelTiles, [&](int64_t begin, int64_t end) {
+            std::vector<float> local_scratch;
+            const int64_t count = dims[0] * dims[1] * dims[2];
+            program_.RunRange(operands, dims, begin * ElementwiseProgram::kTileSize,
+                              std::min(end * ElementwiseProgram::kTileSize, count), output->data_ptr(),
+                              begin == 0 ? scratch_ : local_scratch, scalars_);
+        });
+    }
+    return StatusCode::Success;
+}
+
+bool ElementwiseLayer::SupportsInPlace() const
+{
+    // a tensor program reads every element before it writes that index
+    return !program_.is_list();
+}
+
+StatusCode ElementwiseLayer::Create(const std::shared_ptr<runtime::Operator<float>> &op,
+                                    std::shared_ptr<Layer<float>> &layer)
+{
+    CHECK(op != nullptr) << "Elementwise operator is empty";
+
+    std::string expr;
+    ElementwiseProgram program;
+    if (!GetParameter(*op, "expr", expr) || !program.Compile(expr))
+    {
+        LOG(ERROR) << "Elementwise " << op->name << " has no pointwise or shape expr";
+        return StatusCode::ParseParamError;
+    }
+    if (static_cast<size_t>(program.input_count()) > op->input_operands_seq.size())
+    {
+        LOG(ERROR) << "Elementwise " << op->name << " expr " << expr << " references " << program.input_count()
+                   << " inputs, the operator has " << op->input_operands_seq.size();
+        return StatusCode::ParseParamError;
+    }
+
+    std::vector<std::vector<int32_t>> input_shapes;
+    for (const auto &operand : op->input_operands_seq)
+    {
+        input_shapes.push_back(operand->shapes);
+    }
+    layer = std::make_shared<ElementwiseLayer>(op->name, std::move(program), std::move(input_shapes));
+    return StatusCode::Success;
+}
+
+static LayerRegistererWrapper kElementwiseLayer("jennifer.FusedElementwise", ElementwiseLayer::Create);
+static LayerRegistererWrapper kExpressionLayer("pnnx.Expression", ElementwiseLayer::Create);
+
+} // namespace layer
+} // namespace jennifer
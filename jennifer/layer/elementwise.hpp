@@ -0,0 +1,145 @@
+#ifndef JENNIFER_LAYER_ELEMENTWISE_HPP_
+#define JENNIFER_LAYER_ELEMENTWISE_HPP_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "layer.hpp"
+
+namespace jennifer
+{
+namespace layer
+{
+
+// One operand of a pointwise expression as a strided view over the output index
+// space, dims are ordered slowest first and a zero stride broadcasts the dim
+struct ElementwiseOperand
+{
+    const float *data = nullptr;
+    int64_t strides[3] = {0, 0, 0};
+};
+
+// A pnnx.Expression expr, e.g. mul(@0,sigmoid(@1)) or [int(size(@0,0)),-1],
+// compiled to register code. Besides the pnnx.Expression functions it accepts the
+// activations relu, sigmoid, silu, gelu, gelu_tanh, hardswish, hardsigmoid, mish,
+// softplus, leaky_relu(x,slope) and elu(x,alpha).
+//
+// Subexpressions of numbers and size(@n,dim) are scalars. Constant ones are folded
+// at compile time, the ones reading sizes run as scalar code once per shape. The
+// rest is tensor code: every register holds one tile of kTileSize floats and the
+// program runs instruction by instruction over a tile while it is cache resident,
+// so a whole chain reads its inputs and writes its output once. Temporaries share
+// registers. A list expression has scalar elements only and computes shape values.
+class ElementwiseProgram
+{
+public:
+    static constexpr int kTileSize = 1024;
+
+    // false when expr is neither a pointwise nor a shape expression
+    bool Compile(const std::string &expr);
+
+    // highest @n referenced plus one, inputs take the first registers
+    int input_count() const;
+    int register_count() const;
+    size_t instruction_count() const;
+
+    // false for inputs only referenced through size(), they are not read
+    bool uses_tensor(int input) const;
+    bool is_list() const;
+
+    // the scalar registers for the input shapes, every shape including the batch
+    // dim; false when a size() dim is out of range
+    bool EvaluateScalars(const std::vector<std::vector<int32_t>> &shapes, std::vector<double> &scalars) const;
+
+    // the list elements, or the one value of an expression without tensor inputs
+    bool EvaluateShape(const std::vector<std::vector<int32_t>> &shapes, std::vector<double> &values) const;
+
+    // output holds dims[0] * dims[1] * dims[2] contiguous floats and may alias an
+    // input with the same shape. scratch is resized to the registers of one tile,
+    // scalars comes from EvaluateScalars and may be empty without size() terms.
+    void Run(const std::vector<ElementwiseOperand> &inputs, const int64_t dims[3], float *output,
+             std::vector<float> &scratch, const std::vector<double> &scalars = {}) const;
+
+    // the elements [begin, end) of a tensor Run, begin a multiple of kTileSize, so
+    // that threads with their own scratch can share one output
+    void RunRange(const std::vector<ElementwiseOperand> &inputs, const int64_t dims[3], int64_t begin, int64_t end,
+                  float *output, std::vector<float> &scratch, const std::vector<double> &scalars = {}) const;
+
+private:
+    using TileFunction = void (*)(const float *a, float a_value, const float *b, float b_value, float *out, int n);
+    using ScalarFunction = double (*)(double a, double b);
+
+    // a and b index registers, -1 reads the scalar register a_scalar or b_scalar
+    struct Instruction
+    {
+        TileFunction function;
+        int dst;
+        int a;
+        int b;
+        int a_scalar;
+        int b_scalar;
+    }; // struct Instruction
+
+    // b is -1 for unary functions
+    struct ScalarInstruction
+    {
+        ScalarFunction function;
+        int dst;
+        int a;
+        int b;
+    }; // struct ScalarInstruction
+
+    struct SizeLoad
+    {
+        int dst;
+        int input;
+        int dim;
+    }; // struct SizeLoad
+
+    std::vector<Instruction> instructions_;
+    std::vector<ScalarInstruction> scalar_instructions_;
+    std::vector<SizeLoad> size_loads_;
+    // initial scalar registers, the folded constants
+    std::vector<double> constants_;
+    // scalar registers of the list elements or of a scalar result
+    std::vector<int> results_;
+    std::vector<bool> tensor_inputs_;
+    bool list_ = false;
+    int input_count_ = 0;
+    int register_count_ = 0;
+}; // class ElementwiseProgram
+
+// jennifer.FusedElementwise and pnnx.Expression, the expr param is run by
+// ElementwiseProgram over every sample. Inputs broadcast against the output over
+// the (channels, rows, cols) of data::Tensor, which follows the right aligned
+// broadcasting of the sample shapes. A list expr writes its values one per output
+// element. Large samples are split across the hardware threads by tiles.
+class ElementwiseLayer : public Layer<float>
+{
+public:
+    ElementwiseLayer(std::string layer_name, ElementwiseProgram program, std::vector<std::vector<int32_t>> input_shapes);
+
+    utils::StatusCode Forward(const std::vector<std::shared_ptr<data::Tensor<float>>> &inputs,
+                              std::vector<std::shared_ptr<data::Tensor<float>>> &outputs) override;
+
+    bool SupportsInPlace() const override;
+
+    static utils::StatusCode Create(const std::shared_ptr<runtime::Operator<float>> &op,
+                                    std::shared_ptr<Layer<float>> &layer);
+
+private:
+    ElementwiseProgram program_;
+    // exported input shapes, they give the rank behind each size()
+    std::vector<std::vector<int32_t>> input_shapes_;
+
+    // Forward calls are serialized by RuntimeGraph, scratch_ is the calling thread's
+    std::vector<float> scratch_;
+    std::vector<double> scalars_;
+}; // class ElementwiseLayer
+
+} // namespace layer
+} // namespace jennifer
+
+#endif // JENNIFER_LAYER_ELEMENTWISE_HPP_
@@ -0,0 +1,137 @@
+#ifndef JENNIFER_LAYER_GEMM_KERNEL_HPP_
+#define JENNIFER_LAYER_GEMM_KERNEL_HPP_
+
+namespace jennifer
+{
+namespace layer
+{
+
+// c[m x n] = a[m x k] * b[k x n] + bias[m], every matrix row major
+using GemmKernel = void (*)(int m, int n, int k, const float *a, const float *b, const float *bias, float *c);
+
+// One MR x NR block of c held in registers over the whole k loop. A positive K
+// makes the reduction length a compile time constant.
+template <int MR, int NR, int K>
+inline void GemmBlock(int n, int k_runtime, const float *a, const float *b, const float *bias, float *c)
+{
+    const int k = K > 0 ? K : k_runtime;
+
+    float acc[MR][NR];
+    for (int r = 0; r < MR; ++r)
+    {
+        for (int j = 0; j < NR; ++j)
+        {
+            acc[r][j] = bias != nullptr ? bias[r] : 0.f;
+        }
+    }
+
+    for (int p = 0; p < k; ++p)
+    {
+        float bv[NR];
+        for (int j = 0; j < NR; ++j)
+        {
+            bv[j] = b[p * n + j];
+        }
+        for (int r = 0; r < MR; ++r)
+        {
+            const float av = a[r * k + p];
+            for (int j = 0; j < NR; ++j)
+            {
+                acc[r][j] += av * bv[j];
+            }
+        }
+    }
+
+    for (int r = 0; r < MR; ++r)
+    {
+        for (int j = 0; j < NR; ++j)
+        {
+            c[r * n + j] = acc[r][j];
+        }
+    }
+}
+
+// Tiles c into MR x NR register blocks, the edges fall back to 1 x NR and 1 x 1
+// blocks so any m and n are covered
+template <int MR, int NR, int K = 0>
+void GemmTiled(int m, int n, int k, const float *a, const float *b, const float *bias, float *c)
+{
+    int i = 0;
+    for (; i + MR <= m; i += MR)
+    {
+        int j = 0;
+        for (; j + NR <= n; j += NR)
+        {
+            GemmBlock<MR, NR, K>(n, k, a + i * k, b + j, bias != nullptr ? bias + i : nullptr, c + i * n + j);
+        }
+        for (; j < n; ++j)
+        {
+            GemmBlock<MR, 1, K>(n, k, a + i * k, b + j, bias != nullptr ? bias + i : nullptr, c + i * n + j);
+        }
+    }
+    for (; i < m; ++i)
+    {
+        int j = 0;
+        for (; j + NR <= n; j += NR)
+        {
+            GemmBlock<1, NR, K>(n, k, a + i * k, b + j, bias != nullptr ? bias + i : nullptr, c + i * n + j);
+        }
+        for (; j < n; ++j)
+        {
+            GemmBlock<1, 1, K>(n, k, a + i * k, b + j, bias != nullptr ? bias + i : nullptr, c + i * n + j);
+        }
+    }
+}
+
+// Matrix vector product for n == 1, each row is reduced with KU independent partial
+// sums so the loads of one row are contiguous and the adds do not serialize
+template <int KU>
+void Gemv(int m, int /*n*/, int k, const float *a, const float *b, const float *bias, float *c)
+{
+    for (int i = 0; i < m; ++i)
+    {
+        const float *row = a + i * k;
+        float partial[KU] = {};
+        int p = 0;
+        for (; p + KU <= k; p += KU)
+        {
+            for (int u = 0; u < KU; ++u)
+            {
+                partial[u] += row[p + u] * b[p + u];
+            }
+        }
+
+        float sum = bias != nullptr ? bias[i] : 0.f;
+        for (; p < k; ++p)
+        {
+            sum += row[p] * b[p];
+        }
+        for (int u = 0; u < KU; ++u)
+        {
+            sum += partial[u];
+        }
+        c[i] = sum;
+    }
+}
+
+// reference kernel for any shape, one output element at a time
+inline void GemmGeneric(int m, int n, int k, const float *a, const float *b, const float *bias, float *c)
+{
+    for (int i = 0; i < m; ++i)
+    {
+        for (int j = 0; j < n; ++j)
+        {
+            float sum = bias != nullptr ? bias[i] : 0.f;
+            for (int p = 0; p < k; ++p)
+            {
+                sum += a[i * k + p] * b[p * n + j];
+            }
+            c[i * n + j] = sum;
+        }
+    }
+}
+
+} // namespace layer
+} // namespace jennifer
+
+#endif // JENNIFER_LAYER_GEMM_KERNEL_HPP_
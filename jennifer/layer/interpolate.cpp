@@ -0,0 +1,343 @@
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include "jennifer/utils/parallel.hpp"
+
+#include "interpolate.hpp"
+#include "layer_factory.hpp"
+
+namespace jennifer
+{
+namespace layer
+{
+
+using utils::StatusCode;
+
+// lanes of a vectorized block and the output elements below which work stays on
+// one thread
+static constexpr int64_t kLanes = 8;
+static constexpr int64_t kParallelGrain = 1 << 15;
+
+// input coordinate per output coordinate as torch area_pixel_compute_scale
+static float SourceScale(int64_t in, int64_t out, float factor, bool align_corners)
+{
+    if (align_corners)
+    {
+        return out > 1 ? static_cast<float>(in - 1) / static_cast<float>(out - 1) : 0.f;
+    }
+    return factor > 0.f ? 1.f / factor : static_cast<float>(in) / static_cast<float>(out);
+}
+
+static void NearestTable(int64_t in, int64_t out, float factor, int32_t *index)
+{
+    const float scale = SourceScale(in, out, factor, false);
+    for (int64_t o = 0; o < out; ++o)
+    {
+        index[o] = static_cast<int32_t>(std::min<int64_t>(static_cast<int64_t>(std::floor(o * scale)), in - 1));
+    }
+}
+
+// dst o blends source index0[o] and index1[o] with weight lambda[o] of the second
+static void BilinearTable(int64_t in, int64_t out, float factor, bool align_corners, int32_t *index0,
+                          int32_t *index1, float *lambda)
+{
+    const float scale = SourceScale(in, out, factor, align_corners);
+    for (int64_t o = 0; o < out; ++o)
+    {
+        float source = align_corners ? scale * o : scale * (o + 0.5f) - 0.5f;
+        source = std::max(source, 0.f);
+        const int64_t i0 = std::min<int64_t>(static_cast<int64_t>(source), in - 1);
+        index0[o] = static_cast<int32_t>(i0);
+        index1[o] = static_cast<int32_t>(i0 < in - 1 ? i0 + 1 : i0);
+        lambda[o] = source - static_cast<float>(i0);
+    }
+}
+
+// the integer factor when index is o / factor for every o, 0 otherwise
+static int64_t IntegerFactor(const std::vector<int32_t> &index, int64_t in)
+{
+    const int64_t out = static_cast<int64_t>(index.size());
+    if (out % in != 0)
+    {
+        return 0;
+    }
+    const int64_t factor = out / in;
+    for (int64_t o = 0; o < out; ++o)
+    {
+        if (index[o] != o / factor)
+        {
+            return 0;
+        }
+    }
+    return factor;
+}
+
+// every element of src written K times in a row
+template <int K>
+static void ReplicateRows(const float *src, float *dst, int64_t n)
+{
+    int64_t r = 0;
+    for (; r + kLanes <= n; r += kLanes)
+    {
+        for (int64_t i = 0; i < kLanes; ++i)
+        {
+            for (int j = 0; j < K; ++j)
+            {
+                dst[(r + i) * K + j] = src[r + i];
+            }
+        }
+    }
+    for (; r < n; ++r)
+    {
+        for (int j = 0; j < K; ++j)
+        {
+            dst[r * K + j] = src[r];
+        }
+    }
+}
+
+static void NearestCol(const float *src, float *dst, int64_t in_rows, int64_t out_rows, int64_t row_factor,
+                       const int32_t *row_index)
+{
+    switch (row_factor)
+    {
+    case 1:
+        std::copy(src, src + in_rows, dst);
+        return;
+    case 2:
+        ReplicateRows<2>(src, dst, in_rows);
+        return;
+    case 4:
+        ReplicateRows<4>(src, dst, in_rows);
+        return;
+    default:
+        break;
+    }
+    for (int64_t r = 0; r < out_rows; ++r)
+    {
+        dst[r] = src[row_index[r]];
+    }
+}
+
+static void NearestPlanes(const float *input, float *output, int64_t begin, int64_t end, int64_t in_rows,
+                          int64_t in_cols, int64_t out_rows, int64_t out_cols, const std::vector<int32_t> &row_index,
+                          const std::vector<int32_t> &col_index)
+{
+    const int64_t row_factor = IntegerFactor(row_index, in_rows);
+    for (int64_t ch = begin; ch < end; ++ch)
+    {
+        const float *in = input + ch * in_rows * in_cols;
+        float *out = output + ch * out_rows * out_cols;
+        for (int64_t oc = 0; oc < out_cols; ++oc)
+        {
+            float *dst = out + oc * out_rows;
+            if (oc > 0 && col_index[oc] == col_index[oc - 1])
+            {
+                std::copy(dst - out_rows, dst, dst);
+                continue;
+            }
+            NearestCol(in + col_index[oc] * in_rows, dst, in_rows, out_rows, row_factor, row_index.data());
+        }
+    }
+}
+
+// one source col resized to out_rows
+static void VerticalCol(const float *src, float *dst, int64_t out_rows, const int32_t *index0,
+                        const int32_t *index1, const float *lambda)
+{
+    for (int64_t r = 0; r < out_rows; ++r)
+    {
+        const float a = src[index0[r]];
+        dst[r] = a + (src[index1[r]] - a) * lambda[r];
+    }
+}
+
+static void BlendCols(const float *a, const float *b, float lambda, float *dst, int64_t n)
+{
+    int64_t r = 0;
+    for (; r + kLanes <= n; r += kLanes)
+    {
+        for (int64_t i = 0; i < kLanes; ++i)
+        {
+            dst[r + i] = a[r + i] + (b[r + i] - a[r + i]) * lambda;
+        }
+    }
+    for (; r < n; ++r)
+    {
+        dst[r] = a[r] + (b[r] - a[r]) * lambda;
+    }
+}
+
+struct BilinearTables
+{
+    std::vector<int32_t> row0, row1, col0, col1;
+    std::vector<float> row_lambda, col_lambda;
+}; // struct BilinearTables
+
+static void BilinearPlanes(const float *input, float *output, int64_t begin, int64_t end, int64_t in_rows,
+                           int64_t in_cols, int64_t out_rows, int64_t out_cols, const BilinearTables &tables)
+{
+    std::vector<float> buffer(2 * out_rows);
+    for (int64_t ch = begin; ch < end; ++ch)
+    {
+        const float *in = input + ch * in_rows * in_cols;
+        float *out = output + ch * out_rows * out_cols;
+        // the resized source cols held in a and b
+        float *a = buffer.data();
+        float *b = a + out_rows;
+        int64_t col_a = -1;
+        int64_t col_b = -1;
+        for (int64_t oc = 0; oc < out_cols; ++oc)
+        {
+            const int64_t c0 = tables.col0[oc];
+            const int64_t c1 = tables.col1[oc];
+            if (c0 == col_b)
+            {
+                std::swap(a, b);
+                std::swap(col_a, col_b);
+            }
+            if (c0 != col_a)
+            {
+                VerticalCol(in + c0 * in_rows, a, out_rows, tables.row0.data(), tables.row1.data(),
+                            tables.row_lambda.data());
+                col_a = c0;
+            }
+            if (c1 != col_b)
+            {
+                VerticalCol(in + c1 * in_rows, b, out_rows, tables.row0.data(), tables.row1.data(),
+                            tables.row_lambda.data());
+                col_b = c1;
+            }
+            BlendCols(a, b, tables.col_lambda[oc], out + oc * out_rows, out_rows);
+        }
+    }
+}
+
+void InterpolateKernel(const float *input, float *output, int64_t channels, int64_t in_rows, int64_t in_cols,
+                       int64_t out_rows, int64_t out_cols, InterpolateMode mode, bool align_corners, float row_factor,
+                       float col_factor, int num_threads)
+{
+    if (channels <= 0 || out_rows <= 0 || out_cols <= 0)
+    {
+        return;
+    }
+    CHECK(in_rows > 0 && in_cols > 0) << "Interpolate of an empty plane";
+
+    const int64_t grain = std::max<int64_t>(kParallelGrain / (out_rows * out_cols), 1);
+    if (mode == InterpolateMode::Nearest)
+    {
+        std::vector<int32_t> row_index(out_rows);
+        std::vector<int32_t> col_index(out_cols);
+        NearestTable(in_rows, out_rows, row_factor, row_index.data());
+        NearestTable(in_cols, out_cols, col_factor, col_index.data());
+        utils::ParallelFor(channels, num_threads, grain, [&](int64_t begin, int64_t end) {
+            NearestPlanes(input, output, begin, end, in_rows, in_cols, out_rows, out_cols, row_index, col_index);
+        });
+        return;
+    }
+
+    BilinearTables tables;
+    tables.row0.resize(out_rows);
+    tables.row1.resize(out_rows);
+    tables.row_lambda.resize(out_rows);
+    tables.col0.resize(out_cols);
+    tables.col1.resize(out_cols);
+    tables.col_lambda.resize(out_cols);
+    BilinearTable(in_rows, out_rows, row_factor, align_corners, tables.row0.data(), tables.row1.data(),
+                  tables.row_lambda.data());
+    BilinearTable(in_cols, out_cols, col_factor, align_corners, tables.col0.data(), tables.col1.data(),
+                  tables.col_lambda.data());
+    utils::ParallelFor(channels, num_threads, grain, [&](int64_t begin, int64_t end) {
+        BilinearPlanes(input, output, begin, end, in_rows, in_cols, out_rows, out_cols, tables);
+    });
+}
+
+InterpolateLayer::InterpolateLayer(std::string layer_name, InterpolateMode mode, bool align_corners,
+                                   std::vector<float> scale_factor) :
+    Layer(std::move(layer_name)),
+    mode_(mode), align_corners_(align_corners), scale_factor_(std::move(scale_factor))
+{
+}
+
+StatusCode InterpolateLayer::Forward(const std::vector<std::shared_ptr<data::Tensor<float>>> &inputs,
+                                     std::vector<std::shared_ptr<data::Tensor<float>>> &outputs)
+{
+    if (inputs.empty() || inputs.size() != outputs.size())
+    {
+        LOG(ERROR) << "Interpolate " << layer_name << " has " << inputs.size() << " inputs and " << outputs.size()
+                   << " outputs";
+        return StatusCode::InferInputsEmpty;
+    }
+
+    const float row_factor = scale_factor_.empty() ? 0.f : scale_factor_[0];
+    const float col_factor = scale_factor_.empty() ? 0.f : scale_factor_.back();
+    for (size_t i = 0; i < inputs.size(); ++i)
+    {
+        const data::Tensor<float> &input = *inputs[i];
+        data::Tensor<float> &output = *outputs[i];
+        if (input.channels() != output.channels() || input.empty())
+        {
+            LOG(ERROR) << "Interpolate " << layer_name << " maps " << input.channels() << " channels to "
+                       << output.channels();
+            return StatusCode::InferDimMismatch;
+        }
+        InterpolateKernel(input.data_ptr(), output.data_ptr(), input.channels(), input.rows(), input.cols(),
+                          output.rows(), output.cols(), mode_, align_corners_, row_factor, col_factor, 0);
+    }
+    return StatusCode::Success;
+}
+
+StatusCode InterpolateLayer::Create(const std::shared_ptr<runtime::Operator<float>> &op,
+                                    std::shared_ptr<Layer<float>> &layer)
+{
+    CHECK(op != nullptr) << "Interpolate operator is empty";
+
+    if (op->input_operands_seq.empty() || op->input_operands_seq[0]->shapes.size() != 4)
+    {
+        LOG(ERROR) << "Interpolate " << op->name << " only resizes (N, C, H, W) inputs";
+        return StatusCode::ParseParamError;
+    }
+
+    std::string mode = "nearest";
+    bool align_corners = false;
+    if (op->type == "nn.UpsamplingBilinear2d")
+    {
+        mode = "bilinear";
+        align_corners = true;
+    }
+    else if (op->type != "nn.UpsamplingNearest2d")
+    {
+        GetParameter(*op, "mode", mode);
+        GetParameter(*op, "align_corners", align_corners);
+    }
+    if (mode != "nearest" && mode != "bilinear")
+    {
+        LOG(ERROR) << "Interpolate " << op->name << " mode " << mode << " is not implemented";
+        return StatusCode::FunctionNotImplement;
+    }
+
+    // a given size or recompute_scale_factor derives the scale from the sizes like torch
+    std::vector<float> scale_factor;
+    std::vector<int32_t> size;
+    bool recompute = false;
+    GetParameter(*op, "recompute_scale_factor", recompute);
+    if (!GetParameter(*op, "size", size) && !recompute)
+    {
+        GetParameter(*op, "scale_factor", scale_factor);
+    }
+    layer = std::make_shared<InterpolateLayer>(op->name, mode == "nearest" ? InterpolateMode::Nearest
+                                                                           : InterpolateMode::Bilinear,
+                                               align_corners, scale_factor);
+    return StatusCode::Success;
+}
+
+static LayerRegistererWrapper kUpsampleLayer("nn.Upsample", InterpolateLayer::Create);
+static LayerRegistererWrapper kUpsamplingNearestLayer("nn.UpsamplingNearest2d", InterpolateLayer::Create);
+static LayerRegistererWrapper kUpsamplingBilinearLayer("nn.UpsamplingBilinear2d", InterpolateLayer::Create);
+static LayerRegistererWrapper kInterpolateLayer("F.interpolate", InterpolateLayer::Create);
+static LayerRegistererWrapper kFunctionalUpsampleLayer("F.upsample", InterpolateLayer::Create);
+
+} // namespace layer
+} // namespace jennifer
@@ -0,0 +1,61 @@
+#ifndef JENNIFER_LAYER_INTERPOLATE_HPP_
+#define JENNIFER_LAYER_INTERPOLATE_HPP_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "layer.hpp"
+
+namespace jennifer
+{
+namespace layer
+{
+
+enum class InterpolateMode
+{
+    Nearest,
+    Bilinear,
+}; // enum class InterpolateMode
+
+// Resizes channels planes of in_rows x in_cols into planes of out_rows x out_cols,
+// rows contiguous in every plane as in data::Tensor. Coordinates map to the input
+// as in torch: row_factor and col_factor are the scale_factor of the operator and
+// 0 derives the scale from the sizes, align_corners only applies to bilinear.
+// Source indices and weights are tabulated once per output row and column. An
+// output col that repeats the source col of the previous one is copied, integer
+// nearest factors replicate every input element with stores instead of a gather,
+// and bilinear keeps the two vertically resized source cols of the current output
+// col, so every one is computed once and the horizontal blend runs over contiguous
+// rows. Channels are split across num_threads, 0 takes every hardware thread.
+void InterpolateKernel(const float *input, float *output, int64_t channels, int64_t in_rows, int64_t in_cols,
+                       int64_t out_rows, int64_t out_cols, InterpolateMode mode, bool align_corners, float row_factor,
+                       float col_factor, int num_threads);
+
+// nn.Upsample, nn.UpsamplingNearest2d, nn.UpsamplingBilinear2d, F.interpolate and
+// F.upsample of (N, C, H, W) inputs in nearest or bilinear mode, the output size
+// comes from the output tensor.
+class InterpolateLayer : public Layer<float>
+{
+public:
+    // an empty scale_factor derives the scale from the sizes, one value applies to both dims
+    InterpolateLayer(std::string layer_name, InterpolateMode mode, bool align_corners,
+                     std::vector<float> scale_factor);
+
+    utils::StatusCode Forward(const std::vector<std::shared_ptr<data::Tensor<float>>> &inputs,
+                              std::vector<std::shared_ptr<data::Tensor<float>>> &outputs) override;
+
+    static utils::StatusCode Create(const std::shared_ptr<runtime::Operator<float>> &op,
+                                    std::shared_ptr<Layer<float>> &layer);
+
+private:
+    InterpolateMode mode_;
+    bool align_corners_;
+    std::vector<float> scale_factor_;
+}; // class InterpolateLayer
+
+} // namespace layer
+} // namespace jennifer
+
+#endif // JENNIFER_LAYER_INTERPOLATE_HPP_
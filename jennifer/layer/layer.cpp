@@ -0,0 +1,135 @@
+#include <glog/logging.h>
+
+#include "layer.hpp"
+
+namespace jennifer
+{
+namespace layer
+{
+
+Layer<float>::Layer(std::string layer_name) :
+    layer_name(std::move(layer_name))
+{
+}
+
+utils::StatusCode Layer<float>::Forward(const std::vector<std::shared_ptr<data::Tensor<float>>> &/*inputs*/,
+                                        std::vector<std::shared_ptr<data::Tensor<float>>> &/*outputs*/)
+{
+    LOG(ERROR) << "Layer " << layer_name << " does not implement Forward";
+    return utils::StatusCode::FunctionNotImplement;
+}
+
+bool Layer<float>::SupportsInPlace() const
+{
+    return false;
+}
+
+bool Layer<float>::IsView() const
+{
+    return false;
+}
+
+const std::string &Layer<float>::name() const
+{
+    return layer_name;
+}
+
+template <typename P>
+static const P *FindParameter(const runtime::Operator<float> &op, const std::string &key)
+{
+    auto it = op.params.find(key);
+    if (it == op.params.end())
+    {
+        return nullptr;
+    }
+    return dynamic_cast<const P *>(it->second.get());
+}
+
+bool GetParameter(const runtime::Operator<float> &op, const std::string &key, bool &value)
+{
+    const runtime::ParameterBool *param = FindParameter<runtime::ParameterBool>(op, key);
+    if (param == nullptr)
+    {
+        return false;
+    }
+    value = param->value;
+    return true;
+}
+
+bool GetParameter(const runtime::Operator<float> &op, const std::string &key, int32_t &value)
+{
+    if (const runtime::ParameterInt *param = FindParameter<runtime::ParameterInt>(op, key))
+    {
+        value = param->value;
+        return true;
+    }
+    const runtime::ParameterIntArray *array = FindParameter<runtime::ParameterIntArray>(op, key);
+    if (array == nullptr || array->value.size() != 1)
+    {
+        return false;
+    }
+    value = array->value[0];
+    return true;
+}
+
+bool GetParameter(const runtime::Operator<float> &op, const std::string &key, float &value)
+{
+    if (const runtime::ParameterFloat *param = FindParameter<runtime::ParameterFloat>(op, key))
+    {
+        value = param->value;
+        return true;
+    }
+    const runtime::ParameterInt *param = FindParameter<runtime::ParameterInt>(op, key);
+    if (param == nullptr)
+    {
+        return false;
+    }
+    value = static_cast<float>(param->value);
+    return true;
+}
+
+bool GetParameter(const runtime::Operator<float> &op, const std::string &key, std::string &value)
+{
+    const runtime::ParameterString *param = FindParameter<runtime::ParameterString>(op, key);
+    if (param == nullptr)
+    {
+        return false;
+    }
+    value = param->value;
+    return true;
+}
+
+bool GetParameter(const runtime::Operator<float> &op, const std::string &key, std::vector<int32_t> &value)
+{
+    const runtime::ParameterIntArray *param = FindParameter<runtime::ParameterIntArray>(op, key);
+    if (param == nullptr)
+    {
+        return false;
+    }
+    value = param->value;
+    return true;
+}
+
+bool GetParameter(const runtime::Operator<float> &op, const std::string &key, std::vector<float> &value)
+{
+    if (const runtime::ParameterFloatArray *param = FindParameter<runtime::ParameterFloatArray>(op, key))
+    {
+        value = param->value;
+        return true;
+    }
+    if (const runtime::ParameterIntArray *param = FindParameter<runtime::ParameterIntArray>(op, key))
+    {
+        value.assign(param->value.begin(), param->value.end());
+        return true;
+    }
+    float single = 0.f;
+    if (!GetParameter(op, key, single))
+    {
+        return false;
+    }
+    value.assign(1, single);
+    return true;
+}
+
+} // namespace layer
+} // namespace jennifer
@@ -1,7 +1,13 @@
 #ifndef JENNIFER_LAYER_LAYER_HPP_
 #define JENNIFER_LAYER_LAYER_HPP_
 
+#include <memory>
 #include <string>
+#include <vector>
+
+#include "jennifer/data/tensor.hpp"
+#include "jennifer/runtime/operator.hpp"
+#include "jennifer/utils/common.hpp"
 
 namespace jennifer
 {
@@ -15,11 +21,42 @@ template <>
 class Layer<float>
 {
 public:
+    explicit Layer(std::string layer_name);
+    virtual ~Layer() = default;
+
+    // inputs holds the batch tensors of every input operand, concatenated in operator
+    // input order, a constant operand is repeated for every sample; outputs holds the
+    // batch tensors of the output operand, already allocated with their planned shapes
+    virtual utils::StatusCode Forward(const std::vector<std::shared_ptr<data::Tensor<float>>> &inputs,
+                                      std::vector<std::shared_ptr<data::Tensor<float>>> &outputs);
+
+    // true when Forward gives the same result with an output tensor sharing the
+    // storage of an input tensor of the same shape, so the runtime may run the
+    // layer in place on an input nothing reads afterwards
+    virtual bool SupportsInPlace() const;
+
+    // true when Forward only reinterprets the elements of its first input in the
+    // output shape, so an output whose elements are stored in the same order may
+    // be handed the storage of that input and Forward skips it
+    virtual bool IsView() const;
+
+    const std::string &name() const;
+
 protected:
     std::string layer_name;
 
 }; // class Layer
 
+// typed parameter lookups, false when the operator has no such key or it holds
+// another type; an int array of one element also reads as an int
+bool GetParameter(const runtime::Operator<float> &op, const std::string &key, bool &value);
+bool GetParameter(const runtime::Operator<float> &op, const std::string &key, int32_t &value);
+bool GetParameter(const runtime::Operator<float> &op, const std::string &key, float &value);
+bool GetParameter(const runtime::Operator<float> &op, const std::string &key, std::string &value);
+bool GetParameter(const runtime::Operator<float> &op, const std::string &key, std::vector<int32_t> &value);
+// a float array, a single float or ints converted
+bool GetParameter(const runtime::Operator<float> &op, const std::string &key, std::vector<float> &value);
+
 } // namespace layer
 } // namespace jennifer
 
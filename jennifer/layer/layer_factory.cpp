@@ -0,0 +1,94 @@
+#include <glog/logging.h>
+
+#include "layer_factory.hpp"
+
+namespace jennifer
+{
+namespace layer
+{
+
+std::map<std::string, LayerRegisterer::Creator> &LayerRegisterer::CreatorRegistry()
+{
+    static std::map<std::string, Creator> *registry = new std::map<std::string, Creator>();
+    return *registry;
+}
+
+std::map<std::string, LayerRegisterer::KernelSelector> &LayerRegisterer::SelectorRegistry()
+{
+    static std::map<std::string, KernelSelector> *registry = new std::map<std::string, KernelSelector>();
+    return *registry;
+}
+
+void LayerRegisterer::RegisterCreator(const std::string &kernel, const Creator &creator)
+{
+    CHECK(creator != nullptr) << "Layer creator for " << kernel << " is empty";
+    std::map<std::string, Creator> &registry = CreatorRegistry();
+    CHECK_EQ(registry.count(kernel), 0) << "Layer " << kernel << " has already been registered";
+    registry.insert({kernel, creator});
+}
+
+void LayerRegisterer::RegisterSelector(const std::string &type, const KernelSelector &selector)
+{
+    CHECK(selector != nullptr) << "Kernel selector for " << type << " is empty";
+    std::map<std::string, KernelSelector> &registry = SelectorRegistry();
+    CHECK_EQ(registry.count(type), 0) << "Kernel selector " << type << " has already been registered";
+    registry.insert({type, selector});
+}
+
+bool LayerRegisterer::HasCreator(const std::string &kernel)
+{
+    return CreatorRegistry().count(kernel) != 0;
+}
+
+std::string LayerRegisterer::SelectKernel(const std::shared_ptr<runtime::Operator<float>> &op,
+                                          const std::vector<std::vector<int32_t>> &input_shapes,
+                                          const std::vector<std::vector<int32_t>> &output_shapes)
+{
+    CHECK(op != nullptr) << "Operator is empty";
+    const std::map<std::string, KernelSelector> &registry = SelectorRegistry();
+    auto it = registry.find(op->type);
+    if (it == registry.end())
+    {
+        return op->type;
+    }
+
+    std::string kernel = it->second(op, input_shapes, output_shapes);
+    if (!HasCreator(kernel))
+    {
+        LOG(WARNING) << "Kernel " << kernel << " selected for " << op->name << " is not registered, use " << op->type;
+        return op->type;
+    }
+    return kernel;
+}
+
+std::shared_ptr<Layer<float>> LayerRegisterer::CreateLayer(const std::string &kernel,
+                                                           const std::shared_ptr<runtime::Operator<float>> &op)
+{
+    CHECK(op != nullptr) << "Operator is empty";
+    const std::map<std::string, Creator> &registry = CreatorRegistry();
+    auto it = registry.find(kernel);
+    CHECK(it != registry.end()) << "Can not find the layer " << kernel << " for operator " << op->name;
+
+    std::shared_ptr<Layer<float>> layer;
+    const utils::StatusCode status = it->second(op, layer);
+    if (status != utils::StatusCode::Success || layer == nullptr)
+    {
+        LOG(ERROR) << "Create the layer " << kernel << " for operator " << op->name << " failed, status "
+                   << static_cast<int>(status);
+        return nullptr;
+    }
+    return layer;
+}
+
+std::vector<std::string> LayerRegisterer::RegisteredKernels()
+{
+    std::vector<std::string> kernels;
+    for (const auto &it : CreatorRegistry())
+    {
+        kernels.push_back(it.first);
+    }
+    return kernels;
+}
+
+} // namespace layer
+} // namespace jennifer
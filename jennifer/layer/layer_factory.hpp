@@ -0,0 +1,69 @@
+#ifndef JENNIFER_LAYER_LAYER_FACTORY_HPP_
+#define JENNIFER_LAYER_LAYER_FACTORY_HPP_
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "jennifer/runtime/operator.hpp"
+#include "jennifer/utils/common.hpp"
+
+#include "layer.hpp"
+
+namespace jennifer
+{
+namespace layer
+{
+
+class LayerRegisterer
+{
+public:
+    using Creator = std::function<utils::StatusCode(const std::shared_ptr<runtime::Operator<float>> &op,
+                                                    std::shared_ptr<Layer<float>> &layer)>;
+
+    // picks the registry key of the kernel that runs op for the given concrete shapes
+    using KernelSelector = std::function<std::string(const std::shared_ptr<runtime::Operator<float>> &op,
+                                                     const std::vector<std::vector<int32_t>> &input_shapes,
+                                                     const std::vector<std::vector<int32_t>> &output_shapes)>;
+
+    static void RegisterCreator(const std::string &kernel, const Creator &creator);
+    static void RegisterSelector(const std::string &type, const KernelSelector &selector);
+
+    static bool HasCreator(const std::string &kernel);
+
+    // falls back to the operator type when no selector is registered for it
+    static std::string SelectKernel(const std::shared_ptr<runtime::Operator<float>> &op,
+                                    const std::vector<std::vector<int32_t>> &input_shapes,
+                                    const std::vector<std::vector<int32_t>> &output_shapes);
+
+    // returns nullptr when the creator rejects the operator
+    static std::shared_ptr<Layer<float>> CreateLayer(const std::string &kernel,
+                                                     const std::shared_ptr<runtime::Operator<float>> &op);
+
+    static std::vector<std::string> RegisteredKernels();
+
+private:
+    static std::map<std::string, Creator> &CreatorRegistry();
+    static std::map<std::string, KernelSelector> &SelectorRegistry();
+}; // class LayerRegisterer
+
+class LayerRegistererWrapper
+{
+public:
+    LayerRegistererWrapper(const std::string &kernel, const LayerRegisterer::Creator &creator)
+    {
+        LayerRegisterer::RegisterCreator(kernel, creator);
+    }
+
+    LayerRegistererWrapper(const std::string &type, const LayerRegisterer::KernelSelector &selector)
+    {
+        LayerRegisterer::RegisterSelector(type, selector);
+    }
+}; // class LayerRegistererWrapper
+
+} // namespace layer
+} // namespace jennifer
+
+#endif // JENNIFER_LAYER_LAYER_FACTORY_HPP_
@@ -0,0 +1,309 @@
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include "jennifer/utils/parallel.hpp"
+
+#include "layer_factory.hpp"
+#include "layer_norm.hpp"
+
+namespace jennifer
+{
+namespace layer
+{
+
+using utils::StatusCode;
+
+// lanes of a vectorized block, state kept per run of inner elements and the
+// elements below which work stays on one thread
+static constexpr int64_t kLanes = 8;
+static constexpr int64_t kInnerRun = 256;
+static constexpr int64_t kParallelGrain = 1 << 15;
+
+// y = (x - mean) * scale[a] + shift[a] for n elements of a row
+static inline void NormalizeRun(const float *x, float *y, int64_t n, const float *mean, const float *rstd,
+                                int64_t mean_step, float weight, float bias)
+{
+    int64_t i = 0;
+    for (; i + kLanes <= n; i += kLanes)
+    {
+        float block[kLanes];
+        for (int64_t k = 0; k < kLanes; ++k)
+        {
+            block[k] = (x[i + k] - mean[(i + k) * mean_step]) * (rstd[(i + k) * mean_step] * weight) + bias;
+        }
+        std::copy(block, block + kLanes, y + i);
+    }
+    for (; i < n; ++i)
+    {
+        y[i] = (x[i] - mean[i * mean_step]) * (rstd[i * mean_step] * weight) + bias;
+    }
+}
+
+// n <= kInnerRun contiguous normalizations, element a of normalization i at input[a * inner + i]
+static void LayerNormInnerRun(const float *input, float *output, int64_t axis, int64_t inner, int64_t n,
+                              const float *weight, const float *bias, float eps)
+{
+    float mean[kInnerRun];
+    float m2[kInnerRun];
+    std::fill(mean, mean + n, 0.f);
+    std::fill(m2, m2 + n, 0.f);
+    for (int64_t a = 0; a < axis; ++a)
+    {
+        const float *x = input + a * inner;
+        const float inv = 1.f / static_cast<float>(a + 1);
+        int64_t i = 0;
+        for (; i + kLanes <= n; i += kLanes)
+        {
+            for (int64_t k = 0; k < kLanes; ++k)
+            {
+                const float delta = x[i + k] - mean[i + k];
+                mean[i + k] += delta * inv;
+                m2[i + k] += delta * (x[i + k] - mean[i + k]);
+            }
+        }
+        for (; i < n; ++i)
+        {
+            const float delta = x[i] - mean[i];
+            mean[i] += delta * inv;
+            m2[i] += delta * (x[i] - mean[i]);
+        }
+    }
+
+    // m2 becomes the reciprocal standard deviation
+    for (int64_t i = 0; i < n; ++i)
+    {
+        m2[i] = 1.f / std::sqrt(m2[i] / static_cast<float>(axis) + eps);
+    }
+    for (int64_t a = 0; a < axis; ++a)
+    {
+        NormalizeRun(input + a * inner, output + a * inner, n, mean, m2, 1, weight[a], bias[a]);
+    }
+}
+
+// one normalization over axis contiguous elements
+static void LayerNormRow(const float *x, float *y, int64_t axis, const float *weight, const float *bias, float eps)
+{
+    // every lane sees the same count, merged by the parallel Welford update below
+    float mean[kLanes] = {};
+    float m2[kLanes] = {};
+    int64_t a = 0;
+    for (int64_t count = 1; a + kLanes <= axis; a += kLanes, ++count)
+    {
+        const float inv = 1.f / static_cast<float>(count);
+        for (int64_t k = 0; k < kLanes; ++k)
+        {
+            const float delta = x[a + k] - mean[k];
+            mean[k] += delta * inv;
+            m2[k] += delta * (x[a + k] - mean[k]);
+        }
+    }
+
+    double n = static_cast<double>(a / kLanes);
+    double total_mean = 0.0;
+    double total_m2 = 0.0;
+    double total_n = 0.0;
+    auto merge = [&](double mean_b, double m2_b, double n_b) {
+        if (n_b == 0.0)
+        {
+            return;
+        }
+        const double merged = total_n + n_b;
+        const double delta = mean_b - total_mean;
+        total_mean += delta * n_b / merged;
+        total_m2 += m2_b + delta * delta * total_n * n_b / merged;
+        total_n = merged;
+    };
+    for (int64_t k = 0; k < kLanes; ++k)
+    {
+        merge(mean[k], m2[k], n);
+    }
+    for (; a < axis; ++a)
+    {
+        merge(x[a], 0.0, 1.0);
+    }
+
+    const float row_mean = static_cast<float>(total_mean);
+    const float rstd = static_cast<float>(1.0 / std::sqrt(total_m2 / static_cast<double>(axis) + eps));
+    a = 0;
+    for (; a + kLanes <= axis; a += kLanes)
+    {
+        float block[kLanes];
+        for (int64_t k = 0; k < kLanes; ++k)
+        {
+            block[k] = (x[a + k] - row_mean) * (rstd * weight[a + k]) + bias[a + k];
+        }
+        std::copy(block, block + kLanes, y + a);
+    }
+    for (; a < axis; ++a)
+    {
+        y[a] = (x[a] - row_mean) * (rstd * weight[a]) + bias[a];
+    }
+}
+
+void LayerNormKernel(const float *input, float *output, int64_t outer, int64_t axis, int64_t inner,
+                     const float *weight, const float *bias, float eps, int num_threads)
+{
+    std::vector<float> ones;
+    std::vector<float> zeros;
+    if (weight == nullptr || bias == nullptr)
+    {
+        ones.assign(axis, 1.f);
+        zeros.assign(axis, 0.f);
+        weight = weight != nullptr ? weight : ones.data();
+        bias = bias != nullptr ? bias : zeros.data();
+    }
+
+    if (inner == 1)
+    {
+        utils::ParallelFor(outer, num_threads, std::max<int64_t>(kParallelGrain / axis, 1),
+                           [&](int64_t begin, int64_t end) {
+                               for (int64_t o = begin; o < end; ++o)
+                               {
+                                   LayerNormRow(input + o * axis, output + o * axis, axis, weight, bias, eps);
+                               }
+                           });
+        return;
+    }
+
+    const int64_t runs = (inner + kInnerRun - 1) / kInnerRun;
+    utils::ParallelFor(outer * runs, num_threads, std::max<int64_t>(kParallelGrain / (axis * kInnerRun), 1),
+                       [&](int64_t begin, int64_t end) {
+                           for (int64_t t = begin; t < end; ++t)
+                           {
+                               const int64_t offset = t / runs * axis * inner + t % runs * kInnerRun;
+                               LayerNormInnerRun(input + offset, output + offset, axis, inner,
+                                                 std::min(kInnerRun, inner - t % runs * kInnerRun), weight, bias,
+                                                 eps);
+                           }
+                       });
+}
+
+LayerNormLayer::LayerNormLayer(std::string layer_name, std::vector<int32_t> normalized_shape, float eps,
+                               std::vector<float> weight, std::vector<float> bias) :
+    Layer(std::move(layer_name)), normalized_shape_(std::move(normalized_shape)), eps_(eps),
+    weight_(std::move(weight)), bias_(std::move(bias))
+{
+}
+
+StatusCode LayerNormLayer::Forward(const std::vector<std::shared_ptr<data::Tensor<float>>> &inputs,
+                                   std::vector<std::shared_ptr<data::Tensor<float>>> &outputs)
+{
+    if (inputs.empty() || inputs.size() != outputs.size())
+    {
+        LOG(ERROR) << "LayerNorm " << layer_name << " has " << inputs.size() << " inputs and " << outputs.size()
+                   << " outputs";
+        return StatusCode::InferInputsEmpty;
+    }
+
+    for (size_t i = 0; i < inputs.size(); ++i)
+    {
+        const data::Tensor<float> &input = *inputs[i];
+        data::Tensor<float> &output = *outputs[i];
+        const int32_t dims[3] = {static_cast<int32_t>(input.channels()), static_cast<int32_t>(input.rows()),
+                                 static_cast<int32_t>(input.cols())};
+        const size_t k = normalized_shape_.size();
+        if (!std::equal(normalized_shape_.begin(), normalized_shape_.end(), dims + 3 - k)
+            || output.size() != input.size())
+        {
+            LOG(ERROR) << "LayerNorm " << layer_name << " input does not end in its normalized shape";
+            return StatusCode::InferDimMismatch;
+        }
+
+        // one dim strides by rows through every channel, more dims are contiguous
+        const int64_t plane = static_cast<int64_t>(dims[1]) * dims[2];
+        const int64_t outer = k == 3 ? 1 : dims[0];
+        const int64_t axis = k == 1 ? dims[2] : (k == 2 ? plane : plane * dims[0]);
+        const int64_t inner = k == 1 ? dims[1] : 1;
+        LayerNormKernel(input.data_ptr(), output.data_ptr(), outer, axis, inner,
+                        weight_.empty() ? nullptr : weight_.data(), bias_.empty() ? nullptr : bias_.data(), eps_, 0);
+    }
+    return StatusCode::Success;
+}
+
+// row major (channels, rows, cols) values of the normalized shape in the
+// (channels, cols, rows) memory order of data::Tensor
+static std::vector<float> MemoryOrder(const std::vector<float> &values, const std::vector<int32_t> &shape)
+{
+    if (shape.size() == 1 || values.empty())
+    {
+        return values;
+    }
+    const int64_t rows = shape[shape.size() - 2];
+    const int64_t cols = shape.back();
+    std::vector<float> ordered(values.size());
+    for (size_t p = 0; p < values.size(); p += rows * cols)
+    {
+        for (int64_t r = 0; r < rows; ++r)
+        {
+            for (int64_t c = 0; c < cols; ++c)
+            {
+                ordered[p + c * rows + r] = values[p + r * cols + c];
+            }
+        }
+    }
+    return ordered;
+}
+
+bool LayerNormLayer::SupportsInPlace() const
+{
+    return true;
+}
+
+StatusCode LayerNormLayer::Create(const std::shared_ptr<runtime::Operator<float>> &op,
+                                  std::shared_ptr<Layer<float>> &layer)
+{
+    CHECK(op != nullptr) << "LayerNorm operator is empty";
+
+    std::vector<int32_t> normalized_shape;
+    if (!GetParameter(*op, "normalized_shape", normalized_shape) || normalized_shape.empty()
+        || normalized_shape.size() > 3 || op->input_operands_seq.empty())
+    {
+        LOG(ERROR) << "LayerNorm " << op->name << " needs a normalized_shape of one to three dims";
+        return StatusCode::ParseParamError;
+    }
+    // three dims have to be the whole sample, more would be folded into the channels
+    const size_t rank = op->input_operands_seq[0]->shapes.size();
+    if (normalized_shape.size() == 3 && rank != 4)
+    {
+        LOG(ERROR) << "LayerNorm " << op->name << " normalizes three dims of a rank " << rank << " input";
+        return StatusCode::ParseParamError;
+    }
+
+    float eps = 1e-5f;
+    GetParameter(*op, "eps", eps);
+
+    int64_t count = 1;
+    for (int32_t d : normalized_shape)
+    {
+        count *= d;
+    }
+    std::vector<float> weight;
+    std::vector<float> bias;
+    for (const char *key : {"weight", "bias"})
+    {
+        auto it = op->attrs.find(key);
+        if (it == op->attrs.end() || it->second->weight.empty())
+        {
+            continue;
+        }
+        std::vector<float> values = it->second->get<float>(false);
+        if (static_cast<int64_t>(values.size()) != count)
+        {
+            LOG(ERROR) << "LayerNorm " << op->name << " " << key << " size " << values.size()
+                       << " does not match the normalized shape";
+            return StatusCode::ParseWeightError;
+        }
+        (key[0] == 'w' ? weight : bias) = MemoryOrder(values, normalized_shape);
+    }
+
+    layer = std::make_shared<LayerNormLayer>(op->name, std::move(normalized_shape), eps, std::move(weight),
+                                             std::move(bias));
+    return StatusCode::Success;
+}
+
+static LayerRegistererWrapper kLayerNormLayer("nn.LayerNorm", LayerNormLayer::Create);
+
+} // namespace layer
+} // namespace jennifer
@@ -0,0 +1,51 @@
+#ifndef JENNIFER_LAYER_LAYER_NORM_HPP_
+#define JENNIFER_LAYER_LAYER_NORM_HPP_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "layer.hpp"
+
+namespace jennifer
+{
+namespace layer
+{
+
+// Layer normalization along the axis of an [outer, axis, inner] view of contiguous
+// floats, y = (x - mean) / sqrt(var + eps) * weight[a] + bias[a]. Mean and variance
+// come from one Welford pass, the second pass normalizes and applies the affine
+// transform together. Vectorized and threaded like SoftmaxKernel; weight and bias
+// may be nullptr for no affine transform and output may be input.
+void LayerNormKernel(const float *input, float *output, int64_t outer, int64_t axis, int64_t inner,
+                     const float *weight, const float *bias, float eps, int num_threads);
+
+// nn.LayerNorm over the last one to three dims of the sample. One dim normalizes
+// the cols of data::Tensor, more dims normalize whole contiguous planes, for which
+// weight and bias are stored in memory order.
+class LayerNormLayer : public Layer<float>
+{
+public:
+    LayerNormLayer(std::string layer_name, std::vector<int32_t> normalized_shape, float eps, std::vector<float> weight,
+                   std::vector<float> bias);
+
+    utils::StatusCode Forward(const std::vector<std::shared_ptr<data::Tensor<float>>> &inputs,
+                              std::vector<std::shared_ptr<data::Tensor<float>>> &outputs) override;
+
+    bool SupportsInPlace() const override;
+
+    static utils::StatusCode Create(const std::shared_ptr<runtime::Operator<float>> &op,
+                                    std::shared_ptr<Layer<float>> &layer);
+
+private:
+    std::vector<int32_t> normalized_shape_;
+    float eps_;
+    std::vector<float> weight_;
+    std::vector<float> bias_;
+}; // class LayerNormLayer
+
+} // namespace layer
+} // namespace jennifer
+
+#endif // JENNIFER_LAYER_LAYER_NORM_HPP_
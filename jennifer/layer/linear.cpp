@@ -0,0 +1,128 @@
+#include <glog/logging.h>
+
+#include "layer_factory.hpp"
+#include "linear.hpp"
+
+namespace jennifer
+{
+namespace layer
+{
+
+using utils::StatusCode;
+
+LinearLayer::LinearLayer(std::string layer_name, int in_features, int out_features, std::vector<float> weight,
+                         std::vector<float> bias, GemmKernel kernel) :
+    Layer(std::move(layer_name)), in_features_(in_features), out_features_(out_features),
+    weight_(weight.begin(), weight.end()), bias_(std::move(bias)), kernel_(kernel)
+{
+}
+
+StatusCode LinearLayer::Forward(const std::vector<std::shared_ptr<data::Tensor<float>>> &inputs,
+                                std::vector<std::shared_ptr<data::Tensor<float>>> &outputs)
+{
+    if (inputs.empty() || inputs.size() != outputs.size())
+    {
+        LOG(ERROR) << "Linear " << layer_name << " has " << inputs.size() << " inputs and " << outputs.size() << " outputs";
+        return StatusCode::InferInputsEmpty;
+    }
+
+    for (size_t i = 0; i < inputs.size(); ++i)
+    {
+        const std::shared_ptr<data::Tensor<float>> &input = inputs[i];
+        const std::shared_ptr<data::Tensor<float>> &output = outputs[i];
+
+        const int rows = static_cast<int>(input->rows());
+        if (static_cast<int>(input->cols()) != in_features_ || static_cast<int>(output->cols()) != out_features_
+            || static_cast<int>(output->rows()) != rows || output->channels() != input->channels())
+        {
+            LOG(ERROR) << "Linear " << layer_name << " input or output shape does not match the weight";
+            return StatusCode::InferDimMismatch;
+        }
+
+        for (uint32_t c = 0; c < input->channels(); ++c)
+        {
+            kernel_(out_features_, rows, in_features_, weight_.data(), input->matrix_data_ptr(c),
+                    bias_.empty() ? nullptr : bias_.data(), output->matrix_data_ptr(c));
+        }
+    }
+    return StatusCode::Success;
+}
+
+StatusCode LinearLayer::Create(const std::shared_ptr<runtime::Operator<float>> &op, GemmKernel kernel,
+                               std::shared_ptr<Layer<float>> &layer)
+{
+    CHECK(op != nullptr) << "Linear operator is empty";
+
+    int32_t in_features = 0;
+    int32_t out_features = 0;
+    if (!GetParameter(*op, "in_features", in_features) || !GetParameter(*op, "out_features", out_features))
+    {
+        LOG(ERROR) << "Linear " << op->name << " misses in_features or out_features";
+        return StatusCode::ParseParamError;
+    }
+
+    auto weight_it = op->attrs.find("weight");
+    if (weight_it == op->attrs.end() || weight_it->second->weight.empty())
+    {
+        LOG(ERROR) << "Linear " << op->name << " has no weight";
+        return StatusCode::ParseWeightError;
+    }
+    std::vector<float> weight = weight_it->second->get<float>(false);
+    if (weight.size() != static_cast<size_t>(in_features) * out_features)
+    {
+        LOG(ERROR) << "Linear " << op->name << " weight size " << weight.size() << " does not match its shape";
+        return StatusCode::ParseWeightError;
+    }
+
+    std::vector<float> bias;
+    auto bias_it = op->attrs.find("bias");
+    if (bias_it != op->attrs.end() && !bias_it->second->weight.empty())
+    {
+        bias = bias_it->second->get<float>(false);
+        if (bias.size() != static_cast<size_t>(out_features))
+        {
+            LOG(ERROR) << "Linear " << op->name << " bias size " << bias.size() << " does not match out features";
+            return StatusCode::ParseWeightError;
+        }
+    }
+
+    layer = std::make_shared<LinearLayer>(op->name, in_features, out_features, std::move(weight), std::move(bias), kernel);
+    return StatusCode::Success;
+}
+
+std::string LinearLayer::SelectKernel(const std::shared_ptr<runtime::Operator<float>> &op,
+                                      const std::vector<std::vector<int32_t>> &input_shapes,
+                                      const std::vector<std::vector<int32_t>> &/*output_shapes*/)
+{
+    // the rows of a sample are the dims between the batch and the features
+    if (input_shapes.empty() || input_shapes[0].size() < 2)
+    {
+        return op->type;
+    }
+    int64_t rows = 1;
+    for (size_t i = 1; i + 1 < input_shapes[0].size(); ++i)
+    {
+        rows *= input_shapes[0][i];
+    }
+    return rows == 1 ? "nn.Linear.gemv" : "nn.Linear.gemm4x8";
+}
+
+static LayerRegistererWrapper kLinearSelector("nn.Linear", LayerRegisterer::KernelSelector(LinearLayer::SelectKernel));
+
+static LayerRegistererWrapper kLinearLayer("nn.Linear",
+                                           [](const std::shared_ptr<runtime::Operator<float>> &op, std::shared_ptr<Layer<float>> &layer) {
+                                               return LinearLayer::Create(op, GemmGeneric, layer);
+                                           });
+
+static LayerRegistererWrapper kLinearGemvLayer("nn.Linear.gemv",
+                                               [](const std::shared_ptr<runtime::Operator<float>> &op, std::shared_ptr<Layer<float>> &layer) {
+                                                   return LinearLayer::Create(op, Gemv<8>, layer);
+                                               });
+
+static LayerRegistererWrapper kLinearGemmLayer("nn.Linear.gemm4x8",
+                                               [](const std::shared_ptr<runtime::Operator<float>> &op, std::shared_ptr<Layer<float>> &layer) {
+                                                   return LinearLayer::Create(op, GemmTiled<4, 8>, layer);
+                                               });
+
+} // namespace layer
+} // namespace jennifer
@@ -0,0 +1,49 @@
+#ifndef JENNIFER_LAYER_LINEAR_HPP_
+#define JENNIFER_LAYER_LINEAR_HPP_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "jennifer/utils/huge_pages.hpp"
+
+#include "gemm_kernel.hpp"
+#include "layer.hpp"
+
+namespace jennifer
+{
+namespace layer
+{
+
+// nn.Linear as one gemm per channel of the sample. A (rows x in_features) slice of
+// data::Tensor is column major, that is a row major in_features x rows matrix, so
+// the output slice is weight (out_features x in_features) times the input slice.
+class LinearLayer : public Layer<float>
+{
+public:
+    LinearLayer(std::string layer_name, int in_features, int out_features, std::vector<float> weight,
+                std::vector<float> bias, GemmKernel kernel);
+
+    utils::StatusCode Forward(const std::vector<std::shared_ptr<data::Tensor<float>>> &inputs,
+                              std::vector<std::shared_ptr<data::Tensor<float>>> &outputs) override;
+
+    static utils::StatusCode Create(const std::shared_ptr<runtime::Operator<float>> &op, GemmKernel kernel,
+                                    std::shared_ptr<Layer<float>> &layer);
+
+    // nn.Linear.gemv when every sample is a single row, nn.Linear.gemm4x8 otherwise
+    static std::string SelectKernel(const std::shared_ptr<runtime::Operator<float>> &op,
+                                    const std::vector<std::vector<int32_t>> &input_shapes,
+                                    const std::vector<std::vector<int32_t>> &output_shapes);
+
+private:
+    int in_features_;
+    int out_features_;
+    utils::HugeVector<float> weight_;
+    std::vector<float> bias_;
+    GemmKernel kernel_;
+}; // class LinearLayer
+
+} // namespace layer
+} // namespace jennifer
+
+#endif // JENNIFER_LAYER_LINEAR_HPP_
@@ -0,0 +1,116 @@
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "layer_factory.hpp"
+#include "reshape.hpp"
+#include "transpose.hpp"
+
+namespace jennifer
+{
+namespace layer
+{
+
+using utils::StatusCode;
+
+// a plane with a single row or col is stored in row-major order
+static bool RowMajorPlanes(const data::Tensor<float> &tensor)
+{
+    return tensor.rows() == 1 || tensor.cols() == 1;
+}
+
+// copies between the planes of tensor and the row-major order of the same dims
+static void TransposePlanes(const data::Tensor<float> &tensor, const float *src, float *dst, bool to_row_major)
+{
+    const int64_t rows = tensor.rows();
+    const int64_t cols = tensor.cols();
+    const int64_t shape[3] = {tensor.channels(), rows, cols};
+    const int64_t planes[3] = {rows * cols, 1, rows};
+    const int64_t row_major[3] = {rows * cols, cols, 1};
+    TransposeKernel(src, dst, 3, shape, to_row_major ? planes : row_major, to_row_major ? row_major : planes, 0);
+}
+
+ReshapeLayer::ReshapeLayer(std::string layer_name) :
+    Layer(std::move(layer_name))
+{
+}
+
+StatusCode ReshapeLayer::Forward(const std::vector<std::shared_ptr<data::Tensor<float>>> &inputs,
+                                 std::vector<std::shared_ptr<data::Tensor<float>>> &outputs)
+{
+    if (outputs.empty() || inputs.size() < outputs.size())
+    {
+        LOG(ERROR) << "Reshape " << layer_name << " has " << inputs.size() << " inputs and " << outputs.size()
+                   << " outputs";
+        return StatusCode::InferInputsEmpty;
+    }
+
+    std::vector<float> buffer;
+    for (size_t b = 0; b < outputs.size(); ++b)
+    {
+        const data::Tensor<float> &input = *inputs[b];
+        data::Tensor<float> &output = *outputs[b];
+        if (input.size() != output.size())
+        {
+            LOG(ERROR) << "Reshape " << layer_name << " maps " << input.size() << " elements to " << output.size();
+            return StatusCode::InferDimMismatch;
+        }
+        if (input.data_ptr() == output.data_ptr())
+        {
+            continue;
+        }
+
+        const bool input_row_major = RowMajorPlanes(input);
+        const bool output_row_major = RowMajorPlanes(output);
+        if ((input_row_major && output_row_major)
+            || (input.rows() == output.rows() && input.cols() == output.cols()))
+        {
+            std::copy(input.data_ptr(), input.data_ptr() + input.size(), output.data_ptr());
+            continue;
+        }
+
+        const float *src = input.data_ptr();
+        if (!input_row_major)
+        {
+            float *dst = output.data_ptr();
+            if (!output_row_major)
+            {
+                buffer.resize(input.size());
+                dst = buffer.data();
+            }
+            TransposePlanes(input, src, dst, true);
+            src = dst;
+        }
+        if (!output_row_major)
+        {
+            TransposePlanes(output, src, output.data_ptr(), false);
+        }
+    }
+    return StatusCode::Success;
+}
+
+bool ReshapeLayer::IsView() const
+{
+    return true;
+}
+
+StatusCode ReshapeLayer::Create(const std::shared_ptr<runtime::Operator<float>> &op,
+                                std::shared_ptr<Layer<float>> &layer)
+{
+    CHECK(op != nullptr) << "Reshape operator is empty";
+    layer = std::make_shared<ReshapeLayer>(op->name);
+    return StatusCode::Success;
+}
+
+static LayerRegistererWrapper kViewLayer("Tensor.view", ReshapeLayer::Create);
+static LayerRegistererWrapper kTensorReshapeLayer("Tensor.reshape", ReshapeLayer::Create);
+static LayerRegistererWrapper kReshapeLayer("torch.reshape", ReshapeLayer::Create);
+static LayerRegistererWrapper kFlattenLayer("torch.flatten", ReshapeLayer::Create);
+static LayerRegistererWrapper kFlattenModuleLayer("nn.Flatten", ReshapeLayer::Create);
+static LayerRegistererWrapper kSqueezeLayer("torch.squeeze", ReshapeLayer::Create);
+static LayerRegistererWrapper kUnsqueezeLayer("torch.unsqueeze", ReshapeLayer::Create);
+static LayerRegistererWrapper kContiguousLayer("Tensor.contiguous", ReshapeLayer::Create);
+
+} // namespace layer
+} // namespace jennifer
@@ -0,0 +1,38 @@
+#ifndef JENNIFER_LAYER_RESHAPE_HPP_
+#define JENNIFER_LAYER_RESHAPE_HPP_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "layer.hpp"
+
+namespace jennifer
+{
+namespace layer
+{
+
+// Tensor.view, Tensor.reshape, torch.reshape, torch.flatten, nn.Flatten, torch.squeeze,
+// torch.unsqueeze and Tensor.contiguous within every sample. The memory plan hands
+// the output the storage of the input when both store their elements in the same
+// order, then there is nothing to do. Otherwise the elements are copied in the
+// row-major order of torch, through a blocked transpose of every side whose planes
+// do not already hold that order.
+class ReshapeLayer : public Layer<float>
+{
+public:
+    explicit ReshapeLayer(std::string layer_name);
+
+    utils::StatusCode Forward(const std::vector<std::shared_ptr<data::Tensor<float>>> &inputs,
+                              std::vector<std::shared_ptr<data::Tensor<float>>> &outputs) override;
+
+    bool IsView() const override;
+
+    static utils::StatusCode Create(const std::shared_ptr<runtime::Operator<float>> &op,
+                                    std::shared_ptr<Layer<float>> &layer);
+}; // class ReshapeLayer
+
+} // namespace layer
+} // namespace jennifer
+
+#endif // JENNIFER_LAYER_RESHAPE_HPP_
@@ -0,0 +1,284 @@
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <cfloat>
+
+#include "jennifer/utils/parallel.hpp"
+
+#include "layer_factory.hpp"
+#include "softmax.hpp"
+#include "vector_math.hpp"
+
+namespace jennifer
+{
+namespace layer
+{
+
+using utils::StatusCode;
+
+// lanes of a vectorized block, state kept per run of inner elements, steps of
+// the axis between two updates of the running max and the elements below which
+// work stays on one thread
+static constexpr int64_t kLanes = 8;
+static constexpr int64_t kInnerRun = 256;
+static constexpr int64_t kAxisChunk = 8;
+static constexpr int64_t kParallelGrain = 1 << 15;
+
+// raises the running max of n lanes to chunk_max and rescales their sums to it
+static inline void RescaleSums(float *max, float *sum, const float *chunk_max, int64_t n)
+{
+    for (int64_t i = 0; i < n; ++i)
+    {
+        const float m = std::max(max[i], chunk_max[i]);
+        sum[i] *= VectorExp(max[i] - m);
+        max[i] = m;
+    }
+}
+
+// n <= kInnerRun contiguous softmaxes, element a of softmax i at input[a * inner + i]
+static void SoftmaxInnerRun(const float *input, float *output, int64_t axis, int64_t inner, int64_t n)
+{
+    float max[kInnerRun];
+    float sum[kInnerRun];
+    float chunk_max[kInnerRun];
+    std::fill(max, max + n, -FLT_MAX);
+    std::fill(sum, sum + n, 0.f);
+    for (int64_t a0 = 0; a0 < axis; a0 += kAxisChunk)
+    {
+        const int64_t a1 = std::min(a0 + kAxisChunk, axis);
+        std::copy(input + a0 * inner, input + a0 * inner + n, chunk_max);
+        for (int64_t a = a0 + 1; a < a1; ++a)
+        {
+            const float *x = input + a * inner;
+            for (int64_t i = 0; i < n; ++i)
+            {
+                chunk_max[i] = std::max(chunk_max[i], x[i]);
+            }
+        }
+        RescaleSums(max, sum, chunk_max, n);
+        for (int64_t a = a0; a < a1; ++a)
+        {
+            const float *x = input + a * inner;
+            int64_t i = 0;
+            for (; i + kLanes <= n; i += kLanes)
+            {
+                for (int64_t k = 0; k < kLanes; ++k)
+                {
+                    sum[i + k] += VectorExp(x[i + k] - max[i + k]);
+                }
+            }
+            for (; i < n; ++i)
+            {
+                sum[i] += VectorExp(x[i] - max[i]);
+            }
+        }
+    }
+
+    for (int64_t i = 0; i < n; ++i)
+    {
+        sum[i] = 1.f / sum[i];
+    }
+    for (int64_t a = 0; a < axis; ++a)
+    {
+        const float *x = input + a * inner;
+        float *y = output + a * inner;
+        int64_t i = 0;
+        for (; i + kLanes <= n; i += kLanes)
+        {
+            float block[kLanes];
+            for (int64_t k = 0; k < kLanes; ++k)
+            {
+                block[k] = VectorExp(x[i + k] - max[i + k]) * sum[i + k];
+            }
+            std::copy(block, block + kLanes, y + i);
+        }
+        for (; i < n; ++i)
+        {
+            y[i] = VectorExp(x[i] - max[i]) * sum[i];
+        }
+    }
+}
+
+// one softmax over axis contiguous elements
+static void SoftmaxRow(const float *x, float *y, int64_t axis)
+{
+    // lane k of every block of the chunk, the tail goes to lane 0
+    float max[kLanes];
+    float sum[kLanes];
+    std::fill(max, max + kLanes, -FLT_MAX);
+    std::fill(sum, sum + kLanes, 0.f);
+    const int64_t blocks_end = axis / kLanes * kLanes;
+    for (int64_t a0 = 0; a0 < blocks_end; a0 += kAxisChunk * kLanes)
+    {
+        const int64_t a1 = std::min(a0 + kAxisChunk * kLanes, blocks_end);
+        float chunk_max[kLanes];
+        std::copy(x + a0, x + a0 + kLanes, chunk_max);
+        for (int64_t a = a0 + kLanes; a < a1; a += kLanes)
+        {
+            for (int64_t k = 0; k < kLanes; ++k)
+            {
+                chunk_max[k] = std::max(chunk_max[k], x[a + k]);
+            }
+        }
+        RescaleSums(max, sum, chunk_max, kLanes);
+        for (int64_t a = a0; a < a1; a += kLanes)
+        {
+            for (int64_t k = 0; k < kLanes; ++k)
+            {
+                sum[k] += VectorExp(x[a + k] - max[k]);
+            }
+        }
+    }
+    for (int64_t a = blocks_end; a < axis; ++a)
+    {
+        RescaleSums(max, sum, x + a, 1);
+        sum[0] += VectorExp(x[a] - max[0]);
+    }
+
+    const float m = *std::max_element(max, max + kLanes);
+    float total = 0.f;
+    for (int64_t k = 0; k < kLanes; ++k)
+    {
+        total += sum[k] * VectorExp(max[k] - m);
+    }
+    const float scale = 1.f / total;
+
+    int64_t a = 0;
+    for (; a + kLanes <= axis; a += kLanes)
+    {
+        float block[kLanes];
+        for (int64_t k = 0; k < kLanes; ++k)
+        {
+            block[k] = VectorExp(x[a + k] - m) * scale;
+        }
+        std::copy(block, block + kLanes, y + a);
+    }
+    for (; a < axis; ++a)
+    {
+        y[a] = VectorExp(x[a] - m) * scale;
+    }
+}
+
+void SoftmaxKernel(const float *input, float *output, int64_t outer, int64_t axis, int64_t inner, int num_threads)
+{
+    if (inner == 1)
+    {
+        utils::ParallelFor(outer, num_threads, std::max<int64_t>(kParallelGrain / axis, 1),
+                           [&](int64_t begin, int64_t end) {
+                               for (int64_t o = begin; o < end; ++o)
+                               {
+                                   SoftmaxRow(input + o * axis, output + o * axis, axis);
+                               }
+                           });
+        return;
+    }
+
+    const int64_t runs = (inner + kInnerRun - 1) / kInnerRun;
+    utils::ParallelFor(outer * runs, num_threads, std::max<int64_t>(kParallelGrain / (axis * kInnerRun), 1),
+                       [&](int64_t begin, int64_t end) {
+                           for (int64_t t = begin; t < end; ++t)
+                           {
+                               const int64_t offset = t / runs * axis * inner + t % runs * kInnerRun;
+                               SoftmaxInnerRun(input + offset, output + offset, axis, inner,
+                                               std::min(kInnerRun, inner - t % runs * kInnerRun));
+                           }
+                       });
+}
+
+SoftmaxLayer::SoftmaxLayer(std::string layer_name, int32_t dim, int32_t rank) :
+    Layer(std::move(layer_name)), dim_(dim), rank_(rank)
+{
+}
+
+// the [outer, axis, inner] view of dim over a sample, false for the batch dim and
+// for dims folded into the channels
+static bool AxisView(const data::Tensor<float> &sample, int32_t rank, int32_t dim, int64_t view[3])
+{
+    const int64_t channels = sample.channels();
+    const int64_t rows = sample.rows();
+    const int64_t cols = sample.cols();
+    const int32_t from_end = rank - 1 - dim;
+    if (dim <= 0 || from_end < 0)
+    {
+        return false;
+    }
+    if (from_end == 0)
+    {
+        view[0] = channels;
+        view[1] = cols;
+        view[2] = rows;
+        return true;
+    }
+    if (from_end == 1)
+    {
+        view[0] = channels * cols;
+        view[1] = rows;
+        view[2] = 1;
+        return true;
+    }
+    if (from_end == 2 && rank == 4)
+    {
+        view[0] = 1;
+        view[1] = channels;
+        view[2] = rows * cols;
+        return true;
+    }
+    return false;
+}
+
+StatusCode SoftmaxLayer::Forward(const std::vector<std::shared_ptr<data::Tensor<float>>> &inputs,
+                                 std::vector<std::shared_ptr<data::Tensor<float>>> &outputs)
+{
+    if (inputs.empty() || inputs.size() != outputs.size())
+    {
+        LOG(ERROR) << "Softmax " << layer_name << " has " << inputs.size() << " inputs and " << outputs.size()
+                   << " outputs";
+        return StatusCode::InferInputsEmpty;
+    }
+
+    for (size_t i = 0; i < inputs.size(); ++i)
+    {
+        const data::Tensor<float> &input = *inputs[i];
+        data::Tensor<float> &output = *outputs[i];
+        int64_t view[3];
+        if (!AxisView(input, rank_, dim_, view))
+        {
+            LOG(ERROR) << "Softmax " << layer_name << " dim " << dim_ << " of rank " << rank_ << " is not supported";
+            return StatusCode::InferParamError;
+        }
+        if (output.size() != input.size())
+        {
+            LOG(ERROR) << "Softmax " << layer_name << " output size differs from its input";
+            return StatusCode::InferDimMismatch;
+        }
+        SoftmaxKernel(input.data_ptr(), output.data_ptr(), view[0], view[1], view[2], 0);
+    }
+    return StatusCode::Success;
+}
+
+bool SoftmaxLayer::SupportsInPlace() const
+{
+    return true;
+}
+
+StatusCode SoftmaxLayer::Create(const std::shared_ptr<runtime::Operator<float>> &op,
+                                std::shared_ptr<Layer<float>> &layer)
+{
+    CHECK(op != nullptr) << "Softmax operator is empty";
+
+    int32_t dim = 0;
+    if (!GetParameter(*op, "dim", dim) || op->input_operands_seq.empty())
+    {
+        LOG(ERROR) << "Softmax " << op->name << " misses its dim";
+        return StatusCode::ParseParamError;
+    }
+    const int32_t rank = static_cast<int32_t>(op->input_operands_seq[0]->shapes.size());
+    layer = std::make_shared<SoftmaxLayer>(op->name, dim < 0 ? dim + rank : dim, rank);
+    return StatusCode::Success;
+}
+
+static LayerRegistererWrapper kSoftmaxLayer("nn.Softmax", SoftmaxLayer::Create);
+static LayerRegistererWrapper kFunctionalSoftmaxLayer("F.softmax", SoftmaxLayer::Create);
+
+} // namespace layer
+} // namespace jennifer
@@ -0,0 +1,49 @@
+#ifndef JENNIFER_LAYER_SOFTMAX_HPP_
+#define JENNIFER_LAYER_SOFTMAX_HPP_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "layer.hpp"
+
+namespace jennifer
+{
+namespace layer
+{
+
+// Softmax along the axis of an [outer, axis, inner] view of contiguous floats.
+// One pass keeps a running max and a sum of exp that is rescaled when the max of
+// the next chunk of 8 steps is larger, a second pass writes exp(x - max) / sum.
+// With inner > 1 the state is kept for a run of inner elements at once, so both
+// passes vectorize across inner; with inner == 1 the axis is spread over 8 lanes
+// that are merged at the end. output may be input. Work is split across
+// num_threads, 0 takes every hardware thread.
+void SoftmaxKernel(const float *input, float *output, int64_t outer, int64_t axis, int64_t inner, int num_threads);
+
+// nn.Softmax and F.softmax over one dim of the sample. Of data::Tensor, the cols
+// dim has inner = rows, rows are contiguous and channels span whole planes.
+class SoftmaxLayer : public Layer<float>
+{
+public:
+    SoftmaxLayer(std::string layer_name, int32_t dim, int32_t rank);
+
+    utils::StatusCode Forward(const std::vector<std::shared_ptr<data::Tensor<float>>> &inputs,
+                              std::vector<std::shared_ptr<data::Tensor<float>>> &outputs) override;
+
+    bool SupportsInPlace() const override;
+
+    static utils::StatusCode Create(const std::shared_ptr<runtime::Operator<float>> &op,
+                                    std::shared_ptr<Layer<float>> &layer);
+
+private:
+    int32_t dim_;
+    // exported rank of the input, batch included
+    int32_t rank_;
+}; // class SoftmaxLayer
+
+} // namespace layer
+} // namespace jennifer
+
+#endif // JENNIFER_LAYER_SOFTMAX_HPP_
@@ -0,0 +1,501 @@
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <numeric>
+
+#include "jennifer/utils/parallel.hpp"
+
+#include "layer_factory.hpp"
+#include "transpose.hpp"
+
+namespace jennifer
+{
+namespace layer
+{
+
+using utils::StatusCode;
+
+static constexpr int32_t kMaxRank = 8;
+static constexpr int64_t kTile = 8;
+static constexpr int64_t kParallelGrain = 1 << 15;
+
+struct StridedDims
+{
+    int32_t rank = 0;
+    int64_t shape[kMaxRank];
+    int64_t src[kMaxRank];
+    int64_t dst[kMaxRank];
+}; // struct StridedDims
+
+// drops size 1 dims, orders the rest outer to inner in the output and merges neighbours
+static StridedDims Simplify(int32_t rank, const int64_t *shape, const int64_t *input_strides,
+                            const int64_t *output_strides)
+{
+    int32_t order[kMaxRank];
+    int32_t count = 0;
+    for (int32_t k = 0; k < rank; ++k)
+    {
+        if (shape[k] != 1)
+        {
+            order[count++] = k;
+        }
+    }
+    std::stable_sort(order, order + count, [&](int32_t a, int32_t b) { return output_strides[a] > output_strides[b]; });
+
+    StridedDims dims;
+    for (int32_t i = 0; i < count; ++i)
+    {
+        const int32_t k = order[i];
+        const int32_t last = dims.rank - 1;
+        if (last >= 0 && dims.src[last] == input_strides[k] * shape[k]
+            && dims.dst[last] == output_strides[k] * shape[k])
+        {
+            dims.shape[last] *= shape[k];
+            dims.src[last] = input_strides[k];
+            dims.dst[last] = output_strides[k];
+            continue;
+        }
+        dims.shape[dims.rank] = shape[k];
+        dims.src[dims.rank] = input_strides[k];
+        dims.dst[dims.rank] = output_strides[k];
+        dims.rank += 1;
+    }
+    return dims;
+}
+
+static void CopyRun(const float *src, float *dst, int64_t n, int64_t src_stride, int64_t dst_stride)
+{
+    if (src_stride == 1 && dst_stride == 1)
+    {
+        std::copy(src, src + n, dst);
+        return;
+    }
+    for (int64_t j = 0; j < n; ++j)
+    {
+        dst[j * dst_stride] = src[j * src_stride];
+    }
+}
+
+// a full tile with i contiguous in the input and j contiguous in the output when
+// kUnit, both loops are fixed size so the compiler keeps the tile in registers
+template <bool kUnit>
+static void CopyTile(const float *src, float *dst, int64_t si, int64_t sj, int64_t di, int64_t dj)
+{
+    if (kUnit)
+    {
+        si = 1;
+        dj = 1;
+    }
+    float tile[kTile][kTile];
+    for (int64_t j = 0; j < kTile; ++j)
+    {
+        for (int64_t i = 0; i < kTile; ++i)
+        {
+            tile[i][j] = src[j * sj + i * si];
+        }
+    }
+    for (int64_t i = 0; i < kTile; ++i)
+    {
+        for (int64_t j = 0; j < kTile; ++j)
+        {
+            dst[i * di + j * dj] = tile[i][j];
+        }
+    }
+}
+
+// ni rows of the inner input dim i against the innermost output dim j
+static void CopyTiles(const float *src, float *dst, int64_t ni, int64_t nj, int64_t si, int64_t sj, int64_t di,
+                      int64_t dj)
+{
+    const bool unit = si == 1 && dj == 1;
+    for (int64_t j0 = 0; j0 < nj; j0 += kTile)
+    {
+        const int64_t jb = std::min(kTile, nj - j0);
+        if (ni == kTile && jb == kTile)
+        {
+            if (unit)
+            {
+                CopyTile<true>(src + j0 * sj, dst + j0 * dj, si, sj, di, dj);
+            }
+            else
+            {
+                CopyTile<false>(src + j0 * sj, dst + j0 * dj, si, sj, di, dj);
+            }
+            continue;
+        }
+        for (int64_t i = 0; i < ni; ++i)
+        {
+            for (int64_t j = j0; j < j0 + jb; ++j)
+            {
+                dst[i * di + j * dj] = src[j * sj + i * si];
+            }
+        }
+    }
+}
+
+void TransposeKernel(const float *input, float *output, int32_t rank, const int64_t *shape,
+                     const int64_t *input_strides, const int64_t *output_strides, int num_threads)
+{
+    CHECK(rank >= 0 && rank <= kMaxRank) << "Transpose of rank " << rank << " is not supported";
+    const StridedDims dims = Simplify(rank, shape, input_strides, output_strides);
+    if (dims.rank == 0)
+    {
+        output[0] = input[0];
+        return;
+    }
+
+    // j is the innermost output dim, i the dim the input is densest along when that is another one
+    const int32_t j = dims.rank - 1;
+    int32_t i = -1;
+    for (int32_t k = 0; k < j; ++k)
+    {
+        if (dims.src[k] < dims.src[j] && (i < 0 || dims.src[k] < dims.src[i]))
+        {
+            i = k;
+        }
+    }
+
+    int32_t outer[kMaxRank];
+    int32_t outer_rank = 0;
+    int64_t outer_count = 1;
+    for (int32_t k = 0; k < j; ++k)
+    {
+        if (k != i)
+        {
+            outer[outer_rank++] = k;
+            outer_count *= dims.shape[k];
+        }
+    }
+    const int64_t tiles = i < 0 ? 1 : (dims.shape[i] + kTile - 1) / kTile;
+    const int64_t work = i < 0 ? dims.shape[j] : dims.shape[j] * kTile;
+    const int64_t grain = std::max<int64_t>(kParallelGrain / work, 1);
+
+    utils::ParallelFor(outer_count * tiles, num_threads, grain, [&](int64_t begin, int64_t end) {
+        for (int64_t w = begin; w < end; ++w)
+        {
+            int64_t o = w / tiles;
+            const float *src = input;
+            float *dst = output;
+            for (int32_t k = outer_rank - 1; k >= 0; --k)
+            {
+                const int32_t d = outer[k];
+                const int64_t index = o % dims.shape[d];
+                o /= dims.shape[d];
+                src += index * dims.src[d];
+                dst += index * dims.dst[d];
+            }
+            if (i < 0)
+            {
+                CopyRun(src, dst, dims.shape[j], dims.src[j], dims.dst[j]);
+                continue;
+            }
+            const int64_t i0 = w % tiles * kTile;
+            CopyTiles(src + i0 * dims.src[i], dst + i0 * dims.dst[i], std::min(kTile, dims.shape[i] - i0),
+                      dims.shape[j], dims.src[i], dims.src[j], dims.dst[i], dims.dst[j]);
+        }
+    });
+}
+
+std::vector<int64_t> TensorStrides(const std::vector<int64_t> &dims)
+{
+    const int64_t rank = static_cast<int64_t>(dims.size());
+    std::vector<int64_t> strides(rank);
+    const int64_t rows = rank >= 2 ? dims[rank - 2] : 1;
+    int64_t step = rows;
+    if (rank >= 1)
+    {
+        strides[rank - 1] = rows;
+        step *= dims[rank - 1];
+    }
+    if (rank >= 2)
+    {
+        strides[rank - 2] = 1;
+    }
+    for (int64_t k = rank - 3; k >= 0; --k)
+    {
+        strides[k] = step;
+        step *= dims[k];
+    }
+    return strides;
+}
+
+// logical dims of a sample of data::Tensor, the folded channels are split with the
+// known dims of shape and at most one unknown one takes the rest
+static bool SampleDims(const data::Tensor<float> &tensor, const std::vector<int32_t> &shape,
+                       std::vector<int64_t> &dims)
+{
+    const size_t rank = shape.size();
+    const int64_t padded[3] = {tensor.channels(), tensor.rows(), tensor.cols()};
+    dims.assign(rank, 1);
+    if (rank <= 3)
+    {
+        for (size_t k = 0; k < rank; ++k)
+        {
+            dims[k] = padded[3 - rank + k];
+        }
+        return std::accumulate(dims.begin(), dims.end(), int64_t(1), std::multiplies<int64_t>())
+               == static_cast<int64_t>(tensor.size());
+    }
+
+    dims[rank - 2] = padded[1];
+    dims[rank - 1] = padded[2];
+    int64_t known = 1;
+    int64_t unknown = -1;
+    for (size_t k = 0; k + 2 < rank; ++k)
+    {
+        if (shape[k] > 0)
+        {
+            dims[k] = shape[k];
+            known *= shape[k];
+        }
+        else if (unknown < 0)
+        {
+            unknown = k;
+        }
+        else
+        {
+            return false;
+        }
+    }
+    if (unknown >= 0)
+    {
+        dims[unknown] = padded[0] / known;
+    }
+    return std::accumulate(dims.begin(), dims.end() - 2, int64_t(1), std::multiplies<int64_t>()) == padded[0];
+}
+
+PermuteLayer::PermuteLayer(std::string layer_name, std::vector<int32_t> dims, std::vector<int32_t> input_shape) :
+    Layer(std::move(layer_name)), dims_(std::move(dims)), input_shape_(std::move(input_shape))
+{
+}
+
+StatusCode PermuteLayer::Forward(const std::vector<std::shared_ptr<data::Tensor<float>>> &inputs,
+                                 std::vector<std::shared_ptr<data::Tensor<float>>> &outputs)
+{
+    if (outputs.empty() || inputs.size() < outputs.size())
+    {
+        LOG(ERROR) << "Permute " << layer_name << " has " << inputs.size() << " inputs and " << outputs.size()
+                   << " outputs";
+        return StatusCode::InferInputsEmpty;
+    }
+
+    const size_t rank = dims_.size();
+    std::vector<int64_t> in_dims;
+    std::vector<int64_t> out_dims(rank);
+    std::vector<int64_t> src_strides(rank);
+    for (size_t b = 0; b < outputs.size(); ++b)
+    {
+        const data::Tensor<float> &input = *inputs[b];
+        data::Tensor<float> &output = *outputs[b];
+        if (!SampleDims(input, input_shape_, in_dims))
+        {
+            LOG(ERROR) << "Permute " << layer_name << " can not split its input into " << rank << " dims";
+            return StatusCode::InferDimMismatch;
+        }
+        const std::vector<int64_t> in_strides = TensorStrides(in_dims);
+        for (size_t k = 0; k < rank; ++k)
+        {
+            out_dims[k] = in_dims[dims_[k]];
+            src_strides[k] = in_strides[dims_[k]];
+        }
+        const int64_t rows = rank >= 2 ? out_dims[rank - 2] : 1;
+        const int64_t cols = rank >= 1 ? out_dims[rank - 1] : 1;
+        if (output.size() != input.size() || output.rows() != rows || output.cols() != cols)
+        {
+            LOG(ERROR) << "Permute " << layer_name << " output does not match the permuted input";
+            return StatusCode::InferDimMismatch;
+        }
+        const std::vector<int64_t> out_strides = TensorStrides(out_dims);
+        TransposeKernel(input.data_ptr(), output.data_ptr(), rank, out_dims.data(), src_strides.data(),
+                        out_strides.data(), 0);
+    }
+    return StatusCode::Success;
+}
+
+StatusCode PermuteLayer::Create(const std::shared_ptr<runtime::Operator<float>> &op,
+                                std::shared_ptr<Layer<float>> &layer)
+{
+    CHECK(op != nullptr) << "Permute operator is empty";
+
+    const int32_t rank = op->input_operands_seq.empty() ? 0 : op->input_operands_seq[0]->shapes.size();
+    if (rank < 1 || rank > kMaxRank + 1)
+    {
+        LOG(ERROR) << "Permute " << op->name << " of rank " << rank << " is not supported";
+        return StatusCode::ParseParamError;
+    }
+
+    std::vector<int32_t> dims;
+    if (op->type == "torch.permute" || op->type == "Tensor.permute")
+    {
+        if (!GetParameter(*op, "dims", dims))
+        {
+            LOG(ERROR) << "Permute " << op->name << " misses its dims";
+            return StatusCode::ParseParamError;
+        }
+    }
+    else
+    {
+        int32_t dim0 = 0;
+        int32_t dim1 = 0;
+        if (!GetParameter(*op, "dim0", dim0) || !GetParameter(*op, "dim1", dim1))
+        {
+            LOG(ERROR) << "Transpose " << op->name << " misses its dims";
+            return StatusCode::ParseParamError;
+        }
+        dims.resize(rank);
+        std::iota(dims.begin(), dims.end(), 0);
+        dim0 = dim0 < 0 ? dim0 + rank : dim0;
+        dim1 = dim1 < 0 ? dim1 + rank : dim1;
+        if (dim0 < 0 || dim0 >= rank || dim1 < 0 || dim1 >= rank)
+        {
+            LOG(ERROR) << "Transpose " << op->name << " dims are out of range";
+            return StatusCode::ParseParamError;
+        }
+        std::swap(dims[dim0], dims[dim1]);
+    }
+    if (dims.size() != static_cast<size_t>(rank))
+    {
+        LOG(ERROR) << "Permute " << op->name << " has " << dims.size() << " dims for rank " << rank;
+        return StatusCode::ParseParamError;
+    }
+
+    std::vector<bool> seen(rank, false);
+    for (int32_t &dim : dims)
+    {
+        dim = dim < 0 ? dim + rank : dim;
+        if (dim < 0 || dim >= rank || seen[dim])
+        {
+            LOG(ERROR) << "Permute " << op->name << " dims are not a permutation of rank " << rank;
+            return StatusCode::ParseParamError;
+        }
+        seen[dim] = true;
+    }
+    if (dims[0] != 0)
+    {
+        LOG(ERROR) << "Permute " << op->name << " moves the batch dim";
+        return StatusCode::FunctionNotImplement;
+    }
+
+    // the batch is split into samples
+    std::vector<int32_t> sample_dims;
+    for (int32_t k = 1; k < rank; ++k)
+    {
+        sample_dims.push_back(dims[k] - 1);
+    }
+    const std::vector<int32_t> &shape = op->input_operands_seq[0]->shapes;
+    layer = std::make_shared<PermuteLayer>(op->name, sample_dims, std::vector<int32_t>(shape.begin() + 1, shape.end()));
+    return StatusCode::Success;
+}
+
+ShuffleLayer::ShuffleLayer(std::string layer_name, ShuffleMode mode, int32_t factor) :
+    Layer(std::move(layer_name)), mode_(mode), factor_(factor)
+{
+}
+
+StatusCode ShuffleLayer::Forward(const std::vector<std::shared_ptr<data::Tensor<float>>> &inputs,
+                                 std::vector<std::shared_ptr<data::Tensor<float>>> &outputs)
+{
+    if (outputs.empty() || inputs.size() < outputs.size())
+    {
+        LOG(ERROR) << "Shuffle " << layer_name << " has " << inputs.size() << " inputs and " << outputs.size()
+                   << " outputs";
+        return StatusCode::InferInputsEmpty;
+    }
+
+    const int64_t r = factor_;
+    for (size_t b = 0; b < outputs.size(); ++b)
+    {
+        const data::Tensor<float> &input = *inputs[b];
+        data::Tensor<float> &output = *outputs[b];
+        // a pixel shuffle splits the channels into (c, i, j) and the output rows and
+        // cols into (h, i) and (w, j), its inverse swaps the two sides
+        int32_t rank = 5;
+        int64_t shape[5];
+        int64_t src[5];
+        int64_t dst[5];
+        bool valid = input.size() == output.size();
+        if (mode_ == ShuffleMode::ChannelShuffle)
+        {
+            const int64_t plane = int64_t(input.rows()) * input.cols();
+            const int64_t k = input.channels() / r;
+            valid = valid && input.channels() % r == 0 && output.channels() == input.channels();
+            rank = 3;
+            const int64_t dims[3] = {r, k, plane};
+            const int64_t in[3] = {k * plane, plane, 1};
+            const int64_t out[3] = {plane, r * plane, 1};
+            std::copy(dims, dims + 3, shape);
+            std::copy(in, in + 3, src);
+            std::copy(out, out + 3, dst);
+        }
+        else
+        {
+            const bool up = mode_ == ShuffleMode::PixelShuffle;
+            const data::Tensor<float> &packed = up ? input : output;
+            const data::Tensor<float> &spread = up ? output : input;
+            const int64_t c = spread.channels();
+            const int64_t h = packed.rows();
+            const int64_t w = packed.cols();
+            valid = valid && packed.channels() == c * r * r && spread.rows() == h * r && spread.cols() == w * r;
+            const int64_t dims[5] = {c, h, r, w, r};
+            const int64_t packed_strides[5] = {r * r * h * w, 1, r * h * w, h, h * w};
+            const int64_t spread_strides[5] = {h * r * w * r, r, 1, r * h * r, h * r};
+            std::copy(dims, dims + 5, shape);
+            std::copy(packed_strides, packed_strides + 5, up ? src : dst);
+            std::copy(spread_strides, spread_strides + 5, up ? dst : src);
+        }
+        if (!valid)
+        {
+            LOG(ERROR) << "Shuffle " << layer_name << " output does not match its input and factor " << factor_;
+            return StatusCode::InferDimMismatch;
+        }
+        TransposeKernel(input.data_ptr(), output.data_ptr(), rank, shape, src, dst, 0);
+    }
+    return StatusCode::Success;
+}
+
+StatusCode ShuffleLayer::Create(const std::shared_ptr<runtime::Operator<float>> &op,
+                                std::shared_ptr<Layer<float>> &layer)
+{
+    CHECK(op != nullptr) << "Shuffle operator is empty";
+
+    if (op->input_operands_seq.empty() || op->input_operands_seq[0]->shapes.size() != 4)
+    {
+        LOG(ERROR) << "Shuffle " << op->name << " only shuffles (N, C, H, W) inputs";
+        return StatusCode::ParseParamError;
+    }
+
+    ShuffleMode mode = ShuffleMode::ChannelShuffle;
+    std::string key = "groups";
+    if (op->type == "nn.PixelShuffle" || op->type == "F.pixel_shuffle")
+    {
+        mode = ShuffleMode::PixelShuffle;
+        key = "upscale_factor";
+    }
+    else if (op->type == "nn.PixelUnshuffle" || op->type == "F.pixel_unshuffle")
+    {
+        mode = ShuffleMode::PixelUnshuffle;
+        key = "downscale_factor";
+    }
+    int32_t factor = 0;
+    if (!GetParameter(*op, key, factor) || factor < 1)
+    {
+        LOG(ERROR) << "Shuffle " << op->name << " misses a positive " << key;
+        return StatusCode::ParseParamError;
+    }
+    layer = std::make_shared<ShuffleLayer>(op->name, mode, factor);
+    return StatusCode::Success;
+}
+
+static LayerRegistererWrapper kPermuteLayer("torch.permute", PermuteLayer::Create);
+static LayerRegistererWrapper kTensorPermuteLayer("Tensor.permute", PermuteLayer::Create);
+static LayerRegistererWrapper kTransposeLayer("torch.transpose", PermuteLayer::Create);
+static LayerRegistererWrapper kTensorTransposeLayer("Tensor.transpose", PermuteLayer::Create);
+static LayerRegistererWrapper kPixelShuffleLayer("nn.PixelShuffle", ShuffleLayer::Create);
+static LayerRegistererWrapper kFunctionalPixelShuffleLayer("F.pixel_shuffle", ShuffleLayer::Create);
+static LayerRegistererWrapper kPixelUnshuffleLayer("nn.PixelUnshuffle", ShuffleLayer::Create);
+static LayerRegistererWrapper kFunctionalPixelUnshuffleLayer("F.pixel_unshuffle", ShuffleLayer::Create);
+static LayerRegistererWrapper kChannelShuffleLayer("nn.ChannelShuffle", ShuffleLayer::Create);
+static LayerRegistererWrapper kFunctionalChannelShuffleLayer("F.channel_shuffle", ShuffleLayer::Create);
+
+} // namespace layer
+} // namespace jennifer
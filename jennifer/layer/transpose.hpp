@@ -0,0 +1,81 @@
+#ifndef JENNIFER_LAYER_TRANSPOSE_HPP_
+#define JENNIFER_LAYER_TRANSPOSE_HPP_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "layer.hpp"
+
+namespace jennifer
+{
+namespace layer
+{
+
+// Copies a block of rank dims between two strided layouts: the element at index
+// (i0, ..., i{rank-1}) is read at input + sum(ik * input_strides[k]) and written at
+// output + sum(ik * output_strides[k]). Size 1 dims are dropped, the rest is walked
+// in the memory order of the output and dims contiguous in both layouts are merged.
+// When the input is contiguous along another dim than the innermost output dim, the
+// two are moved in 8 x 8 tiles, read along input runs and written along output
+// runs, so neither side strides a cache line per float. Outer dims and tiles are
+// split across num_threads, 0 takes every hardware thread.
+void TransposeKernel(const float *input, float *output, int32_t rank, const int64_t *shape,
+                     const int64_t *input_strides, const int64_t *output_strides, int num_threads);
+
+// Strides of the logical dims of a sample stored in data::Tensor: dims before the
+// last two fold into the channels and every plane is stored col by col.
+std::vector<int64_t> TensorStrides(const std::vector<int64_t> &dims);
+
+// torch.permute, Tensor.permute, torch.transpose and Tensor.transpose that keep the
+// batch dim in front. A sample of more than three dims is split back from the
+// channels of data::Tensor with the exported shape of the input.
+class PermuteLayer : public Layer<float>
+{
+public:
+    // permutation of the sample dims and the exported sample shape of the input,
+    // -1 for dims only known at run time
+    PermuteLayer(std::string layer_name, std::vector<int32_t> dims, std::vector<int32_t> input_shape);
+
+    utils::StatusCode Forward(const std::vector<std::shared_ptr<data::Tensor<float>>> &inputs,
+                              std::vector<std::shared_ptr<data::Tensor<float>>> &outputs) override;
+
+    static utils::StatusCode Create(const std::shared_ptr<runtime::Operator<float>> &op,
+                                    std::shared_ptr<Layer<float>> &layer);
+
+private:
+    std::vector<int32_t> dims_;
+    std::vector<int32_t> input_shape_;
+}; // class PermuteLayer
+
+enum class ShuffleMode
+{
+    PixelShuffle,
+    PixelUnshuffle,
+    ChannelShuffle,
+}; // enum class ShuffleMode
+
+// nn.PixelShuffle, nn.PixelUnshuffle and nn.ChannelShuffle of (N, C, H, W) inputs
+// and their functional forms, written as one strided copy of the split dims.
+class ShuffleLayer : public Layer<float>
+{
+public:
+    // factor is the upscale or downscale factor of a pixel shuffle, the groups of a channel shuffle
+    ShuffleLayer(std::string layer_name, ShuffleMode mode, int32_t factor);
+
+    utils::StatusCode Forward(const std::vector<std::shared_ptr<data::Tensor<float>>> &inputs,
+                              std::vector<std::shared_ptr<data::Tensor<float>>> &outputs) override;
+
+    static utils::StatusCode Create(const std::shared_ptr<runtime::Operator<float>> &op,
+                                    std::shared_ptr<Layer<float>> &layer);
+
+private:
+    ShuffleMode mode_;
+    int32_t factor_;
+}; // class ShuffleLayer
+
+} // namespace layer
+} // namespace jennifer
+
+#endif // JENNIFER_LAYER_TRANSPOSE_HPP_
@@ -0,0 +1,84 @@
+#ifndef JENNIFER_LAYER_VECTOR_MATH_HPP_
+#define JENNIFER_LAYER_VECTOR_MATH_HPP_
+
+#include <cstdint>
+#include <cstring>
+
+namespace jennifer
+{
+namespace layer
+{
+
+// Float transcendentals without branches or library calls, so that loops over
+// them vectorize like plain arithmetic. std::exp and std::erf stay scalar calls
+// unless the build enables fast math.
+
+// bitwise select of a where condition holds and b elsewhere. GCC threads jumps
+// through a conditional expression and its constant arms, which leaves control
+// flow in the loop and keeps it scalar; the mask does not.
+inline float Select(bool condition, float a, float b)
+{
+    const int32_t mask = -static_cast<int32_t>(condition);
+    int32_t a_bits;
+    int32_t b_bits;
+    memcpy(&a_bits, &a, sizeof(a_bits));
+    memcpy(&b_bits, &b, sizeof(b_bits));
+    const int32_t bits = (a_bits & mask) | (b_bits & ~mask);
+    float result;
+    memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+// exp by Cody-Waite reduction to r in [-ln2/2, ln2/2] and the cephes polynomial,
+// within 2 ulp. Below -87.3 the result is 0, above 88 it saturates at exp(88).
+inline float VectorExp(float x)
+{
+    const float clamped = Select(x > 88.f, 88.f, Select(x < -87.3365f, -87.3365f, x));
+
+    // round x / ln2 to the nearest integer k with the 1.5 * 2^23 trick
+    const float magic = 12582912.f;
+    float k = clamped * 1.44269504088896341f + magic;
+    int32_t k_bits;
+    memcpy(&k_bits, &k, sizeof(k_bits));
+    k -= magic;
+    const int32_t exponent = k_bits - 0x4B400000;
+
+    const float r = (clamped - k * 0.693359375f) + k * 2.12194440e-4f;
+    float p = 1.9875691500e-4f;
+    p = p * r + 1.3981999507e-3f;
+    p = p * r + 8.3334519073e-3f;
+    p = p * r + 4.1665795894e-2f;
+    p = p * r + 1.6666665459e-1f;
+    p = p * r + 5.0000001201e-1f;
+    p = p * r * r + r + 1.f;
+
+    const int32_t scale_bits = (exponent + 127) << 23;
+    float scale;
+    memcpy(&scale, &scale_bits, sizeof(scale));
+    return Select(x < -87.3365f, 0.f, p * scale);
+}
+
+// Abramowitz and Stegun 7.1.26, absolute error below 5e-7 in float
+inline float VectorErf(float x)
+{
+    const float magnitude = Select(x < 0.f, -x, x);
+    const float a = Select(magnitude > 10.f, 10.f, magnitude);
+    const float t = 1.f / (1.f + 0.3275911f * a);
+    float p = 1.061405429f;
+    p = p * t - 1.453152027f;
+    p = p * t + 1.421413741f;
+    p = p * t - 0.284496736f;
+    p = p * t + 0.254829592f;
+    const float y = 1.f - p * t * VectorExp(-a * a);
+    return Select(x < 0.f, -y, y);
+}
+
+inline float VectorTanh(float x)
+{
+    return 1.f - 2.f / (VectorExp(2.f * x) + 1.f);
+}
+
+} // namespace layer
+} // namespace jennifer
+
+#endif // JENNIFER_LAYER_VECTOR_MATH_HPP_
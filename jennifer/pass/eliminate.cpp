@@ -0,0 +1,236 @@
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <set>
+#include <sstream>
+#include <unordered_map>
+
+#include "eliminate.hpp"
+
+namespace jennifer
+{
+namespace pass
+{
+
+EliminationReport &EliminationReport::operator+=(const EliminationReport &other)
+{
+    removed_operators += other.removed_operators;
+    removed_operands += other.removed_operands;
+    saved_bytes += other.saved_bytes;
+    removed_names.insert(removed_names.end(), other.removed_names.begin(), other.removed_names.end());
+    return *this;
+}
+
+static size_t AttributeBytes(const pnnx::Operator *op)
+{
+    size_t bytes = 0;
+    for (const auto &attr : op->attrs)
+    {
+        bytes += attr.second.data.size();
+    }
+    return bytes;
+}
+
+// detaches op from its inputs, deletes its outputs and op itself
+static void RemoveOperator(pnnx::Graph &graph, pnnx::Operator *op, EliminationReport &report)
+{
+    for (pnnx::Operand *input : op->inputs)
+    {
+        input->remove_consumer(op);
+    }
+    for (pnnx::Operand *output : op->outputs)
+    {
+        auto it = std::find(graph.operands.begin(), graph.operands.end(), output);
+        if (it != graph.operands.end())
+        {
+            graph.operands.erase(it);
+        }
+        delete output;
+        report.removed_operands++;
+    }
+
+    report.removed_operators++;
+    report.saved_bytes += AttributeBytes(op);
+    report.removed_names.push_back(op->name);
+
+    graph.ops.erase(std::find(graph.ops.begin(), graph.ops.end(), op));
+    delete op;
+}
+
+EliminationReport EliminateDeadCode(pnnx::Graph &graph, const std::vector<std::string> &outputs)
+{
+    std::set<const pnnx::Operator *> live;
+    for (const pnnx::Operator *op : graph.ops)
+    {
+        if (op->type == "pnnx.Input")
+        {
+            live.insert(op);
+        }
+        else if (op->type == "pnnx.Output" &&
+                 (outputs.empty() || std::find(outputs.begin(), outputs.end(), op->name) != outputs.end()))
+        {
+            live.insert(op);
+        }
+    }
+
+    // ops are topologically sorted, a single reverse sweep reaches every producer
+    for (auto it = graph.ops.rbegin(); it != graph.ops.rend(); ++it)
+    {
+        if (live.find(*it) == live.end())
+        {
+            continue;
+        }
+        for (const pnnx::Operand *input : (*it)->inputs)
+        {
+            if (input->producer)
+            {
+                live.insert(input->producer);
+            }
+        }
+    }
+
+    // remove consumers first so every removed operand is already unused
+    EliminationReport report;
+    for (int i = static_cast<int>(graph.ops.size()) - 1; i >= 0; --i)
+    {
+        pnnx::Operator *op = graph.ops[i];
+        if (live.find(op) == live.end())
+        {
+            RemoveOperator(graph, op, report);
+        }
+    }
+    std::reverse(report.removed_names.begin(), report.removed_names.end());
+    return report;
+}
+
+static bool IsRandom(const std::string &type)
+{
+    static const std::set<std::string> random_types = {
+        "torch.rand",      "torch.randn",      "torch.randint",  "torch.rand_like",
+        "torch.randn_like", "torch.randint_like", "torch.normal", "torch.bernoulli",
+        "torch.multinomial", "torch.empty",     "torch.empty_like", "F.dropout",
+    };
+    return random_types.find(type) != random_types.end();
+}
+
+static bool IsMergeable(const pnnx::Operator *op)
+{
+    if (op->type == "pnnx.Input" || op->type == "pnnx.Output" || op->outputs.empty() || IsRandom(op->type))
+    {
+        return false;
+    }
+    for (const auto &attr : op->attrs)
+    {
+        // attributes parsed without weights compare equal regardless of their values
+        if (attr.second.type != 0 && attr.second.data.empty())
+        {
+            return false;
+        }
+    }
+    for (const pnnx::Operand *output : op->outputs)
+    {
+        for (const pnnx::Operator *consumer : output->consumers)
+        {
+            // keep the names of the graph outputs
+            if (consumer->type == "pnnx.Output")
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static uint64_t HashBytes(const std::vector<char> &data)
+{
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ull;
+    for (char c : data)
+    {
+        hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ull;
+    }
+    return hash;
+}
+
+static std::string OperatorKey(const pnnx::Operator *op)
+{
+    std::ostringstream key;
+    key << op->type << '|' << op->outputs.size() << '|';
+    for (const pnnx::Operand *input : op->inputs)
+    {
+        key << static_cast<const void *>(input) << ',';
+    }
+    key << '|';
+    for (const std::string &name : op->inputnames)
+    {
+        key << name << ',';
+    }
+    key << '|';
+    for (const auto &param : op->params)
+    {
+        key << param.first << '=' << pnnx::Parameter::encode_to_string(param.second) << ',';
+    }
+    key << '|';
+    for (const auto &attr : op->attrs)
+    {
+        key << attr.first << '=' << attr.second.type << ':';
+        for (int dim : attr.second.shape)
+        {
+            key << dim << 'x';
+        }
+        key << ':' << HashBytes(attr.second.data) << ',';
+    }
+    return key.str();
+}
+
+EliminationReport EliminateCommonSubexpressions(pnnx::Graph &graph)
+{
+    EliminationReport report;
+    std::unordered_map<std::string, std::vector<pnnx::Operator *>> seen;
+
+    for (size_t i = 0; i < graph.ops.size();)
+    {
+        pnnx::Operator *op = graph.ops[i];
+        if (!IsMergeable(op))
+        {
+            ++i;
+            continue;
+        }
+
+        // inputs were already rewired to the surviving operands, so chains of
+        // duplicates collapse in a single forward sweep
+        std::vector<pnnx::Operator *> &candidates = seen[OperatorKey(op)];
+        pnnx::Operator *same = nullptr;
+        for (pnnx::Operator *candidate : candidates)
+        {
+            if (candidate->params == op->params && candidate->attrs == op->attrs)
+            {
+                same = candidate;
+                break;
+            }
+        }
+        if (!same)
+        {
+            candidates.push_back(op);
+            ++i;
+            continue;
+        }
+
+        for (size_t j = 0; j < op->outputs.size(); ++j)
+        {
+            pnnx::Operand *duplicate = op->outputs[j];
+            pnnx::Operand *survivor = same->outputs[j];
+            for (pnnx::Operator *consumer : duplicate->consumers)
+            {
+                std::replace(consumer->inputs.begin(), consumer->inputs.end(), duplicate, survivor);
+                survivor->consumers.push_back(consumer);
+            }
+            duplicate->consumers.clear();
+        }
+        RemoveOperator(graph, op, report);
+    }
+    return report;
+}
+
+} // namespace pass
+} // namespace jennifer
@@ -0,0 +1,40 @@
+#ifndef JENNIFER_PASS_ELIMINATE_HPP_
+#define JENNIFER_PASS_ELIMINATE_HPP_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "jennifer/runtime/pnnx/ir.h"
+
+namespace jennifer
+{
+namespace pass
+{
+
+struct EliminationReport
+{
+    int removed_operators = 0;
+    int removed_operands = 0;
+    // attribute bytes no longer held by the graph
+    size_t saved_bytes = 0;
+    std::vector<std::string> removed_names;
+
+    EliminationReport &operator+=(const EliminationReport &other);
+}; // struct EliminationReport
+
+// Removes the operators that do not reach a kept pnnx.Output. outputs names the
+// pnnx.Output operators to keep, an empty list keeps all of them and the others are
+// removed together with their dead producers. pnnx.Input operators are always kept
+// so the input signature of the graph does not change.
+EliminationReport EliminateDeadCode(pnnx::Graph &graph, const std::vector<std::string> &outputs = {});
+
+// Merges operators with the same type, params, attrs and input operands into the
+// first occurrence, rewiring the consumers of the duplicates. Operators producing
+// random values and operators feeding a pnnx.Output are never merged.
+EliminationReport EliminateCommonSubexpressions(pnnx::Graph &graph);
+
+} // namespace pass
+} // namespace jennifer
+
+#endif // JENNIFER_PASS_ELIMINATE_HPP_
@@ -0,0 +1,818 @@
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <numeric>
+
+#include "jennifer/layer/elementwise.hpp"
+#include "jennifer/runtime/shape_inference.hpp"
+
+#include "fold_constants.hpp"
+
+namespace jennifer
+{
+namespace pass
+{
+
+using runtime::Shape;
+
+// constant values widened to double, which holds every supported element type
+// (int64 up to 2^53) exactly
+struct Constant
+{
+    int type = 0;
+    Shape shape;
+    std::vector<double> data;
+};
+
+using Evaluator = std::function<bool(const pnnx::Operator *op, const std::vector<Constant> &inputs,
+                                     std::vector<Constant> &outputs)>;
+
+static size_t ElementCount(const Shape &shape)
+{
+    return std::accumulate(shape.begin(), shape.end(), size_t(1), std::multiplies<size_t>());
+}
+
+static std::vector<size_t> Strides(const Shape &shape)
+{
+    std::vector<size_t> strides(shape.size(), 1);
+    for (int i = static_cast<int>(shape.size()) - 2; i >= 0; --i)
+    {
+        strides[i] = strides[i + 1] * shape[i + 1];
+    }
+    return strides;
+}
+
+static int32_t NormalizeDim(int32_t dim, size_t rank)
+{
+    return dim < 0 ? dim + static_cast<int32_t>(rank) : dim;
+}
+
+static bool IsFloatType(int type)
+{
+    return type == 1 || type == 2 || type == 3 || type == 13;
+}
+
+static int IntegerRank(int type)
+{
+    // bool < u8 < i8 < i16 < i32 < i64
+    switch (type)
+    {
+    case 9: return 0;
+    case 8: return 1;
+    case 7: return 2;
+    case 6: return 3;
+    case 4: return 4;
+    case 5: return 5;
+    default: return -1;
+    }
+}
+
+static int PromoteType(int a, int b)
+{
+    if (IsFloatType(a) || IsFloatType(b))
+    {
+        return (a == 2 || b == 2) ? 2 : 1;
+    }
+    return IntegerRank(a) >= IntegerRank(b) ? a : b;
+}
+
+static bool LoadConstant(const pnnx::Operand *operand, Constant &constant)
+{
+    const pnnx::Operator *producer = operand->producer;
+    if (!producer || producer->type != "pnnx.Attribute" || producer->attrs.size() != 1)
+    {
+        return false;
+    }
+
+    const pnnx::Attribute &attr = producer->attrs.begin()->second;
+    if (attr.shape.empty() || attr.elemsize() == 0)
+    {
+        return false;
+    }
+    const size_t count = ElementCount(attr.shape);
+    if (attr.data.size() != count * attr.elemsize())
+    {
+        // shape only attribute, the weight was not loaded
+        return false;
+    }
+
+    constant.type = attr.type;
+    constant.shape = attr.shape;
+    constant.data.resize(count);
+
+    const char *p = attr.data.data();
+    for (size_t i = 0; i < count; ++i)
+    {
+        double &v = constant.data[i];
+        switch (attr.type)
+        {
+        case 1: v = reinterpret_cast<const float *>(p)[i]; break;
+        case 2: v = reinterpret_cast<const double *>(p)[i]; break;
+        case 4: v = reinterpret_cast<const int32_t *>(p)[i]; break;
+        case 5: v = static_cast<double>(reinterpret_cast<const int64_t *>(p)[i]); break;
+        case 6: v = reinterpret_cast<const int16_t *>(p)[i]; break;
+        case 7: v = reinterpret_cast<const int8_t *>(p)[i]; break;
+        case 8: v = reinterpret_cast<const uint8_t *>(p)[i]; break;
+        case 9: v = p[i] ? 1.0 : 0.0; break;
+        case 13: {
+            uint32_t bits = static_cast<uint32_t>(reinterpret_cast<const uint16_t *>(p)[i]) << 16;
+            float f;
+            memcpy(&f, &bits, sizeof(f));
+            v = f;
+            break;
+        }
+        case 3: break;
+        default: return false;
+        }
+    }
+
+    if (attr.type == 3)
+    {
+        std::vector<float> values = attr.get_float32_data();
+        std::copy(values.begin(), values.end(), constant.data.begin());
+    }
+    return true;
+}
+
+static void StoreConstant(const Constant &constant, pnnx::Attribute &attr)
+{
+    // half precision results are kept in f32
+    attr.type = (constant.type == 3 || constant.type == 13) ? 1 : constant.type;
+    attr.shape = constant.shape;
+    attr.data.resize(constant.data.size() * attr.elemsize());
+
+    char *p = attr.data.data();
+    for (size_t i = 0; i < constant.data.size(); ++i)
+    {
+        const double v = constant.data[i];
+        switch (attr.type)
+        {
+        case 1: reinterpret_cast<float *>(p)[i] = static_cast<float>(v); break;
+        case 2: reinterpret_cast<double *>(p)[i] = v; break;
+        case 4: reinterpret_cast<int32_t *>(p)[i] = static_cast<int32_t>(v); break;
+        case 5: reinterpret_cast<int64_t *>(p)[i] = static_cast<int64_t>(v); break;
+        case 6: reinterpret_cast<int16_t *>(p)[i] = static_cast<int16_t>(v); break;
+        case 7: reinterpret_cast<int8_t *>(p)[i] = static_cast<int8_t>(v); break;
+        case 8: reinterpret_cast<uint8_t *>(p)[i] = static_cast<uint8_t>(v); break;
+        case 9: p[i] = v != 0.0 ? 1 : 0; break;
+        default: LOG(FATAL) << "Unsupported constant type " << attr.type;
+        }
+    }
+}
+
+// output shape from the runtime shape function, data untouched
+static bool EvalView(const pnnx::Operator *op, const std::vector<Constant> &inputs, std::vector<Constant> &outputs)
+{
+    std::vector<Shape> shapes;
+    if (inputs.size() != 1 || runtime::ShapeInference::InferOperator(op, {inputs[0].shape}, shapes) != utils::StatusCode::Success)
+    {
+        return false;
+    }
+    if (ElementCount(shapes[0]) != inputs[0].data.size())
+    {
+        return false;
+    }
+
+    outputs.assign(1, inputs[0]);
+    outputs[0].shape = shapes[0];
+    return true;
+}
+
+static Constant Permute(const Constant &input, const std::vector<int32_t> &dims)
+{
+    const size_t rank = input.shape.size();
+    const std::vector<size_t> in_strides = Strides(input.shape);
+
+    Constant output;
+    output.type = input.type;
+    output.shape.resize(rank);
+    for (size_t i = 0; i < rank; ++i)
+    {
+        output.shape[i] = input.shape[dims[i]];
+    }
+    output.data.resize(input.data.size());
+
+    std::vector<int32_t> coords(rank, 0);
+    for (size_t o = 0; o < output.data.size(); ++o)
+    {
+        size_t src = 0;
+        for (size_t i = 0; i < rank; ++i)
+        {
+            src += coords[i] * in_strides[dims[i]];
+        }
+        output.data[o] = input.data[src];
+
+        for (int i = static_cast<int>(rank) - 1; i >= 0; --i)
+        {
+            if (++coords[i] < output.shape[i])
+            {
+                break;
+            }
+            coords[i] = 0;
+        }
+    }
+    return output;
+}
+
+static bool EvalPermute(const pnnx::Operator *op, const std::vector<Constant> &inputs, std::vector<Constant> &outputs)
+{
+    auto it = op->params.find("dims");
+    if (inputs.size() != 1 || it == op->params.end() || it->second.ai.size() != inputs[0].shape.size())
+    {
+        return false;
+    }
+
+    std::vector<int32_t> dims = it->second.ai;
+    for (int32_t &d : dims)
+    {
+        d = NormalizeDim(d, dims.size());
+    }
+    outputs.assign(1, Permute(inputs[0], dims));
+    return true;
+}
+
+static bool EvalTranspose(const pnnx::Operator *op, const std::vector<Constant> &inputs, std::vector<Constant> &outputs)
+{
+    if (inputs.size() != 1 || !op->has_param("dim0") || !op->has_param("dim1"))
+    {
+        return false;
+    }
+
+    const size_t rank = inputs[0].shape.size();
+    std::vector<int32_t> dims(rank);
+    std::iota(dims.begin(), dims.end(), 0);
+    std::swap(dims[NormalizeDim(op->params.at("dim0").i, rank)], dims[NormalizeDim(op->params.at("dim1").i, rank)]);
+    outputs.assign(1, Permute(inputs[0], dims));
+    return true;
+}
+
+static bool EvalConcat(const pnnx::Operator *op, const std::vector<Constant> &inputs, std::vector<Constant> &outputs)
+{
+    std::vector<Shape> input_shapes;
+    for (const Constant &input : inputs)
+    {
+        input_shapes.push_back(input.shape);
+    }
+    std::vector<Shape> shapes;
+    if (runtime::ShapeInference::InferOperator(op, input_shapes, shapes) != utils::StatusCode::Success)
+    {
+        return false;
+    }
+
+    const size_t rank = shapes[0].size();
+    const int32_t dim = NormalizeDim(op->has_param("dim") ? op->params.at("dim").i : 0, rank);
+    const size_t outer = ElementCount(Shape(shapes[0].begin(), shapes[0].begin() + dim));
+
+    Constant output;
+    output.type = inputs[0].type;
+    output.shape = shapes[0];
+    output.data.reserve(ElementCount(output.shape));
+    for (const Constant &input : inputs)
+    {
+        output.type = PromoteType(output.type, input.type);
+    }
+
+    for (size_t o = 0; o < outer; ++o)
+    {
+        for (const Constant &input : inputs)
+        {
+            // a stacked input is a size one slice along dim, so both cases copy a contiguous block
+            const size_t block = input.data.size() / outer;
+            output.data.insert(output.data.end(), input.data.begin() + o * block, input.data.begin() + (o + 1) * block);
+        }
+    }
+
+    outputs.assign(1, output);
+    return true;
+}
+
+static bool EvalSlice(const pnnx::Operator *op, const std::vector<Constant> &inputs, std::vector<Constant> &outputs)
+{
+    std::vector<Shape> shapes;
+    if (inputs.size() != 1 || runtime::ShapeInference::InferOperator(op, {inputs[0].shape}, shapes) != utils::StatusCode::Success)
+    {
+        return false;
+    }
+
+    const Constant &input = inputs[0];
+    const int32_t dim = NormalizeDim(op->params.at("dim").i, input.shape.size());
+    const int32_t size = input.shape[dim];
+    const int32_t start_param = op->params.at("start").i;
+    const int32_t start = start_param < 0 ? std::max(start_param + size, 0) : std::min(start_param, size);
+    const int32_t step = op->has_param("step") ? op->params.at("step").i : 1;
+
+    const size_t outer = ElementCount(Shape(input.shape.begin(), input.shape.begin() + dim));
+    const size_t inner = ElementCount(Shape(input.shape.begin() + dim + 1, input.shape.end()));
+    const int32_t count = shapes[0][dim];
+
+    Constant output;
+    output.type = input.type;
+    output.shape = shapes[0];
+    for (size_t o = 0; o < outer; ++o)
+    {
+        for (int32_t k = 0; k < count; ++k)
+        {
+            const size_t src = (o * size + start + k * step) * inner;
+            output.data.insert(output.data.end(), input.data.begin() + src, input.data.begin() + src + inner);
+        }
+    }
+
+    outputs.assign(1, output);
+    return true;
+}
+
+static bool EvalChunk(const pnnx::Operator *op, const std::vector<Constant> &inputs, std::vector<Constant> &outputs)
+{
+    std::vector<Shape> shapes;
+    if (inputs.size() != 1 || runtime::ShapeInference::InferOperator(op, {inputs[0].shape}, shapes) != utils::StatusCode::Success)
+    {
+        return false;
+    }
+
+    const Constant &input = inputs[0];
+    const int32_t dim = NormalizeDim(op->params.at("dim").i, input.shape.size());
+    const size_t outer = ElementCount(Shape(input.shape.begin(), input.shape.begin() + dim));
+    const size_t inner = ElementCount(Shape(input.shape.begin() + dim + 1, input.shape.end()));
+
+    outputs.clear();
+    int32_t begin = 0;
+    for (const Shape &shape : shapes)
+    {
+        Constant output;
+        output.type = input.type;
+        output.shape = shape;
+        for (size_t o = 0; o < outer; ++o)
+        {
+            const size_t src = (o * input.shape[dim] + begin) * inner;
+            output.data.insert(output.data.end(), input.data.begin() + src, input.data.begin() + src + shape[dim] * inner);
+        }
+        begin += shape[dim];
+        outputs.push_back(output);
+    }
+    return true;
+}
+
+static bool EvalBinary(const Constant &a, const Constant &b, int type, const std::function<double(double, double)> &f,
+                       Constant &output)
+{
+    const size_t rank = std::max(a.shape.size(), b.shape.size());
+    Shape a_shape(rank - a.shape.size(), 1);
+    Shape b_shape(rank - b.shape.size(), 1);
+    a_shape.insert(a_shape.end(), a.shape.begin(), a.shape.end());
+    b_shape.insert(b_shape.end(), b.shape.begin(), b.shape.end());
+
+    output.type = type;
+    output.shape.resize(rank);
+    for (size_t i = 0; i < rank; ++i)
+    {
+        if (a_shape[i] != b_shape[i] && a_shape[i] != 1 && b_shape[i] != 1)
+        {
+            return false;
+        }
+        output.shape[i] = std::max(a_shape[i], b_shape[i]);
+    }
+
+    // broadcast dims read with a zero stride
+    std::vector<size_t> a_strides = Strides(a_shape);
+    std::vector<size_t> b_strides = Strides(b_shape);
+    for (size_t i = 0; i < rank; ++i)
+    {
+        if (a_shape[i] == 1) a_strides[i] = 0;
+        if (b_shape[i] == 1) b_strides[i] = 0;
+    }
+
+    output.data.resize(ElementCount(output.shape));
+    std::vector<int32_t> coords(rank, 0);
+    for (size_t o = 0; o < output.data.size(); ++o)
+    {
+        size_t ia = 0;
+        size_t ib = 0;
+        for (size_t i = 0; i < rank; ++i)
+        {
+            ia += coords[i] * a_strides[i];
+            ib += coords[i] * b_strides[i];
+        }
+        output.data[o] = f(a.data[ia], b.data[ib]);
+
+        for (int i = static_cast<int>(rank) - 1; i >= 0; --i)
+        {
+            if (++coords[i] < output.shape[i])
+            {
+                break;
+            }
+            coords[i] = 0;
+        }
+    }
+    return true;
+}
+
+static bool EvalArithmetic(const pnnx::Operator *op, const std::vector<Constant> &inputs, std::vector<Constant> &outputs)
+{
+    if (inputs.size() != 2)
+    {
+        return false;
+    }
+
+    const Constant &a = inputs[0];
+    const Constant &b = inputs[1];
+    int type = PromoteType(a.type, b.type);
+
+    double alpha = 1.0;
+    if (op->has_param("alpha"))
+    {
+        const pnnx::Parameter &p = op->params.at("alpha");
+        alpha = p.type == 3 ? p.f : p.i;
+    }
+
+    std::function<double(double, double)> f;
+    if (op->type == "torch.add")
+    {
+        f = [alpha](double x, double y) { return x + alpha * y; };
+    }
+    else if (op->type == "torch.sub")
+    {
+        f = [alpha](double x, double y) { return x - alpha * y; };
+    }
+    else if (op->type == "torch.mul")
+    {
+        f = [](double x, double y) { return x * y; };
+    }
+    else if (op->type == "torch.div")
+    {
+        std::string rounding_mode;
+        if (op->has_param("rounding_mode") && op->params.at("rounding_mode").type == 4)
+        {
+            rounding_mode = op->params.at("rounding_mode").s;
+        }
+        if (rounding_mode == "trunc")
+        {
+            f = [](double x, double y) { return std::trunc(x / y); };
+        }
+        else if (rounding_mode == "floor")
+        {
+            f = [](double x, double y) { return std::floor(x / y); };
+        }
+        else
+        {
+            // true division always produces floating point
+            type = PromoteType(type, 1);
+            f = [](double x, double y) { return x / y; };
+        }
+    }
+    else if (op->type == "torch.maximum")
+    {
+        f = [](double x, double y) { return std::max(x, y); };
+    }
+    else if (op->type == "torch.minimum")
+    {
+        f = [](double x, double y) { return std::min(x, y); };
+    }
+    else if (op->type == "torch.pow")
+    {
+        f = [](double x, double y) { return std::pow(x, y); };
+    }
+    else
+    {
+        return false;
+    }
+
+    Constant output;
+    if (!EvalBinary(a, b, type, f, output))
+    {
+        return false;
+    }
+    outputs.assign(1, output);
+    return true;
+}
+
+static bool EvalUnary(const pnnx::Operator *op, const std::vector<Constant> &inputs, std::vector<Constant> &outputs)
+{
+    if (inputs.size() != 1)
+    {
+        return false;
+    }
+
+    const std::string &t = op->type;
+    bool to_float = true;
+    std::function<double(double)> f;
+    if (t == "torch.neg")
+    {
+        f = [](double x) { return -x; };
+        to_float = false;
+    }
+    else if (t == "torch.abs")
+    {
+        f = [](double x) { return std::fabs(x); };
+        to_float = false;
+    }
+    else if (t == "torch.square")
+    {
+        f = [](double x) { return x * x; };
+        to_float = false;
+    }
+    else if (t == "nn.ReLU" || t == "F.relu")
+    {
+        f = [](double x) { return std::max(x, 0.0); };
+        to_float = false;
+    }
+    else if (t == "torch.clamp")
+    {
+        double lo = -INFINITY;
+        double hi = INFINITY;
+        auto bound = [op](const char *key, double &v) {
+            auto it = op->params.find(key);
+            if (it != op->params.end() && it->second.type == 2) v = it->second.i;
+            if (it != op->params.end() && it->second.type == 3) v = it->second.f;
+        };
+        bound("min", lo);
+        bound("max", hi);
+        f = [lo, hi](double x) { return std::min(std::max(x, lo), hi); };
+        to_float = false;
+    }
+    else if (t == "torch.sqrt")
+    {
+        f = [](double x) { return std::sqrt(x); };
+    }
+    else if (t == "torch.rsqrt")
+    {
+        f = [](double x) { return 1.0 / std::sqrt(x); };
+    }
+    else if (t == "torch.exp")
+    {
+        f = [](double x) { return std::exp(x); };
+    }
+    else if (t == "torch.log")
+    {
+        f = [](double x) { return std::log(x); };
+    }
+    else if (t == "torch.sigmoid" || t == "F.sigmoid" || t == "nn.Sigmoid")
+    {
+        f = [](double x) { return 1.0 / (1.0 + std::exp(-x)); };
+    }
+    else if (t == "torch.tanh" || t == "F.tanh" || t == "nn.Tanh")
+    {
+        f = [](double x) { return std::tanh(x); };
+    }
+    else
+    {
+        return false;
+    }
+
+    Constant output = inputs[0];
+    if (to_float)
+    {
+        output.type = PromoteType(output.type, 1);
+    }
+    std::transform(output.data.begin(), output.data.end(), output.data.begin(), f);
+    outputs.assign(1, output);
+    return true;
+}
+
+// A list of shape values becomes an i64 constant. Pointwise arithmetic runs the
+// compiled program in f32 like the runtime does, so it folds float inputs only.
+static bool EvalExpression(const pnnx::Operator *op, const std::vector<Constant> &inputs,
+                           std::vector<Constant> &outputs)
+{
+    auto expr = op->params.find("expr");
+    layer::ElementwiseProgram program;
+    if (expr == op->params.end() || expr->second.type != 4 || !program.Compile(expr->second.s)
+        || static_cast<size_t>(program.input_count()) > inputs.size())
+    {
+        return false;
+    }
+
+    std::vector<Shape> shapes;
+    for (const Constant &input : inputs)
+    {
+        shapes.push_back(input.shape);
+    }
+
+    Constant output;
+    if (program.is_list())
+    {
+        output.type = 5;
+        if (!program.EvaluateShape(shapes, output.data))
+        {
+            return false;
+        }
+        output.shape = {static_cast<int32_t>(output.data.size())};
+        outputs.assign(1, output);
+        return true;
+    }
+
+    // the shape the tensor inputs broadcast to, data is overwritten below
+    output.type = 1;
+    for (int i = 0; i < program.input_count(); ++i)
+    {
+        if (!program.uses_tensor(i))
+        {
+            continue;
+        }
+        if (!IsFloatType(inputs[i].type))
+        {
+            return false;
+        }
+        Constant zero;
+        zero.shape = output.shape;
+        zero.data.assign(ElementCount(zero.shape), 0.0);
+        if (!EvalBinary(zero, inputs[i], 1, [](double x, double y) { return x + y; }, output))
+        {
+            return false;
+        }
+    }
+    std::vector<double> scalars;
+    if (output.shape.empty() || !program.EvaluateScalars(shapes, scalars))
+    {
+        return false;
+    }
+
+    // every tensor input expanded to the output shape, then one contiguous run
+    const size_t count = ElementCount(output.shape);
+    std::vector<std::vector<float>> expanded(program.input_count());
+    std::vector<layer::ElementwiseOperand> operands(program.input_count());
+    for (int i = 0; i < program.input_count(); ++i)
+    {
+        if (!program.uses_tensor(i))
+        {
+            continue;
+        }
+        Constant zero;
+        zero.shape = output.shape;
+        zero.data.assign(count, 0.0);
+        Constant broadcast;
+        EvalBinary(zero, inputs[i], 1, [](double, double y) { return y; }, broadcast);
+        expanded[i].assign(broadcast.data.begin(), broadcast.data.end());
+        operands[i].data = expanded[i].data();
+        operands[i].strides[2] = 1;
+    }
+
+    const int64_t dims[3] = {1, 1, static_cast<int64_t>(count)};
+    std::vector<float> result(count);
+    std::vector<float> scratch;
+    program.Run(operands, dims, result.data(), scratch, scalars);
+    output.data.assign(result.begin(), result.end());
+    outputs.assign(1, output);
+    return true;
+}
+
+static const std::map<std::string, Evaluator> &Evaluators()
+{
+    static const std::map<std::string, Evaluator> *evaluators = [] {
+        auto *registry = new std::map<std::string, Evaluator>();
+
+        const char *view_types[] = {
+            "Tensor.reshape", "Tensor.view", "torch.reshape", "torch.flatten", "nn.Flatten", "torch.squeeze",
+            "torch.unsqueeze", "Tensor.contiguous", "torch.clone", "Tensor.clone", "nn.Identity", "nn.Dropout",
+        };
+        for (const char *type : view_types)
+        {
+            (*registry)[type] = EvalView;
+        }
+
+        const char *arithmetic_types[] = {
+            "torch.add", "torch.sub", "torch.mul", "torch.div", "torch.maximum", "torch.minimum", "torch.pow",
+        };
+        for (const char *type : arithmetic_types)
+        {
+            (*registry)[type] = EvalArithmetic;
+        }
+
+        const char *unary_types[] = {
+            "torch.neg", "torch.abs", "torch.square", "nn.ReLU", "F.relu", "torch.clamp", "torch.sqrt",
+            "torch.rsqrt", "torch.exp", "torch.log", "torch.sigmoid", "F.sigmoid", "nn.Sigmoid",
+            "torch.tanh", "F.tanh", "nn.Tanh",
+        };
+        for (const char *type : unary_types)
+        {
+            (*registry)[type] = EvalUnary;
+        }
+
+        (*registry)["torch.permute"] = EvalPermute;
+        (*registry)["Tensor.permute"] = EvalPermute;
+        (*registry)["torch.transpose"] = EvalTranspose;
+        (*registry)["Tensor.transpose"] = EvalTranspose;
+        (*registry)["torch.cat"] = EvalConcat;
+        (*registry)["torch.stack"] = EvalConcat;
+        (*registry)["Tensor.slice"] = EvalSlice;
+        (*registry)["torch.chunk"] = EvalChunk;
+        (*registry)["pnnx.Expression"] = EvalExpression;
+        return registry;
+    }();
+    return *evaluators;
+}
+
+static int RemoveUnusedConstants(pnnx::Graph &graph)
+{
+    int removed = 0;
+    for (size_t i = 0; i < graph.ops.size();)
+    {
+        pnnx::Operator *op = graph.ops[i];
+        bool unused = op->type == "pnnx.Attribute";
+        for (const pnnx::Operand *output : op->outputs)
+        {
+            unused = unused && output->consumers.empty();
+        }
+        if (!unused)
+        {
+            ++i;
+            continue;
+        }
+
+        for (pnnx::Operand *output : op->outputs)
+        {
+            graph.operands.erase(std::find(graph.operands.begin(), graph.operands.end(), output));
+            delete output;
+        }
+        graph.ops.erase(graph.ops.begin() + i);
+        delete op;
+        removed++;
+    }
+    return removed;
+}
+
+int FoldConstants(pnnx::Graph &graph, size_t max_result_bytes)
+{
+    const std::map<std::string, Evaluator> &evaluators = Evaluators();
+
+    int folded = 0;
+    for (size_t i = 0; i < graph.ops.size(); ++i)
+    {
+        pnnx::Operator *op = graph.ops[i];
+        auto evaluator = evaluators.find(op->type);
+        if (evaluator == evaluators.end() || op->inputs.empty() || op->outputs.empty())
+        {
+            continue;
+        }
+
+        std::vector<Constant> inputs(op->inputs.size());
+        bool all_constant = true;
+        for (size_t j = 0; j < op->inputs.size() && all_constant; ++j)
+        {
+            all_constant = LoadConstant(op->inputs[j], inputs[j]);
+        }
+        if (!all_constant)
+        {
+            continue;
+        }
+
+        std::vector<Constant> outputs;
+        if (!evaluator->second(op, inputs, outputs) || outputs.size() != op->outputs.size())
+        {
+            continue;
+        }
+
+        size_t result_bytes = 0;
+        for (const Constant &output : outputs)
+        {
+            result_bytes += output.data.size() * sizeof(float);
+        }
+        if (result_bytes > max_result_bytes)
+        {
+            continue;
+        }
+
+        // the new constants take the place of op so the operator list stays topologically sorted
+        for (size_t j = 0; j < op->outputs.size(); ++j)
+        {
+            pnnx::Operand *operand = op->outputs[j];
+            pnnx::Operator *constant = graph.new_operator_before("pnnx.Attribute", "pnnx_fold_" + operand->name, op);
+            pnnx::Attribute &attr = constant->attrs["data"];
+            StoreConstant(outputs[j], attr);
+
+            constant->outputs.push_back(operand);
+            operand->producer = constant;
+            operand->type = attr.type;
+            operand->shape = attr.shape;
+            for (auto it = operand->params.begin(); it != operand->params.end();)
+            {
+                it = it->first.compare(0, 9, "__shape__") == 0 ? operand->params.erase(it) : std::next(it);
+            }
+        }
+
+        for (pnnx::Operand *input : op->inputs)
+        {
+            input->remove_consumer(op);
+        }
+
+        i += op->outputs.size();
+        graph.ops.erase(graph.ops.begin() + i);
+        delete op;
+        --i;
+        folded++;
+    }
+
+    const int removed = RemoveUnusedConstants(graph);
+    if (folded != 0)
+    {
+        LOG(INFO) << "Folded " << folded << " constant operators, removed " << removed << " unused constants";
+    }
+    return folded;
+}
+
+} // namespace pass
+} // namespace jennifer
@@ -0,0 +1,22 @@
+#ifndef JENNIFER_PASS_FOLD_CONSTANTS_HPP_
+#define JENNIFER_PASS_FOLD_CONSTANTS_HPP_
+
+#include <cstddef>
+
+#include "jennifer/runtime/pnnx/ir.h"
+
+namespace jennifer
+{
+namespace pass
+{
+
+// Evaluates operators whose inputs are all produced by pnnx.Attribute and replaces
+// them with pnnx.Attribute operators carrying the result, then drops the constants
+// that are no longer consumed. Results larger than max_result_bytes are left alone
+// so that folding never inflates the weights. Returns the number of folded operators.
+int FoldConstants(pnnx::Graph &graph, size_t max_result_bytes = 64 * 1024 * 1024);
+
+} // namespace pass
+} // namespace jennifer
+
+#endif // JENNIFER_PASS_FOLD_CONSTANTS_HPP_
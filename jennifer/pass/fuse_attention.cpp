@@ -0,0 +1,238 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "fuse_attention.hpp"
+#include "fuse_elementwise.hpp"
+
+namespace jennifer
+{
+namespace pass
+{
+
+static int NormalizeDim(int dim, int rank)
+{
+    return dim < 0 ? dim + rank : dim;
+}
+
+static bool IsFloatOperand(const pnnx::Operand *operand)
+{
+    return operand->type == 0 || operand->type == 1;
+}
+
+// the operator producing operand when operand has no other consumer
+static pnnx::Operator *OnlyProducer(const pnnx::Operand *operand, const std::string &type)
+{
+    if (operand->consumers.size() != 1 || operand->producer == nullptr || !IsFloatOperand(operand))
+    {
+        return nullptr;
+    }
+    return type.empty() || operand->producer->type == type ? operand->producer : nullptr;
+}
+
+static bool StartsWith(const std::string &text, const std::string &prefix)
+{
+    return text.compare(0, prefix.size(), prefix) == 0;
+}
+
+// the positive factor of a pointwise operator that multiplies or divides @0 by a number
+static bool ScaleFactor(const pnnx::Operator *op, double &scale)
+{
+    std::string expr;
+    if (op->inputs.size() != 1 || !PointwiseExpression(op, expr) || expr.back() != ')')
+    {
+        return false;
+    }
+
+    std::string number;
+    if (StartsWith(expr, "mul(@0,") || StartsWith(expr, "div(@0,"))
+    {
+        number = expr.substr(7, expr.size() - 8);
+    }
+    else if (StartsWith(expr, "mul(") && expr.size() > 9 && expr.compare(expr.size() - 4, 4, ",@0)") == 0)
+    {
+        number = expr.substr(4, expr.size() - 8);
+    }
+    else
+    {
+        return false;
+    }
+
+    char *end = nullptr;
+    scale = strtod(number.c_str(), &end);
+    if (number.empty() || end != number.c_str() + number.size() || !std::isfinite(scale) || scale <= 0.0)
+    {
+        return false;
+    }
+    if (StartsWith(expr, "div("))
+    {
+        scale = 1.0 / scale;
+    }
+    return true;
+}
+
+// true when op swaps the last two dims of its rank input and nothing else
+static bool SwapsLastDims(const pnnx::Operator *op, int rank)
+{
+    if (op == nullptr || op->inputs.size() != 1 || static_cast<int>(op->inputs[0]->shape.size()) != rank)
+    {
+        return false;
+    }
+    if (op->type == "torch.transpose")
+    {
+        auto dim0 = op->params.find("dim0");
+        auto dim1 = op->params.find("dim1");
+        if (dim0 == op->params.end() || dim1 == op->params.end() || dim0->second.type != 2 || dim1->second.type != 2)
+        {
+            return false;
+        }
+        const int a = NormalizeDim(dim0->second.i, rank);
+        const int b = NormalizeDim(dim1->second.i, rank);
+        return std::min(a, b) == rank - 2 && std::max(a, b) == rank - 1;
+    }
+    if (op->type == "Tensor.permute")
+    {
+        auto dims = op->params.find("dims");
+        if (dims == op->params.end() || dims->second.type != 5 || static_cast<int>(dims->second.ai.size()) != rank)
+        {
+            return false;
+        }
+        for (int i = 0; i < rank; ++i)
+        {
+            const int expected = i < rank - 2 ? i : (i == rank - 2 ? rank - 1 : rank - 2);
+            if (NormalizeDim(dims->second.ai[i], rank) != expected)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+struct AttentionMatch
+{
+    pnnx::Operator *output;
+    pnnx::Operator *softmax;
+    pnnx::Operator *scale;
+    pnnx::Operator *scores;
+    pnnx::Operator *transpose;
+    double factor;
+}; // struct AttentionMatch
+
+static bool MatchAttention(pnnx::Operator *op, AttentionMatch &match)
+{
+    if (op->type != "torch.matmul" || op->inputs.size() != 2 || op->outputs.size() != 1)
+    {
+        return false;
+    }
+    match.output = op;
+
+    pnnx::Operator *softmax = OnlyProducer(op->inputs[0], "");
+    if (softmax == nullptr || (softmax->type != "F.softmax" && softmax->type != "nn.Softmax")
+        || softmax->inputs.size() != 1)
+    {
+        return false;
+    }
+    const int rank = static_cast<int>(softmax->inputs[0]->shape.size());
+    auto dim = softmax->params.find("dim");
+    if (rank < 3 || dim == softmax->params.end() || dim->second.type != 2
+        || NormalizeDim(dim->second.i, rank) != rank - 1)
+    {
+        return false;
+    }
+    match.softmax = softmax;
+
+    pnnx::Operator *producer = OnlyProducer(softmax->inputs[0], "");
+    match.scale = nullptr;
+    match.factor = 1.0;
+    if (producer != nullptr && ScaleFactor(producer, match.factor))
+    {
+        match.scale = producer;
+        producer = OnlyProducer(producer->inputs[0], "");
+    }
+    if (producer == nullptr || producer->type != "torch.matmul" || producer->inputs.size() != 2)
+    {
+        return false;
+    }
+    match.scores = producer;
+
+    match.transpose = producer->inputs[1]->producer;
+    if (!SwapsLastDims(match.transpose, rank) || static_cast<int>(producer->inputs[0]->shape.size()) != rank
+        || static_cast<int>(op->inputs[1]->shape.size()) != rank)
+    {
+        return false;
+    }
+    return IsFloatOperand(producer->inputs[0]) && IsFloatOperand(match.transpose->inputs[0])
+           && IsFloatOperand(op->inputs[1]);
+}
+
+static void RemoveOperator(pnnx::Graph &graph, pnnx::Operator *op)
+{
+    for (pnnx::Operand *input : op->inputs)
+    {
+        input->remove_consumer(op);
+    }
+    for (pnnx::Operand *output : op->outputs)
+    {
+        graph.operands.erase(std::find(graph.operands.begin(), graph.operands.end(), output));
+        delete output;
+    }
+    graph.ops.erase(std::find(graph.ops.begin(), graph.ops.end(), op));
+    delete op;
+}
+
+int FuseAttention(pnnx::Graph &graph)
+{
+    std::vector<AttentionMatch> matches;
+    for (pnnx::Operator *op : graph.ops)
+    {
+        AttentionMatch match;
+        if (MatchAttention(op, match))
+        {
+            matches.push_back(match);
+        }
+    }
+
+    for (const AttentionMatch &match : matches)
+    {
+        pnnx::Operand *query = match.scores->inputs[0];
+        pnnx::Operand *key = match.transpose->inputs[0];
+        pnnx::Operand *value = match.output->inputs[1];
+
+        pnnx::Operator *attention =
+            graph.new_operator_before("F.scaled_dot_product_attention", match.output->name, match.output);
+        attention->params["dropout_p"] = 0.f;
+        attention->params["is_causal"] = false;
+        attention->params["scale"] = static_cast<float>(match.factor);
+        for (pnnx::Operand *input : {query, key, value})
+        {
+            input->consumers.push_back(attention);
+            attention->inputs.push_back(input);
+        }
+
+        pnnx::Operand *output = match.output->outputs[0];
+        output->producer = attention;
+        attention->outputs.push_back(output);
+        match.output->outputs.clear();
+
+        // consumers first, a transpose feeding other operators stays
+        RemoveOperator(graph, match.output);
+        RemoveOperator(graph, match.softmax);
+        if (match.scale != nullptr)
+        {
+            RemoveOperator(graph, match.scale);
+        }
+        RemoveOperator(graph, match.scores);
+        if (match.transpose->outputs[0]->consumers.empty())
+        {
+            RemoveOperator(graph, match.transpose);
+        }
+    }
+    return static_cast<int>(matches.size());
+}
+
+} // namespace pass
+} // namespace jennifer
@@ -0,0 +1,22 @@
+#ifndef JENNIFER_PASS_FUSE_ATTENTION_HPP_
+#define JENNIFER_PASS_FUSE_ATTENTION_HPP_
+
+#include "jennifer/runtime/pnnx/ir.h"
+
+namespace jennifer
+{
+namespace pass
+{
+
+// Replaces manual attention, torch.matmul(softmax(torch.matmul(q, k^T) * scale, -1), v)
+// with k^T a transpose or permute of the last two dims and the scale an optional
+// multiply or divide by a number, with one F.scaled_dot_product_attention so the
+// scores are never materialized. Every intermediate must have the next operator
+// as its only consumer; a transpose that is used elsewhere stays in the graph.
+// Returns the number of attention blocks replaced.
+int FuseAttention(pnnx::Graph &graph);
+
+} // namespace pass
+} // namespace jennifer
+
+#endif // JENNIFER_PASS_FUSE_ATTENTION_HPP_
@@ -0,0 +1,391 @@
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <map>
+#include <set>
+
+#include "jennifer/layer/elementwise.hpp"
+
+#include "fuse_elementwise.hpp"
+
+namespace jennifer
+{
+namespace pass
+{
+
+// f32 or an operand exported without a type
+static bool IsFloatOperand(const pnnx::Operand *operand)
+{
+    return operand->type == 0 || operand->type == 1;
+}
+
+// true when key holds a number, value is left alone when key is absent or None
+static bool GetNumber(const pnnx::Operator *op, const std::string &key, double &value, bool &found)
+{
+    found = false;
+    auto it = op->params.find(key);
+    if (it == op->params.end() || it->second.type == 0)
+    {
+        return true;
+    }
+
+    if (it->second.type == 2)
+    {
+        value = it->second.i;
+    }
+    else if (it->second.type == 3)
+    {
+        value = it->second.f;
+    }
+    else
+    {
+        return false;
+    }
+    found = true;
+    return std::isfinite(value);
+}
+
+static bool GetNumber(const pnnx::Operator *op, const std::string &key, double &value)
+{
+    bool found = false;
+    return GetNumber(op, key, value, found);
+}
+
+// shortest text that reads back as the same float
+static std::string FormatNumber(double value)
+{
+    char text[32];
+    snprintf(text, sizeof(text), "%.9g", static_cast<float>(value));
+    return text;
+}
+
+static std::string GetString(const pnnx::Operator *op, const std::string &key)
+{
+    auto it = op->params.find(key);
+    return it != op->params.end() && it->second.type == 4 ? it->second.s : std::string();
+}
+
+static bool UnaryExpression(const pnnx::Operator *op, std::string &expr)
+{
+    static const std::map<std::string, std::string> kFunctions = {
+        {"nn.ReLU", "relu"}, {"F.relu", "relu"}, {"nn.Sigmoid", "sigmoid"}, {"F.sigmoid", "sigmoid"},
+        {"torch.sigmoid", "sigmoid"}, {"nn.Tanh", "tanh"}, {"F.tanh", "tanh"}, {"torch.tanh", "tanh"},
+        {"nn.SiLU", "silu"}, {"F.silu", "silu"}, {"nn.Hardswish", "hardswish"}, {"F.hardswish", "hardswish"},
+        {"nn.Hardsigmoid", "hardsigmoid"}, {"F.hardsigmoid", "hardsigmoid"}, {"nn.Mish", "mish"},
+        {"F.mish", "mish"}, {"torch.abs", "abs"}, {"torch.exp", "exp"}, {"torch.log", "log"},
+        {"torch.sqrt", "sqrt"}, {"torch.rsqrt", "rsqrt"}, {"torch.neg", "neg"}, {"torch.square", "square"},
+    };
+
+    const std::string &type = op->type;
+    auto it = kFunctions.find(type);
+    if (it != kFunctions.end())
+    {
+        expr = it->second + "(@0)";
+        return true;
+    }
+
+    if (type == "nn.ReLU6" || type == "F.relu6")
+    {
+        expr = "min(max(@0,0),6)";
+        return true;
+    }
+    if (type == "nn.LeakyReLU" || type == "F.leaky_relu")
+    {
+        double slope = 0.01;
+        if (!GetNumber(op, "negative_slope", slope))
+        {
+            return false;
+        }
+        expr = "leaky_relu(@0," + FormatNumber(slope) + ")";
+        return true;
+    }
+    if (type == "nn.ELU" || type == "F.elu")
+    {
+        double alpha = 1.0;
+        if (!GetNumber(op, "alpha", alpha))
+        {
+            return false;
+        }
+        expr = "elu(@0," + FormatNumber(alpha) + ")";
+        return true;
+    }
+    if (type == "nn.GELU" || type == "F.gelu")
+    {
+        const std::string approximate = GetString(op, "approximate");
+        if (approximate != "" && approximate != "none" && approximate != "tanh")
+        {
+            return false;
+        }
+        expr = approximate == "tanh" ? "gelu_tanh(@0)" : "gelu(@0)";
+        return true;
+    }
+    if (type == "nn.Softplus" || type == "F.softplus")
+    {
+        double beta = 1.0;
+        double threshold = 20.0;
+        if (!GetNumber(op, "beta", beta) || !GetNumber(op, "threshold", threshold) || beta != 1.0 || threshold != 20.0)
+        {
+            return false;
+        }
+        expr = "softplus(@0)";
+        return true;
+    }
+    if (type == "nn.Hardtanh" || type == "F.hardtanh" || type == "torch.clamp")
+    {
+        const bool hardtanh = type != "torch.clamp";
+        double lower = -1.0;
+        double upper = 1.0;
+        bool has_lower = hardtanh;
+        bool has_upper = hardtanh;
+        bool found = false;
+        if (!GetNumber(op, hardtanh ? "min_val" : "min", lower, found))
+        {
+            return false;
+        }
+        has_lower = has_lower || found;
+        if (!GetNumber(op, hardtanh ? "max_val" : "max", upper, found))
+        {
+            return false;
+        }
+        has_upper = has_upper || found;
+
+        expr = "@0";
+        if (has_lower)
+        {
+            expr = "max(" + expr + "," + FormatNumber(lower) + ")";
+        }
+        if (has_upper)
+        {
+            expr = "min(" + expr + "," + FormatNumber(upper) + ")";
+        }
+        return has_lower || has_upper;
+    }
+    return false;
+}
+
+static bool BinaryExpression(const pnnx::Operator *op, std::string &expr)
+{
+    const std::string &type = op->type;
+    if (type == "torch.add" || type == "torch.sub")
+    {
+        double alpha = 1.0;
+        if (!GetNumber(op, "alpha", alpha))
+        {
+            return false;
+        }
+        const std::string other = alpha == 1.0 ? "@1" : "mul(@1," + FormatNumber(alpha) + ")";
+        expr = (type == "torch.add" ? "add(@0," : "sub(@0,") + other + ")";
+        return true;
+    }
+    if (type == "torch.div")
+    {
+        const std::string rounding_mode = GetString(op, "rounding_mode");
+        if (rounding_mode.empty())
+        {
+            expr = "div(@0,@1)";
+        }
+        else if (rounding_mode == "floor")
+        {
+            expr = "floor_divide(@0,@1)";
+        }
+        else if (rounding_mode == "trunc")
+        {
+            expr = "trunc(div(@0,@1))";
+        }
+        else
+        {
+            return false;
+        }
+        return true;
+    }
+
+    static const std::map<std::string, std::string> kFunctions = {
+        {"torch.mul", "mul"}, {"torch.maximum", "max"}, {"torch.minimum", "min"}, {"torch.pow", "pow"},
+    };
+    auto it = kFunctions.find(type);
+    if (it == kFunctions.end())
+    {
+        return false;
+    }
+    expr = it->second + "(@0,@1)";
+    return true;
+}
+
+bool PointwiseExpression(const pnnx::Operator *op, std::string &expr)
+{
+    if (op->outputs.size() != 1 || !IsFloatOperand(op->outputs[0]))
+    {
+        return false;
+    }
+    for (const pnnx::Operand *input : op->inputs)
+    {
+        if (!IsFloatOperand(input))
+        {
+            return false;
+        }
+    }
+
+    if (op->type == "pnnx.Expression")
+    {
+        // Only tensor arithmetic composes, size() reads the shape of an input that
+        // would become a subexpression and list or scalar results are shape values.
+        layer::ElementwiseProgram program;
+        expr = GetString(op, "expr");
+        if (expr.find("size(") != std::string::npos || !program.Compile(expr) || program.is_list()
+            || static_cast<size_t>(program.input_count()) > op->inputs.size())
+        {
+            return false;
+        }
+        for (int i = 0; i < program.input_count(); ++i)
+        {
+            if (program.uses_tensor(i))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+    if (op->inputs.size() == 1)
+    {
+        return UnaryExpression(op, expr);
+    }
+    if (op->inputs.size() == 2)
+    {
+        return BinaryExpression(op, expr);
+    }
+    return false;
+}
+
+// replaces every @n of expr by args[n]
+static std::string SubstituteInputs(const std::string &expr, const std::vector<std::string> &args)
+{
+    std::string result;
+    for (size_t i = 0; i < expr.size();)
+    {
+        if (expr[i] != '@')
+        {
+            result += expr[i++];
+            continue;
+        }
+
+        size_t end = i + 1;
+        while (end < expr.size() && isdigit(static_cast<unsigned char>(expr[end])))
+        {
+            end++;
+        }
+        result += args[std::stoi(expr.substr(i + 1, end - i - 1))];
+        i = end;
+    }
+    return result;
+}
+
+int FuseElementwise(pnnx::Graph &graph)
+{
+    std::map<const pnnx::Operator *, std::string> exprs;
+    for (const pnnx::Operator *op : graph.ops)
+    {
+        std::string expr;
+        if (PointwiseExpression(op, expr))
+        {
+            exprs[op] = expr;
+        }
+    }
+
+    // ops are topologically sorted, so walking them in reverse meets the root of
+    // every tree before any of its members
+    std::set<const pnnx::Operator *> grouped;
+    std::vector<std::vector<pnnx::Operator *>> trees;
+    for (auto it = graph.ops.rbegin(); it != graph.ops.rend(); ++it)
+    {
+        pnnx::Operator *root = *it;
+        if (exprs.find(root) == exprs.end() || grouped.find(root) != grouped.end())
+        {
+            continue;
+        }
+
+        std::vector<pnnx::Operator *> tree = {root};
+        grouped.insert(root);
+        for (size_t i = 0; i < tree.size(); ++i)
+        {
+            for (pnnx::Operand *input : tree[i]->inputs)
+            {
+                pnnx::Operator *producer = input->producer;
+                if (producer == nullptr || exprs.find(producer) == exprs.end()
+                    || grouped.find(producer) != grouped.end() || input->consumers.size() != 1)
+                {
+                    continue;
+                }
+                tree.push_back(producer);
+                grouped.insert(producer);
+            }
+        }
+        trees.push_back(std::move(tree));
+    }
+
+    int replaced = 0;
+    for (const std::vector<pnnx::Operator *> &tree : trees)
+    {
+        const std::set<const pnnx::Operator *> members(tree.begin(), tree.end());
+        pnnx::Operator *root = tree.front();
+
+        std::vector<pnnx::Operand *> externals;
+        std::function<std::string(const pnnx::Operator *)> compose = [&](const pnnx::Operator *op) {
+            std::vector<std::string> args;
+            for (pnnx::Operand *input : op->inputs)
+            {
+                if (input->producer != nullptr && members.find(input->producer) != members.end())
+                {
+                    args.push_back(compose(input->producer));
+                    continue;
+                }
+                auto found = std::find(externals.begin(), externals.end(), input);
+                args.push_back("@" + std::to_string(found - externals.begin()));
+                if (found == externals.end())
+                {
+                    externals.push_back(input);
+                }
+            }
+            return SubstituteInputs(exprs.at(op), args);
+        };
+        const std::string expr = compose(root);
+
+        pnnx::Operator *fused = graph.new_operator_before("jennifer.FusedElementwise", root->name, root);
+        fused->params["expr"] = expr;
+
+        for (const pnnx::Operator *member : tree)
+        {
+            for (pnnx::Operand *input : member->inputs)
+            {
+                input->remove_consumer(member);
+            }
+        }
+        for (pnnx::Operand *input : externals)
+        {
+            input->consumers.push_back(fused);
+            fused->inputs.push_back(input);
+        }
+
+        pnnx::Operand *output = root->outputs[0];
+        output->producer = fused;
+        fused->outputs.push_back(output);
+        root->outputs.clear();
+
+        for (pnnx::Operator *member : tree)
+        {
+            for (pnnx::Operand *internal : member->outputs)
+            {
+                graph.operands.erase(std::find(graph.operands.begin(), graph.operands.end(), internal));
+                delete internal;
+            }
+            graph.ops.erase(std::find(graph.ops.begin(), graph.ops.end(), member));
+            delete member;
+        }
+        replaced += static_cast<int>(tree.size());
+    }
+    return replaced;
+}
+
+} // namespace pass
+} // namespace jennifer
@@ -0,0 +1,29 @@
+#ifndef JENNIFER_PASS_FUSE_ELEMENTWISE_HPP_
+#define JENNIFER_PASS_FUSE_ELEMENTWISE_HPP_
+
+#include <string>
+
+#include "jennifer/runtime/pnnx/ir.h"
+
+namespace jennifer
+{
+namespace pass
+{
+
+// The pointwise expression of a single float operator over @0..@n-1 of its inputs,
+// e.g. leaky_relu(@0,0.1) for nn.LeakyReLU. False when op is not pointwise or one of
+// its params has no pointwise equivalent.
+bool PointwiseExpression(const pnnx::Operator *op, std::string &expr);
+
+// Replaces every maximal tree of pointwise operators by one jennifer.FusedElementwise
+// whose expr param composes their expressions over the external inputs of the tree.
+// A producer joins the tree of its consumer when that consumer is the only user of
+// its output, so none of the intermediate tensors is materialized any more and a
+// lone pointwise operator becomes a tree of one. Returns the number of operators
+// replaced.
+int FuseElementwise(pnnx::Graph &graph);
+
+} // namespace pass
+} // namespace jennifer
+
+#endif // JENNIFER_PASS_FUSE_ELEMENTWISE_HPP_
@@ -0,0 +1,152 @@
+#include <glog/logging.h>
+
+#include <stdexcept>
+
+#include "async_runner.hpp"
+
+namespace jennifer
+{
+namespace runtime
+{
+
+AsyncRunner::AsyncRunner(Executor executor, const AsyncOptions &options) :
+    executor_(std::move(executor)), options_(options)
+{
+    CHECK(executor_ != nullptr) << "Async runner executor is empty";
+    CHECK_GT(options_.workers, 0) << "Async runner needs a worker";
+
+    for (uint32_t i = 0; i < options_.workers; ++i)
+    {
+        workers_.emplace_back(&AsyncRunner::Loop, this);
+    }
+}
+
+AsyncRunner::~AsyncRunner()
+{
+    Stop();
+}
+
+std::future<AsyncResult> AsyncRunner::Submit(std::vector<std::shared_ptr<Operand<float>>> inputs)
+{
+    auto promise = std::make_shared<std::promise<AsyncResult>>();
+    std::future<AsyncResult> future = promise->get_future();
+    Enqueue({std::move(inputs), [promise](AsyncResult result) {
+                 if (result.exception != nullptr)
+                 {
+                     promise->set_exception(result.exception);
+                     return;
+                 }
+                 promise->set_value(std::move(result));
+             }});
+    return future;
+}
+
+void AsyncRunner::Submit(std::vector<std::shared_ptr<Operand<float>>> inputs, Callback callback)
+{
+    CHECK(callback != nullptr) << "Async runner callback is empty";
+
+    if (options_.post == nullptr)
+    {
+        Enqueue({std::move(inputs), std::move(callback)});
+        return;
+    }
+    // the result is moved into the posted closure, the worker does not wait for it
+    const std::function<void(std::function<void()>)> &post = options_.post;
+    Enqueue({std::move(inputs), [post, callback](AsyncResult result) {
+                 auto shared = std::make_shared<AsyncResult>(std::move(result));
+                 post([callback, shared]() { callback(std::move(*shared)); });
+             }});
+}
+
+void AsyncRunner::Enqueue(Request request)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!stop_)
+        {
+            queue_.push_back(std::move(request));
+            cv_.notify_one();
+            return;
+        }
+    }
+    AsyncResult result;
+    result.exception = std::make_exception_ptr(std::runtime_error("Async runner is stopped"));
+    request.done(std::move(result));
+}
+
+void AsyncRunner::Loop()
+{
+    while (true)
+    {
+        Request request;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+            if (queue_.empty())
+            {
+                // stopped and drained
+                return;
+            }
+            request = std::move(queue_.front());
+            queue_.pop_front();
+            running_ += 1;
+        }
+
+        AsyncResult result;
+        try
+        {
+            result.status = executor_(request.inputs, result.outputs);
+            if (result.status != utils::StatusCode::Success)
+            {
+                LOG(ERROR) << "Async executor failed with status " << static_cast<int>(result.status);
+            }
+        }
+        catch (...)
+        {
+            result.exception = std::current_exception();
+        }
+        request.inputs.clear();
+        try
+        {
+            // a throwing callback must not take the worker down with it
+            request.done(std::move(result));
+        }
+        catch (const std::exception &e)
+        {
+            LOG(ERROR) << "Async runner callback threw: " << e.what();
+        }
+        catch (...)
+        {
+            LOG(ERROR) << "Async runner callback threw an unknown exception";
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ -= 1;
+    }
+}
+
+void AsyncRunner::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+
+    for (std::thread &worker : workers_)
+    {
+        if (worker.joinable())
+        {
+            worker.join();
+        }
+    }
+}
+
+size_t AsyncRunner::pending() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.size() + running_;
+}
+
+} // namespace runtime
+} // namespace jennifer
@@ -0,0 +1,151 @@
+#ifndef JENNIFER_RUNTIME_ASYNC_RUNNER_HPP
+#define JENNIFER_RUNTIME_ASYNC_RUNNER_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <coroutine>
+#define JENNIFER_HAS_COROUTINES 1
+#endif
+
+#include "jennifer/utils/common.hpp"
+
+#include "operand.hpp"
+
+namespace jennifer
+{
+namespace runtime
+{
+
+struct AsyncResult
+{
+    utils::StatusCode status = utils::StatusCode::Success;
+    std::vector<std::shared_ptr<Operand<float>>> outputs;
+
+    // thrown by the executor, status is meaningless then
+    std::exception_ptr exception;
+}; // struct AsyncResult
+
+struct AsyncOptions
+{
+    // threads running requests, more than one only helps executors that run
+    // requests concurrently such as ReplicaSet::Forward
+    uint32_t workers = 1;
+
+    // Hands a completion callback or a coroutine resumption to the caller, e.g. by
+    // posting it to an event loop. Empty runs it on the worker that ran the request.
+    std::function<void(std::function<void()>)> post;
+}; // struct AsyncOptions
+
+// Runs inference requests on worker threads of its own so that the submitting
+// thread, typically an I/O loop, never blocks on compute. A request completes
+// through a future, a callback or, with C++20, co_await runner.Run(inputs).
+//
+//   AsyncRunner runner([&graph](const auto &inputs, auto &outputs) { return graph.Forward(inputs, outputs); });
+//   runner.Submit(inputs, [](AsyncResult result) { ... });
+class AsyncRunner
+{
+public:
+    using Executor = std::function<utils::StatusCode(const std::vector<std::shared_ptr<Operand<float>>> &inputs,
+                                                     std::vector<std::shared_ptr<Operand<float>>> &outputs)>;
+    using Callback = std::function<void(AsyncResult result)>;
+
+    explicit AsyncRunner(Executor executor, const AsyncOptions &options = AsyncOptions());
+    ~AsyncRunner();
+
+    AsyncRunner(const AsyncRunner &) = delete;
+    AsyncRunner &operator=(const AsyncRunner &) = delete;
+
+    // the future throws what the executor threw, a failed status is in the result
+    std::future<AsyncResult> Submit(std::vector<std::shared_ptr<Operand<float>>> inputs);
+
+    // callback runs through AsyncOptions::post once the request is done, an exception
+    // it throws on a worker is logged and dropped
+    void Submit(std::vector<std::shared_ptr<Operand<float>>> inputs, Callback callback);
+
+#ifdef JENNIFER_HAS_COROUTINES
+    // co_await suspends the coroutine until the request is done and resumes it
+    // through AsyncOptions::post; it rethrows what the executor threw
+    class RunAwaitable
+    {
+    public:
+        RunAwaitable(AsyncRunner &runner, std::vector<std::shared_ptr<Operand<float>>> inputs) :
+            runner_(runner), inputs_(std::move(inputs))
+        {
+        }
+
+        bool await_ready() const noexcept
+        {
+            return false;
+        }
+
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+            runner_.Submit(std::move(inputs_), [this, handle](AsyncResult result) {
+                result_ = std::move(result);
+                handle.resume();
+            });
+        }
+
+        AsyncResult await_resume()
+        {
+            if (result_.exception != nullptr)
+            {
+                std::rethrow_exception(result_.exception);
+            }
+            return std::move(result_);
+        }
+
+    private:
+        AsyncRunner &runner_;
+        std::vector<std::shared_ptr<Operand<float>>> inputs_;
+        AsyncResult result_;
+    }; // class RunAwaitable
+
+    RunAwaitable Run(std::vector<std::shared_ptr<Operand<float>>> inputs)
+    {
+        return RunAwaitable(*this, std::move(inputs));
+    }
+#endif
+
+    // runs the queued requests and joins the workers, later submissions fail
+    void Stop();
+
+    // requests queued or running
+    size_t pending() const;
+
+private:
+    struct Request
+    {
+        std::vector<std::shared_ptr<Operand<float>>> inputs;
+        std::function<void(AsyncResult)> done;
+    }; // struct Request
+
+    void Enqueue(Request request);
+    void Loop();
+
+    Executor executor_;
+    AsyncOptions options_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<Request> queue_;
+    size_t running_ = 0;
+    bool stop_ = false;
+
+    std::vector<std::thread> workers_;
+}; // class AsyncRunner
+
+} // namespace runtime
+} // namespace jennifer
+
+#endif // JENNIFER_RUNTIME_ASYNC_RUNNER_HPP
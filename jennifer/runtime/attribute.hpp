@@ -71,8 +71,6 @@ std::vector<T> Attribute::get(bool clear_weight)
         break;
     }
     default: {
-        static_assert(std::is_same<T, float>::value == false,
-                      "Attribute AttributeType is not supported for this type");
         LOG(FATAL) << "Unsupported AttributeType for get: " << static_cast<int>(type);
     }
     }
@@ -0,0 +1,190 @@
+#include <glog/logging.h>
+
+#include <stdexcept>
+#include <string>
+
+#include "batcher.hpp"
+
+namespace jennifer
+{
+namespace runtime
+{
+
+DynamicBatcher::DynamicBatcher(Executor executor, const BatcherOptions &options) :
+    executor_(std::move(executor)), options_(options)
+{
+    CHECK(executor_ != nullptr) << "Batcher executor is empty";
+    CHECK_GT(options_.max_batch_size, 0) << "Batcher max batch size must be positive";
+    CHECK_GE(options_.max_queue_size, options_.max_batch_size) << "Batcher queue is smaller than one batch";
+
+    worker_ = std::thread(&DynamicBatcher::Loop, this);
+}
+
+DynamicBatcher::~DynamicBatcher()
+{
+    Stop();
+}
+
+std::future<std::shared_ptr<Tensor<float>>> DynamicBatcher::Submit(const std::shared_ptr<Tensor<float>> &input)
+{
+    CHECK(input != nullptr && !input->empty()) << "Batcher input is empty";
+
+    Request request;
+    request.input = input;
+    std::future<std::shared_ptr<Tensor<float>>> future = request.promise.get_future();
+
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        space_cv_.wait(lock, [this] { return stop_ || queue_.size() < options_.max_queue_size; });
+        if (stop_)
+        {
+            request.promise.set_exception(std::make_exception_ptr(std::runtime_error("Batcher is stopped")));
+            return future;
+        }
+
+        request.enqueue_time = std::chrono::steady_clock::now();
+        queue_.push_back(std::move(request));
+    }
+    queue_cv_.notify_one();
+
+    return future;
+}
+
+void DynamicBatcher::Stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    queue_cv_.notify_all();
+    space_cv_.notify_all();
+
+    if (worker_.joinable())
+    {
+        worker_.join();
+    }
+}
+
+BatcherStats DynamicBatcher::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void DynamicBatcher::Loop()
+{
+    while (true)
+    {
+        std::vector<Request> batch;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            queue_cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+            if (queue_.empty())
+            {
+                // stopped and drained
+                return;
+            }
+
+            // the deadline is measured from the oldest queued request, on stop the
+            // remaining requests are flushed without waiting
+            const auto deadline = queue_.front().enqueue_time + options_.max_delay;
+            queue_cv_.wait_until(lock, deadline, [this] {
+                return stop_ || FrontBatchSize() == options_.max_batch_size;
+            });
+
+            const size_t batch_size = FrontBatchSize();
+            for (size_t i = 0; i < batch_size; ++i)
+            {
+                batch.push_back(std::move(queue_.front()));
+                queue_.pop_front();
+            }
+
+            stats_.requests += batch.size();
+            stats_.batches += 1;
+            if (batch.size() == options_.max_batch_size)
+            {
+                stats_.full_flushes += 1;
+            }
+            else if (std::chrono::steady_clock::now() >= deadline)
+            {
+                stats_.deadline_flushes += 1;
+            }
+        }
+        space_cv_.notify_all();
+
+        Execute(batch);
+    }
+}
+
+size_t DynamicBatcher::FrontBatchSize() const
+{
+    // only the leading run of requests sharing the front sample shape forms a batch
+    const std::vector<uint32_t> &sample_shape = queue_.front().input->raw_shape();
+    size_t size = 0;
+    while (size < queue_.size() && size < options_.max_batch_size
+           && queue_[size].input->raw_shape() == sample_shape)
+    {
+        size += 1;
+    }
+    return size;
+}
+
+void DynamicBatcher::Execute(std::vector<Request> &batch)
+{
+    const uint32_t batch_size = batch.size();
+
+    std::vector<int32_t> shapes{static_cast<int32_t>(batch_size)};
+    for (uint32_t dim : batch.front().input->raw_shape())
+    {
+        shapes.push_back(static_cast<int32_t>(dim));
+    }
+
+    auto inputs = std::make_shared<Operand<float>>("batch", shapes, batch_size, AttributeType::Float32);
+    for (uint32_t i = 0; i < batch_size; ++i)
+    {
+        inputs->data[i] = batch[i].input;
+    }
+
+    std::shared_ptr<Operand<float>> outputs;
+    std::string error;
+    try
+    {
+        utils::StatusCode status = executor_(inputs, outputs);
+        if (status != utils::StatusCode::Success)
+        {
+            error = "Batch executor failed with status " + std::to_string(static_cast<int>(status));
+        }
+        else if (outputs == nullptr || outputs->data.size() != batch_size)
+        {
+            error = "Batch executor output size mismatch";
+        }
+    }
+    catch (...)
+    {
+        std::exception_ptr exception = std::current_exception();
+        for (Request &request : batch)
+        {
+            request.promise.set_exception(exception);
+        }
+        return;
+    }
+
+    if (!error.empty())
+    {
+        LOG(ERROR) << error;
+        std::exception_ptr exception = std::make_exception_ptr(std::runtime_error(error));
+        for (Request &request : batch)
+        {
+            request.promise.set_exception(exception);
+        }
+        return;
+    }
+
+    for (uint32_t i = 0; i < batch_size; ++i)
+    {
+        batch[i].promise.set_value(outputs->data[i]);
+    }
+}
+
+} // namespace runtime
+} // namespace jennifer
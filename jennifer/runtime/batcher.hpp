@@ -0,0 +1,101 @@
+#ifndef JENNIFER_RUNTIME_BATCHER_HPP
+#define JENNIFER_RUNTIME_BATCHER_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "jennifer/utils/common.hpp"
+
+#include "operand.hpp"
+
+namespace jennifer
+{
+namespace runtime
+{
+
+struct BatcherOptions
+{
+    // flush as soon as this many requests of one sample shape are queued in a row
+    uint32_t max_batch_size = 16;
+
+    // flush when the oldest queued request has waited this long
+    std::chrono::microseconds max_delay = std::chrono::microseconds(2000);
+
+    // Submit blocks while the queue holds this many requests
+    uint32_t max_queue_size = 4096;
+}; // struct BatcherOptions
+
+struct BatcherStats
+{
+    uint64_t requests = 0;
+    uint64_t batches = 0;
+    uint64_t full_flushes = 0;
+    // partial batches flushed once the oldest request waited max_delay, batches
+    // flushed by Stop are neither full nor deadline flushes
+    uint64_t deadline_flushes = 0;
+
+    double mean_batch_size() const
+    {
+        return batches == 0 ? 0.0 : static_cast<double>(requests) / static_cast<double>(batches);
+    }
+}; // struct BatcherStats
+
+// Queues single-sample requests and coalesces them into one batched Operand along
+// the batch dimension (Operand::data), then scatters the batched outputs back to
+// the callers' futures. Only requests with identical sample shapes share a batch.
+class DynamicBatcher
+{
+public:
+    using Executor = std::function<utils::StatusCode(const std::shared_ptr<Operand<float>> &inputs,
+                                                     std::shared_ptr<Operand<float>> &outputs)>;
+
+    explicit DynamicBatcher(Executor executor, const BatcherOptions &options = BatcherOptions());
+    ~DynamicBatcher();
+
+    DynamicBatcher(const DynamicBatcher &) = delete;
+    DynamicBatcher &operator=(const DynamicBatcher &) = delete;
+
+    std::future<std::shared_ptr<Tensor<float>>> Submit(const std::shared_ptr<Tensor<float>> &input);
+
+    void Stop();
+
+    BatcherStats stats() const;
+
+private:
+    struct Request
+    {
+        std::shared_ptr<Tensor<float>> input;
+        std::promise<std::shared_ptr<Tensor<float>>> promise;
+        std::chrono::steady_clock::time_point enqueue_time;
+    };
+
+    void Loop();
+    // requests the next batch takes from the front of the queue, which must not be empty
+    size_t FrontBatchSize() const;
+    void Execute(std::vector<Request> &batch);
+
+    Executor executor_;
+    BatcherOptions options_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable queue_cv_;
+    std::condition_variable space_cv_;
+    std::deque<Request> queue_;
+    bool stop_ = false;
+
+    BatcherStats stats_;
+    std::thread worker_;
+}; // class DynamicBatcher
+
+} // namespace runtime
+} // namespace jennifer
+
+#endif // JENNIFER_RUNTIME_BATCHER_HPP
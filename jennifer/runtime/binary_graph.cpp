@@ -0,0 +1,612 @@
+#include <glog/logging.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include "jennifer/runtime/pnnx/store_zip.hpp"
+
+#include "binary_graph.hpp"
+
+namespace jennifer
+{
+namespace runtime
+{
+
+static const uint64_t kSectionAlignment = 8;
+
+static uint32_t FloatBits(float f)
+{
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    return bits;
+}
+
+static float BitsFloat(uint32_t bits)
+{
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+// collects the sections of a graph while it is serialized
+struct BinaryGraphBuilder
+{
+    std::vector<BinaryOperator> operators;
+    std::vector<BinaryOperand> operands;
+    std::vector<BinaryParameter> params;
+    std::vector<BinaryAttribute> attrs;
+    std::vector<uint32_t> refs;
+    std::vector<int32_t> dims;
+    std::vector<uint32_t> blobs;
+    std::string strings;
+    std::unordered_map<std::string, uint32_t> string_offsets;
+
+    uint32_t String(const std::string &s)
+    {
+        auto it = string_offsets.find(s);
+        if (it != string_offsets.end())
+        {
+            return it->second;
+        }
+        const uint32_t offset = static_cast<uint32_t>(strings.size());
+        strings.append(s);
+        strings.push_back('\0');
+        string_offsets.emplace(s, offset);
+        return offset;
+    }
+
+    uint32_t Shape(const std::vector<int> &shape)
+    {
+        const uint32_t begin = static_cast<uint32_t>(dims.size());
+        dims.insert(dims.end(), shape.begin(), shape.end());
+        return begin;
+    }
+
+    uint32_t Params(const std::map<std::string, pnnx::Parameter> &values)
+    {
+        const uint32_t begin = static_cast<uint32_t>(params.size());
+        for (const auto &it : values)
+        {
+            const pnnx::Parameter &p = it.second;
+            BinaryParameter record{String(it.first), p.type, 0, 0};
+            switch (p.type)
+            {
+            case 1: record.value = p.b ? 1 : 0; break;
+            case 2: record.value = static_cast<uint32_t>(p.i); break;
+            case 3: record.value = FloatBits(p.f); break;
+            case 4: record.value = String(p.s); break;
+            case 5:
+                record.value = static_cast<uint32_t>(blobs.size());
+                record.count = static_cast<uint32_t>(p.ai.size());
+                for (int v : p.ai)
+                {
+                    blobs.push_back(static_cast<uint32_t>(v));
+                }
+                break;
+            case 6:
+                record.value = static_cast<uint32_t>(blobs.size());
+                record.count = static_cast<uint32_t>(p.af.size());
+                for (float v : p.af)
+                {
+                    blobs.push_back(FloatBits(v));
+                }
+                break;
+            case 7:
+                record.value = static_cast<uint32_t>(blobs.size());
+                record.count = static_cast<uint32_t>(p.as.size());
+                for (const std::string &v : p.as)
+                {
+                    blobs.push_back(String(v));
+                }
+                break;
+            case 10:
+                record.value = static_cast<uint32_t>(blobs.size());
+                record.count = 1;
+                blobs.push_back(FloatBits(p.c.real()));
+                blobs.push_back(FloatBits(p.c.imag()));
+                break;
+            case 11:
+                record.value = static_cast<uint32_t>(blobs.size());
+                record.count = static_cast<uint32_t>(p.ac.size());
+                for (const std::complex<float> &v : p.ac)
+                {
+                    blobs.push_back(FloatBits(v.real()));
+                    blobs.push_back(FloatBits(v.imag()));
+                }
+                break;
+            default: break;
+            }
+            params.push_back(record);
+        }
+        return begin;
+    }
+};
+
+template <typename T>
+static void WriteSection(std::string &out, BinaryGraphSection &section, const std::vector<T> &records)
+{
+    out.resize((out.size() + kSectionAlignment - 1) / kSectionAlignment * kSectionAlignment, '\0');
+    section.offset = out.size();
+    section.count = records.size();
+    out.append(reinterpret_cast<const char *>(records.data()), records.size() * sizeof(T));
+}
+
+bool BinaryGraph::Save(const pnnx::Graph &graph, const std::string &path)
+{
+    std::map<const pnnx::Operator *, int32_t> op_indices;
+    std::map<const pnnx::Operand *, uint32_t> operand_indices;
+    for (size_t i = 0; i < graph.ops.size(); ++i)
+    {
+        op_indices[graph.ops[i]] = static_cast<int32_t>(i);
+    }
+    for (size_t i = 0; i < graph.operands.size(); ++i)
+    {
+        operand_indices[graph.operands[i]] = static_cast<uint32_t>(i);
+    }
+
+    BinaryGraphBuilder builder;
+    for (const pnnx::Operator *op : graph.ops)
+    {
+        BinaryOperator record{};
+        record.type = builder.String(op->type);
+        record.name = builder.String(op->name);
+
+        record.inputs = static_cast<uint32_t>(builder.refs.size());
+        record.input_count = static_cast<uint32_t>(op->inputs.size());
+        for (const pnnx::Operand *operand : op->inputs)
+        {
+            builder.refs.push_back(operand_indices.at(operand));
+        }
+        record.outputs = static_cast<uint32_t>(builder.refs.size());
+        record.output_count = static_cast<uint32_t>(op->outputs.size());
+        for (const pnnx::Operand *operand : op->outputs)
+        {
+            builder.refs.push_back(operand_indices.at(operand));
+        }
+
+        record.has_inputnames = op->inputnames.size() == op->inputs.size() && !op->inputnames.empty();
+        record.inputnames = static_cast<uint32_t>(builder.refs.size());
+        if (record.has_inputnames)
+        {
+            for (const std::string &inputname : op->inputnames)
+            {
+                builder.refs.push_back(builder.String(inputname));
+            }
+        }
+
+        record.params = builder.Params(op->params);
+        record.param_count = static_cast<uint32_t>(op->params.size());
+
+        record.attrs = static_cast<uint32_t>(builder.attrs.size());
+        record.attr_count = static_cast<uint32_t>(op->attrs.size());
+        for (const auto &it : op->attrs)
+        {
+            const uint32_t key = builder.String(it.first);
+            const uint32_t shape = builder.Shape(it.second.shape);
+            builder.attrs.push_back({key, it.second.type, shape, static_cast<uint32_t>(it.second.shape.size())});
+        }
+        builder.operators.push_back(record);
+    }
+
+    for (const pnnx::Operand *operand : graph.operands)
+    {
+        BinaryOperand record{};
+        record.name = builder.String(operand->name);
+        record.type = operand->type;
+        record.producer = operand->producer ? op_indices.at(operand->producer) : -1;
+        record.consumers = static_cast<uint32_t>(builder.refs.size());
+        record.consumer_count = static_cast<uint32_t>(operand->consumers.size());
+        for (const pnnx::Operator *consumer : operand->consumers)
+        {
+            builder.refs.push_back(static_cast<uint32_t>(op_indices.at(consumer)));
+        }
+        record.shape = builder.Shape(operand->shape);
+        record.rank = static_cast<uint32_t>(operand->shape.size());
+        record.params = builder.Params(operand->params);
+        record.param_count = static_cast<uint32_t>(operand->params.size());
+        builder.operands.push_back(record);
+    }
+
+    BinaryGraphHeader header{};
+    header.magic = kBinaryGraphMagic;
+    header.version = kBinaryGraphVersion;
+
+    std::string out(sizeof(header), '\0');
+    WriteSection(out, header.operators, builder.operators);
+    WriteSection(out, header.operands, builder.operands);
+    WriteSection(out, header.params, builder.params);
+    WriteSection(out, header.attrs, builder.attrs);
+    WriteSection(out, header.refs, builder.refs);
+    WriteSection(out, header.dims, builder.dims);
+    WriteSection(out, header.blobs, builder.blobs);
+    WriteSection(out, header.strings, std::vector<char>(builder.strings.begin(), builder.strings.end()));
+    memcpy(&out[0], &header, sizeof(header));
+
+    std::ofstream file(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file.good())
+    {
+        LOG(ERROR) << "Can not open " << path;
+        return false;
+    }
+    file.write(out.data(), static_cast<std::streamsize>(out.size()));
+    return file.good();
+}
+
+BinaryGraph::~BinaryGraph()
+{
+    Close();
+}
+
+bool BinaryGraph::IsBinaryGraph(const std::string &path)
+{
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    uint32_t magic = 0;
+    file.read(reinterpret_cast<char *>(&magic), sizeof(magic));
+    return file.good() && magic == kBinaryGraphMagic;
+}
+
+bool BinaryGraph::Open(const std::string &path)
+{
+    Close();
+
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        LOG(ERROR) << "Can not open " << path;
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        LOG(ERROR) << "Can not stat " << path;
+        close(fd);
+        return false;
+    }
+
+    void *mapped = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED)
+    {
+        LOG(ERROR) << "Can not map " << path;
+        return false;
+    }
+
+    if (!Parse(mapped, static_cast<size_t>(st.st_size)))
+    {
+        munmap(mapped, static_cast<size_t>(st.st_size));
+        return false;
+    }
+    mapped_ = mapped;
+    return true;
+}
+
+bool BinaryGraph::Parse(const void *data, size_t size)
+{
+    Close();
+
+    const BinaryGraphHeader *header = static_cast<const BinaryGraphHeader *>(data);
+    if (size < sizeof(BinaryGraphHeader) || header->magic != kBinaryGraphMagic)
+    {
+        LOG(ERROR) << "Not a binary graph";
+        return false;
+    }
+    if (header->version != kBinaryGraphVersion)
+    {
+        LOG(ERROR) << "Unsupported binary graph version " << header->version;
+        return false;
+    }
+
+    const std::pair<const BinaryGraphSection *, size_t> sections[] = {
+        {&header->operators, sizeof(BinaryOperator)}, {&header->operands, sizeof(BinaryOperand)},
+        {&header->params, sizeof(BinaryParameter)},   {&header->attrs, sizeof(BinaryAttribute)},
+        {&header->refs, sizeof(uint32_t)},            {&header->dims, sizeof(int32_t)},
+        {&header->blobs, sizeof(uint32_t)},           {&header->strings, sizeof(char)},
+    };
+    for (const auto &section : sections)
+    {
+        const uint64_t offset = section.first->offset;
+        const uint64_t count = section.first->count;
+        if (offset % kSectionAlignment != 0 || offset > size || count > (size - offset) / section.second)
+        {
+            LOG(ERROR) << "Binary graph section out of range";
+            return false;
+        }
+    }
+    if (header->strings.count != 0 && static_cast<const char *>(data)[header->strings.offset + header->strings.count - 1] != '\0')
+    {
+        LOG(ERROR) << "Binary graph string section is not terminated";
+        return false;
+    }
+
+    data_ = static_cast<const char *>(data);
+    size_ = size;
+    if (!ValidateRecords())
+    {
+        data_ = nullptr;
+        size_ = 0;
+        return false;
+    }
+    return true;
+}
+
+void BinaryGraph::Close()
+{
+    if (mapped_ != nullptr)
+    {
+        munmap(mapped_, size_);
+        mapped_ = nullptr;
+    }
+    data_ = nullptr;
+    size_ = 0;
+}
+
+// every reference is checked once here so the accessors and ToGraph can trust them
+bool BinaryGraph::ValidateRecords() const
+{
+    const BinaryGraphHeader &h = header();
+    auto range = [](uint64_t begin, uint64_t count, uint64_t limit) { return begin <= limit && count <= limit - begin; };
+    auto valid_params = [&](uint32_t begin, uint32_t count) {
+        if (!range(begin, count, h.params.count))
+        {
+            return false;
+        }
+        for (uint32_t i = begin; i < begin + count; ++i)
+        {
+            const BinaryParameter &p = params()[i];
+            const uint64_t words = p.type == 10 || p.type == 11 ? 2ull * p.count : p.count;
+            const bool array = p.type == 5 || p.type == 6 || p.type == 7 || p.type == 10 || p.type == 11;
+            if (p.key >= h.strings.count || (p.type == 4 && p.value >= h.strings.count) ||
+                (array && !range(p.value, words, h.blobs.count)))
+            {
+                return false;
+            }
+            for (uint64_t j = 0; p.type == 7 && j < p.count; ++j)
+            {
+                if (blobs()[p.value + j] >= h.strings.count)
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    };
+    auto valid_refs = [&](uint32_t begin, uint32_t count, uint64_t limit) {
+        if (!range(begin, count, h.refs.count))
+        {
+            return false;
+        }
+        for (uint32_t i = begin; i < begin + count; ++i)
+        {
+            if (refs()[i] >= limit)
+            {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    for (uint64_t i = 0; i < h.operators.count; ++i)
+    {
+        const BinaryOperator &op = operators()[i];
+        bool valid = op.type < h.strings.count && op.name < h.strings.count &&
+                     valid_refs(op.inputs, op.input_count, h.operands.count) &&
+                     valid_refs(op.outputs, op.output_count, h.operands.count) &&
+                     (!op.has_inputnames || valid_refs(op.inputnames, op.input_count, h.strings.count)) &&
+                     valid_params(op.params, op.param_count) && range(op.attrs, op.attr_count, h.attrs.count);
+        for (uint32_t j = op.attrs; valid && j < op.attrs + op.attr_count; ++j)
+        {
+            valid = attrs()[j].key < h.strings.count && range(attrs()[j].shape, attrs()[j].rank, h.dims.count);
+        }
+        if (!valid)
+        {
+            LOG(ERROR) << "Binary graph operator " << i << " is corrupted";
+            return false;
+        }
+    }
+
+    for (uint64_t i = 0; i < h.operands.count; ++i)
+    {
+        const BinaryOperand &operand = operands()[i];
+        const bool valid = operand.name < h.strings.count &&
+                           (operand.producer == -1 || (operand.producer >= 0 && operand.producer < static_cast<int64_t>(h.operators.count))) &&
+                           valid_refs(operand.consumers, operand.consumer_count, h.operators.count) &&
+                           range(operand.shape, operand.rank, h.dims.count) && valid_params(operand.params, operand.param_count);
+        if (!valid)
+        {
+            LOG(ERROR) << "Binary graph operand " << i << " is corrupted";
+            return false;
+        }
+    }
+    return true;
+}
+
+const BinaryGraphHeader &BinaryGraph::header() const
+{
+    return *reinterpret_cast<const BinaryGraphHeader *>(data_);
+}
+
+const BinaryOperator *BinaryGraph::operators() const
+{
+    return reinterpret_cast<const BinaryOperator *>(data_ + header().operators.offset);
+}
+
+const BinaryOperand *BinaryGraph::operands() const
+{
+    return reinterpret_cast<const BinaryOperand *>(data_ + header().operands.offset);
+}
+
+const BinaryParameter *BinaryGraph::params() const
+{
+    return reinterpret_cast<const BinaryParameter *>(data_ + header().params.offset);
+}
+
+const BinaryAttribute *BinaryGraph::attrs() const
+{
+    return reinterpret_cast<const BinaryAttribute *>(data_ + header().attrs.offset);
+}
+
+const uint32_t *BinaryGraph::refs() const
+{
+    return reinterpret_cast<const uint32_t *>(data_ + header().refs.offset);
+}
+
+const int32_t *BinaryGraph::dims() const
+{
+    return reinterpret_cast<const int32_t *>(data_ + header().dims.offset);
+}
+
+const uint32_t *BinaryGraph::blobs() const
+{
+    return reinterpret_cast<const uint32_t *>(data_ + header().blobs.offset);
+}
+
+const char *BinaryGraph::string(uint32_t offset) const
+{
+    return data_ + header().strings.offset + offset;
+}
+
+static pnnx::Parameter DecodeParameter(const BinaryGraph &binary, const BinaryParameter &record)
+{
+    const uint32_t *words = binary.blobs() + record.value;
+
+    pnnx::Parameter p;
+    p.type = record.type;
+    switch (record.type)
+    {
+    case 1: p.b = record.value != 0; break;
+    case 2: p.i = static_cast<int32_t>(record.value); break;
+    case 3: p.f = BitsFloat(record.value); break;
+    case 4: p.s = binary.string(record.value); break;
+    case 5:
+        p.ai.resize(record.count);
+        memcpy(p.ai.data(), words, record.count * sizeof(int32_t));
+        break;
+    case 6:
+        p.af.resize(record.count);
+        memcpy(p.af.data(), words, record.count * sizeof(float));
+        break;
+    case 7:
+        for (uint32_t i = 0; i < record.count; ++i)
+        {
+            p.as.emplace_back(binary.string(words[i]));
+        }
+        break;
+    case 10: p.c = std::complex<float>(BitsFloat(words[0]), BitsFloat(words[1])); break;
+    case 11:
+        for (uint32_t i = 0; i < record.count; ++i)
+        {
+            p.ac.emplace_back(BitsFloat(words[2 * i]), BitsFloat(words[2 * i + 1]));
+        }
+        break;
+    default: break;
+    }
+    return p;
+}
+
+bool BinaryGraph::ToGraph(pnnx::Graph &graph, const std::string &bin_path) const
+{
+    CHECK(data_ != nullptr) << "The binary graph is not opened";
+    if (!graph.ops.empty() || !graph.operands.empty())
+    {
+        LOG(ERROR) << "The pnnx graph is not empty";
+        return false;
+    }
+
+    const BinaryGraphHeader &h = header();
+    graph.ops.reserve(h.operators.count);
+    graph.operands.reserve(h.operands.count);
+    for (uint64_t i = 0; i < h.operators.count; ++i)
+    {
+        graph.new_operator(string(operators()[i].type), string(operators()[i].name));
+    }
+    for (uint64_t i = 0; i < h.operands.count; ++i)
+    {
+        const BinaryOperand &record = operands()[i];
+        pnnx::Operand *operand = graph.new_operand(string(record.name));
+        operand->type = record.type;
+        operand->producer = record.producer >= 0 ? graph.ops[record.producer] : nullptr;
+        operand->shape.assign(dims() + record.shape, dims() + record.shape + record.rank);
+        for (uint32_t j = 0; j < record.consumer_count; ++j)
+        {
+            operand->consumers.push_back(graph.ops[refs()[record.consumers + j]]);
+        }
+        for (uint32_t j = record.params; j < record.params + record.param_count; ++j)
+        {
+            operand->params[string(params()[j].key)] = DecodeParameter(*this, params()[j]);
+        }
+    }
+
+    pnnx::StoreZipReader szr;
+    const bool has_weights = !bin_path.empty();
+    if (has_weights && szr.open(bin_path) != 0)
+    {
+        LOG(ERROR) << "Can not open " << bin_path;
+        return false;
+    }
+
+    std::vector<std::string> filenames;
+    std::vector<char *> datas;
+    for (uint64_t i = 0; i < h.operators.count; ++i)
+    {
+        const BinaryOperator &record = operators()[i];
+        pnnx::Operator *op = graph.ops[i];
+        for (uint32_t j = 0; j < record.input_count; ++j)
+        {
+            op->inputs.push_back(graph.operands[refs()[record.inputs + j]]);
+        }
+        for (uint32_t j = 0; j < record.output_count; ++j)
+        {
+            op->outputs.push_back(graph.operands[refs()[record.outputs + j]]);
+        }
+        for (uint32_t j = 0; record.has_inputnames && j < record.input_count; ++j)
+        {
+            op->inputnames.emplace_back(string(refs()[record.inputnames + j]));
+        }
+        for (uint32_t j = record.params; j < record.params + record.param_count; ++j)
+        {
+            op->params[string(params()[j].key)] = DecodeParameter(*this, params()[j]);
+        }
+        for (uint32_t j = record.attrs; j < record.attrs + record.attr_count; ++j)
+        {
+            const BinaryAttribute &attr_record = attrs()[j];
+            pnnx::Attribute &attr = op->attrs[string(attr_record.key)];
+            attr.type = attr_record.type;
+            attr.shape.assign(dims() + attr_record.shape, dims() + attr_record.shape + attr_record.rank);
+
+            const std::string filename = op->name + "." + string(attr_record.key);
+            if (!has_weights || attr.type == 0 || attr.shape.empty())
+            {
+                continue;
+            }
+            const size_t bytesize = attr.elemcount() * attr.elemsize();
+            if (szr.get_file_size(filename) != bytesize)
+            {
+                LOG(ERROR) << "Attribute " << filename << " size does not match its shape";
+                continue;
+            }
+            attr.data.resize(bytesize);
+            filenames.push_back(filename);
+            datas.push_back(attr.data.data());
+        }
+    }
+
+    if (has_weights && szr.read_files(filenames, datas) != 0)
+    {
+        LOG(ERROR) << "Can not read the attributes from " << bin_path;
+        return false;
+    }
+    return true;
+}
+
+} // namespace runtime
+} // namespace jennifer
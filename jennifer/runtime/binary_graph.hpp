@@ -0,0 +1,134 @@
+#ifndef JENNIFER_RUNTIME_BINARY_GRAPH_HPP
+#define JENNIFER_RUNTIME_BINARY_GRAPH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "jennifer/runtime/pnnx/ir.h"
+
+namespace jennifer
+{
+namespace runtime
+{
+
+// On-disk layout of a binary pnnx graph. Every section is an array of fixed width
+// little endian records aligned to 8 bytes, so a mapped file is used in place.
+// Records reference each other by index, names by byte offset into the string
+// section (nul terminated) and variable length parameter values by word index into
+// the blob section. Attribute weights stay in the pnnx .bin zip.
+static constexpr uint32_t kBinaryGraphMagic = 0x3147424a; // "JBG1"
+static constexpr uint32_t kBinaryGraphVersion = 1;
+
+struct BinaryGraphSection
+{
+    uint64_t offset;
+    uint64_t count;
+};
+
+struct BinaryGraphHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    BinaryGraphSection operators;  // BinaryOperator
+    BinaryGraphSection operands;   // BinaryOperand
+    BinaryGraphSection params;     // BinaryParameter
+    BinaryGraphSection attrs;      // BinaryAttribute
+    BinaryGraphSection refs;       // uint32_t operand, operator or string references
+    BinaryGraphSection dims;       // int32_t shape dims
+    BinaryGraphSection blobs;      // uint32_t parameter array words
+    BinaryGraphSection strings;    // char
+};
+
+struct BinaryOperator
+{
+    uint32_t type;
+    uint32_t name;
+    uint32_t inputs;      // refs to operands
+    uint32_t input_count;
+    uint32_t outputs;     // refs to operands
+    uint32_t output_count;
+    uint32_t inputnames;  // refs to strings, input_count of them when has_inputnames
+    uint32_t has_inputnames;
+    uint32_t params;
+    uint32_t param_count;
+    uint32_t attrs;
+    uint32_t attr_count;
+};
+
+struct BinaryOperand
+{
+    uint32_t name;
+    int32_t type;
+    int32_t producer;     // operator index, -1 for none
+    uint32_t consumers;   // refs to operators
+    uint32_t consumer_count;
+    uint32_t shape;       // dims
+    uint32_t rank;
+    uint32_t params;
+    uint32_t param_count;
+};
+
+// value holds b, i, the bits of f or the string of s inline, arrays and complex
+// values start at blob word value and have count elements
+struct BinaryParameter
+{
+    uint32_t key;
+    int32_t type;
+    uint32_t value;
+    uint32_t count;
+};
+
+struct BinaryAttribute
+{
+    uint32_t key;
+    int32_t type;
+    uint32_t shape;       // dims
+    uint32_t rank;
+};
+
+// Read only view of a binary graph, either mapped from a file or over a caller owned
+// buffer. The record accessors need no allocation, ToGraph materializes a pnnx::Graph
+// for the runtime.
+class BinaryGraph
+{
+public:
+    BinaryGraph() = default;
+    ~BinaryGraph();
+
+    BinaryGraph(const BinaryGraph &) = delete;
+    BinaryGraph &operator=(const BinaryGraph &) = delete;
+
+    bool Open(const std::string &path);
+    // data must outlive this view and be aligned to 8 bytes
+    bool Parse(const void *data, size_t size);
+    void Close();
+
+    const BinaryGraphHeader &header() const;
+    const BinaryOperator *operators() const;
+    const BinaryOperand *operands() const;
+    const BinaryParameter *params() const;
+    const BinaryAttribute *attrs() const;
+    const uint32_t *refs() const;
+    const int32_t *dims() const;
+    const uint32_t *blobs() const;
+    const char *string(uint32_t offset) const;
+
+    // attribute data is read from bin_path when it is not empty
+    bool ToGraph(pnnx::Graph &graph, const std::string &bin_path = "") const;
+
+    static bool IsBinaryGraph(const std::string &path);
+    static bool Save(const pnnx::Graph &graph, const std::string &path);
+
+private:
+    bool ValidateRecords() const;
+
+    const char *data_ = nullptr;
+    size_t size_ = 0;
+    void *mapped_ = nullptr;
+}; // class BinaryGraph
+
+} // namespace runtime
+} // namespace jennifer
+
+#endif // JENNIFER_RUNTIME_BINARY_GRAPH_HPP
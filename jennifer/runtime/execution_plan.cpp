@@ -0,0 +1,419 @@
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <numeric>
+
+#include "execution_plan.hpp"
+
+namespace jennifer
+{
+namespace runtime
+{
+
+static const size_t kArenaAlignment = 64;
+
+std::string MakeShapeSignature(const std::vector<Shape> &input_shapes)
+{
+    std::string signature;
+    for (size_t i = 0; i < input_shapes.size(); ++i)
+    {
+        if (i != 0)
+        {
+            signature += ';';
+        }
+        for (size_t j = 0; j < input_shapes[i].size(); ++j)
+        {
+            if (j != 0)
+            {
+                signature += 'x';
+            }
+            signature += std::to_string(input_shapes[i][j]);
+        }
+    }
+    return signature;
+}
+
+// an operand the runtime allocates, not a graph input, constant or graph output
+static bool IsIntermediate(const pnnx::Operand *operand)
+{
+    const std::string &type = operand->producer->type;
+    if (type == "pnnx.Input" || type == "pnnx.Attribute")
+    {
+        return false;
+    }
+    for (const pnnx::Operator *consumer : operand->consumers)
+    {
+        if (consumer->type == "pnnx.Output")
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Floats between two steps of dim in a sample of shape, 0 when a step along dim is
+// not a contiguous slice of the sample. Samples of rank up to 3 are padded to the
+// (channels, rows, cols) of data::Tensor, stored as channels, then cols, then rows.
+static int64_t ContiguousStep(const Shape &shape, int32_t dim)
+{
+    const int32_t sample_rank = static_cast<int32_t>(shape.size()) - 1;
+    if (sample_rank < 1 || sample_rank > 3 || dim < 1)
+    {
+        return 0;
+    }
+    int64_t padded[3] = {1, 1, 1};
+    for (int32_t i = 0; i < sample_rank; ++i)
+    {
+        padded[3 - sample_rank + i] = shape[i + 1];
+    }
+    const int32_t axis = 3 - sample_rank + dim - 1;
+    const int32_t memory_order[3] = {0, 2, 1};
+    int64_t step = 1;
+    bool inner = false;
+    for (int32_t a : memory_order)
+    {
+        if (inner)
+        {
+            step *= padded[a];
+        }
+        else if (a == axis)
+        {
+            inner = true;
+        }
+        else if (padded[a] != 1)
+        {
+            return 0;
+        }
+    }
+    return step;
+}
+
+static void PlanConcatAliases(const pnnx::Graph &graph, const ShapeInference &inference, ExecutionPlan &plan)
+{
+    plan.alias_roots.assign(graph.operands.size(), -1);
+    plan.alias_offsets.assign(graph.operands.size(), 0);
+    for (const pnnx::Operator *op : graph.ops)
+    {
+        if (op->type != "torch.cat" || op->outputs.size() != 1)
+        {
+            continue;
+        }
+        const int output = inference.operand_index(op->outputs[0]);
+        const Shape &shape = plan.shapes[output];
+        auto p = op->params.find("dim");
+        const int32_t rank = static_cast<int32_t>(shape.size());
+        const int32_t dim = p == op->params.end() ? 0 : (p->second.i < 0 ? p->second.i + rank : p->second.i);
+        const int64_t step = ContiguousStep(shape, dim);
+        if (step == 0)
+        {
+            continue;
+        }
+
+        int64_t position = 0;
+        for (const pnnx::Operand *operand : op->inputs)
+        {
+            const int index = inference.operand_index(operand);
+            const int64_t offset = position * step;
+            position += plan.shapes[index][dim];
+            // an input given twice needs two copies, one already in another cat keeps its slice
+            if (!IsIntermediate(operand) || plan.alias_roots[index] >= 0
+                || std::count(op->inputs.begin(), op->inputs.end(), operand) != 1)
+            {
+                continue;
+            }
+            plan.alias_roots[index] = output;
+            plan.alias_offsets[index] = offset;
+        }
+    }
+
+    // the output of an inner cat may be an input of an outer one
+    const std::vector<int> parents = plan.alias_roots;
+    const std::vector<int64_t> parent_offsets = plan.alias_offsets;
+    for (size_t i = 0; i < parents.size(); ++i)
+    {
+        int root = parents[i];
+        while (root >= 0 && parents[root] >= 0)
+        {
+            plan.alias_offsets[i] += parent_offsets[root];
+            root = parents[root];
+        }
+        plan.alias_roots[i] = root;
+    }
+}
+
+static size_t ElementCount(const Shape &shape)
+{
+    return std::accumulate(shape.begin(), shape.end(), size_t(1), std::multiplies<size_t>());
+}
+
+// Elements of a sample of shape are stored like data::Tensor: channels, then cols,
+// then rows of the last two dims. Two samples of the same size store their elements
+// in the same order when their planes match, or when neither plane has more than
+// one row or col, which is the row-major order of torch.
+static bool SameMemoryOrder(const Shape &a, const Shape &b)
+{
+    auto plane = [](const Shape &shape, int64_t &rows, int64_t &cols) {
+        const size_t rank = shape.size();
+        rows = rank >= 3 ? shape[rank - 2] : 1;
+        cols = rank >= 2 ? shape[rank - 1] : 1;
+    };
+    int64_t a_rows, a_cols, b_rows, b_cols;
+    plane(a, a_rows, a_cols);
+    plane(b, b_rows, b_cols);
+    if (ElementCount(a) != ElementCount(b))
+    {
+        return false;
+    }
+    return (a_rows == b_rows && a_cols == b_cols) || ((a_rows == 1 || a_cols == 1) && (b_rows == 1 || b_cols == 1));
+}
+
+// Walks the operators in order and lets the output of an in place operator take the
+// storage of an input of the same shape when nothing reads that storage after the
+// operator: not the input, nor the other operands living in it. The output of a
+// view takes the storage of its first input whatever it is read by later. starts
+// and ends are the lifetimes of the storage roots and are widened by the new aliases.
+static void PlanReuse(const pnnx::Graph &graph, const ShapeInference &inference,
+                      const std::vector<StorageReuse> &reuse, std::vector<int32_t> &starts,
+                      std::vector<int32_t> &ends, ExecutionPlan &plan)
+{
+    std::vector<const pnnx::Operand *> operands(graph.operands.size());
+    std::vector<bool> has_aliases(graph.operands.size(), false);
+    for (const pnnx::Operand *operand : graph.operands)
+    {
+        const int index = inference.operand_index(operand);
+        operands[index] = operand;
+        if (plan.alias_roots[index] >= 0)
+        {
+            has_aliases[plan.alias_roots[index]] = true;
+        }
+    }
+
+    auto root_of = [&](const pnnx::Operand *operand) {
+        const int index = inference.operand_index(operand);
+        return plan.alias_roots[index] >= 0 ? plan.alias_roots[index] : index;
+    };
+    auto alias = [&](int output, int root, int64_t offset) {
+        plan.alias_roots[output] = root;
+        plan.alias_offsets[output] = offset;
+        has_aliases[root] = true;
+        starts[root] = std::min(starts[root], starts[output]);
+        ends[root] = std::max(ends[root], ends[output]);
+    };
+
+    for (size_t t = 0; t < graph.ops.size() && t < reuse.size(); ++t)
+    {
+        const pnnx::Operator *op = graph.ops[t];
+        if (reuse[t] == StorageReuse::None || op->outputs.size() != 1 || op->inputs.empty())
+        {
+            continue;
+        }
+        const int output = inference.operand_index(op->outputs[0]);
+        if (!IsIntermediate(op->outputs[0]) || plan.alias_roots[output] >= 0 || has_aliases[output])
+        {
+            continue;
+        }
+
+        if (reuse[t] == StorageReuse::View)
+        {
+            // graph inputs are only read through the view, constants are shared by
+            // every sample and a view that moves elements across samples needs a copy
+            const pnnx::Operand *operand = op->inputs[0];
+            const int input = inference.operand_index(operand);
+            const Shape &input_shape = plan.shapes[input];
+            const Shape &output_shape = plan.shapes[output];
+            if (operand->producer->type != "pnnx.Attribute" && !input_shape.empty() && !output_shape.empty()
+                && input_shape[0] == output_shape[0] && SameMemoryOrder(input_shape, output_shape))
+            {
+                alias(output, root_of(operand), plan.alias_offsets[input]);
+            }
+            continue;
+        }
+
+        for (const pnnx::Operand *operand : op->inputs)
+        {
+            const int input = inference.operand_index(operand);
+            const int root = root_of(operand);
+            // the input has to own all of its storage, not a slice of a cat output,
+            // and no other input may read from that storage while it is overwritten
+            if (!IsIntermediate(operand) || !IsIntermediate(operands[root]) || plan.alias_offsets[input] != 0
+                || plan.shapes[input] != plan.shapes[output]
+                || ElementCount(plan.shapes[root]) != ElementCount(plan.shapes[output])
+                || ends[root] > static_cast<int32_t>(t)
+                || std::any_of(op->inputs.begin(), op->inputs.end(), [&](const pnnx::Operand *other) {
+                       return other != operand && root_of(other) == root;
+                   }))
+            {
+                continue;
+            }
+            alias(output, root, 0);
+            break;
+        }
+    }
+}
+
+void PlanMemory(const pnnx::Graph &graph, const ShapeInference &inference, ExecutionPlan &plan,
+                const std::vector<StorageReuse> &reuse)
+{
+    CHECK_EQ(plan.shapes.size(), graph.operands.size()) << "Plan shapes are not inferred";
+    PlanConcatAliases(graph, inference, plan);
+
+    struct Block
+    {
+        int index;
+        size_t size;
+        int32_t start;
+        int32_t end;
+        size_t offset;
+    };
+
+    std::map<const pnnx::Operator *, int32_t> times;
+    for (size_t i = 0; i < graph.ops.size(); ++i)
+    {
+        times[graph.ops[i]] = i;
+    }
+
+    // lifetimes of every operand, an alias widens the one of its root
+    std::vector<int32_t> starts(graph.operands.size());
+    std::vector<int32_t> ends(graph.operands.size());
+    for (const pnnx::Operand *operand : graph.operands)
+    {
+        const int index = inference.operand_index(operand);
+        starts[index] = times.at(operand->producer);
+        ends[index] = starts[index];
+        for (const pnnx::Operator *consumer : operand->consumers)
+        {
+            ends[index] = std::max(ends[index], times.at(consumer));
+        }
+    }
+    for (size_t i = 0; i < graph.operands.size(); ++i)
+    {
+        const int root = plan.alias_roots[i];
+        if (root >= 0)
+        {
+            starts[root] = std::min(starts[root], starts[i]);
+            ends[root] = std::max(ends[root], ends[i]);
+        }
+    }
+    PlanReuse(graph, inference, reuse, starts, ends, plan);
+
+    std::vector<Block> blocks;
+    for (const pnnx::Operand *operand : graph.operands)
+    {
+        const int index = inference.operand_index(operand);
+        if (!IsIntermediate(operand) || plan.alias_roots[index] >= 0)
+        {
+            continue;
+        }
+
+        const size_t count = ElementCount(plan.shapes[index]);
+        const size_t size = (count * sizeof(float) + kArenaAlignment - 1) / kArenaAlignment * kArenaAlignment;
+        blocks.push_back({index, size, starts[index], ends[index], 0});
+    }
+
+    std::sort(blocks.begin(), blocks.end(), [](const Block &a, const Block &b) {
+        return a.size != b.size ? a.size > b.size : a.start < b.start;
+    });
+
+    plan.offsets.assign(graph.operands.size(), -1);
+    plan.arena_size = 0;
+
+    std::vector<const Block *> placed;
+    for (Block &block : blocks)
+    {
+        std::vector<const Block *> live;
+        for (const Block *other : placed)
+        {
+            if (other->start <= block.end && block.start <= other->end)
+            {
+                live.push_back(other);
+            }
+        }
+        std::sort(live.begin(), live.end(), [](const Block *a, const Block *b) { return a->offset < b->offset; });
+
+        size_t offset = 0;
+        for (const Block *other : live)
+        {
+            if (offset + block.size <= other->offset)
+            {
+                break;
+            }
+            offset = std::max(offset, other->offset + other->size);
+        }
+
+        block.offset = offset;
+        placed.push_back(&block);
+        plan.offsets[block.index] = offset;
+        plan.arena_size = std::max(plan.arena_size, offset + block.size);
+    }
+}
+
+PlanCache::PlanCache(size_t capacity) :
+    capacity_(capacity)
+{
+    CHECK_GT(capacity_, 0) << "Plan cache capacity must be positive";
+}
+
+std::shared_ptr<const ExecutionPlan> PlanCache::Find(const std::string &signature)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(signature);
+    if (it == index_.end())
+    {
+        misses_ += 1;
+        return nullptr;
+    }
+
+    hits_ += 1;
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return it->second->second;
+}
+
+void PlanCache::Insert(const std::shared_ptr<const ExecutionPlan> &plan)
+{
+    CHECK(plan != nullptr) << "Execution plan is empty";
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(plan->signature);
+    if (it != index_.end())
+    {
+        // another thread planned the same signature first, keep that one
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return;
+    }
+
+    if (entries_.size() >= capacity_)
+    {
+        index_.erase(entries_.back().first);
+        entries_.pop_back();
+    }
+    entries_.emplace_front(plan->signature, plan);
+    index_[plan->signature] = entries_.begin();
+}
+
+void PlanCache::Clear()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    index_.clear();
+}
+
+size_t PlanCache::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+uint64_t PlanCache::hits() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return hits_;
+}
+
+uint64_t PlanCache::misses() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return misses_;
+}
+
+} // namespace runtime
+} // namespace jennifer
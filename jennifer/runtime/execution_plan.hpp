@@ -0,0 +1,102 @@
+#ifndef JENNIFER_RUNTIME_EXECUTION_PLAN_HPP
+#define JENNIFER_RUNTIME_EXECUTION_PLAN_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "jennifer/runtime/pnnx/ir.h"
+#include "jennifer/utils/common.hpp"
+
+#include "shape_inference.hpp"
+
+namespace jennifer
+{
+namespace runtime
+{
+
+// Everything resolved for one concrete input shape signature. Operand entries are
+// indexed like pnnx::Graph::operands and operator entries like pnnx::Graph::ops.
+struct ExecutionPlan
+{
+    std::string signature;
+
+    std::vector<Shape> shapes;
+
+    // byte offset of each operand inside the activation arena, -1 for operands that
+    // are not arena backed (graph inputs, graph outputs and constants)
+    std::vector<int64_t> offsets;
+    size_t arena_size = 0;
+
+    // operands the producer writes straight into the storage of another operand,
+    // the inputs of a torch.cat into its output, the output of an in place operator
+    // over its input or a view over the storage of its input: the operand owning
+    // the storage, -1 for operands with storage of their own, and the float offset
+    // inside every sample of it. Chains resolve to the outermost owner.
+    std::vector<int> alias_roots;
+    std::vector<int64_t> alias_offsets;
+
+    // layer registry key chosen for each operator
+    std::vector<std::string> kernels;
+}; // struct ExecutionPlan
+
+std::string MakeShapeSignature(const std::vector<Shape> &input_shapes);
+
+// how the output of an operator may share the storage of its inputs
+enum class StorageReuse
+{
+    None,
+    // overwrites an input of the same shape that is dead after the operator
+    InPlace,
+    // reinterprets its first input, valid for as long as the output is read
+    View,
+}; // enum class StorageReuse
+
+// Assigns arena offsets so that operands whose lifetimes [producer, last consumer]
+// overlap never share bytes. Operands are placed largest first at the lowest offset
+// that does not collide with an already placed, overlapping operand. A torch.cat
+// input that is a contiguous slice of every output sample, and has no storage
+// constraint of its own, becomes an alias of that slice, so the cat copies nothing;
+// the output then lives from the first producer to the last consumer of them all.
+// reuse is indexed like pnnx::Graph::ops. The output of an InPlace operator takes
+// over the storage of an input of the same shape that nothing reads afterwards.
+// The output of a View operator shares the storage of its first input when both
+// store their elements in the same order, the input then lives as long as the view.
+void PlanMemory(const pnnx::Graph &graph, const ShapeInference &inference, ExecutionPlan &plan,
+                const std::vector<StorageReuse> &reuse = {});
+
+// Thread-safe map from shape signature to plan, evicting the least recently used
+// signature once capacity plans are cached.
+class PlanCache
+{
+public:
+    explicit PlanCache(size_t capacity = 64);
+
+    std::shared_ptr<const ExecutionPlan> Find(const std::string &signature);
+    void Insert(const std::shared_ptr<const ExecutionPlan> &plan);
+    void Clear();
+
+    size_t size() const;
+    uint64_t hits() const;
+    uint64_t misses() const;
+
+private:
+    using Entry = std::pair<std::string, std::shared_ptr<const ExecutionPlan>>;
+
+    size_t capacity_;
+    mutable std::mutex mutex_;
+    std::list<Entry> entries_;
+    std::map<std::string, std::list<Entry>::iterator> index_;
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+}; // class PlanCache
+
+} // namespace runtime
+} // namespace jennifer
+
+#endif // JENNIFER_RUNTIME_EXECUTION_PLAN_HPP
@@ -0,0 +1,177 @@
+#include <glog/logging.h>
+
+#include <algorithm>
+
+#include "kv_cache.hpp"
+
+namespace jennifer
+{
+namespace runtime
+{
+
+KVCache::KVCache(const KVCacheConfig &config) : config_(config)
+{
+    CHECK(config_.page_tokens > 0 && config_.max_pages > 0) << "KV cache needs pages of at least one token";
+    if (config_.token_width > 0)
+    {
+        Allocate(config_.token_width);
+    }
+}
+
+void KVCache::Allocate(int64_t token_width)
+{
+    config_.token_width = token_width;
+    storage_.resize(config_.max_pages * config_.page_tokens * token_width);
+    // the lowest pages are handed out first
+    for (int64_t p = config_.max_pages - 1; p >= 0; --p)
+    {
+        free_pages_.push_back(storage_.data() + p * config_.page_tokens * token_width);
+    }
+}
+
+int64_t KVCache::AddSequence()
+{
+    sequences_[next_sequence_];
+    return next_sequence_++;
+}
+
+void KVCache::RemoveSequence(int64_t sequence)
+{
+    auto it = sequences_.find(sequence);
+    if (it == sequences_.end())
+    {
+        return;
+    }
+    for (const LayerCache &cache : it->second)
+    {
+        free_pages_.insert(free_pages_.end(), cache.key_pages.rbegin(), cache.key_pages.rend());
+        free_pages_.insert(free_pages_.end(), cache.value_pages.rbegin(), cache.value_pages.rend());
+    }
+    sequences_.erase(it);
+}
+
+bool KVCache::HasSequence(int64_t sequence) const
+{
+    return sequences_.find(sequence) != sequences_.end();
+}
+
+int64_t KVCache::length(int64_t sequence, int layer) const
+{
+    auto it = sequences_.find(sequence);
+    if (it == sequences_.end() || layer < 0 || static_cast<size_t>(layer) >= it->second.size())
+    {
+        return 0;
+    }
+    return it->second[layer].length;
+}
+
+bool KVCache::Append(int64_t sequence, int layer, const layer::AttentionView<const float> &key,
+                     const layer::AttentionView<const float> &value, int64_t kv_heads, int64_t rows,
+                     int64_t head_dim, int64_t value_dim)
+{
+    auto it = sequences_.find(sequence);
+    if (it == sequences_.end() || layer < 0)
+    {
+        LOG(ERROR) << "KV cache has no sequence " << sequence;
+        return false;
+    }
+    if (static_cast<size_t>(layer) >= it->second.size())
+    {
+        it->second.resize(layer + 1);
+    }
+
+    LayerCache &cache = it->second[layer];
+    if (cache.kv_heads == 0)
+    {
+        cache.kv_heads = kv_heads;
+        cache.head_dim = head_dim;
+        cache.value_dim = value_dim;
+    }
+    else if (cache.kv_heads != kv_heads || cache.head_dim != head_dim || cache.value_dim != value_dim)
+    {
+        LOG(ERROR) << "KV cache layer " << layer << " holds rows of " << cache.kv_heads << " x " << cache.head_dim
+                   << " and " << cache.value_dim << " dims";
+        return false;
+    }
+
+    const int64_t width = kv_heads * std::max(head_dim, value_dim);
+    if (storage_.empty())
+    {
+        Allocate(width);
+    }
+    const int64_t pages = (cache.length + rows + config_.page_tokens - 1) / config_.page_tokens;
+    const int64_t missing = pages - static_cast<int64_t>(cache.key_pages.size());
+    if (width > config_.token_width || missing * 2 > static_cast<int64_t>(free_pages_.size()))
+    {
+        LOG(ERROR) << "KV cache can not hold " << rows << " more rows of " << width << " floats, "
+                   << free_pages_.size() << " pages of " << config_.token_width << " floats are free";
+        return false;
+    }
+    for (int64_t p = 0; p < missing; ++p)
+    {
+        cache.key_pages.push_back(free_pages_.back());
+        free_pages_.pop_back();
+        cache.value_pages.push_back(free_pages_.back());
+        free_pages_.pop_back();
+    }
+
+    for (int64_t r = 0; r < rows; ++r)
+    {
+        const int64_t position = cache.length + r;
+        const int64_t page = position / config_.page_tokens;
+        const int64_t page_row = position % config_.page_tokens;
+        for (int64_t h = 0; h < kv_heads; ++h)
+        {
+            const float *key_row = layer::RowPointer(key, h, r);
+            float *key_page = cache.key_pages[page] + (h * config_.page_tokens + page_row) * head_dim;
+            for (int64_t c = 0; c < head_dim; ++c)
+            {
+                key_page[c] = key_row[c * key.col_stride];
+            }
+            const float *value_row = layer::RowPointer(value, h, r);
+            float *value_page = cache.value_pages[page] + (h * config_.page_tokens + page_row) * value_dim;
+            for (int64_t c = 0; c < value_dim; ++c)
+            {
+                value_page[c] = value_row[c * value.col_stride];
+            }
+        }
+    }
+    cache.length += rows;
+    return true;
+}
+
+layer::AttentionView<const float> KVCache::PagedView(const std::vector<float *> &pages, int64_t dim) const
+{
+    layer::AttentionView<const float> view;
+    view.head_stride = config_.page_tokens * dim;
+    view.row_stride = dim;
+    view.col_stride = 1;
+    view.pages = pages.data();
+    view.page_rows = config_.page_tokens;
+    return view;
+}
+
+layer::AttentionView<const float> KVCache::keys(int64_t sequence, int layer) const
+{
+    const LayerCache &cache = sequences_.at(sequence).at(layer);
+    return PagedView(cache.key_pages, cache.head_dim);
+}
+
+layer::AttentionView<const float> KVCache::values(int64_t sequence, int layer) const
+{
+    const LayerCache &cache = sequences_.at(sequence).at(layer);
+    return PagedView(cache.value_pages, cache.value_dim);
+}
+
+int64_t KVCache::free_pages() const
+{
+    return static_cast<int64_t>(free_pages_.size());
+}
+
+const KVCacheConfig &KVCache::config() const
+{
+    return config_;
+}
+
+} // namespace runtime
+} // namespace jennifer
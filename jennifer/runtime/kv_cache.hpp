@@ -0,0 +1,87 @@
+#ifndef JENNIFER_RUNTIME_KV_CACHE_HPP
+#define JENNIFER_RUNTIME_KV_CACHE_HPP
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include "jennifer/layer/attention.hpp"
+#include "jennifer/utils/huge_pages.hpp"
+
+namespace jennifer
+{
+namespace runtime
+{
+
+struct KVCacheConfig
+{
+    // tokens of one page; a multiple of the 64 key rows of an attention tile keeps
+    // every tile inside one page
+    int64_t page_tokens = 64;
+    int64_t max_pages = 1024;
+    // floats of one token of one layer, kv_heads * head_dim of the wider of key and
+    // value; 0 takes the width of the first append
+    int64_t token_width = 0;
+}; // struct KVCacheConfig
+
+// Keys and values of the attention layers of a decoder for every sequence in
+// flight. Storage is one block of max_pages pages allocated up front, a page holds
+// page_tokens rows of the key or the value of one layer as (kv_heads, page_tokens,
+// dim). Appending writes the new rows in place and takes a free page only when the
+// last one is full, so a growing sequence never copies what it has cached, and
+// removing a sequence returns its pages.
+class KVCache
+{
+public:
+    explicit KVCache(const KVCacheConfig &config = KVCacheConfig());
+
+    KVCache(const KVCache &) = delete;
+    KVCache &operator=(const KVCache &) = delete;
+
+    // a new empty sequence
+    int64_t AddSequence();
+    void RemoveSequence(int64_t sequence);
+    bool HasSequence(int64_t sequence) const;
+
+    // tokens cached for layer of sequence, 0 before its first append
+    int64_t length(int64_t sequence, int layer = 0) const;
+
+    // appends rows [0, rows) of key (kv_heads, rows, head_dim) and value (kv_heads,
+    // rows, value_dim); false when the pages run out or the dims differ from the
+    // earlier appends of the layer
+    bool Append(int64_t sequence, int layer, const layer::AttentionView<const float> &key,
+                const layer::AttentionView<const float> &value, int64_t kv_heads, int64_t rows, int64_t head_dim,
+                int64_t value_dim);
+
+    // paged views over every cached row, valid until the next append or removal
+    layer::AttentionView<const float> keys(int64_t sequence, int layer) const;
+    layer::AttentionView<const float> values(int64_t sequence, int layer) const;
+
+    int64_t free_pages() const;
+    const KVCacheConfig &config() const;
+
+private:
+    struct LayerCache
+    {
+        int64_t length = 0;
+        int64_t kv_heads = 0;
+        int64_t head_dim = 0;
+        int64_t value_dim = 0;
+        std::vector<float *> key_pages;
+        std::vector<float *> value_pages;
+    }; // struct LayerCache
+
+    void Allocate(int64_t token_width);
+    layer::AttentionView<const float> PagedView(const std::vector<float *> &pages, int64_t dim) const;
+
+    KVCacheConfig config_;
+    utils::HugeVector<float> storage_;
+    std::vector<float *> free_pages_;
+    std::map<int64_t, std::vector<LayerCache>> sequences_;
+    int64_t next_sequence_ = 0;
+}; // class KVCache
+
+} // namespace runtime
+} // namespace jennifer
+
+#endif // JENNIFER_RUNTIME_KV_CACHE_HPP
@@ -0,0 +1,151 @@
+#include <glog/logging.h>
+
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+#include "jennifer/utils/parallel.hpp"
+
+#include "numa.hpp"
+
+namespace jennifer
+{
+namespace runtime
+{
+
+// mode of set_mempolicy(2), glibc has no wrapper without libnuma
+static const int kInterleavePolicy = 3;
+
+std::vector<int32_t> ParseCpuList(const std::string &list)
+{
+    std::vector<int32_t> cpus;
+    size_t begin = 0;
+    while (begin < list.size())
+    {
+        size_t end = list.find(',', begin);
+        end = end == std::string::npos ? list.size() : end;
+        const std::string range = list.substr(begin, end - begin);
+        begin = end + 1;
+        if (range.empty() || range == "\n")
+        {
+            continue;
+        }
+
+        int first = 0;
+        int last = 0;
+        char tail = 0;
+        const int n = sscanf(range.c_str(), "%d-%d%c", &first, &last, &tail);
+        if (n == 1)
+        {
+            last = first;
+        }
+        if (n < 1 || (n == 3 && tail != '\n') || first < 0 || last < first)
+        {
+            return {};
+        }
+        for (int cpu = first; cpu <= last; ++cpu)
+        {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+std::vector<NumaNode> DetectNumaTopology(const std::string &root)
+{
+    std::vector<NumaNode> nodes;
+    if (DIR *dir = opendir(root.c_str()))
+    {
+        while (const dirent *entry = readdir(dir))
+        {
+            int id = 0;
+            char tail = 0;
+            if (sscanf(entry->d_name, "node%d%c", &id, &tail) != 1)
+            {
+                continue;
+            }
+            std::ifstream file(root + "/" + entry->d_name + "/cpulist");
+            std::string list;
+            if (!std::getline(file, list))
+            {
+                continue;
+            }
+            NumaNode node;
+            node.id = id;
+            node.cpus = ParseCpuList(list);
+            if (!node.cpus.empty())
+            {
+                nodes.push_back(std::move(node));
+            }
+        }
+        closedir(dir);
+    }
+    std::sort(nodes.begin(), nodes.end(), [](const NumaNode &a, const NumaNode &b) { return a.id < b.id; });
+
+    if (nodes.empty())
+    {
+        NumaNode node;
+        const int32_t count = std::max(1u, std::thread::hardware_concurrency());
+        for (int32_t cpu = 0; cpu < count; ++cpu)
+        {
+            node.cpus.push_back(cpu);
+        }
+        nodes.push_back(std::move(node));
+    }
+    return nodes;
+}
+
+bool PinThread(const NumaNode &node)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int32_t cpu : node.cpus)
+    {
+        if (cpu >= 0 && cpu < CPU_SETSIZE)
+        {
+            CPU_SET(cpu, &set);
+        }
+    }
+    const int status = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (status != 0)
+    {
+        LOG(WARNING) << "Can not pin the thread to the " << node.cpus.size() << " cpus of node " << node.id
+                     << ", error " << status;
+        return false;
+    }
+    utils::DefaultThreads() = static_cast<int>(node.cpus.size());
+    return true;
+}
+
+bool InterleaveMemory(const std::vector<NumaNode> &nodes)
+{
+    const int bits = 8 * sizeof(unsigned long);
+    std::vector<unsigned long> mask(1);
+    for (const NumaNode &node : nodes)
+    {
+        if (node.id < 0)
+        {
+            continue;
+        }
+        mask.resize(std::max<size_t>(mask.size(), node.id / bits + 1), 0);
+        mask[node.id / bits] |= 1UL << (node.id % bits);
+    }
+    if (syscall(SYS_set_mempolicy, kInterleavePolicy, mask.data(), mask.size() * bits + 1) != 0)
+    {
+        LOG(WARNING) << "Can not interleave memory over " << nodes.size() << " nodes, " << strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+} // namespace runtime
+} // namespace jennifer
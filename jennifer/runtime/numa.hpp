@@ -0,0 +1,38 @@
+#ifndef JENNIFER_RUNTIME_NUMA_HPP
+#define JENNIFER_RUNTIME_NUMA_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace jennifer
+{
+namespace runtime
+{
+
+struct NumaNode
+{
+    int32_t id = 0;
+    std::vector<int32_t> cpus;
+}; // struct NumaNode
+
+// cpus of a sysfs cpulist such as "0-3,8,10-11", empty when the list is malformed
+std::vector<int32_t> ParseCpuList(const std::string &list);
+
+// Nodes and their cpus from root/node<N>/cpulist sorted by id, nodes without cpus
+// are left out. Without the directory there is a single node 0 holding every
+// hardware thread.
+std::vector<NumaNode> DetectNumaTopology(const std::string &root = "/sys/devices/system/node");
+
+// Pins the calling thread to the cpus of node. Threads it starts inherit the mask,
+// ParallelFor on it defaults to one thread per cpu of the node, and pages it first
+// touches afterwards are allocated on the node by the default local policy.
+bool PinThread(const NumaNode &node);
+
+// Spreads the pages the calling thread allocates afterwards round robin over nodes
+bool InterleaveMemory(const std::vector<NumaNode> &nodes);
+
+} // namespace runtime
+} // namespace jennifer
+
+#endif // JENNIFER_RUNTIME_NUMA_HPP
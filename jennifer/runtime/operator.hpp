@@ -1,22 +1,29 @@
 #ifndef JENNIFER_RUNTIME_OPERATOR_HPP
 #define JENNIFER_RUNTIME_OPERATOR_HPP
 
+#include <map>
 #include <memory>
 #include <string>
 #include <vector>
 #include <cstdint>
 
+#include "attribute.hpp"
 #include "operand.hpp"
 #include "parameter.hpp"
 
 namespace jennifer
 {
-namespace runtime
+namespace layer
 {
 
 template <typename T>
 class Layer;
 
+} // namespace layer
+
+namespace runtime
+{
+
 template <typename T>
 struct Operator
 {
@@ -29,7 +36,7 @@ struct Operator
 
     bool has_forward = false;
 
-    std::shared_ptr<Layer<T>> layer;
+    std::shared_ptr<layer::Layer<T>> layer;
 
     std::vector<std::string> output_names;
 
@@ -39,6 +46,9 @@ struct Operator
 
     std::map<std::string, std::shared_ptr<Operator<T>>> output_operators;
 
+    std::map<std::string, std::shared_ptr<Parameter>> params;
+    std::map<std::string, std::shared_ptr<Attribute>> attrs;
+
 }; // struct Operator
 
 } // namespace runtime
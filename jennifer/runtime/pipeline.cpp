@@ -0,0 +1,296 @@
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <stdexcept>
+
+#include "jennifer/utils/parallel.hpp"
+
+#include "pipeline.hpp"
+
+namespace jennifer
+{
+namespace runtime
+{
+
+using utils::StatusCode;
+
+std::vector<std::pair<size_t, size_t>> PartitionStages(const std::vector<double> &costs, uint32_t stages)
+{
+    const size_t n = costs.size();
+    const size_t k = std::max<size_t>(1, std::min<size_t>(stages, n));
+    std::vector<std::pair<size_t, size_t>> ranges;
+    if (n == 0)
+    {
+        ranges.emplace_back(0, 0);
+        return ranges;
+    }
+
+    std::vector<double> prefix(n + 1, 0.0);
+    for (size_t i = 0; i < n; ++i)
+    {
+        prefix[i + 1] = prefix[i] + costs[i];
+    }
+
+    // best[s][j] is the smallest largest stage of operators [0, j) in s + 1 stages,
+    // cut[s][j] where its last stage begins
+    const double inf = std::numeric_limits<double>::infinity();
+    std::vector<std::vector<double>> best(k, std::vector<double>(n + 1, inf));
+    std::vector<std::vector<size_t>> cut(k, std::vector<size_t>(n + 1, 0));
+    for (size_t j = 1; j <= n; ++j)
+    {
+        best[0][j] = prefix[j];
+    }
+    for (size_t s = 1; s < k; ++s)
+    {
+        for (size_t j = s + 1; j <= n; ++j)
+        {
+            for (size_t i = s; i < j; ++i)
+            {
+                const double cost = std::max(best[s - 1][i], prefix[j] - prefix[i]);
+                if (cost < best[s][j])
+                {
+                    best[s][j] = cost;
+                    cut[s][j] = i;
+                }
+            }
+        }
+    }
+
+    size_t end = n;
+    for (size_t s = k; s-- > 0;)
+    {
+        const size_t begin = s == 0 ? 0 : cut[s][end];
+        ranges.emplace_back(begin, end);
+        end = begin;
+    }
+    std::reverse(ranges.begin(), ranges.end());
+    return ranges;
+}
+
+Pipeline::Pipeline(RuntimeGraph &graph, const PipelineOptions &options) : graph_(graph), options_(options)
+{
+    CHECK_GT(options_.stages, 0) << "Pipeline needs a stage";
+    CHECK_GT(options_.queue_depth, 0) << "Pipeline queues need room for a frame";
+}
+
+Pipeline::~Pipeline()
+{
+    Stop();
+}
+
+StatusCode Pipeline::Init(const std::vector<std::shared_ptr<Operand<float>>> &sample_inputs)
+{
+    CHECK(stages_.empty()) << "Pipeline is already initialized";
+
+    int threads = options_.threads_per_stage;
+    if (threads <= 0)
+    {
+        threads = std::max(1, utils::ResolveThreads(0) / static_cast<int>(options_.stages));
+    }
+
+    // calibrate with the threads a stage will have, the first pass plans the
+    // shapes and warms the layers up
+    const size_t count = graph_.graph().ops.size();
+    std::vector<double> costs(count, 0.0);
+    std::unique_ptr<RuntimeGraph::Frame> frame(new RuntimeGraph::Frame);
+    std::vector<std::shared_ptr<Operand<float>>> outputs;
+    const int saved_threads = utils::DefaultThreads();
+    utils::DefaultThreads() = threads;
+    StatusCode status = StatusCode::Success;
+    for (int pass = 0; pass < 2 && status == StatusCode::Success; ++pass)
+    {
+        status = graph_.BeginFrame(sample_inputs, *frame);
+        for (size_t i = 0; i < count && status == StatusCode::Success; ++i)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            status = graph_.RunFrame(*frame, i, i + 1);
+            costs[i] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+        if (status == StatusCode::Success)
+        {
+            graph_.EndFrame(*frame, outputs);
+        }
+    }
+    utils::DefaultThreads() = saved_threads;
+    if (status != StatusCode::Success)
+    {
+        LOG(ERROR) << "Pipeline calibration failed with status " << static_cast<int>(status);
+        return status;
+    }
+    frames_.push_back(std::move(frame));
+
+    ranges_ = PartitionStages(costs, options_.stages);
+    stage_costs_.clear();
+    for (const auto &range : ranges_)
+    {
+        double cost = 0.0;
+        for (size_t i = range.first; i < range.second; ++i)
+        {
+            cost += costs[i];
+        }
+        stage_costs_.push_back(cost);
+        stages_.emplace_back(new Stage);
+        stages_.back()->begin = range.first;
+        stages_.back()->end = range.second;
+    }
+    for (size_t i = 0; i < stages_.size(); ++i)
+    {
+        stages_[i]->thread = std::thread([this, i, threads]() {
+            utils::DefaultThreads() = threads;
+            Loop(i);
+        });
+    }
+    return StatusCode::Success;
+}
+
+std::future<AsyncResult> Pipeline::Submit(std::vector<std::shared_ptr<Operand<float>>> inputs)
+{
+    std::unique_ptr<Job> job(new Job);
+    job->inputs = std::move(inputs);
+    std::future<AsyncResult> future = job->promise.get_future();
+    if (stages_.empty() || !Push(*stages_.front(), std::move(job)))
+    {
+        std::promise<AsyncResult> failed;
+        failed.set_exception(std::make_exception_ptr(std::runtime_error("Pipeline is not running")));
+        return failed.get_future();
+    }
+    return future;
+}
+
+bool Pipeline::Push(Stage &stage, std::unique_ptr<Job> job)
+{
+    std::unique_lock<std::mutex> lock(stage.mutex);
+    stage.not_full.wait(lock, [&] { return stage.closed || stage.jobs.size() < options_.queue_depth; });
+    if (stage.closed)
+    {
+        return false;
+    }
+    stage.jobs.push_back(std::move(job));
+    stage.not_empty.notify_one();
+    return true;
+}
+
+void Pipeline::Loop(size_t index)
+{
+    Stage &stage = *stages_[index];
+    while (true)
+    {
+        std::unique_ptr<Job> job;
+        {
+            std::unique_lock<std::mutex> lock(stage.mutex);
+            stage.not_empty.wait(lock, [&] { return stage.closed || !stage.jobs.empty(); });
+            if (stage.jobs.empty())
+            {
+                // closed and drained
+                return;
+            }
+            job = std::move(stage.jobs.front());
+            stage.jobs.pop_front();
+            stage.not_full.notify_one();
+        }
+
+        try
+        {
+            if (index == 0)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(frame_mutex_);
+                    if (!frames_.empty())
+                    {
+                        job->frame = std::move(frames_.back());
+                        frames_.pop_back();
+                    }
+                }
+                if (job->frame == nullptr)
+                {
+                    job->frame.reset(new RuntimeGraph::Frame);
+                }
+                job->status = graph_.BeginFrame(job->inputs, *job->frame);
+            }
+            // a failed frame passes through the later stages to keep the order
+            if (job->status == StatusCode::Success && job->exception == nullptr)
+            {
+                job->status = graph_.RunFrame(*job->frame, stage.begin, stage.end);
+            }
+        }
+        catch (...)
+        {
+            job->exception = std::current_exception();
+        }
+
+        if (index + 1 == stages_.size())
+        {
+            Finish(std::move(job));
+        }
+        else
+        {
+            // the next stage closes only after this one has joined
+            CHECK(Push(*stages_[index + 1], std::move(job)));
+        }
+    }
+}
+
+void Pipeline::Finish(std::unique_ptr<Job> job)
+{
+    AsyncResult result;
+    result.status = job->status;
+    if (job->status == StatusCode::Success && job->exception == nullptr)
+    {
+        graph_.EndFrame(*job->frame, result.outputs);
+    }
+    else if (job->frame != nullptr)
+    {
+        job->frame->values.clear();
+        job->frame->plan.reset();
+    }
+    job->inputs.clear();
+    if (job->frame != nullptr)
+    {
+        std::lock_guard<std::mutex> lock(frame_mutex_);
+        frames_.push_back(std::move(job->frame));
+    }
+
+    if (job->exception != nullptr)
+    {
+        job->promise.set_exception(job->exception);
+        return;
+    }
+    if (result.status != StatusCode::Success)
+    {
+        LOG(ERROR) << "Pipeline frame failed with status " << static_cast<int>(result.status);
+    }
+    job->promise.set_value(std::move(result));
+}
+
+void Pipeline::Stop()
+{
+    // stages close front to back, each after the one before has drained into it
+    for (const std::unique_ptr<Stage> &stage : stages_)
+    {
+        {
+            std::lock_guard<std::mutex> lock(stage->mutex);
+            stage->closed = true;
+        }
+        stage->not_empty.notify_all();
+        stage->not_full.notify_all();
+        if (stage->thread.joinable())
+        {
+            stage->thread.join();
+        }
+    }
+}
+
+const std::vector<std::pair<size_t, size_t>> &Pipeline::stages() const
+{
+    return ranges_;
+}
+
+const std::vector<double> &Pipeline::stage_costs() const
+{
+    return stage_costs_;
+}
+
+} // namespace runtime
+} // namespace jennifer
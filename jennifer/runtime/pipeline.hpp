@@ -0,0 +1,115 @@
+#ifndef JENNIFER_RUNTIME_PIPELINE_HPP
+#define JENNIFER_RUNTIME_PIPELINE_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "jennifer/utils/common.hpp"
+
+#include "async_runner.hpp"
+#include "operand.hpp"
+#include "runtime_graph.hpp"
+
+namespace jennifer
+{
+namespace runtime
+{
+
+struct PipelineOptions
+{
+    // contiguous operator ranges, each run by a thread of its own
+    uint32_t stages = 2;
+
+    // ParallelFor threads of every stage, 0 shares the hardware threads out evenly
+    int threads_per_stage = 0;
+
+    // frames waiting in front of every stage, Submit blocks while the first stage is full
+    uint32_t queue_depth = 2;
+}; // struct PipelineOptions
+
+// Splits the operators [0, costs.size()) into stages contiguous ranges whose
+// largest summed cost is the smallest possible.
+std::vector<std::pair<size_t, size_t>> PartitionStages(const std::vector<double> &costs, uint32_t stages);
+
+// Runs a stream of frames through a graph split into stages. Stage s runs its
+// operators for frame n while stage s + 1 runs frame n - 1, so once the pipeline
+// is full a frame completes every time the slowest stage does. Frames complete in
+// submission order. Stages are balanced for the shapes of the calibration inputs,
+// and the graph must not run Forward or Decode while the pipeline runs.
+class Pipeline
+{
+public:
+    explicit Pipeline(RuntimeGraph &graph, const PipelineOptions &options = PipelineOptions());
+    ~Pipeline();
+
+    Pipeline(const Pipeline &) = delete;
+    Pipeline &operator=(const Pipeline &) = delete;
+
+    // times every operator on sample inputs, partitions the operators by those
+    // times and starts the stage threads
+    utils::StatusCode Init(const std::vector<std::shared_ptr<Operand<float>>> &sample_inputs);
+
+    // the future throws what a layer threw, a failed status is in the result
+    std::future<AsyncResult> Submit(std::vector<std::shared_ptr<Operand<float>>> inputs);
+
+    // runs the queued frames and joins the stages, later submissions fail
+    void Stop();
+
+    // graph operators [begin, end) of every stage
+    const std::vector<std::pair<size_t, size_t>> &stages() const;
+
+    // calibrated milliseconds of every stage
+    const std::vector<double> &stage_costs() const;
+
+private:
+    struct Job
+    {
+        std::vector<std::shared_ptr<Operand<float>>> inputs;
+        std::unique_ptr<RuntimeGraph::Frame> frame;
+        utils::StatusCode status = utils::StatusCode::Success;
+        std::exception_ptr exception;
+        std::promise<AsyncResult> promise;
+    }; // struct Job
+
+    // bounded queue in front of a stage
+    struct Stage
+    {
+        size_t begin = 0;
+        size_t end = 0;
+
+        std::mutex mutex;
+        std::condition_variable not_empty;
+        std::condition_variable not_full;
+        std::deque<std::unique_ptr<Job>> jobs;
+        bool closed = false;
+
+        std::thread thread;
+    }; // struct Stage
+
+    bool Push(Stage &stage, std::unique_ptr<Job> job);
+    void Loop(size_t index);
+    void Finish(std::unique_ptr<Job> job);
+
+    RuntimeGraph &graph_;
+    PipelineOptions options_;
+
+    std::vector<std::pair<size_t, size_t>> ranges_;
+    std::vector<double> stage_costs_;
+    std::vector<std::unique_ptr<Stage>> stages_;
+
+    // frames whose arenas the next jobs reuse
+    std::mutex frame_mutex_;
+    std::vector<std::unique_ptr<RuntimeGraph::Frame>> frames_;
+}; // class Pipeline
+
+} // namespace runtime
+} // namespace jennifer
+
+#endif // JENNIFER_RUNTIME_PIPELINE_HPP
@@ -14,10 +14,13 @@
 
 #include "runtime/pnnx/ir.h"
 
+#include <float.h>
 #include <limits.h>
+#include <math.h>
 #include <stdint.h>
 #include <string.h>
 #include <algorithm>
+#include <charconv>
 #include <fstream>
 #include <sstream>
 #include <string>
@@ -429,7 +432,7 @@ Attribute operator+(const Attribute& a, const Attribute& b)
     return c;
 }
 
-Parameter Parameter::parse_from_string(const std::string& value)
+Parameter Parameter::parse_from_string_legacy(const std::string& value)
 {
     if (value.find('%') != std::string::npos)
     {
@@ -510,6 +513,138 @@ Parameter Parameter::parse_from_string(const std::string& value)
     return p;
 }
 
+// same test as the legacy parser, a token is numeric when it starts with a digit or
+// with a minus followed by a digit
+static bool is_numeric_token(std::string_view s)
+{
+    if (s.empty())
+        return false;
+
+    if (s[0] == '-')
+        return s.size() > 1 && s[1] >= '0' && s[1] <= '9';
+
+    return s[0] >= '0' && s[0] <= '9';
+}
+
+static bool is_float_token(std::string_view s)
+{
+    return s.find('.') != std::string_view::npos || s.find('e') != std::string_view::npos;
+}
+
+// like std::stoi and std::stof the longest numeric prefix is taken, false for what
+// from_chars cannot reproduce (hexadecimal, out of range, subnormal floats which
+// strtof reports as ERANGE) so the caller falls back
+static bool parse_int_token(std::string_view s, int& v)
+{
+    if (s.find_first_of("xX") != std::string_view::npos)
+        return false;
+
+    return std::from_chars(s.data(), s.data() + s.size(), v).ec == std::errc();
+}
+
+static bool parse_float_token(std::string_view s, float& v)
+{
+    if (s.find_first_of("xX") != std::string_view::npos)
+        return false;
+
+    if (std::from_chars(s.data(), s.data() + s.size(), v, std::chars_format::general).ec != std::errc())
+        return false;
+
+    return v == 0.f || fabsf(v) >= FLT_MIN;
+}
+
+Parameter Parameter::parse_from_string(std::string_view value)
+{
+    Parameter p;
+    p.type = 0;
+
+    if (value.find('%') != std::string_view::npos)
+    {
+        p.type = 4;
+        p.s = std::string(value);
+        return p;
+    }
+
+    if (value == "None" || value == "()" || value == "[]")
+    {
+        return p;
+    }
+
+    if (value == "True" || value == "False")
+    {
+        p.type = 1;
+        p.b = value == "True";
+        return p;
+    }
+
+    if (!value.empty() && (value[0] == '(' || value[0] == '['))
+    {
+        // list, every comma separates two elements so n commas give n + 1 elements
+        std::string_view lc = value.substr(1, value.size() - 2);
+
+        size_t count = std::count(lc.begin(), lc.end(), ',') + 1;
+
+        size_t begin = 0;
+        for (size_t i = 0; i < count; i++)
+        {
+            size_t end = std::min(lc.find(',', begin), lc.size());
+            std::string_view elem = lc.substr(begin, end - begin);
+            begin = end + 1;
+
+            if (!is_numeric_token(elem))
+            {
+                if (p.as.empty())
+                    p.as.reserve(count);
+                p.type = 7;
+                p.as.emplace_back(elem);
+            }
+            else if (is_float_token(elem))
+            {
+                float f;
+                if (!parse_float_token(elem, f))
+                    return parse_from_string_legacy(std::string(value));
+
+                if (p.af.empty())
+                    p.af.reserve(count);
+                p.type = 6;
+                p.af.push_back(f);
+            }
+            else
+            {
+                int v;
+                if (!parse_int_token(elem, v))
+                    return parse_from_string_legacy(std::string(value));
+
+                if (p.ai.empty())
+                    p.ai.reserve(count);
+                p.type = 5;
+                p.ai.push_back(v);
+            }
+        }
+        return p;
+    }
+
+    if (!is_numeric_token(value))
+    {
+        p.type = 4;
+        p.s = std::string(value);
+        return p;
+    }
+
+    if (is_float_token(value))
+    {
+        p.type = 3;
+        if (!parse_float_token(value, p.f))
+            return parse_from_string_legacy(std::string(value));
+        return p;
+    }
+
+    p.type = 2;
+    if (!parse_int_token(value, p.i))
+        return parse_from_string_legacy(std::string(value));
+    return p;
+}
+
 std::string Parameter::encode_to_string(const Parameter& param)
 {
     if (param.type == 0)
@@ -664,6 +799,13 @@ Graph& Graph::operator=(const Graph& /*rhs*/)
 
 static void load_parameter(Operator* op, const std::string& key, const std::string& value)
 {
+    if (op->type == "pnnx.Expression" && key == "expr")
+    {
+        // a list expression like [int(size(@0,0)),-1] is text, not an array
+        op->params[key] = Parameter(value);
+        return;
+    }
+
     op->params[key] = Parameter::parse_from_string(value);
 }
 
@@ -721,6 +863,11 @@ static void load_shape(Operator* op, const std::string& key, const std::string&
     std::istringstream lcss(lc);
 
     operand->shape.clear();
+    if (lc.empty())
+    {
+        // scalar
+        return;
+    }
     while (!lcss.eof())
     {
         std::string elem;
@@ -746,7 +893,9 @@ static void load_shape(Operator* op, const std::string& key, const std::string&
     }
 }
 
-static void load_attribute(Operator* op, const std::string& key, const std::string& value, StoreZipReader& szr)
+// the attribute data is allocated here and read later with the other attributes, so
+// that compressed entries are decompressed in parallel
+static void load_attribute(Operator* op, const std::string& key, const std::string& value, StoreZipReader& szr, std::vector<std::string>& filenames, std::vector<char*>& datas)
 {
     Attribute& a = op->attrs[key];
 
@@ -796,10 +945,12 @@ static void load_attribute(Operator* op, const std::string& key, const std::stri
     if (filesize != bytesize)
     {
         fprintf(stderr, "file size not match expect %lu but got %lu\n", bytesize, filesize);
+        return;
     }
 
     a.data.resize(bytesize);
-    szr.read_file(filename, (char*)a.data.data());
+    filenames.push_back(filename);
+    datas.push_back((char*)a.data.data());
 }
 
 int Graph::load(const std::string& parampath, const std::string& binpath)
@@ -829,6 +980,8 @@ int Graph::load(const std::string& parampath, const std::string& binpath)
 
     int operator_count = 0;
     int operand_count = 0;
+    std::vector<std::string> attribute_filenames;
+    std::vector<char*> attribute_datas;
     {
         std::string line;
         std::getline(is, line);
@@ -887,7 +1040,7 @@ int Graph::load(const std::string& parampath, const std::string& binpath)
             if (key[0] == '@')
             {
                 // attribute
-                load_attribute(op, key.substr(1), value, szr);
+                load_attribute(op, key.substr(1), value, szr, attribute_filenames, attribute_datas);
             }
             else if (key[0] == '$')
             {
@@ -907,10 +1060,16 @@ int Graph::load(const std::string& parampath, const std::string& binpath)
         }
     }
 
+    if (szr.read_files(attribute_filenames, attribute_datas) != 0)
+    {
+        fprintf(stderr, "read %s failed\n", binpath.c_str());
+        return -1;
+    }
+
     return 0;
 }
 
-int Graph::save(const std::string& parampath, const std::string& binpath)
+int Graph::save(const std::string& parampath, const std::string& binpath, int compression)
 {
     FILE* paramfp = fopen(parampath.c_str(), "wb");
     if (!paramfp)
@@ -926,6 +1085,8 @@ int Graph::save(const std::string& parampath, const std::string& binpath)
         return -1;
     }
 
+    szw.set_compression(compression);
+
     // magic
     fprintf(paramfp, "7767517\n");
 
@@ -972,7 +1133,7 @@ int Graph::save(const std::string& parampath, const std::string& binpath)
             fprintf(paramfp, type_to_string(attr.type));
 
             std::string filename = op->name + "." + it.first;
-            szw.write_file(filename, attr.data.data(), attr.data.size());
+            szw.write_file_deferred(filename, attr.data.data(), attr.data.size(), type_to_elemsize(attr.type));
         }
 
         if (op->inputnames.size() == op->inputs.size())
@@ -1046,6 +1207,13 @@ int Graph::save(const std::string& parampath, const std::string& binpath)
 
     fclose(paramfp);
 
+    // attribute data is written here, after every entry has its offset
+    if (szw.close() != 0)
+    {
+        fprintf(stderr, "write %s failed\n", binpath.c_str());
+        return -1;
+    }
+
     return 0;
 }
 
@@ -2751,6 +2919,998 @@ int Graph::python(const std::string& pypath, const std::string& pnnxbinpath)
     return 0;
 }
 
+// kernels of the generated translation unit, every shape is a template argument so
+// the compiler sees constant trip counts and strides for each call site
+static const char* cpp_kernels = R"CPP(
+template<int N, int C, int H, int W, int OC, int OH, int OW, int KH, int KW, int SH, int SW, int PH, int PW, int DH, int DW, int G>
+static inline void conv2d(const float* in, const float* weight, const float* bias, float* out)
+{
+    constexpr int CG = C / G;
+    constexpr int OCG = OC / G;
+    for (int n = 0; n < N; n++)
+    {
+        for (int p = 0; p < OC; p++)
+        {
+            const int g = p / OCG;
+            const float* w = weight + p * CG * KH * KW;
+            float* o = out + (n * OC + p) * OH * OW;
+
+            const float b = bias ? bias[p] : 0.f;
+            for (int i = 0; i < OH * OW; i++)
+                o[i] = b;
+
+            for (int q = 0; q < CG; q++)
+            {
+                const float* x = in + (n * C + g * CG + q) * H * W;
+                for (int kh = 0; kh < KH; kh++)
+                {
+                    for (int kw = 0; kw < KW; kw++)
+                    {
+                        const float k = w[(q * KH + kh) * KW + kw];
+                        for (int oh = 0; oh < OH; oh++)
+                        {
+                            const int ih = oh * SH - PH + kh * DH;
+                            if (ih < 0 || ih >= H)
+                                continue;
+
+                            for (int ow = 0; ow < OW; ow++)
+                            {
+                                const int iw = ow * SW - PW + kw * DW;
+                                if (iw < 0 || iw >= W)
+                                    continue;
+
+                                o[oh * OW + ow] += k * x[ih * W + iw];
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+template<int M, int K, int N>
+static inline void linear(const float* in, const float* weight, const float* bias, float* out)
+{
+    for (int m = 0; m < M; m++)
+    {
+        const float* x = in + m * K;
+        for (int n = 0; n < N; n++)
+        {
+            const float* w = weight + n * K;
+            float sum = bias ? bias[n] : 0.f;
+            for (int k = 0; k < K; k++)
+                sum += x[k] * w[k];
+
+            out[m * N + n] = sum;
+        }
+    }
+}
+
+template<int N, int C, int H, int W, int OH, int OW, int KH, int KW, int SH, int SW, int PH, int PW, int DH, int DW>
+static inline void max_pool2d(const float* in, float* out)
+{
+    for (int c = 0; c < N * C; c++)
+    {
+        const float* x = in + c * H * W;
+        float* o = out + c * OH * OW;
+        for (int oh = 0; oh < OH; oh++)
+        {
+            for (int ow = 0; ow < OW; ow++)
+            {
+                float v = -INFINITY;
+                for (int kh = 0; kh < KH; kh++)
+                {
+                    const int ih = oh * SH - PH + kh * DH;
+                    if (ih < 0 || ih >= H)
+                        continue;
+
+                    for (int kw = 0; kw < KW; kw++)
+                    {
+                        const int iw = ow * SW - PW + kw * DW;
+                        if (iw < 0 || iw >= W)
+                            continue;
+
+                        v = fmaxf(v, x[ih * W + iw]);
+                    }
+                }
+                o[oh * OW + ow] = v;
+            }
+        }
+    }
+}
+
+template<int N, int C, int H, int W, int OH, int OW, int KH, int KW, int SH, int SW, int PH, int PW, bool COUNT_PAD>
+static inline void avg_pool2d(const float* in, float* out)
+{
+    for (int c = 0; c < N * C; c++)
+    {
+        const float* x = in + c * H * W;
+        float* o = out + c * OH * OW;
+        for (int oh = 0; oh < OH; oh++)
+        {
+            for (int ow = 0; ow < OW; ow++)
+            {
+                float sum = 0.f;
+                int count = 0;
+                for (int kh = 0; kh < KH; kh++)
+                {
+                    const int ih = oh * SH - PH + kh;
+                    if (ih < 0 || ih >= H)
+                        continue;
+
+                    for (int kw = 0; kw < KW; kw++)
+                    {
+                        const int iw = ow * SW - PW + kw;
+                        if (iw < 0 || iw >= W)
+                            continue;
+
+                        sum += x[ih * W + iw];
+                        count++;
+                    }
+                }
+                o[oh * OW + ow] = sum / (COUNT_PAD ? KH * KW : count);
+            }
+        }
+    }
+}
+
+template<int N, int C, int H, int W, int OH, int OW>
+static inline void adaptive_avg_pool2d(const float* in, float* out)
+{
+    for (int c = 0; c < N * C; c++)
+    {
+        const float* x = in + c * H * W;
+        float* o = out + c * OH * OW;
+        for (int oh = 0; oh < OH; oh++)
+        {
+            const int h0 = oh * H / OH;
+            const int h1 = ((oh + 1) * H + OH - 1) / OH;
+            for (int ow = 0; ow < OW; ow++)
+            {
+                const int w0 = ow * W / OW;
+                const int w1 = ((ow + 1) * W + OW - 1) / OW;
+
+                float sum = 0.f;
+                for (int ih = h0; ih < h1; ih++)
+                {
+                    for (int iw = w0; iw < w1; iw++)
+                        sum += x[ih * W + iw];
+                }
+                o[oh * OW + ow] = sum / ((h1 - h0) * (w1 - w0));
+            }
+        }
+    }
+}
+
+// per channel scale and bias, batchnorm folded at generation time
+template<int OUTER, int C, int INNER>
+static inline void channel_affine(const float* in, const float* scale, const float* bias, float* out)
+{
+    for (int n = 0; n < OUTER; n++)
+    {
+        for (int c = 0; c < C; c++)
+        {
+            const float* x = in + (n * C + c) * INNER;
+            float* o = out + (n * C + c) * INNER;
+            for (int i = 0; i < INNER; i++)
+                o[i] = x[i] * scale[c] + bias[c];
+        }
+    }
+}
+
+template<int OUTER, int D, int INNER>
+static inline void softmax(const float* in, float* out)
+{
+    for (int n = 0; n < OUTER; n++)
+    {
+        for (int i = 0; i < INNER; i++)
+        {
+            const float* x = in + n * D * INNER + i;
+            float* o = out + n * D * INNER + i;
+
+            float max = -INFINITY;
+            for (int d = 0; d < D; d++)
+                max = fmaxf(max, x[d * INNER]);
+
+            float sum = 0.f;
+            for (int d = 0; d < D; d++)
+            {
+                o[d * INNER] = expf(x[d * INNER] - max);
+                sum += o[d * INNER];
+            }
+
+            for (int d = 0; d < D; d++)
+                o[d * INNER] /= sum;
+        }
+    }
+}
+)CPP";
+
+static int64_t cpp_numel(const std::vector<int>& shape)
+{
+    int64_t numel = 1;
+    for (int d : shape)
+        numel *= d;
+
+    return numel;
+}
+
+static std::string cpp_float(float v)
+{
+    if (isnan(v))
+        return "NAN";
+
+    if (isinf(v))
+        return v > 0 ? "INFINITY" : "(-INFINITY)";
+
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.9ef", v);
+    return v < 0 ? std::string("(") + buf + ")" : std::string(buf);
+}
+
+static float cpp_param_float(const Operator* op, const char* key, float default_value)
+{
+    if (!op->has_param(key))
+        return default_value;
+
+    const Parameter& p = op->params.at(key);
+    if (p.type == 2)
+        return (float)p.i;
+    if (p.type == 3)
+        return p.f;
+
+    return default_value;
+}
+
+// pair parameters like kernel_size=(3,3), a single int applies to both
+static std::vector<int> cpp_param_pair(const Operator* op, const char* key, int default_value)
+{
+    if (!op->has_param(key))
+        return std::vector<int>(2, default_value);
+
+    const Parameter& p = op->params.at(key);
+    if (p.type == 2)
+        return std::vector<int>(2, p.i);
+    if (p.type == 5 && p.ai.size() == 1)
+        return std::vector<int>(2, p.ai[0]);
+    if (p.type == 5 && p.ai.size() == 2)
+        return p.ai;
+
+    return std::vector<int>(2, default_value);
+}
+
+// operators whose output is the input with another shape, they share the buffer
+static bool cpp_is_view(const std::string& type)
+{
+    return type == "torch.flatten" || type == "nn.Flatten" || type == "Tensor.view" || type == "Tensor.reshape"
+           || type == "torch.reshape" || type == "torch.squeeze" || type == "torch.unsqueeze"
+           || type == "Tensor.contiguous" || type == "nn.Dropout" || type == "F.dropout" || type == "nn.Identity"
+           || type == "torch.clone" || type == "Tensor.clone";
+}
+
+// elementwise operators as a scalar C expression over @0 @1 ..., false when unsupported
+static bool cpp_elementwise_expression(const Operator* op, std::string& expr)
+{
+    const std::string& t = op->type;
+
+    if (t == "nn.ReLU" || t == "F.relu")
+        expr = "fmaxf(@0, 0.f)";
+    else if (t == "nn.ReLU6" || t == "F.relu6")
+        expr = "fminf(fmaxf(@0, 0.f), 6.f)";
+    else if (t == "nn.LeakyReLU" || t == "F.leaky_relu")
+        expr = std::string("(@0 > 0.f ? @0 : @0 * ") + cpp_float(cpp_param_float(op, "negative_slope", 0.01f)) + ")";
+    else if (t == "nn.Sigmoid" || t == "F.sigmoid" || t == "torch.sigmoid")
+        expr = "(1.f / (1.f + expf(-@0)))";
+    else if (t == "nn.Tanh" || t == "F.tanh" || t == "torch.tanh")
+        expr = "tanhf(@0)";
+    else if (t == "nn.SiLU" || t == "F.silu")
+        expr = "(@0 / (1.f + expf(-@0)))";
+    else if (t == "nn.Hardswish" || t == "F.hardswish")
+        expr = "(@0 * fminf(fmaxf(@0 + 3.f, 0.f), 6.f) / 6.f)";
+    else if (t == "nn.Hardsigmoid" || t == "F.hardsigmoid")
+        expr = "(fminf(fmaxf(@0 + 3.f, 0.f), 6.f) / 6.f)";
+    else if (t == "nn.Hardtanh" || t == "F.hardtanh")
+        expr = std::string("fminf(fmaxf(@0, ") + cpp_float(cpp_param_float(op, "min_val", -1.f)) + "), " + cpp_float(cpp_param_float(op, "max_val", 1.f)) + ")";
+    else if (t == "nn.ELU" || t == "F.elu")
+        expr = std::string("(@0 > 0.f ? @0 : ") + cpp_float(cpp_param_float(op, "alpha", 1.f)) + " * (expf(@0) - 1.f))";
+    else if (t == "nn.GELU" || t == "F.gelu")
+    {
+        if (op->has_param("approximate") && op->params.at("approximate").s == "tanh")
+            expr = "(0.5f * @0 * (1.f + tanhf(0.7978845608f * (@0 + 0.044715f * @0 * @0 * @0))))";
+        else
+            expr = "(0.5f * @0 * (1.f + erff(@0 * 0.7071067812f)))";
+    }
+    else if (t == "torch.abs")
+        expr = "fabsf(@0)";
+    else if (t == "torch.exp")
+        expr = "expf(@0)";
+    else if (t == "torch.log")
+        expr = "logf(@0)";
+    else if (t == "torch.sqrt")
+        expr = "sqrtf(@0)";
+    else if (t == "torch.rsqrt")
+        expr = "(1.f / sqrtf(@0))";
+    else if (t == "torch.neg")
+        expr = "(-@0)";
+    else if (t == "torch.square")
+        expr = "(@0 * @0)";
+    else if (t == "torch.clamp")
+    {
+        expr = "@0";
+        if (op->has_param("min") && op->params.at("min").type != 0)
+            expr = std::string("fmaxf(") + expr + ", " + cpp_float(cpp_param_float(op, "min", 0.f)) + ")";
+        if (op->has_param("max") && op->params.at("max").type != 0)
+            expr = std::string("fminf(") + expr + ", " + cpp_float(cpp_param_float(op, "max", 0.f)) + ")";
+    }
+    else if ((t == "torch.add" || t == "torch.sub") && op->inputs.size() == 2)
+    {
+        const float alpha = cpp_param_float(op, "alpha", 1.f);
+        const char* binaryop = t == "torch.add" ? " + " : " - ";
+        expr = std::string("(@0") + binaryop + (alpha == 1.f ? "@1" : cpp_float(alpha) + " * @1") + ")";
+    }
+    else if (t == "torch.mul" && op->inputs.size() == 2)
+        expr = "(@0 * @1)";
+    else if (t == "torch.div" && op->inputs.size() == 2 && (!op->has_param("rounding_mode") || op->params.at("rounding_mode").type == 0))
+        expr = "(@0 / @1)";
+    else if (t == "torch.maximum" && op->inputs.size() == 2)
+        expr = "fmaxf(@0, @1)";
+    else if (t == "torch.minimum" && op->inputs.size() == 2)
+        expr = "fminf(@0, @1)";
+    else if (t == "torch.pow" && op->inputs.size() == 2)
+        expr = "powf(@0, @1)";
+    else if (t == "pnnx.Expression")
+    {
+        // same tokenization as expand_expression, lists, sizes and casts are rejected
+        std::string e = op->params.at("expr").s;
+
+        std::vector<std::string> tokens;
+        {
+            std::string tk;
+            for (size_t i = 0; i < e.size(); i++)
+            {
+                char ch = e[i];
+                if (ch == '[')
+                    return false;
+
+                if (ch == '(' || ch == ')' || ch == ',' || ch == ']')
+                {
+                    if (!tk.empty())
+                    {
+                        tokens.push_back(tk);
+                        tk.clear();
+                    }
+                }
+                else
+                {
+                    tk += ch;
+                }
+            }
+
+            if (!tk.empty())
+                tokens.push_back(tk);
+        }
+
+        std::stack<std::string> exprstack;
+        for (int i = (int)tokens.size() - 1; i >= 0; i--)
+        {
+            const std::string& tk = tokens[i];
+
+            std::string unaryop;
+            if (tk == "abs") unaryop = "fabsf";
+            if (tk == "acos") unaryop = "acosf";
+            if (tk == "asin") unaryop = "asinf";
+            if (tk == "atan") unaryop = "atanf";
+            if (tk == "ceil") unaryop = "ceilf";
+            if (tk == "cos") unaryop = "cosf";
+            if (tk == "cosh") unaryop = "coshf";
+            if (tk == "exp") unaryop = "expf";
+            if (tk == "floor") unaryop = "floorf";
+            if (tk == "log") unaryop = "logf";
+            if (tk == "log10") unaryop = "log10f";
+            if (tk == "neg") unaryop = "-";
+            if (tk == "reciprocal") unaryop = "1.f / ";
+            if (tk == "round") unaryop = "nearbyintf";
+            if (tk == "rsqrt") unaryop = "1.f / sqrtf";
+            if (tk == "sin") unaryop = "sinf";
+            if (tk == "sinh") unaryop = "sinhf";
+            if (tk == "sqrt") unaryop = "sqrtf";
+            if (tk == "tan") unaryop = "tanf";
+            if (tk == "tanh") unaryop = "tanhf";
+            if (tk == "trunc") unaryop = "truncf";
+
+            std::string binaryfunc;
+            if (tk == "atan2") binaryfunc = "atan2f";
+            if (tk == "fmod") binaryfunc = "fmodf";
+            if (tk == "max" || tk == "maximum") binaryfunc = "fmaxf";
+            if (tk == "min" || tk == "minimum") binaryfunc = "fminf";
+            if (tk == "pow") binaryfunc = "powf";
+
+            std::string binaryop;
+            if (tk == "add") binaryop = "+";
+            if (tk == "sub") binaryop = "-";
+            if (tk == "mul") binaryop = "*";
+            if (tk == "div") binaryop = "/";
+
+            if (!unaryop.empty() || tk == "square" || tk == "sign")
+            {
+                if (exprstack.empty())
+                    return false;
+
+                std::string a = exprstack.top();
+                exprstack.pop();
+
+                if (tk == "square")
+                    exprstack.push(std::string("(") + a + " * " + a + ")");
+                else if (tk == "sign")
+                    exprstack.push(std::string("(float)((") + a + " > 0.f) - (" + a + " < 0.f))");
+                else
+                    exprstack.push(std::string("(") + unaryop + "(" + a + "))");
+            }
+            else if (!binaryfunc.empty() || !binaryop.empty() || tk == "floor_divide" || tk == "remainder")
+            {
+                if (exprstack.size() < 2)
+                    return false;
+
+                std::string a = exprstack.top();
+                exprstack.pop();
+                std::string b = exprstack.top();
+                exprstack.pop();
+
+                if (tk == "floor_divide")
+                    exprstack.push(std::string("floorf(") + a + " / " + b + ")");
+                else if (tk == "remainder")
+                    exprstack.push(std::string("(") + a + " - floorf(" + a + " / " + b + ") * " + b + ")");
+                else if (!binaryfunc.empty())
+                    exprstack.push(binaryfunc + "(" + a + ", " + b + ")");
+                else
+                    exprstack.push(std::string("(") + a + " " + binaryop + " " + b + ")");
+            }
+            else if (tk[0] == '@')
+            {
+                exprstack.push(tk);
+            }
+            else if ((tk[0] >= '0' && tk[0] <= '9') || (tk[0] == '-' && tk.size() > 1 && tk[1] >= '0' && tk[1] <= '9'))
+            {
+                if (tk[tk.size() - 1] == 'j')
+                    return false;
+
+                exprstack.push(cpp_float(std::stof(tk)));
+            }
+            else
+            {
+                // size, int, torch casts and anything else not elementwise on floats
+                return false;
+            }
+        }
+
+        if (exprstack.size() != 1)
+            return false;
+
+        expr = exprstack.top();
+    }
+    else
+    {
+        return false;
+    }
+
+    return true;
+}
+
+int Graph::cpp(const std::string& cpppath, const std::string& weightpath)
+{
+    // every operand must be float32 with a static shape
+    for (const Operand* r : operands)
+    {
+        bool is_static = r->type == 1;
+        for (int d : r->shape)
+        {
+            if (d <= 0)
+                is_static = false;
+        }
+
+        if (!is_static)
+        {
+            fprintf(stderr, "cpp requires static float32 shape for operand %s\n", r->name.c_str());
+            return -1;
+        }
+    }
+
+    // weights, each tensor aligned to 64 bytes in one flat float32 file
+    std::vector<float> weights;
+    std::map<std::string, size_t> weight_offsets;
+    auto add_weight = [&](const std::string& key, const std::vector<float>& data) {
+        weights.resize((weights.size() + 15) / 16 * 16);
+        weight_offsets[key] = weights.size();
+        weights.insert(weights.end(), data.begin(), data.end());
+    };
+
+    // buffer sharing of views and buffer lifetime in operator order
+    std::map<const Operand*, const Operand*> roots;
+    std::map<const Operand*, int> last_use;
+    for (int i = 0; i < (int)ops.size(); i++)
+    {
+        const Operator* op = ops[i];
+
+        for (const Operand* r : op->inputs)
+        {
+            last_use[roots[r]] = i;
+        }
+
+        for (const Operand* r : op->outputs)
+        {
+            roots[r] = cpp_is_view(op->type) ? roots[op->inputs[0]] : r;
+            last_use[roots[r]] = std::max(last_use[roots[r]], i);
+        }
+    }
+
+    for (const Operator* op : ops)
+    {
+        const std::string& t = op->type;
+
+        if (t == "pnnx.Input" || t == "pnnx.Output" || cpp_is_view(t))
+            continue;
+
+        if (t == "pnnx.Attribute" || t == "nn.Conv2d" || t == "nn.Linear" || t == "nn.BatchNorm1d" || t == "nn.BatchNorm2d")
+        {
+            for (const auto& it : op->attrs)
+            {
+                if (it.second.data.empty())
+                {
+                    fprintf(stderr, "cpp requires the weight data of %s.%s\n", op->name.c_str(), it.first.c_str());
+                    return -1;
+                }
+            }
+        }
+
+        if (t == "pnnx.Attribute")
+        {
+            add_weight(op->outputs[0]->name, op->attrs.begin()->second.get_float32_data());
+        }
+        else if (t == "nn.Conv2d")
+        {
+            if (op->has_param("padding_mode") && op->params.at("padding_mode").s != "zeros")
+            {
+                fprintf(stderr, "cpp supports zeros padding only for %s\n", op->name.c_str());
+                return -1;
+            }
+
+            add_weight(op->name + ".weight", op->attrs.at("weight").get_float32_data());
+            if (op->has_attr("bias"))
+                add_weight(op->name + ".bias", op->attrs.at("bias").get_float32_data());
+        }
+        else if (t == "nn.Linear")
+        {
+            add_weight(op->name + ".weight", op->attrs.at("weight").get_float32_data());
+            if (op->has_attr("bias"))
+                add_weight(op->name + ".bias", op->attrs.at("bias").get_float32_data());
+        }
+        else if (t == "nn.BatchNorm1d" || t == "nn.BatchNorm2d")
+        {
+            // y = x * scale + bias
+            const int channels = op->params.at("num_features").i;
+            const float eps = cpp_param_float(op, "eps", 1e-5f);
+            const std::vector<float> mean = op->attrs.at("running_mean").get_float32_data();
+            const std::vector<float> var = op->attrs.at("running_var").get_float32_data();
+
+            std::vector<float> scale(channels);
+            std::vector<float> bias(channels);
+            for (int c = 0; c < channels; c++)
+            {
+                const float w = op->has_attr("weight") ? op->attrs.at("weight").get_float32_data()[c] : 1.f;
+                const float b = op->has_attr("bias") ? op->attrs.at("bias").get_float32_data()[c] : 0.f;
+                scale[c] = w / sqrtf(var[c] + eps);
+                bias[c] = b - mean[c] * scale[c];
+            }
+
+            add_weight(op->name + ".scale", scale);
+            add_weight(op->name + ".bias", bias);
+        }
+        else if (t == "nn.MaxPool2d" || t == "F.max_pool2d" || t == "nn.AvgPool2d" || t == "F.avg_pool2d"
+                 || t == "nn.AdaptiveAvgPool2d" || t == "F.adaptive_avg_pool2d" || t == "nn.Softmax"
+                 || t == "F.softmax" || t == "torch.cat")
+        {
+            if ((t == "nn.AvgPool2d" || t == "F.avg_pool2d") && op->has_param("ceil_mode") && op->params.at("ceil_mode").b)
+            {
+                fprintf(stderr, "cpp does not support ceil_mode avg_pool2d %s\n", op->name.c_str());
+                return -1;
+            }
+        }
+        else
+        {
+            std::string expr;
+            if (!cpp_elementwise_expression(op, expr))
+            {
+                fprintf(stderr, "cpp does not support %s %s\n", t.c_str(), op->name.c_str());
+                return -1;
+            }
+        }
+    }
+
+    // first fit arena offsets, outputs are placed before the dead inputs are released
+    // so no kernel writes over what it reads
+    std::map<const Operand*, size_t> arena_offsets;
+    size_t arena_size = 0;
+    {
+        std::map<size_t, size_t> live; // offset to size
+        for (int i = 0; i < (int)ops.size(); i++)
+        {
+            const Operator* op = ops[i];
+            if (op->type != "pnnx.Attribute" && !cpp_is_view(op->type))
+            {
+                for (const Operand* r : op->outputs)
+                {
+                    const size_t size = ((size_t)cpp_numel(r->shape) + 15) / 16 * 16;
+
+                    size_t offset = 0;
+                    for (const auto& it : live)
+                    {
+                        if (it.first >= offset + size)
+                            break;
+
+                        offset = std::max(offset, it.first + it.second);
+                    }
+
+                    live[offset] = size;
+                    arena_offsets[r] = offset;
+                    arena_size = std::max(arena_size, offset + size);
+                }
+            }
+
+            std::vector<const Operand*> used(op->inputs.begin(), op->inputs.end());
+            used.insert(used.end(), op->outputs.begin(), op->outputs.end());
+            for (const Operand* r : used)
+            {
+                const Operand* root = roots[r];
+                if (last_use[root] == i && arena_offsets.find(root) != arena_offsets.end())
+                    live.erase(arena_offsets[root]);
+            }
+        }
+    }
+
+    FILE* wfp = fopen(weightpath.c_str(), "wb");
+    if (!wfp)
+    {
+        fprintf(stderr, "fopen %s failed\n", weightpath.c_str());
+        return -1;
+    }
+
+    if (fwrite(weights.data(), sizeof(float), weights.size(), wfp) != weights.size())
+    {
+        fprintf(stderr, "write %s failed\n", weightpath.c_str());
+        fclose(wfp);
+        return -1;
+    }
+
+    fclose(wfp);
+
+    FILE* cppfp = fopen(cpppath.c_str(), "wb");
+    if (!cppfp)
+    {
+        fprintf(stderr, "fopen %s failed\n", cpppath.c_str());
+        return -1;
+    }
+
+    fprintf(cppfp, "// generated by pnnx Graph::cpp, shapes are fixed at generation time\n");
+    fprintf(cppfp, "#include <math.h>\n");
+    fprintf(cppfp, "#include <stdio.h>\n");
+    fprintf(cppfp, "#include <string.h>\n");
+    fprintf(cppfp, "#include <vector>\n");
+    fprintf(cppfp, "\n");
+    fprintf(cppfp, "namespace pnnx_model {\n");
+    fprintf(cppfp, "%s\n", cpp_kernels);
+
+    std::vector<const Operand*> input_operands;
+    std::vector<const Operand*> output_operands;
+    for (const Operator* op : ops)
+    {
+        if (op->type == "pnnx.Input")
+            input_operands.push_back(op->outputs[0]);
+        if (op->type == "pnnx.Output")
+            output_operands.push_back(op->inputs[0]);
+    }
+
+    fprintf(cppfp, "class Model\n");
+    fprintf(cppfp, "{\n");
+    fprintf(cppfp, "public:\n");
+    fprintf(cppfp, "    static constexpr size_t weight_size = %lu;\n", (unsigned long)weights.size());
+    fprintf(cppfp, "    static constexpr size_t arena_size = %lu;\n", (unsigned long)arena_size);
+    for (size_t i = 0; i < input_operands.size(); i++)
+    {
+        fprintf(cppfp, "    static constexpr size_t in%d_size = %lld; // (", (int)i, (long long)cpp_numel(input_operands[i]->shape));
+        for (size_t j = 0; j < input_operands[i]->shape.size(); j++)
+            fprintf(cppfp, j ? ",%d" : "%d", input_operands[i]->shape[j]);
+        fprintf(cppfp, ")\n");
+    }
+    for (size_t i = 0; i < output_operands.size(); i++)
+    {
+        fprintf(cppfp, "    static constexpr size_t out%d_size = %lld; // (", (int)i, (long long)cpp_numel(output_operands[i]->shape));
+        for (size_t j = 0; j < output_operands[i]->shape.size(); j++)
+            fprintf(cppfp, j ? ",%d" : "%d", output_operands[i]->shape[j]);
+        fprintf(cppfp, ")\n");
+    }
+    fprintf(cppfp, "\n");
+    fprintf(cppfp, "    Model() : weights(weight_size), arena(arena_size) {}\n");
+    fprintf(cppfp, "\n");
+    fprintf(cppfp, "    int load(const char* weightpath)\n");
+    fprintf(cppfp, "    {\n");
+    fprintf(cppfp, "        FILE* fp = fopen(weightpath, \"rb\");\n");
+    fprintf(cppfp, "        if (!fp)\n");
+    fprintf(cppfp, "            return -1;\n");
+    fprintf(cppfp, "        size_t nread = fread(weights.data(), sizeof(float), weight_size, fp);\n");
+    fprintf(cppfp, "        fclose(fp);\n");
+    fprintf(cppfp, "        return nread == weight_size ? 0 : -1;\n");
+    fprintf(cppfp, "    }\n");
+    fprintf(cppfp, "\n");
+
+    std::string arguments;
+    for (size_t i = 0; i < input_operands.size(); i++)
+        arguments += std::string(arguments.empty() ? "" : ", ") + "const float* in" + std::to_string(i);
+    for (size_t i = 0; i < output_operands.size(); i++)
+        arguments += std::string(arguments.empty() ? "" : ", ") + "float* out" + std::to_string(i);
+
+    fprintf(cppfp, "    void forward(%s)\n", arguments.c_str());
+    fprintf(cppfp, "    {\n");
+    fprintf(cppfp, "        float* w = weights.data();\n");
+    fprintf(cppfp, "        float* a = arena.data();\n");
+
+    int input_index = 0;
+    int output_index = 0;
+    for (const Operator* op : ops)
+    {
+        const std::string& t = op->type;
+
+        fprintf(cppfp, "\n");
+        fprintf(cppfp, "        // %s %s\n", t.c_str(), op->name.c_str());
+
+        if (t == "pnnx.Output")
+        {
+            const Operand* in = op->inputs[0];
+            fprintf(cppfp, "        memcpy(out%d, v_%s, %lld * sizeof(float));\n", output_index++, sanitize_identifier(in->name).c_str(), (long long)cpp_numel(in->shape));
+            continue;
+        }
+
+        for (const Operand* r : op->outputs)
+        {
+            std::string id = sanitize_identifier(r->name);
+            if (t == "pnnx.Attribute")
+                fprintf(cppfp, "        float* v_%s = w + %lu;\n", id.c_str(), (unsigned long)weight_offsets.at(r->name));
+            else if (cpp_is_view(t))
+                fprintf(cppfp, "        float* v_%s = v_%s;\n", id.c_str(), sanitize_identifier(op->inputs[0]->name).c_str());
+            else
+                fprintf(cppfp, "        float* v_%s = a + %lu;\n", id.c_str(), (unsigned long)arena_offsets.at(r));
+        }
+
+        if (t == "pnnx.Attribute" || cpp_is_view(t))
+            continue;
+
+        const std::string in = op->inputs.empty() ? std::string() : std::string("v_") + sanitize_identifier(op->inputs[0]->name);
+        const std::string out = std::string("v_") + sanitize_identifier(op->outputs[0]->name);
+        const std::vector<int> in_shape = op->inputs.empty() ? std::vector<int>() : op->inputs[0]->shape;
+        const std::vector<int>& out_shape = op->outputs[0]->shape;
+
+        if (t == "pnnx.Input")
+        {
+            fprintf(cppfp, "        memcpy(%s, in%d, %lld * sizeof(float));\n", out.c_str(), input_index++, (long long)cpp_numel(out_shape));
+        }
+        else if (t == "nn.Conv2d")
+        {
+            const int rank = (int)in_shape.size();
+            const int c = in_shape[rank - 3];
+            const int h = in_shape[rank - 2];
+            const int w = in_shape[rank - 1];
+            const int n = (int)(cpp_numel(in_shape) / ((int64_t)c * h * w));
+            const int oc = out_shape[rank - 3];
+            const int oh = out_shape[rank - 2];
+            const int ow = out_shape[rank - 1];
+
+            const std::vector<int> kernel_size = cpp_param_pair(op, "kernel_size", 1);
+            const std::vector<int> stride = cpp_param_pair(op, "stride", 1);
+            const std::vector<int> dilation = cpp_param_pair(op, "dilation", 1);
+            std::vector<int> padding = cpp_param_pair(op, "padding", 0);
+            if (op->has_param("padding") && op->params.at("padding").type == 4 && op->params.at("padding").s == "same")
+            {
+                padding[0] = (kernel_size[0] - 1) * dilation[0] / 2;
+                padding[1] = (kernel_size[1] - 1) * dilation[1] / 2;
+            }
+            const int groups = op->has_param("groups") ? op->params.at("groups").i : 1;
+
+            const std::string bias = op->has_attr("bias") ? std::string("w + ") + std::to_string(weight_offsets.at(op->name + ".bias")) : std::string("nullptr");
+            fprintf(cppfp, "        conv2d<%d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d>(%s, w + %lu, %s, %s);\n",
+                    n, c, h, w, oc, oh, ow, kernel_size[0], kernel_size[1], stride[0], stride[1], padding[0], padding[1], dilation[0], dilation[1], groups,
+                    in.c_str(), (unsigned long)weight_offsets.at(op->name + ".weight"), bias.c_str(), out.c_str());
+        }
+        else if (t == "nn.Linear")
+        {
+            const int k = op->params.at("in_features").i;
+            const int nout = op->params.at("out_features").i;
+            const int m = (int)(cpp_numel(in_shape) / k);
+
+            const std::string bias = op->has_attr("bias") ? std::string("w + ") + std::to_string(weight_offsets.at(op->name + ".bias")) : std::string("nullptr");
+            fprintf(cppfp, "        linear<%d, %d, %d>(%s, w + %lu, %s, %s);\n", m, k, nout, in.c_str(), (unsigned long)weight_offsets.at(op->name + ".weight"), bias.c_str(), out.c_str());
+        }
+        else if (t == "nn.BatchNorm1d" || t == "nn.BatchNorm2d")
+        {
+            const int c = op->params.at("num_features").i;
+            const int outer = in_shape.size() > 1 ? in_shape[0] : 1;
+            const int inner = (int)(cpp_numel(in_shape) / ((int64_t)outer * c));
+            fprintf(cppfp, "        channel_affine<%d, %d, %d>(%s, w + %lu, w + %lu, %s);\n", outer, c, inner, in.c_str(),
+                    (unsigned long)weight_offsets.at(op->name + ".scale"), (unsigned long)weight_offsets.at(op->name + ".bias"), out.c_str());
+        }
+        else if (t == "nn.MaxPool2d" || t == "F.max_pool2d" || t == "nn.AvgPool2d" || t == "F.avg_pool2d")
+        {
+            const int rank = (int)in_shape.size();
+            const int c = in_shape[rank - 3];
+            const int h = in_shape[rank - 2];
+            const int w = in_shape[rank - 1];
+            const int n = (int)(cpp_numel(in_shape) / ((int64_t)c * h * w));
+            const int oh = out_shape[rank - 2];
+            const int ow = out_shape[rank - 1];
+
+            const std::vector<int> kernel_size = cpp_param_pair(op, "kernel_size", 1);
+            // stride defaults to the kernel size
+            std::vector<int> stride = cpp_param_pair(op, "stride", 0);
+            if (stride[0] == 0)
+                stride = kernel_size;
+            const std::vector<int> padding = cpp_param_pair(op, "padding", 0);
+
+            if (t == "nn.MaxPool2d" || t == "F.max_pool2d")
+            {
+                const std::vector<int> dilation = cpp_param_pair(op, "dilation", 1);
+                fprintf(cppfp, "        max_pool2d<%d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d>(%s, %s);\n",
+                        n, c, h, w, oh, ow, kernel_size[0], kernel_size[1], stride[0], stride[1], padding[0], padding[1], dilation[0], dilation[1], in.c_str(), out.c_str());
+            }
+            else
+            {
+                const bool count_include_pad = !op->has_param("count_include_pad") || op->params.at("count_include_pad").b;
+                fprintf(cppfp, "        avg_pool2d<%d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %d, %s>(%s, %s);\n",
+                        n, c, h, w, oh, ow, kernel_size[0], kernel_size[1], stride[0], stride[1], padding[0], padding[1], count_include_pad ? "true" : "false", in.c_str(), out.c_str());
+            }
+        }
+        else if (t == "nn.AdaptiveAvgPool2d" || t == "F.adaptive_avg_pool2d")
+        {
+            const int rank = (int)in_shape.size();
+            const int c = in_shape[rank - 3];
+            const int h = in_shape[rank - 2];
+            const int w = in_shape[rank - 1];
+            const int n = (int)(cpp_numel(in_shape) / ((int64_t)c * h * w));
+            fprintf(cppfp, "        adaptive_avg_pool2d<%d, %d, %d, %d, %d, %d>(%s, %s);\n", n, c, h, w, out_shape[rank - 2], out_shape[rank - 1], in.c_str(), out.c_str());
+        }
+        else if (t == "nn.Softmax" || t == "F.softmax")
+        {
+            const int rank = (int)in_shape.size();
+            int dim = op->params.at("dim").i;
+            if (dim < 0)
+                dim += rank;
+
+            int64_t outer = 1;
+            int64_t inner = 1;
+            for (int j = 0; j < dim; j++)
+                outer *= in_shape[j];
+            for (int j = dim + 1; j < rank; j++)
+                inner *= in_shape[j];
+
+            fprintf(cppfp, "        softmax<%lld, %d, %lld>(%s, %s);\n", (long long)outer, in_shape[dim], (long long)inner, in.c_str(), out.c_str());
+        }
+        else if (t == "torch.cat")
+        {
+            const int rank = (int)out_shape.size();
+            int dim = op->params.at("dim").i;
+            if (dim < 0)
+                dim += rank;
+
+            int64_t outer = 1;
+            int64_t inner = 1;
+            for (int j = 0; j < dim; j++)
+                outer *= out_shape[j];
+            for (int j = dim + 1; j < rank; j++)
+                inner *= out_shape[j];
+
+            const int64_t out_stride = out_shape[dim] * inner;
+            fprintf(cppfp, "        for (int i = 0; i < %lld; i++)\n", (long long)outer);
+            fprintf(cppfp, "        {\n");
+            int64_t offset = 0;
+            for (const Operand* r : op->inputs)
+            {
+                const int64_t size = r->shape[dim] * inner;
+                fprintf(cppfp, "            memcpy(%s + i * %lld + %lld, v_%s + i * %lld, %lld * sizeof(float));\n", out.c_str(), (long long)out_stride, (long long)offset,
+                        sanitize_identifier(r->name).c_str(), (long long)size, (long long)size);
+                offset += size;
+            }
+            fprintf(cppfp, "        }\n");
+        }
+        else
+        {
+            // elementwise with broadcasting, the strides of broadcast dims are zero
+            std::string expr;
+            cpp_elementwise_expression(op, expr);
+
+            const int rank = (int)out_shape.size();
+            std::vector<std::vector<int64_t> > strides(op->inputs.size(), std::vector<int64_t>(rank, 0));
+            bool flat = true;
+            for (size_t j = 0; j < op->inputs.size(); j++)
+            {
+                const std::vector<int>& shape = op->inputs[j]->shape;
+                const int offset = rank - (int)shape.size();
+
+                int64_t stride = 1;
+                for (int k = rank - 1; k >= 0; k--)
+                {
+                    const int d = k - offset < 0 ? 1 : shape[k - offset];
+                    strides[j][k] = d == 1 ? 0 : stride;
+                    stride *= d;
+                }
+
+                if (cpp_numel(shape) != 1 && shape != out_shape && cpp_numel(shape) != cpp_numel(out_shape))
+                    flat = false;
+            }
+
+            std::vector<std::string> indexes(op->inputs.size());
+            if (flat)
+            {
+                fprintf(cppfp, "        for (int i = 0; i < %lld; i++)\n", (long long)cpp_numel(out_shape));
+                for (size_t j = 0; j < op->inputs.size(); j++)
+                    indexes[j] = cpp_numel(op->inputs[j]->shape) == 1 ? "0" : "i";
+            }
+            else
+            {
+                fprintf(cppfp, "        for (int i = 0, d0 = 0; d0 < %d; d0++)\n", out_shape[0]);
+                for (int k = 1; k < rank; k++)
+                    fprintf(cppfp, "        for (int d%d = 0; d%d < %d; d%d++)\n", k, k, out_shape[k], k);
+
+                for (size_t j = 0; j < op->inputs.size(); j++)
+                {
+                    std::string index;
+                    for (int k = 0; k < rank; k++)
+                    {
+                        if (strides[j][k] == 0)
+                            continue;
+
+                        if (!index.empty())
+                            index += " + ";
+                        index += std::string("d") + std::to_string(k) + " * " + std::to_string(strides[j][k]);
+                    }
+                    indexes[j] = index.empty() ? "0" : index;
+                }
+            }
+
+            // substitute @n with the input elements
+            std::string body;
+            for (size_t j = 0; j < expr.size(); j++)
+            {
+                if (expr[j] != '@')
+                {
+                    body += expr[j];
+                    continue;
+                }
+
+                size_t end = j + 1;
+                while (end < expr.size() && expr[end] >= '0' && expr[end] <= '9')
+                    end++;
+
+                const int index = std::stoi(expr.substr(j + 1, end - j - 1));
+                body += std::string("v_") + sanitize_identifier(op->inputs[index]->name) + "[" + indexes[index] + "]";
+                j = end - 1;
+            }
+
+            fprintf(cppfp, flat ? "            %s[i] = %s;\n" : "            %s[i++] = %s;\n", out.c_str(), body.c_str());
+        }
+    }
+
+    fprintf(cppfp, "    }\n");
+    fprintf(cppfp, "\n");
+    fprintf(cppfp, "private:\n");
+    fprintf(cppfp, "    std::vector<float> weights;\n");
+    fprintf(cppfp, "    std::vector<float> arena;\n");
+    fprintf(cppfp, "};\n");
+    fprintf(cppfp, "\n");
+    fprintf(cppfp, "} // namespace pnnx_model\n");
+
+    fclose(cppfp);
+
+    return 0;
+}
+
 int Graph::parse(const std::string& param)
 {
     std::istringstream is(param);
@@ -2829,7 +3989,7 @@ int Graph::parse(const std::string& param)
             if (key[0] == '@')
             {
                 // attribute
-                //                 load_attribute(op, key.substr(1), value, szr);
+                //                 load_attribute(op, key.substr(1), value, szr, attribute_filenames, attribute_datas);
                 op->attrs[key.substr(1)] = Attribute();
 
                 Attribute& attr = op->attrs[key.substr(1)];
@@ -22,6 +22,7 @@
 #include <map>
 #include <set>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #if BUILD_TORCH2PNNX
@@ -198,16 +199,19 @@ public:
     Parameter(const onnx2pnnx::OnnxAttributeProxy& attr);
 #endif // BUILD_ONNX2PNNX
 
-    static Parameter parse_from_string(const std::string& value);
+    // tokens are parsed in place with std::from_chars, anything from_chars does not
+    // accept goes through parse_from_string_legacy so both always agree
+    static Parameter parse_from_string(std::string_view value);
+    static Parameter parse_from_string_legacy(const std::string& value);
     static std::string encode_to_string(const Parameter& param);
 
     // 0=null 1=b 2=i 3=f 4=s 5=ai 6=af 7=as 8=others 10=c 11=ac
     int type;
 
     // value
-    bool b;
-    int i;
-    float f;
+    bool b = false;
+    int i = 0;
+    float f = 0.f;
     std::complex<float> c;
     std::vector<int> ai;
     std::vector<float> af;
@@ -315,10 +319,15 @@ public:
     ~Graph();
 
     int load(const std::string& parampath, const std::string& binpath);
-    int save(const std::string& parampath, const std::string& binpath);
+    // compression is one of the StoreZip methods, attributes are stored uncompressed by default
+    int save(const std::string& parampath, const std::string& binpath, int compression = 0);
 
     int python(const std::string& pypath, const std::string& binpath);
 
+    // standalone C++ source of a static shape float32 graph, shapes and kernel choices
+    // become template arguments and the weights are written to one flat float32 file
+    int cpp(const std::string& cpppath, const std::string& weightpath);
+
     int parse(const std::string& param);
 
     Operator* new_operator(const std::string& type, const std::string& name);
@@ -14,10 +14,17 @@
 
 #include "runtime/pnnx/store_zip.hpp"
 
+#include <fcntl.h>
 #include <stdio.h>
 #include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <zlib.h>
+#include <algorithm>
+#include <atomic>
 #include <map>
 #include <string>
+#include <thread>
 #include <vector>
 
 namespace pnnx {
@@ -96,42 +103,314 @@ PACK(struct end_of_central_directory_record {
     uint16_t comment_length;
 });
 
-static uint32_t CRC32_TABLE[256];
-
-static void CRC32_TABLE_INIT()
+struct crc32_tables
 {
-    for (int i = 0; i < 256; i++)
+    uint32_t t[16][256];
+
+    crc32_tables()
     {
-        uint32_t c = i;
-        for (int j = 0; j < 8; j++)
+        for (int i = 0; i < 256; i++)
         {
-            if (c & 1)
-                c = (c >> 1) ^ 0xedb88320;
-            else
-                c >>= 1;
+            uint32_t c = i;
+            for (int j = 0; j < 8; j++)
+            {
+                if (c & 1)
+                    c = (c >> 1) ^ 0xedb88320;
+                else
+                    c >>= 1;
+            }
+            t[0][i] = c;
+        }
+
+        // t[k][i] is the crc of byte i followed by k zero bytes
+        for (int k = 1; k < 16; k++)
+        {
+            for (int i = 0; i < 256; i++)
+            {
+                t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xff];
+            }
         }
-        CRC32_TABLE[i] = c;
     }
+};
+
+static const crc32_tables& CRC32_TABLES()
+{
+    static const crc32_tables tables;
+    return tables;
 }
 
-static uint32_t CRC32(uint32_t x, unsigned char ch)
+static inline uint32_t load_u32(const unsigned char* p)
 {
-    return (x >> 8) ^ CRC32_TABLE[(x ^ ch) & 0xff];
+    // zip is little endian and so are the structs above
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
 }
 
-static uint32_t CRC32_buffer(const unsigned char* data, uint64_t len)
+uint32_t crc32(const void* data, uint64_t size, uint32_t crc)
 {
-    uint32_t x = 0xffffffff;
+    const uint32_t(*t)[256] = CRC32_TABLES().t;
+    const unsigned char* p = (const unsigned char*)data;
 
-    for (uint64_t i = 0; i < len; i++)
-        x = CRC32(x, data[i]);
+    uint32_t x = crc ^ 0xffffffff;
+
+    while (size >= 16)
+    {
+        uint32_t a = load_u32(p) ^ x;
+        uint32_t b = load_u32(p + 4);
+        uint32_t c = load_u32(p + 8);
+        uint32_t d = load_u32(p + 12);
+
+        x = t[15][a & 0xff] ^ t[14][(a >> 8) & 0xff] ^ t[13][(a >> 16) & 0xff] ^ t[12][a >> 24]
+            ^ t[11][b & 0xff] ^ t[10][(b >> 8) & 0xff] ^ t[9][(b >> 16) & 0xff] ^ t[8][b >> 24]
+            ^ t[7][c & 0xff] ^ t[6][(c >> 8) & 0xff] ^ t[5][(c >> 16) & 0xff] ^ t[4][c >> 24]
+            ^ t[3][d & 0xff] ^ t[2][(d >> 8) & 0xff] ^ t[1][(d >> 16) & 0xff] ^ t[0][d >> 24];
+
+        p += 16;
+        size -= 16;
+    }
+
+    while (size--)
+    {
+        x = (x >> 8) ^ t[0][(x ^ *p++) & 0xff];
+    }
 
     return x ^ 0xffffffff;
 }
 
+static uint32_t gf2_matrix_times(const uint32_t* mat, uint32_t vec)
+{
+    uint32_t sum = 0;
+    while (vec)
+    {
+        if (vec & 1)
+            sum ^= *mat;
+        vec >>= 1;
+        mat++;
+    }
+    return sum;
+}
+
+static void gf2_matrix_square(uint32_t* square, const uint32_t* mat)
+{
+    for (int n = 0; n < 32; n++)
+    {
+        square[n] = gf2_matrix_times(mat, mat[n]);
+    }
+}
+
+uint32_t crc32_combine(uint32_t crc1, uint32_t crc2, uint64_t size2)
+{
+    // same as zlib, apply size2 zero bytes to crc1 through repeated squaring of the
+    // one zero bit operator
+    if (size2 == 0)
+        return crc1;
+
+    uint32_t even[32];
+    uint32_t odd[32];
+
+    odd[0] = 0xedb88320;
+    uint32_t row = 1;
+    for (int n = 1; n < 32; n++)
+    {
+        odd[n] = row;
+        row <<= 1;
+    }
+
+    // two and four zero bits
+    gf2_matrix_square(even, odd);
+    gf2_matrix_square(odd, even);
+
+    do
+    {
+        gf2_matrix_square(even, odd);
+        if (size2 & 1)
+            crc1 = gf2_matrix_times(even, crc1);
+        size2 >>= 1;
+
+        if (size2 == 0)
+            break;
+
+        gf2_matrix_square(odd, even);
+        if (size2 & 1)
+            crc1 = gf2_matrix_times(odd, crc1);
+        size2 >>= 1;
+    } while (size2 != 0);
+
+    return crc1 ^ crc2;
+}
+
+// entries are split into chunks of this size for parallel crc and writes
+static const uint64_t PARALLEL_CHUNK_SIZE = 4 * 1024 * 1024;
+
+static int resolve_num_threads(int num_threads)
+{
+    if (num_threads > 0)
+        return num_threads;
+
+    int n = (int)std::thread::hardware_concurrency();
+    return n > 0 ? n : 1;
+}
+
+// run f(i) for i in [0, count) on up to num_threads threads
+template<typename F>
+static void parallel_for(size_t count, int num_threads, const F& f)
+{
+    num_threads = (int)std::min<size_t>(resolve_num_threads(num_threads), count);
+
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        for (size_t i = next++; i < count; i = next++)
+        {
+            f(i);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < num_threads; i++)
+    {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& t : threads)
+    {
+        t.join();
+    }
+}
+
+uint32_t crc32_parallel(const void* data, uint64_t size, int num_threads)
+{
+    const unsigned char* p = (const unsigned char*)data;
+
+    uint64_t chunk_count = (size + PARALLEL_CHUNK_SIZE - 1) / PARALLEL_CHUNK_SIZE;
+    if (chunk_count <= 1 || resolve_num_threads(num_threads) <= 1)
+        return crc32(p, size);
+
+    std::vector<uint32_t> crcs(chunk_count);
+    parallel_for(chunk_count, num_threads, [&](size_t i) {
+        uint64_t begin = i * PARALLEL_CHUNK_SIZE;
+        crcs[i] = crc32(p + begin, std::min(PARALLEL_CHUNK_SIZE, size - begin));
+    });
+
+    uint32_t crc = crcs[0];
+    for (uint64_t i = 1; i < chunk_count; i++)
+    {
+        uint64_t begin = i * PARALLEL_CHUNK_SIZE;
+        crc = crc32_combine(crc, crcs[i], std::min(PARALLEL_CHUNK_SIZE, size - begin));
+    }
+    return crc;
+}
+
+static bool is_shuffle_compression(int compression)
+{
+    return (compression & 0xff00) == STOREZIP_SHUFFLE_DEFLATE;
+}
+
+// regroup byte k of every element into plane k, trailing bytes that do not form a
+// whole element are kept as is
+static void byte_shuffle(const char* src, char* dst, uint64_t size, int elemsize)
+{
+    uint64_t count = size / elemsize;
+    for (uint64_t i = 0; i < count; i++)
+    {
+        for (int k = 0; k < elemsize; k++)
+        {
+            dst[k * count + i] = src[i * elemsize + k];
+        }
+    }
+    memcpy(dst + count * elemsize, src + count * elemsize, size - count * elemsize);
+}
+
+static void byte_unshuffle(const char* src, char* dst, uint64_t size, int elemsize)
+{
+    uint64_t count = size / elemsize;
+    for (uint64_t i = 0; i < count; i++)
+    {
+        for (int k = 0; k < elemsize; k++)
+        {
+            dst[i * elemsize + k] = src[k * count + i];
+        }
+    }
+    memcpy(dst + count * elemsize, src + count * elemsize, size - count * elemsize);
+}
+
+// raw deflate of one chunk. every chunk is an independent stream ending on a byte
+// boundary with a sync flush, only the last one finishes the stream, so the chunks
+// concatenate into a single valid deflate stream
+static int deflate_chunk(const char* data, uint64_t size, int level, bool last, std::vector<char>& out)
+{
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    if (deflateInit2(&zs, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        return -1;
+
+    out.resize(deflateBound(&zs, size) + 16);
+
+    zs.next_in = (Bytef*)data;
+    zs.avail_in = (uInt)size;
+    zs.next_out = (Bytef*)out.data();
+    zs.avail_out = (uInt)out.size();
+
+    int ret = deflate(&zs, last ? Z_FINISH : Z_SYNC_FLUSH);
+    bool ok = last ? ret == Z_STREAM_END : (ret == Z_OK && zs.avail_in == 0);
+
+    out.resize(zs.total_out);
+    deflateEnd(&zs);
+
+    return ok ? 0 : -1;
+}
+
+static int inflate_raw(const char* data, uint64_t size, char* out, uint64_t out_size)
+{
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    if (inflateInit2(&zs, -15) != Z_OK)
+        return -1;
+
+    // inflate rejects a null output even when nothing is produced
+    char empty;
+    if (out_size == 0)
+        out = &empty;
+
+    zs.next_out = (Bytef*)out;
+
+    // avail_in and avail_out are 32bit
+    const uint64_t step = 1u << 30;
+
+    int ret = Z_OK;
+    while (ret == Z_OK)
+    {
+        if (zs.avail_in == 0)
+        {
+            zs.next_in = (Bytef*)data;
+            zs.avail_in = (uInt)std::min(step, size);
+            data += zs.avail_in;
+            size -= zs.avail_in;
+        }
+        if (zs.avail_out == 0)
+        {
+            zs.next_out = (Bytef*)out;
+            zs.avail_out = (uInt)std::min(step, out_size);
+            out += zs.avail_out;
+            out_size -= zs.avail_out;
+        }
+
+        ret = inflate(&zs, Z_NO_FLUSH);
+        if (ret == Z_BUF_ERROR && ((zs.avail_in == 0 && size != 0) || (zs.avail_out == 0 && out_size != 0)))
+            ret = Z_OK;
+    }
+
+    bool ok = ret == Z_STREAM_END && zs.avail_out == 0 && out_size == 0;
+    inflateEnd(&zs);
+
+    return ok ? 0 : -1;
+}
+
 StoreZipReader::StoreZipReader()
 {
     fp = 0;
+    verify_crc = false;
+    num_threads = 0;
 }
 
 StoreZipReader::~StoreZipReader()
@@ -171,7 +450,19 @@ int StoreZipReader::open(const std::string& path)
                 return -1;
             }
 
-            if (lfh.compression != 0 || lfh.compressed_size != lfh.uncompressed_size)
+            if (lfh.compression != STOREZIP_STORED && lfh.compression != STOREZIP_DEFLATE && !is_shuffle_compression(lfh.compression))
+            {
+                fprintf(stderr, "unsupported zip compression %d\n", lfh.compression);
+                return -1;
+            }
+
+            if (is_shuffle_compression(lfh.compression) && (lfh.compression & 0xff) < 2)
+            {
+                fprintf(stderr, "unsupported zip compression %d\n", lfh.compression);
+                return -1;
+            }
+
+            if (lfh.compression == STOREZIP_STORED && lfh.compressed_size != lfh.uncompressed_size)
             {
                 fprintf(stderr, "not stored zip file %d %d\n", lfh.compressed_size, lfh.uncompressed_size);
                 return -1;
@@ -222,6 +513,9 @@ int StoreZipReader::open(const std::string& path)
             StoreZipMeta fm;
             fm.offset = ftell(fp);
             fm.size = compressed_size;
+            fm.uncompressed_size = uncompressed_size;
+            fm.crc32 = lfh.crc32;
+            fm.compression = lfh.compression;
 
             filemetas[name] = fm;
 
@@ -293,24 +587,101 @@ uint64_t StoreZipReader::get_file_size(const std::string& name) const
         return 0;
     }
 
-    return filemetas.at(name).size;
+    return filemetas.at(name).uncompressed_size;
+}
+
+static int pread_all(int fd, char* data, uint64_t size, uint64_t offset)
+{
+    while (size > 0)
+    {
+        ssize_t n = pread(fd, data, size, offset);
+        if (n <= 0)
+            return -1;
+
+        data += n;
+        size -= n;
+        offset += n;
+    }
+
+    return 0;
 }
 
 int StoreZipReader::read_file(const std::string& name, char* data)
 {
-    if (filemetas.find(name) == filemetas.end())
+    return read_files(std::vector<std::string>(1, name), std::vector<char*>(1, data));
+}
+
+int StoreZipReader::read_files(const std::vector<std::string>& names, const std::vector<char*>& datas)
+{
+    std::vector<const StoreZipMeta*> metas;
+    for (const std::string& name : names)
     {
-        fprintf(stderr, "no such file %s\n", name.c_str());
-        return -1;
+        if (filemetas.find(name) == filemetas.end())
+        {
+            fprintf(stderr, "no such file %s\n", name.c_str());
+            return -1;
+        }
+
+        metas.push_back(&filemetas.at(name));
     }
 
-    uint64_t offset = filemetas[name].offset;
-    uint64_t size = filemetas[name].size;
+    // pread does not move the shared file position, entries are read concurrently
+    const int fd = fileno(fp);
+    // a single entry gets all threads for its crc check instead
+    const int crc_threads = names.size() == 1 ? num_threads : 1;
 
-    fseek(fp, offset, SEEK_SET);
-    fread(data, size, 1, fp);
+    std::atomic<int> failed(0);
+    parallel_for(names.size(), num_threads, [&](size_t i) {
+        const StoreZipMeta& fm = *metas[i];
+        char* data = datas[i];
 
-    return 0;
+        int ret = 0;
+        if (fm.compression == STOREZIP_STORED)
+        {
+            ret = pread_all(fd, data, fm.size, fm.offset);
+        }
+        else
+        {
+            std::vector<char> compressed(fm.size);
+            ret = pread_all(fd, compressed.data(), fm.size, fm.offset);
+            if (ret == 0 && is_shuffle_compression(fm.compression))
+            {
+                std::vector<char> shuffled(fm.uncompressed_size);
+                ret = inflate_raw(compressed.data(), fm.size, shuffled.data(), shuffled.size());
+                if (ret == 0)
+                    byte_unshuffle(shuffled.data(), data, fm.uncompressed_size, fm.compression & 0xff);
+            }
+            else if (ret == 0)
+            {
+                ret = inflate_raw(compressed.data(), fm.size, data, fm.uncompressed_size);
+            }
+        }
+
+        if (ret != 0)
+        {
+            fprintf(stderr, "read %s failed\n", names[i].c_str());
+            failed = 1;
+            return;
+        }
+
+        if (verify_crc && crc32_parallel(data, fm.uncompressed_size, crc_threads) != fm.crc32)
+        {
+            fprintf(stderr, "crc32 mismatch %s\n", names[i].c_str());
+            failed = 1;
+        }
+    });
+
+    return failed ? -1 : 0;
+}
+
+void StoreZipReader::set_verify_crc(bool enable)
+{
+    verify_crc = enable;
+}
+
+void StoreZipReader::set_num_threads(int _num_threads)
+{
+    num_threads = _num_threads;
 }
 
 int StoreZipReader::close()
@@ -324,45 +695,44 @@ int StoreZipReader::close()
     return 0;
 }
 
-StoreZipWriter::StoreZipWriter()
+static int pwrite_all(int fd, const char* data, uint64_t size, uint64_t offset)
 {
-    fp = 0;
+    while (size > 0)
+    {
+        ssize_t n = pwrite(fd, data, size, offset);
+        if (n <= 0)
+            return -1;
+
+        data += n;
+        size -= n;
+        offset += n;
+    }
 
-    CRC32_TABLE_INIT();
+    return 0;
 }
 
-StoreZipWriter::~StoreZipWriter()
+static void append_bytes(std::vector<char>& buf, const void* data, size_t size)
 {
-    close();
+    buf.insert(buf.end(), (const char*)data, (const char*)data + size);
 }
 
-int StoreZipWriter::open(const std::string& path)
+static uint64_t local_file_header_size(const std::string& name)
 {
-    close();
-
-    fp = fopen(path.c_str(), "wb");
-    if (!fp)
-    {
-        fprintf(stderr, "open failed\n");
-        return -1;
-    }
-
-    return 0;
+    return sizeof(uint32_t) + sizeof(local_file_header) + name.size() + sizeof(uint16_t) * 2 + sizeof(zip64_extended_extra_field);
 }
 
-int StoreZipWriter::write_file(const std::string& name, const char* data, uint64_t size)
+static std::vector<char> local_file_header_bytes(const std::string& name, uint16_t compression, uint32_t crc32, uint64_t size, uint64_t compressed_size)
 {
-    long offset = ftell(fp);
+    std::vector<char> buf;
+    buf.reserve(local_file_header_size(name));
 
     uint32_t signature = 0x04034b50;
-    fwrite((char*)&signature, sizeof(signature), 1, fp);
-
-    uint32_t crc32 = CRC32_buffer((const unsigned char*)data, size);
+    append_bytes(buf, &signature, sizeof(signature));
 
     local_file_header lfh;
     lfh.version = 0;
     lfh.flag = 0;
-    lfh.compression = 0;
+    lfh.compression = compression;
     lfh.last_modify_time = 0;
     lfh.last_modify_date = 0;
     lfh.crc32 = crc32;
@@ -373,7 +743,7 @@ int StoreZipWriter::write_file(const std::string& name, const char* data, uint64
     // zip64 extra field
     zip64_extended_extra_field zip64_eef;
     zip64_eef.uncompressed_size = size;
-    zip64_eef.compressed_size = size;
+    zip64_eef.compressed_size = compressed_size;
     zip64_eef.lfh_offset = 0;
     zip64_eef.disk_number = 0;
 
@@ -382,44 +752,246 @@ int StoreZipWriter::write_file(const std::string& name, const char* data, uint64
 
     lfh.extra_field_length = sizeof(extra_id) + sizeof(extra_size) + sizeof(zip64_eef);
 
-    fwrite((char*)&lfh, sizeof(lfh), 1, fp);
+    append_bytes(buf, &lfh, sizeof(lfh));
+    append_bytes(buf, name.data(), name.size());
+    append_bytes(buf, &extra_id, sizeof(extra_id));
+    append_bytes(buf, &extra_size, sizeof(extra_size));
+    append_bytes(buf, &zip64_eef, sizeof(zip64_eef));
+
+    return buf;
+}
+
+StoreZipWriter::StoreZipWriter()
+{
+    fd = -1;
+    offset = 0;
+    num_threads = 0;
+    compression = STOREZIP_STORED;
+    level = 1;
+}
+
+StoreZipWriter::~StoreZipWriter()
+{
+    close();
+}
+
+int StoreZipWriter::open(const std::string& path)
+{
+    close();
 
-    fwrite((char*)name.c_str(), name.size(), 1, fp);
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        fprintf(stderr, "open failed\n");
+        return -1;
+    }
 
-    fwrite((char*)&extra_id, sizeof(extra_id), 1, fp);
-    fwrite((char*)&extra_size, sizeof(extra_size), 1, fp);
-    fwrite((char*)&zip64_eef, sizeof(zip64_eef), 1, fp);
+    offset = 0;
+    filemetas.clear();
 
-    fwrite(data, size, 1, fp);
+    return 0;
+}
+
+void StoreZipWriter::set_compression(int _compression, int _level)
+{
+    compression = _compression;
+    level = _level;
+}
 
+void StoreZipWriter::set_num_threads(int _num_threads)
+{
+    num_threads = _num_threads;
+}
+
+int StoreZipWriter::write_file(const std::string& name, const char* data, uint64_t size, int elemsize)
+{
+    // same path as the deferred entries, the data is consumed before returning
+    if (write_file_deferred(name, data, size, elemsize) != 0)
+        return -1;
+
+    return flush_deferred();
+}
+
+int StoreZipWriter::write_file_deferred(const std::string& name, const char* data, uint64_t size, int elemsize)
+{
     StoreZipMeta szm;
     szm.name = name;
-    szm.lfh_offset = offset;
-    szm.crc32 = crc32;
+    szm.lfh_offset = 0;
+    szm.crc32 = 0;
     szm.size = size;
+    szm.compressed_size = size;
+    szm.compression = compression;
+    szm.deferred = true;
+    szm.deferred_data = data;
+
+    if (compression == STOREZIP_SHUFFLE_DEFLATE)
+    {
+        // nothing to regroup for byte sized elements
+        szm.compression = elemsize > 1 && elemsize <= 0xff ? STOREZIP_SHUFFLE_DEFLATE | elemsize : STOREZIP_DEFLATE;
+    }
 
     filemetas.push_back(szm);
 
     return 0;
 }
 
+int StoreZipWriter::flush_deferred()
+{
+    // every deferred entry is split into chunks that are checksummed, compressed and
+    // written at their final offset independently
+    struct chunk
+    {
+        size_t meta_index;
+        uint64_t begin;
+        uint64_t size;
+        uint32_t crc32;
+        uint64_t file_offset;
+        std::vector<char> compressed;
+    };
+
+    std::vector<size_t> entries;
+    std::vector<chunk> chunks;
+    for (size_t i = 0; i < filemetas.size(); i++)
+    {
+        const StoreZipMeta& szm = filemetas[i];
+        if (!szm.deferred)
+            continue;
+
+        entries.push_back(i);
+
+        uint64_t begin = 0;
+        do
+        {
+            chunk c{};
+            c.meta_index = i;
+            c.begin = begin;
+            c.size = std::min(PARALLEL_CHUNK_SIZE, szm.size - begin);
+            chunks.push_back(c);
+            begin += c.size;
+        } while (begin < szm.size);
+    }
+
+    if (chunks.empty())
+        return 0;
+
+    // byte planes span the whole entry, so shuffle before chunking
+    std::map<size_t, std::vector<char> > shuffled;
+    for (size_t i : entries)
+    {
+        if (is_shuffle_compression(filemetas[i].compression))
+            shuffled[i].resize(filemetas[i].size);
+    }
+    parallel_for(entries.size(), num_threads, [&](size_t k) {
+        const StoreZipMeta& szm = filemetas[entries[k]];
+        if (is_shuffle_compression(szm.compression))
+            byte_shuffle(szm.deferred_data, shuffled.at(entries[k]).data(), szm.size, szm.compression & 0xff);
+    });
+
+    std::atomic<int> failed(0);
+    parallel_for(chunks.size(), num_threads, [&](size_t i) {
+        chunk& c = chunks[i];
+        const StoreZipMeta& szm = filemetas[c.meta_index];
+
+        c.crc32 = crc32(szm.deferred_data + c.begin, c.size);
+
+        if (szm.compression != STOREZIP_STORED)
+        {
+            const char* src = is_shuffle_compression(szm.compression) ? shuffled.at(c.meta_index).data() : szm.deferred_data;
+            bool last = c.begin + c.size == szm.size;
+            if (deflate_chunk(src + c.begin, c.size, level, last, c.compressed) != 0)
+                failed = 1;
+        }
+    });
+
+    if (failed)
+    {
+        fprintf(stderr, "compress failed\n");
+        return -1;
+    }
+
+    // chunks are ordered by entry, fold them into the entry crc and lay out the entries
+    std::vector<std::vector<char> > headers;
+    for (size_t i = 0; i < chunks.size(); i++)
+    {
+        chunk& c = chunks[i];
+        StoreZipMeta& szm = filemetas[c.meta_index];
+        if (c.begin == 0)
+        {
+            szm.crc32 = c.crc32;
+            szm.compressed_size = 0;
+            szm.lfh_offset = offset;
+            offset += local_file_header_size(szm.name);
+        }
+        else
+        {
+            szm.crc32 = crc32_combine(szm.crc32, c.crc32, c.size);
+        }
+
+        c.file_offset = offset;
+        uint64_t stored_size = szm.compression == STOREZIP_STORED ? c.size : c.compressed.size();
+        szm.compressed_size += stored_size;
+        offset += stored_size;
+
+        bool last = i + 1 == chunks.size() || chunks[i + 1].meta_index != c.meta_index;
+        if (last)
+            headers.push_back(local_file_header_bytes(szm.name, szm.compression, szm.crc32, szm.size, szm.compressed_size));
+    }
+
+    parallel_for(chunks.size() + headers.size(), num_threads, [&](size_t i) {
+        int ret;
+        if (i < headers.size())
+        {
+            const StoreZipMeta& szm = filemetas[entries[i]];
+            ret = pwrite_all(fd, headers[i].data(), headers[i].size(), szm.lfh_offset);
+        }
+        else
+        {
+            const chunk& c = chunks[i - headers.size()];
+            const StoreZipMeta& szm = filemetas[c.meta_index];
+            if (szm.compression == STOREZIP_STORED)
+                ret = pwrite_all(fd, szm.deferred_data + c.begin, c.size, c.file_offset);
+            else
+                ret = pwrite_all(fd, c.compressed.data(), c.compressed.size(), c.file_offset);
+        }
+
+        if (ret != 0)
+            failed = 1;
+    });
+
+    for (size_t i : entries)
+    {
+        filemetas[i].deferred = false;
+        filemetas[i].deferred_data = 0;
+    }
+
+    if (failed)
+    {
+        fprintf(stderr, "write failed\n");
+        return -1;
+    }
+
+    return 0;
+}
+
 int StoreZipWriter::close()
 {
-    if (!fp)
+    if (fd < 0)
         return 0;
 
-    long offset = ftell(fp);
+    int ret = flush_deferred();
+
+    std::vector<char> buf;
 
     for (const StoreZipMeta& szm : filemetas)
     {
         uint32_t signature = 0x02014b50;
-        fwrite((char*)&signature, sizeof(signature), 1, fp);
+        append_bytes(buf, &signature, sizeof(signature));
 
         central_directory_file_header cdfh;
         cdfh.version_made = 0;
         cdfh.version = 0;
         cdfh.flag = 0;
-        cdfh.compression = 0;
+        cdfh.compression = szm.compression;
         cdfh.last_modify_time = 0;
         cdfh.last_modify_date = 0;
         cdfh.crc32 = szm.crc32;
@@ -435,7 +1007,7 @@ int StoreZipWriter::close()
         // zip64 extra field
         zip64_extended_extra_field zip64_eef;
         zip64_eef.uncompressed_size = szm.size;
-        zip64_eef.compressed_size = szm.size;
+        zip64_eef.compressed_size = szm.compressed_size;
         zip64_eef.lfh_offset = szm.lfh_offset;
         zip64_eef.disk_number = 0;
 
@@ -444,20 +1016,18 @@ int StoreZipWriter::close()
 
         cdfh.extra_field_length = sizeof(extra_id) + sizeof(extra_size) + sizeof(zip64_eef);
 
-        fwrite((char*)&cdfh, sizeof(cdfh), 1, fp);
-
-        fwrite((char*)szm.name.c_str(), szm.name.size(), 1, fp);
-
-        fwrite((char*)&extra_id, sizeof(extra_id), 1, fp);
-        fwrite((char*)&extra_size, sizeof(extra_size), 1, fp);
-        fwrite((char*)&zip64_eef, sizeof(zip64_eef), 1, fp);
+        append_bytes(buf, &cdfh, sizeof(cdfh));
+        append_bytes(buf, szm.name.data(), szm.name.size());
+        append_bytes(buf, &extra_id, sizeof(extra_id));
+        append_bytes(buf, &extra_size, sizeof(extra_size));
+        append_bytes(buf, &zip64_eef, sizeof(zip64_eef));
     }
 
-    long offset2 = ftell(fp);
+    uint64_t offset2 = offset + buf.size();
 
     {
         uint32_t signature = 0x06064b50;
-        fwrite((char*)&signature, sizeof(signature), 1, fp);
+        append_bytes(buf, &signature, sizeof(signature));
 
         zip64_end_of_central_directory_record eocdr64;
         eocdr64.size_of_eocd64_m12 = sizeof(eocdr64) - 8;
@@ -470,24 +1040,24 @@ int StoreZipWriter::close()
         eocdr64.cd_size = offset2 - offset;
         eocdr64.cd_offset = offset;
 
-        fwrite((char*)&eocdr64, sizeof(eocdr64), 1, fp);
+        append_bytes(buf, &eocdr64, sizeof(eocdr64));
     }
 
     {
         uint32_t signature = 0x07064b50;
-        fwrite((char*)&signature, sizeof(signature), 1, fp);
+        append_bytes(buf, &signature, sizeof(signature));
 
         zip64_end_of_central_directory_locator eocdl64;
         eocdl64.eocdr64_disk_number = 0;
         eocdl64.eocdr64_offset = offset2;
         eocdl64.disk_count = 1;
 
-        fwrite((char*)&eocdl64, sizeof(eocdl64), 1, fp);
+        append_bytes(buf, &eocdl64, sizeof(eocdl64));
     }
 
     {
         uint32_t signature = 0x06054b50;
-        fwrite((char*)&signature, sizeof(signature), 1, fp);
+        append_bytes(buf, &signature, sizeof(signature));
 
         end_of_central_directory_record eocdr;
         eocdr.disk_number = 0xffff;
@@ -498,13 +1068,20 @@ int StoreZipWriter::close()
         eocdr.cd_offset = 0xffffffff;
         eocdr.comment_length = 0;
 
-        fwrite((char*)&eocdr, sizeof(eocdr), 1, fp);
+        append_bytes(buf, &eocdr, sizeof(eocdr));
     }
 
-    fclose(fp);
-    fp = 0;
+    if (pwrite_all(fd, buf.data(), buf.size(), offset) != 0)
+    {
+        fprintf(stderr, "write central directory failed\n");
+        ret = -1;
+    }
 
-    return 0;
+    ::close(fd);
+    fd = -1;
+    filemetas.clear();
+
+    return ret;
 }
 
 } // namespace pnnx
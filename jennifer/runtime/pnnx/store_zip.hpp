@@ -16,12 +16,33 @@
 #define PNNX_STOREZIP_H
 
 #include <stdint.h>
+#include <stdio.h>
 #include <map>
 #include <string>
 #include <vector>
 
 namespace pnnx {
 
+// zip crc32 of data continuing from crc, slicing-by-16
+uint32_t crc32(const void* data, uint64_t size, uint32_t crc = 0);
+
+// crc32 of the concatenation of two buffers from their crc32 values
+uint32_t crc32_combine(uint32_t crc1, uint32_t crc2, uint64_t size2);
+
+// crc32 of large buffers computed in chunks on num_threads threads
+uint32_t crc32_parallel(const void* data, uint64_t size, int num_threads);
+
+// entry compression methods. shuffle deflate is private to pnnx, the bytes of every
+// element are regrouped into byte planes before deflate, which lets float weights
+// with similar exponents compress much better. the zip method id is
+// STOREZIP_SHUFFLE_DEFLATE | elemsize
+enum
+{
+    STOREZIP_STORED = 0,
+    STOREZIP_DEFLATE = 8,
+    STOREZIP_SHUFFLE_DEFLATE = 0x5300
+};
+
 class StoreZipReader
 {
 public:
@@ -34,17 +55,32 @@ public:
 
     uint64_t get_file_size(const std::string& name) const;
 
+    // read get_file_size(name) uncompressed bytes into data
     int read_file(const std::string& name, char* data);
 
+    // read several entries, decompressing them in parallel
+    int read_files(const std::vector<std::string>& names, const std::vector<char*>& datas);
+
+    // check the crc32 of every entry read, off by default
+    void set_verify_crc(bool enable);
+
+    // threads used by read_files and crc checks, 0 for hardware concurrency
+    void set_num_threads(int num_threads);
+
     int close();
 
 private:
     FILE* fp;
+    bool verify_crc;
+    int num_threads;
 
     struct StoreZipMeta
     {
         uint64_t offset;
         uint64_t size;
+        uint64_t uncompressed_size;
+        uint32_t crc32;
+        uint16_t compression;
     };
 
     std::map<std::string, StoreZipMeta> filemetas;
@@ -58,12 +94,29 @@ public:
 
     int open(const std::string& path);
 
-    int write_file(const std::string& name, const char* data, uint64_t size);
+    // elemsize is the byte plane stride for STOREZIP_SHUFFLE_DEFLATE
+    int write_file(const std::string& name, const char* data, uint64_t size, int elemsize = 1);
+
+    // write the entry on close, data must stay valid until then. deferred entries are
+    // compressed, checksummed and written in parallel
+    int write_file_deferred(const std::string& name, const char* data, uint64_t size, int elemsize = 1);
+
+    // compression for the entries written from now on, STOREZIP_STORED by default
+    void set_compression(int compression, int level = 1);
+
+    // threads used for compression, crc and writes, 0 for hardware concurrency
+    void set_num_threads(int num_threads);
 
     int close();
 
 private:
-    FILE* fp;
+    int flush_deferred();
+
+    int fd;
+    uint64_t offset;
+    int num_threads;
+    int compression;
+    int level;
 
     struct StoreZipMeta
     {
@@ -71,6 +124,10 @@ private:
         uint64_t lfh_offset;
         uint32_t crc32;
         uint64_t size;
+        uint64_t compressed_size;
+        uint16_t compression;
+        bool deferred;
+        const char* deferred_data;
     };
 
     std::vector<StoreZipMeta> filemetas;
@@ -0,0 +1,179 @@
+#include <glog/logging.h>
+
+#include <future>
+
+#include "replica_set.hpp"
+
+namespace jennifer
+{
+namespace runtime
+{
+
+using utils::StatusCode;
+
+ReplicaSet::ReplicaSet(std::string param_path, std::string bin_path, const ReplicaOptions &options) :
+    options_(options)
+{
+    loader_ = [param_path, bin_path]() {
+        std::unique_ptr<RuntimeGraph> graph(new RuntimeGraph(param_path, bin_path));
+        return graph->Init() ? std::move(graph) : nullptr;
+    };
+}
+
+ReplicaSet::ReplicaSet(GraphLoader loader, const ReplicaOptions &options) :
+    loader_(std::move(loader)), options_(options)
+{
+    CHECK(loader_ != nullptr) << "Replica graph loader is empty";
+}
+
+ReplicaSet::~ReplicaSet()
+{
+    Stop();
+}
+
+bool ReplicaSet::Init()
+{
+    CHECK(replicas_.empty()) << "Replica set is already initialized";
+
+    topology_ = DetectNumaTopology(options_.topology_root);
+    if (options_.max_nodes > 0 && topology_.size() > options_.max_nodes)
+    {
+        topology_.resize(options_.max_nodes);
+    }
+    const size_t count = options_.policy == NumaPolicy::Replicate ? topology_.size() : 1;
+
+    // every replica loads on its own thread, the nodes load in parallel
+    std::vector<std::future<bool>> loaded;
+    for (size_t i = 0; i < count; ++i)
+    {
+        replicas_.emplace_back(new Replica);
+        Replica &replica = *replicas_.back();
+        replica.node = topology_[i];
+        auto promise = std::make_shared<std::promise<bool>>();
+        loaded.push_back(promise->get_future());
+        replica.thread = std::thread(&ReplicaSet::Loop, this, std::ref(replica),
+                                     [promise](bool ok) { promise->set_value(ok); });
+    }
+
+    bool ok = true;
+    for (size_t i = 0; i < loaded.size(); ++i)
+    {
+        if (!loaded[i].get())
+        {
+            LOG(ERROR) << "Replica " << i << " on node " << replicas_[i]->node.id << " can not load its graph";
+            ok = false;
+        }
+    }
+    if (!ok)
+    {
+        Stop();
+        replicas_.clear();
+    }
+    return ok;
+}
+
+void ReplicaSet::Loop(Replica &replica, std::function<void(bool)> loaded)
+{
+    if (options_.policy == NumaPolicy::Replicate)
+    {
+        PinThread(replica.node);
+    }
+    else
+    {
+        InterleaveMemory(topology_);
+    }
+
+    replica.graph = loader_();
+    loaded(replica.graph != nullptr);
+    if (replica.graph == nullptr)
+    {
+        return;
+    }
+
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(replica.mutex);
+            replica.cv.wait(lock, [&replica] { return replica.stop || !replica.tasks.empty(); });
+            if (replica.tasks.empty())
+            {
+                return;
+            }
+            task = std::move(replica.tasks.front());
+            replica.tasks.pop_front();
+        }
+        replica.served += 1;
+        task();
+        replica.pending -= 1;
+    }
+}
+
+StatusCode ReplicaSet::Forward(const std::vector<std::shared_ptr<Operand<float>>> &inputs,
+                               std::vector<std::shared_ptr<Operand<float>>> &outputs)
+{
+    CHECK(!replicas_.empty()) << "Replica set is not initialized";
+
+    Replica *replica = replicas_[0].get();
+    for (const std::unique_ptr<Replica> &other : replicas_)
+    {
+        if (other->pending < replica->pending)
+        {
+            replica = other.get();
+        }
+    }
+    replica->pending += 1;
+
+    std::packaged_task<StatusCode()> task([&]() { return replica->graph->Forward(inputs, outputs); });
+    std::future<StatusCode> status = task.get_future();
+    {
+        std::lock_guard<std::mutex> lock(replica->mutex);
+        if (replica->stop)
+        {
+            replica->pending -= 1;
+            LOG(ERROR) << "Replica set is stopped";
+            return StatusCode::RuntimeStopped;
+        }
+        replica->tasks.emplace_back([&task]() { task(); });
+    }
+    replica->cv.notify_one();
+    return status.get();
+}
+
+void ReplicaSet::Stop()
+{
+    for (const std::unique_ptr<Replica> &replica : replicas_)
+    {
+        {
+            std::lock_guard<std::mutex> lock(replica->mutex);
+            replica->stop = true;
+        }
+        replica->cv.notify_all();
+    }
+    for (const std::unique_ptr<Replica> &replica : replicas_)
+    {
+        if (replica->thread.joinable())
+        {
+            replica->thread.join();
+        }
+    }
+}
+
+size_t ReplicaSet::size() const
+{
+    return replicas_.size();
+}
+
+const std::vector<NumaNode> &ReplicaSet::topology() const
+{
+    return topology_;
+}
+
+uint64_t ReplicaSet::served(size_t replica) const
+{
+    CHECK_LT(replica, replicas_.size()) << "Replica index is out of range";
+    return replicas_[replica]->served;
+}
+
+} // namespace runtime
+} // namespace jennifer
@@ -0,0 +1,109 @@
+#ifndef JENNIFER_RUNTIME_REPLICA_SET_HPP
+#define JENNIFER_RUNTIME_REPLICA_SET_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "jennifer/utils/common.hpp"
+
+#include "numa.hpp"
+#include "operand.hpp"
+#include "runtime_graph.hpp"
+
+namespace jennifer
+{
+namespace runtime
+{
+
+enum class NumaPolicy
+{
+    // a graph per node, loaded and run by a thread pinned to the node so weights,
+    // packed kernels and the activation arena are first touched in local memory
+    Replicate,
+    // a single graph whose pages are interleaved over every node, for models that
+    // do not fit once per node, run by an unpinned thread
+    Interleave,
+}; // enum class NumaPolicy
+
+struct ReplicaOptions
+{
+    NumaPolicy policy = NumaPolicy::Replicate;
+
+    // sysfs directory of the node topology
+    std::string topology_root = "/sys/devices/system/node";
+
+    // nodes to deploy on, 0 for every detected node
+    uint32_t max_nodes = 0;
+}; // struct ReplicaOptions
+
+// Deploys a model once per NUMA node of the machine. Every replica owns an executor
+// thread that loads its RuntimeGraph and runs its requests, and the ParallelFor
+// workers of the executor stay on the cores of its node. Forward may be called from
+// many threads at once and waits on the replica with the fewest pending requests.
+class ReplicaSet
+{
+public:
+    // loads the graph of a replica on its executor thread, nullptr on failure
+    using GraphLoader = std::function<std::unique_ptr<RuntimeGraph>()>;
+
+    ReplicaSet(std::string param_path, std::string bin_path, const ReplicaOptions &options = ReplicaOptions());
+    explicit ReplicaSet(GraphLoader loader, const ReplicaOptions &options = ReplicaOptions());
+    ~ReplicaSet();
+
+    ReplicaSet(const ReplicaSet &) = delete;
+    ReplicaSet &operator=(const ReplicaSet &) = delete;
+
+    // detects the topology and starts the replicas, false when one fails to load
+    bool Init();
+
+    // RuntimeStopped once Stop has been called
+    utils::StatusCode Forward(const std::vector<std::shared_ptr<Operand<float>>> &inputs,
+                              std::vector<std::shared_ptr<Operand<float>>> &outputs);
+
+    // runs the queued requests and joins the executors
+    void Stop();
+
+    size_t size() const;
+
+    // nodes the replicas run on, every node for a single interleaved replica
+    const std::vector<NumaNode> &topology() const;
+
+    // requests replica has run
+    uint64_t served(size_t replica) const;
+
+private:
+    struct Replica
+    {
+        NumaNode node;
+        std::unique_ptr<RuntimeGraph> graph;
+
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::deque<std::function<void()>> tasks;
+        bool stop = false;
+
+        std::atomic<uint32_t> pending{0};
+        std::atomic<uint64_t> served{0};
+        std::thread thread;
+    }; // struct Replica
+
+    void Loop(Replica &replica, std::function<void(bool)> loaded);
+
+    GraphLoader loader_;
+    ReplicaOptions options_;
+    std::vector<NumaNode> topology_;
+    std::vector<std::unique_ptr<Replica>> replicas_;
+}; // class ReplicaSet
+
+} // namespace runtime
+} // namespace jennifer
+
+#endif // JENNIFER_RUNTIME_REPLICA_SET_HPP
@@ -0,0 +1,635 @@
+#include <glog/logging.h>
+
+#include <numeric>
+
+#include "jennifer/layer/attention.hpp"
+#include "jennifer/layer/layer_factory.hpp"
+#include "jennifer/pass/eliminate.hpp"
+#include "jennifer/pass/fold_constants.hpp"
+#include "jennifer/pass/fuse_attention.hpp"
+#include "jennifer/pass/fuse_elementwise.hpp"
+
+#include "binary_graph.hpp"
+#include "runtime_graph.hpp"
+
+namespace jennifer
+{
+namespace runtime
+{
+
+using utils::StatusCode;
+
+// per-sample tensor shape of an activation, the leading dim is the batch and
+// dims beyond three are folded into the channels
+static std::vector<uint32_t> SampleShape(const Shape &shape)
+{
+    std::vector<uint32_t> sample;
+    for (size_t i = 1; i < shape.size(); ++i)
+    {
+        sample.push_back(static_cast<uint32_t>(shape[i]));
+    }
+    while (sample.size() > 3)
+    {
+        sample[1] *= sample[0];
+        sample.erase(sample.begin());
+    }
+    if (sample.empty())
+    {
+        sample.push_back(1);
+    }
+    return sample;
+}
+
+static uint32_t BatchSize(const Shape &shape)
+{
+    return shape.empty() ? 1 : static_cast<uint32_t>(shape[0]);
+}
+
+static std::shared_ptr<Parameter> ConvertParameter(const pnnx::Parameter &param)
+{
+    switch (param.type)
+    {
+    case 1: return std::make_shared<ParameterBool>(param.b);
+    case 2: return std::make_shared<ParameterInt>(param.i);
+    case 3: return std::make_shared<ParameterFloat>(param.f);
+    case 4: return std::make_shared<ParameterString>(param.s);
+    case 5: return std::make_shared<ParameterIntArray>(param.ai);
+    case 6: return std::make_shared<ParameterFloatArray>(param.af);
+    case 7: return std::make_shared<ParameterStringArray>(param.as);
+    default: return nullptr;
+    }
+}
+
+RuntimeGraph::RuntimeGraph()
+{
+}
+
+RuntimeGraph::RuntimeGraph(std::string param_path, std::string bin_path) :
+    param_path_(std::move(param_path)), bin_path_(std::move(bin_path))
+{
+}
+
+bool RuntimeGraph::Init()
+{
+    if (param_path_.empty() || bin_path_.empty())
+    {
+        LOG(ERROR) << "The param path or bin path is empty";
+        return false;
+    }
+
+    // the param path may also be a binary graph converted from the text format
+    std::unique_ptr<pnnx::Graph> graph(new pnnx::Graph);
+    if (BinaryGraph::IsBinaryGraph(param_path_))
+    {
+        BinaryGraph binary;
+        if (!binary.Open(param_path_) || !binary.ToGraph(*graph, bin_path_))
+        {
+            LOG(ERROR) << "Can not load the binary graph " << param_path_ << " " << bin_path_;
+            return false;
+        }
+    }
+    else if (graph->load(param_path_, bin_path_) != 0)
+    {
+        LOG(ERROR) << "Can not load the pnnx graph " << param_path_ << " " << bin_path_;
+        return false;
+    }
+    return Init(std::move(graph));
+}
+
+bool RuntimeGraph::Init(std::unique_ptr<pnnx::Graph> graph)
+{
+    if (graph == nullptr || graph->ops.empty())
+    {
+        LOG(ERROR) << "The pnnx graph is empty";
+        return false;
+    }
+
+    pass::FoldConstants(*graph);
+    pass::EliminationReport report = pass::EliminateCommonSubexpressions(*graph);
+    report += pass::EliminateDeadCode(*graph);
+    if (report.removed_operators != 0)
+    {
+        LOG(INFO) << "Eliminated " << report.removed_operators << " operators and " << report.removed_operands
+                  << " operands, saved " << report.saved_bytes << " bytes";
+    }
+
+    const int attention = pass::FuseAttention(*graph);
+    if (attention != 0)
+    {
+        LOG(INFO) << "Fused " << attention << " attention blocks";
+    }
+
+    const int fused = pass::FuseElementwise(*graph);
+    if (fused != 0)
+    {
+        LOG(INFO) << "Fused " << fused << " pointwise operators";
+    }
+
+    graph_ = std::move(graph);
+    inference_.reset(new ShapeInference(*graph_));
+    if (inference_->input_operators().empty() || inference_->output_operators().empty())
+    {
+        LOG(ERROR) << "The pnnx graph has no pnnx.Input or pnnx.Output";
+        return false;
+    }
+
+    plan_cache_.Clear();
+    {
+        std::lock_guard<std::mutex> lock(layer_mutex_);
+        layers_.clear();
+    }
+
+    InitOperators();
+    InitConstants();
+    return true;
+}
+
+void RuntimeGraph::InitOperators()
+{
+    operators_.clear();
+
+    std::vector<std::shared_ptr<Operand<float>>> operands;
+    for (const pnnx::Operand *operand : graph_->operands)
+    {
+        operands.push_back(std::make_shared<Operand<float>>(operand->name, operand->shape, 0,
+                                                            static_cast<AttributeType>(operand->type)));
+    }
+
+    for (const pnnx::Operator *op : graph_->ops)
+    {
+        auto runtime_op = std::make_shared<Operator<float>>();
+        runtime_op->name = op->name;
+        runtime_op->type = op->type;
+
+        for (const pnnx::Operand *input : op->inputs)
+        {
+            const auto &operand = operands[inference_->operand_index(input)];
+            runtime_op->input_operands.insert({operand->name, operand});
+            runtime_op->input_operands_seq.push_back(operand);
+        }
+
+        if (!op->outputs.empty())
+        {
+            runtime_op->output_operands = operands[inference_->operand_index(op->outputs[0])];
+        }
+        for (const pnnx::Operand *output : op->outputs)
+        {
+            for (const pnnx::Operator *consumer : output->consumers)
+            {
+                runtime_op->output_names.push_back(consumer->name);
+            }
+        }
+
+        for (const auto &it : op->params)
+        {
+            std::shared_ptr<Parameter> param = ConvertParameter(it.second);
+            if (param == nullptr)
+            {
+                LOG(WARNING) << "Unsupported parameter " << it.first << " of type " << it.second.type << " in " << op->name;
+                continue;
+            }
+            runtime_op->params.insert({it.first, param});
+        }
+
+        for (const auto &it : op->attrs)
+        {
+            const pnnx::Attribute &attr = it.second;
+            if (attr.type < static_cast<int>(AttributeType::Float32) || attr.type > static_cast<int>(AttributeType::UInt8))
+            {
+                LOG(WARNING) << "Unsupported attribute " << it.first << " of type " << attr.type << " in " << op->name;
+                continue;
+            }
+            runtime_op->attrs.insert({it.first, std::make_shared<Attribute>(attr.shape, attr.data, static_cast<AttributeType>(attr.type))});
+        }
+
+        operators_.push_back(runtime_op);
+    }
+
+    std::map<std::string, std::shared_ptr<Operator<float>>> by_name;
+    for (const auto &op : operators_)
+    {
+        by_name.insert({op->name, op});
+    }
+    for (const auto &op : operators_)
+    {
+        for (const std::string &name : op->output_names)
+        {
+            op->output_operators.insert({name, by_name.at(name)});
+        }
+    }
+}
+
+void RuntimeGraph::InitConstants()
+{
+    constants_.assign(graph_->operands.size(), nullptr);
+
+    for (const pnnx::Operator *op : graph_->ops)
+    {
+        if (op->type != "pnnx.Attribute" || op->attrs.empty() || op->outputs.empty())
+        {
+            continue;
+        }
+
+        const pnnx::Attribute &attr = op->attrs.begin()->second;
+        std::vector<float> values;
+        if (attr.type == 1 || attr.type == 2 || attr.type == 3)
+        {
+            values = attr.get_float32_data();
+        }
+        else
+        {
+            const int count = attr.elemcount();
+            values.resize(count);
+            for (int i = 0; i < count; ++i)
+            {
+                const char *p = attr.data.data() + i * attr.elemsize();
+                switch (attr.type)
+                {
+                case 4: values[i] = static_cast<float>(*reinterpret_cast<const int32_t *>(p)); break;
+                case 5: values[i] = static_cast<float>(*reinterpret_cast<const int64_t *>(p)); break;
+                case 6: values[i] = static_cast<float>(*reinterpret_cast<const int16_t *>(p)); break;
+                case 7: values[i] = static_cast<float>(*reinterpret_cast<const int8_t *>(p)); break;
+                case 8: values[i] = static_cast<float>(*reinterpret_cast<const uint8_t *>(p)); break;
+                case 9: values[i] = *p ? 1.f : 0.f; break;
+                default: LOG(FATAL) << "Unsupported constant type " << attr.type << " in " << op->name;
+                }
+            }
+        }
+        if (values.empty() || values.size() != attr.data.size() / std::max<size_t>(attr.elemsize(), 1))
+        {
+            // shape only attribute without weight data
+            continue;
+        }
+
+        // constants carry no batch dim, fold them like a single sample
+        Shape shape{1};
+        shape.insert(shape.end(), attr.shape.begin(), attr.shape.end());
+        auto tensor = std::make_shared<Tensor<float>>(SampleShape(shape));
+        tensor->Fill(values, true);
+        constants_[inference_->operand_index(op->outputs[0])] = tensor;
+    }
+}
+
+std::shared_ptr<layer::Layer<float>> RuntimeGraph::FindLayer(int op_index, const std::string &kernel)
+{
+    std::lock_guard<std::mutex> lock(layer_mutex_);
+    auto key = std::make_pair(op_index, kernel);
+    auto it = layers_.find(key);
+    if (it != layers_.end())
+    {
+        return it->second;
+    }
+
+    if (!layer::LayerRegisterer::HasCreator(kernel))
+    {
+        return nullptr;
+    }
+
+    const std::shared_ptr<Operator<float>> &op = operators_[op_index];
+    std::shared_ptr<layer::Layer<float>> layer = layer::LayerRegisterer::CreateLayer(kernel, op);
+    if (layer == nullptr)
+    {
+        return nullptr;
+    }
+    if (kernel == op->type)
+    {
+        op->layer = layer;
+        op->has_forward = true;
+    }
+    layers_.insert({key, layer});
+    return layer;
+}
+
+StatusCode RuntimeGraph::Plan(const std::vector<Shape> &input_shapes, std::shared_ptr<const ExecutionPlan> &plan)
+{
+    CHECK(graph_ != nullptr) << "Runtime graph is not initialized";
+
+    const std::string signature = MakeShapeSignature(input_shapes);
+    plan = plan_cache_.Find(signature);
+    if (plan != nullptr)
+    {
+        return StatusCode::Success;
+    }
+
+    auto new_plan = std::make_shared<ExecutionPlan>();
+    new_plan->signature = signature;
+
+    StatusCode status = inference_->Infer(input_shapes, new_plan->shapes);
+    if (status != StatusCode::Success)
+    {
+        LOG(ERROR) << "Shape inference failed for input shapes " << signature;
+        return status;
+    }
+
+    new_plan->kernels.resize(graph_->ops.size());
+    std::vector<StorageReuse> reuse(graph_->ops.size(), StorageReuse::None);
+    for (size_t i = 0; i < graph_->ops.size(); ++i)
+    {
+        const pnnx::Operator *op = graph_->ops[i];
+        if (op->type == "pnnx.Input" || op->type == "pnnx.Output" || op->type == "pnnx.Attribute")
+        {
+            new_plan->kernels[i] = op->type;
+            continue;
+        }
+
+        std::vector<Shape> op_inputs;
+        std::vector<Shape> op_outputs;
+        for (const pnnx::Operand *operand : op->inputs)
+        {
+            op_inputs.push_back(new_plan->shapes[inference_->operand_index(operand)]);
+        }
+        for (const pnnx::Operand *operand : op->outputs)
+        {
+            op_outputs.push_back(new_plan->shapes[inference_->operand_index(operand)]);
+        }
+
+        const std::string kernel = layer::LayerRegisterer::SelectKernel(operators_[i], op_inputs, op_outputs);
+        std::shared_ptr<layer::Layer<float>> layer = FindLayer(i, kernel);
+        if (layer == nullptr)
+        {
+            LOG(ERROR) << "Can not find the layer " << kernel << " for operator " << op->name;
+            return StatusCode::FunctionNotImplement;
+        }
+        new_plan->kernels[i] = kernel;
+        if (layer->IsView())
+        {
+            reuse[i] = StorageReuse::View;
+        }
+        else if (layer->SupportsInPlace())
+        {
+            reuse[i] = StorageReuse::InPlace;
+        }
+    }
+
+    PlanMemory(*graph_, *inference_, *new_plan, reuse);
+
+    plan = new_plan;
+    plan_cache_.Insert(plan);
+    return StatusCode::Success;
+}
+
+StatusCode RuntimeGraph::Forward(const std::vector<std::shared_ptr<Operand<float>>> &inputs,
+                                 std::vector<std::shared_ptr<Operand<float>>> &outputs)
+{
+    return Run(inputs, outputs, nullptr, {});
+}
+
+StatusCode RuntimeGraph::Decode(const std::vector<std::shared_ptr<Operand<float>>> &inputs,
+                                const std::vector<int64_t> &sequences, KVCache &cache,
+                                std::vector<std::shared_ptr<Operand<float>>> &outputs)
+{
+    for (const auto &input : inputs)
+    {
+        if (input == nullptr || input->data.size() != sequences.size())
+        {
+            LOG(ERROR) << "Decode of " << sequences.size() << " sequences needs as many samples in every input";
+            return StatusCode::InferInputsEmpty;
+        }
+    }
+    for (int64_t sequence : sequences)
+    {
+        if (!cache.HasSequence(sequence))
+        {
+            LOG(ERROR) << "KV cache has no sequence " << sequence;
+            return StatusCode::InferParamError;
+        }
+    }
+    return Run(inputs, outputs, &cache, sequences);
+}
+
+StatusCode RuntimeGraph::Run(const std::vector<std::shared_ptr<Operand<float>>> &inputs,
+                             std::vector<std::shared_ptr<Operand<float>>> &outputs, KVCache *cache,
+                             const std::vector<int64_t> &sequences)
+{
+    std::shared_ptr<const ExecutionPlan> plan;
+    StatusCode status = PlanInputs(inputs, plan);
+    if (status != StatusCode::Success)
+    {
+        return status;
+    }
+
+    std::lock_guard<std::mutex> lock(forward_mutex_);
+    if (arena_.size() * sizeof(float) < plan->arena_size)
+    {
+        arena_.resize(plan->arena_size / sizeof(float));
+    }
+
+    std::vector<std::vector<std::shared_ptr<Tensor<float>>>> values;
+    BindValues(inputs, *plan, arena_.data(), values);
+    status = RunOperators(*plan, values, 0, graph_->ops.size(), cache, sequences);
+    if (status != StatusCode::Success)
+    {
+        return status;
+    }
+    CollectOutputs(*plan, values, outputs);
+    return StatusCode::Success;
+}
+
+StatusCode RuntimeGraph::BeginFrame(const std::vector<std::shared_ptr<Operand<float>>> &inputs, Frame &frame)
+{
+    StatusCode status = PlanInputs(inputs, frame.plan);
+    if (status != StatusCode::Success)
+    {
+        return status;
+    }
+    if (frame.arena.size() * sizeof(float) < frame.plan->arena_size)
+    {
+        frame.arena.resize(frame.plan->arena_size / sizeof(float));
+    }
+    BindValues(inputs, *frame.plan, frame.arena.data(), frame.values);
+    return StatusCode::Success;
+}
+
+StatusCode RuntimeGraph::RunFrame(Frame &frame, size_t begin, size_t end)
+{
+    CHECK(frame.plan != nullptr) << "Frame has not begun";
+    CHECK_LE(begin, end);
+    CHECK_LE(end, graph_->ops.size());
+    return RunOperators(*frame.plan, frame.values, begin, end, nullptr, {});
+}
+
+void RuntimeGraph::EndFrame(Frame &frame, std::vector<std::shared_ptr<Operand<float>>> &outputs)
+{
+    CHECK(frame.plan != nullptr) << "Frame has not begun";
+    CollectOutputs(*frame.plan, frame.values, outputs);
+    frame.values.clear();
+    frame.plan.reset();
+}
+
+StatusCode RuntimeGraph::PlanInputs(const std::vector<std::shared_ptr<Operand<float>>> &inputs,
+                                    std::shared_ptr<const ExecutionPlan> &plan)
+{
+    CHECK(graph_ != nullptr) << "Runtime graph is not initialized";
+
+    const std::vector<const pnnx::Operator *> &input_ops = inference_->input_operators();
+    if (inputs.size() != input_ops.size())
+    {
+        LOG(ERROR) << "Graph has " << input_ops.size() << " inputs but got " << inputs.size();
+        return StatusCode::InferInputsEmpty;
+    }
+
+    std::vector<Shape> input_shapes;
+    for (const auto &input : inputs)
+    {
+        if (input == nullptr || input->data.empty() || input->shapes.empty()
+            || input->data.size() != static_cast<size_t>(input->shapes[0]))
+        {
+            LOG(ERROR) << "Input operand is empty or its batch does not match the shape";
+            return StatusCode::InferInputsEmpty;
+        }
+        input_shapes.push_back(input->shapes);
+    }
+    return Plan(input_shapes, plan);
+}
+
+void RuntimeGraph::BindValues(const std::vector<std::shared_ptr<Operand<float>>> &inputs, const ExecutionPlan &plan,
+                              float *arena, std::vector<std::vector<std::shared_ptr<Tensor<float>>>> &values)
+{
+    const std::vector<const pnnx::Operator *> &input_ops = inference_->input_operators();
+    values.assign(graph_->operands.size(), {});
+    for (size_t i = 0; i < input_ops.size(); ++i)
+    {
+        values[inference_->operand_index(input_ops[i]->outputs[0])] = inputs[i]->data;
+    }
+
+    for (size_t i = 0; i < graph_->operands.size(); ++i)
+    {
+        if (!values[i].empty() || plan.alias_roots[i] >= 0)
+        {
+            continue;
+        }
+        if (constants_[i] != nullptr)
+        {
+            values[i].push_back(constants_[i]);
+            continue;
+        }
+
+        const Shape &shape = plan.shapes[i];
+        const std::vector<uint32_t> sample_shape = SampleShape(shape);
+        const uint32_t batch_size = BatchSize(shape);
+        const size_t sample_count = std::accumulate(sample_shape.begin(), sample_shape.end(), size_t(1), std::multiplies<size_t>());
+        for (uint32_t b = 0; b < batch_size; ++b)
+        {
+            if (plan.offsets[i] >= 0)
+            {
+                float *ptr = arena + plan.offsets[i] / sizeof(float) + b * sample_count;
+                values[i].push_back(std::make_shared<Tensor<float>>(ptr, sample_shape));
+            }
+            else
+            {
+                values[i].push_back(std::make_shared<Tensor<float>>(sample_shape));
+            }
+        }
+    }
+
+    // producers of cat inputs write into the slices of the cat output, in place
+    // operators and views into the storage of their input
+    for (size_t i = 0; i < graph_->operands.size(); ++i)
+    {
+        const int root = plan.alias_roots[i];
+        if (root < 0)
+        {
+            continue;
+        }
+        const std::vector<uint32_t> sample_shape = SampleShape(plan.shapes[i]);
+        for (const std::shared_ptr<Tensor<float>> &sample : values[root])
+        {
+            values[i].push_back(std::make_shared<Tensor<float>>(sample->data_ptr(plan.alias_offsets[i]), sample_shape));
+        }
+    }
+}
+
+StatusCode RuntimeGraph::RunOperators(const ExecutionPlan &plan,
+                                      std::vector<std::vector<std::shared_ptr<Tensor<float>>>> &values, size_t begin,
+                                      size_t end, KVCache *cache, const std::vector<int64_t> &sequences)
+{
+    CHECK(cache == nullptr || begin == 0) << "Decode runs every operator at once";
+
+    std::vector<std::shared_ptr<Tensor<float>>> op_inputs;
+    std::vector<std::shared_ptr<Tensor<float>>> op_outputs;
+    // attention operators in graph order are the layers of the KV cache
+    int cache_layer = 0;
+    StatusCode status = StatusCode::Success;
+    for (size_t i = begin; i < end; ++i)
+    {
+        const pnnx::Operator *op = graph_->ops[i];
+        if (op->type == "pnnx.Input" || op->type == "pnnx.Output" || op->type == "pnnx.Attribute")
+        {
+            continue;
+        }
+
+        op_inputs.clear();
+        op_outputs.clear();
+        for (const pnnx::Operand *operand : op->outputs)
+        {
+            const auto &v = values[inference_->operand_index(operand)];
+            op_outputs.insert(op_outputs.end(), v.begin(), v.end());
+        }
+        // a constant is shared by every sample of the batch
+        const size_t batch_size = op->outputs.empty() ? 1 : values[inference_->operand_index(op->outputs[0])].size();
+        for (const pnnx::Operand *operand : op->inputs)
+        {
+            const int index = inference_->operand_index(operand);
+            const auto &v = values[index];
+            if (constants_[index] != nullptr && batch_size > 1)
+            {
+                op_inputs.insert(op_inputs.end(), batch_size, v[0]);
+                continue;
+            }
+            op_inputs.insert(op_inputs.end(), v.begin(), v.end());
+        }
+
+        std::shared_ptr<layer::Layer<float>> layer = FindLayer(i, plan.kernels[i]);
+        if (cache != nullptr && op->type == "F.scaled_dot_product_attention")
+        {
+            auto *attention = dynamic_cast<layer::AttentionLayer *>(layer.get());
+            CHECK(attention != nullptr) << "Attention " << op->name << " runs kernel " << plan.kernels[i];
+            status = attention->Decode(op_inputs, op_outputs, *cache, cache_layer++, sequences);
+        }
+        else
+        {
+            status = layer->Forward(op_inputs, op_outputs);
+        }
+        if (status != StatusCode::Success)
+        {
+            LOG(ERROR) << "Forward of " << op->type << " " << op->name << " failed with status " << static_cast<int>(status);
+            return status;
+        }
+    }
+    return StatusCode::Success;
+}
+
+void RuntimeGraph::CollectOutputs(const ExecutionPlan &plan,
+                                  const std::vector<std::vector<std::shared_ptr<Tensor<float>>>> &values,
+                                  std::vector<std::shared_ptr<Operand<float>>> &outputs)
+{
+    outputs.clear();
+    for (const pnnx::Operator *op : inference_->output_operators())
+    {
+        for (const pnnx::Operand *operand : op->inputs)
+        {
+            const int index = inference_->operand_index(operand);
+            outputs.push_back(std::make_shared<Operand<float>>(operand->name, plan.shapes[index], values[index],
+                                                               AttributeType::Float32));
+        }
+    }
+}
+
+const pnnx::Graph &RuntimeGraph::graph() const
+{
+    CHECK(graph_ != nullptr) << "Runtime graph is not initialized";
+    return *graph_;
+}
+
+const std::vector<std::shared_ptr<Operator<float>>> &RuntimeGraph::operators() const
+{
+    return operators_;
+}
+
+const PlanCache &RuntimeGraph::plan_cache() const
+{
+    return plan_cache_;
+}
+
+} // namespace runtime
+} // namespace jennifer
@@ -0,0 +1,128 @@
+#ifndef JENNIFER_RUNTIME_RUNTIME_GRAPH_HPP
+#define JENNIFER_RUNTIME_RUNTIME_GRAPH_HPP
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "jennifer/layer/layer.hpp"
+#include "jennifer/runtime/pnnx/ir.h"
+#include "jennifer/utils/common.hpp"
+#include "jennifer/utils/huge_pages.hpp"
+
+#include "execution_plan.hpp"
+#include "kv_cache.hpp"
+#include "operand.hpp"
+#include "operator.hpp"
+#include "shape_inference.hpp"
+
+namespace jennifer
+{
+namespace runtime
+{
+
+class RuntimeGraph
+{
+public:
+    RuntimeGraph();
+    RuntimeGraph(std::string param_path, std::string bin_path);
+
+    RuntimeGraph(const RuntimeGraph &) = delete;
+    RuntimeGraph &operator=(const RuntimeGraph &) = delete;
+
+    bool Init();
+    bool Init(std::unique_ptr<pnnx::Graph> graph);
+
+    // inputs follow the order of the pnnx.Input operators and outputs the order of
+    // the pnnx.Output operators, the leading shape dim is the batch (Operand::data)
+    utils::StatusCode Forward(const std::vector<std::shared_ptr<Operand<float>>> &inputs,
+                              std::vector<std::shared_ptr<Operand<float>>> &outputs);
+
+    // One incremental step of a decoder graph. The inputs hold only the new
+    // positions, sample b continues sequences[b] of cache: every
+    // F.scaled_dot_product_attention appends its key and value rows to its layer of
+    // the cache and attends causally over all rows cached for the sequence, so a
+    // step costs the new tokens instead of the whole prefix.
+    utils::StatusCode Decode(const std::vector<std::shared_ptr<Operand<float>>> &inputs,
+                             const std::vector<int64_t> &sequences, KVCache &cache,
+                             std::vector<std::shared_ptr<Operand<float>>> &outputs);
+
+    // Storage of one forward pass, which lets a pass run as ranges of operators on
+    // different threads like Pipeline does. Every frame owns its arena, so frames in
+    // flight never share intermediates, but an operator must not run for two frames
+    // at once and frames must not overlap Forward or Decode.
+    struct Frame
+    {
+        std::shared_ptr<const ExecutionPlan> plan;
+        utils::HugeVector<float> arena;
+        std::vector<std::vector<std::shared_ptr<Tensor<float>>>> values;
+    }; // struct Frame
+
+    // plans the pass for inputs and binds its operands to the arena of frame
+    utils::StatusCode BeginFrame(const std::vector<std::shared_ptr<Operand<float>>> &inputs, Frame &frame);
+
+    // runs graph operators [begin, end) of the frame, earlier ones must have run
+    utils::StatusCode RunFrame(Frame &frame, size_t begin, size_t end);
+
+    // outputs of a frame whose operators all ran, the frame keeps its arena for the next BeginFrame
+    void EndFrame(Frame &frame, std::vector<std::shared_ptr<Operand<float>>> &outputs);
+
+    // returns the cached plan for these input shapes, planning it on the first call
+    utils::StatusCode Plan(const std::vector<Shape> &input_shapes, std::shared_ptr<const ExecutionPlan> &plan);
+
+    const pnnx::Graph &graph() const;
+    const std::vector<std::shared_ptr<Operator<float>>> &operators() const;
+    const PlanCache &plan_cache() const;
+
+private:
+    // Forward without a cache, Decode with one
+    utils::StatusCode Run(const std::vector<std::shared_ptr<Operand<float>>> &inputs,
+                          std::vector<std::shared_ptr<Operand<float>>> &outputs, KVCache *cache,
+                          const std::vector<int64_t> &sequences);
+
+    // checks the inputs and looks up or builds their plan
+    utils::StatusCode PlanInputs(const std::vector<std::shared_ptr<Operand<float>>> &inputs,
+                                 std::shared_ptr<const ExecutionPlan> &plan);
+
+    // one tensor per sample for every operand, intermediates placed in arena
+    void BindValues(const std::vector<std::shared_ptr<Operand<float>>> &inputs, const ExecutionPlan &plan, float *arena,
+                    std::vector<std::vector<std::shared_ptr<Tensor<float>>>> &values);
+
+    utils::StatusCode RunOperators(const ExecutionPlan &plan,
+                                   std::vector<std::vector<std::shared_ptr<Tensor<float>>>> &values, size_t begin,
+                                   size_t end, KVCache *cache, const std::vector<int64_t> &sequences);
+
+    void CollectOutputs(const ExecutionPlan &plan,
+                        const std::vector<std::vector<std::shared_ptr<Tensor<float>>>> &values,
+                        std::vector<std::shared_ptr<Operand<float>>> &outputs);
+
+    void InitOperators();
+    void InitConstants();
+
+    std::shared_ptr<layer::Layer<float>> FindLayer(int op_index, const std::string &kernel);
+
+    std::string param_path_;
+    std::string bin_path_;
+
+    std::unique_ptr<pnnx::Graph> graph_;
+    std::unique_ptr<ShapeInference> inference_;
+
+    std::vector<std::shared_ptr<Operator<float>>> operators_;
+    std::vector<std::shared_ptr<Tensor<float>>> constants_;
+
+    PlanCache plan_cache_;
+
+    std::mutex layer_mutex_;
+    std::map<std::pair<int, std::string>, std::shared_ptr<layer::Layer<float>>> layers_;
+
+    std::mutex forward_mutex_;
+    utils::HugeVector<float> arena_;
+}; // class RuntimeGraph
+
+} // namespace runtime
+} // namespace jennifer
+
+#endif // JENNIFER_RUNTIME_RUNTIME_GRAPH_HPP
@@ -0,0 +1,1308 @@
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <numeric>
+
+#include "shape_inference.hpp"
+
+namespace jennifer
+{
+namespace runtime
+{
+
+using utils::StatusCode;
+
+// -1 for a dim outside [-rank, rank)
+static int32_t NormalizeDim(int32_t dim, int32_t rank)
+{
+    if (dim < -rank || dim >= rank)
+    {
+        return -1;
+    }
+    return dim < 0 ? dim + rank : dim;
+}
+
+static const pnnx::Parameter *FindParam(const pnnx::Operator *op, const std::string &key)
+{
+    auto it = op->params.find(key);
+    return it == op->params.end() ? nullptr : &it->second;
+}
+
+// int or int array parameter expanded to n values, pnnx writes both forms
+static bool GetInts(const pnnx::Operator *op, const std::string &key, size_t n, std::vector<int32_t> &values)
+{
+    const pnnx::Parameter *p = FindParam(op, key);
+    if (!p)
+    {
+        return false;
+    }
+    if (p->type == 2)
+    {
+        values.assign(n, p->i);
+        return true;
+    }
+    if (p->type == 5 && !p->ai.empty())
+    {
+        values = p->ai;
+        if (values.size() == 1 && n > 1)
+        {
+            values.assign(n, values[0]);
+        }
+        return values.size() == n;
+    }
+    return false;
+}
+
+static bool Broadcast(const std::vector<Shape> &shapes, Shape &output)
+{
+    size_t rank = 0;
+    for (const Shape &s : shapes)
+    {
+        rank = std::max(rank, s.size());
+    }
+
+    output.assign(rank, 1);
+    for (const Shape &s : shapes)
+    {
+        const size_t offset = rank - s.size();
+        for (size_t i = 0; i < s.size(); ++i)
+        {
+            int32_t &d = output[offset + i];
+            if (s[i] == d || s[i] == 1)
+            {
+                continue;
+            }
+            if (d != 1)
+            {
+                return false;
+            }
+            d = s[i];
+        }
+    }
+    return true;
+}
+
+static StatusCode IdentityShape(const pnnx::Operator *op, const std::vector<Shape> &inputs, std::vector<Shape> &outputs)
+{
+    if (inputs.empty())
+    {
+        return StatusCode::InferInputsEmpty;
+    }
+    outputs.assign(op->outputs.size(), inputs[0]);
+    return StatusCode::Success;
+}
+
+static StatusCode BroadcastShape(const pnnx::Operator *op, const std::vector<Shape> &inputs, std::vector<Shape> &outputs)
+{
+    if (inputs.empty())
+    {
+        return StatusCode::InferInputsEmpty;
+    }
+
+    Shape output;
+    if (!Broadcast(inputs, output))
+    {
+        LOG(ERROR) << "Operator " << op->name << " inputs can not be broadcast";
+        return StatusCode::InferDimMismatch;
+    }
+    outputs.assign(op->outputs.size(), output);
+    return StatusCode::Success;
+}
+
+static StatusCode ConvShape(const pnnx::Operator *op, const std::vector<Shape> &inputs, std::vector<Shape> &outputs)
+{
+    if (inputs.empty())
+    {
+        return StatusCode::InferInputsEmpty;
+    }
+
+    const Shape &input = inputs[0];
+    if (input.size() < 3)
+    {
+        return StatusCode::InferDimMismatch;
+    }
+    const size_t spatial = input.size() - 2;
+    const bool transposed = op->type.find("ConvTranspose") != std::string::npos;
+
+    std::vector<int32_t> kernel;
+    int32_t out_channels = 0;
+    if (const pnnx::Parameter *p = FindParam(op, "out_channels"))
+    {
+        out_channels = p->i;
+        if (!GetInts(op, "kernel_size", spatial, kernel))
+        {
+            return StatusCode::InferParamError;
+        }
+    }
+    else
+    {
+        // functional form, the weight is the second input
+        if (inputs.size() < 2 || inputs[1].size() != spatial + 2)
+        {
+            return StatusCode::InferParamError;
+        }
+        out_channels = inputs[1][0];
+        if (transposed)
+        {
+            int32_t groups = 1;
+            if (const pnnx::Parameter *g = FindParam(op, "groups"))
+            {
+                groups = g->i;
+            }
+            out_channels = inputs[1][1] * groups;
+        }
+        kernel.assign(inputs[1].begin() + 2, inputs[1].end());
+    }
+
+    std::vector<int32_t> stride(spatial, 1);
+    std::vector<int32_t> dilation(spatial, 1);
+    std::vector<int32_t> padding(spatial, 0);
+    std::vector<int32_t> output_padding(spatial, 0);
+    GetInts(op, "stride", spatial, stride);
+    GetInts(op, "dilation", spatial, dilation);
+    GetInts(op, "output_padding", spatial, output_padding);
+
+    bool same_padding = false;
+    if (const pnnx::Parameter *p = FindParam(op, "padding"))
+    {
+        if (p->type == 4)
+        {
+            same_padding = p->s == "same";
+        }
+        else if (!GetInts(op, "padding", spatial, padding))
+        {
+            return StatusCode::InferParamError;
+        }
+    }
+
+    Shape output(input.begin(), input.begin() + 2);
+    output[1] = out_channels;
+    for (size_t i = 0; i < spatial; ++i)
+    {
+        const int32_t in = input[i + 2];
+        const int32_t extent = dilation[i] * (kernel[i] - 1) + 1;
+        int32_t out = 0;
+        if (transposed)
+        {
+            out = (in - 1) * stride[i] - 2 * padding[i] + extent + output_padding[i];
+        }
+        else if (same_padding)
+        {
+            out = in;
+        }
+        else
+        {
+            out = (in + 2 * padding[i] - extent) / stride[i] + 1;
+        }
+        if (out <= 0)
+        {
+            LOG(ERROR) << "Operator " << op->name << " produces an empty output";
+            return StatusCode::InferDimMismatch;
+        }
+        output.push_back(out);
+    }
+
+    outputs.assign(op->outputs.size(), output);
+    return StatusCode::Success;
+}
+
+static StatusCode PoolShape(const pnnx::Operator *op, const std::vector<Shape> &inputs, std::vector<Shape> &outputs)
+{
+    if (inputs.empty())
+    {
+        return StatusCode::InferInputsEmpty;
+    }
+
+    const Shape &input = inputs[0];
+    const size_t spatial = op->type.find("1d") != std::string::npos ? 1 : op->type.find("3d") != std::string::npos ? 3 : 2;
+    if (input.size() < spatial + 1)
+    {
+        return StatusCode::InferDimMismatch;
+    }
+
+    std::vector<int32_t> kernel;
+    if (!GetInts(op, "kernel_size", spatial, kernel))
+    {
+        return StatusCode::InferParamError;
+    }
+    std::vector<int32_t> stride = kernel;
+    std::vector<int32_t> padding(spatial, 0);
+    std::vector<int32_t> dilation(spatial, 1);
+    GetInts(op, "stride", spatial, stride);
+    GetInts(op, "padding", spatial, padding);
+    GetInts(op, "dilation", spatial, dilation);
+
+    bool ceil_mode = false;
+    if (const pnnx::Parameter *p = FindParam(op, "ceil_mode"))
+    {
+        ceil_mode = p->b;
+    }
+
+    Shape output(input.begin(), input.end() - spatial);
+    for (size_t i = 0; i < spatial; ++i)
+    {
+        const int32_t in = input[input.size() - spatial + i];
+        const int32_t extent = dilation[i] * (kernel[i] - 1) + 1;
+        const int32_t span = in + 2 * padding[i] - extent;
+        int32_t out = (ceil_mode ? (span + stride[i] - 1) / stride[i] : span / stride[i]) + 1;
+        // the last window must start inside the input or the left padding
+        if (ceil_mode && (out - 1) * stride[i] >= in + padding[i])
+        {
+            out -= 1;
+        }
+        if (out <= 0)
+        {
+            return StatusCode::InferDimMismatch;
+        }
+        output.push_back(out);
+    }
+
+    outputs.assign(op->outputs.size(), output);
+    return StatusCode::Success;
+}
+
+static StatusCode AdaptivePoolShape(const pnnx::Operator *op, const std::vector<Shape> &inputs, std::vector<Shape> &outputs)
+{
+    if (inputs.empty())
+    {
+        return StatusCode::InferInputsEmpty;
+    }
+
+    const Shape &input = inputs[0];
+    const size_t spatial = op->type.find("1d") != std::string::npos ? 1 : op->type.find("3d") != std::string::npos ? 3 : 2;
+    std::vector<int32_t> output_size;
+    if (input.size() < spatial || !GetInts(op, "output_size", spatial, output_size))
+    {
+        return StatusCode::InferParamError;
+    }
+
+    Shape output = input;
+    for (size_t i = 0; i < spatial; ++i)
+    {
+        // 0 is the exported form of None, which keeps the input size
+        if (output_size[i] != 0)
+        {
+            output[input.size() - spatial + i] = output_size[i];
+        }
+    }
+
+    outputs.assign(op->outputs.size(), output);
+    return StatusCode::Success;
+}
+
+static StatusCode LinearShape(const pnnx::Operator *op, const std::vector<Shape> &inputs, std::vector<Shape> &outputs)
+{
+    if (inputs.empty() || inputs[0].empty())
+    {
+        return StatusCode::InferInputsEmpty;
+    }
+
+    Shape output = inputs[0];
+    if (const pnnx::Parameter *p = FindParam(op, "out_features"))
+    {
+        output.back() = p->i;
+    }
+    else if (inputs.size() >= 2 && inputs[1].size() == 2)
+    {
+        output.back() = inputs[1][0];
+    }
+    else
+    {
+        return StatusCode::InferParamError;
+    }
+
+    outputs.assign(op->outputs.size(), output);
+    return StatusCode::Success;
+}
+
+static StatusCode FlattenShape(const pnnx::Operator *op, const std::vector<Shape> &inputs, std::vector<Shape> &outputs)
+{
+    if (inputs.empty())
+    {
+        return StatusCode::InferInputsEmpty;
+    }
+
+    const Shape &input = inputs[0];
+    const int32_t rank = input.size();
+    int32_t start_dim = 0;
+    int32_t end_dim = -1;
+    if (const pnnx::Parameter *p = FindParam(op, "start_dim"))
+    {
+        start_dim = p->i;
+    }
+    if (const pnnx::Parameter *p = FindParam(op, "end_dim"))
+    {
+        end_dim = p->i;
+    }
+    if (op->type == "nn.Flatten" && !FindParam(op, "start_dim"))
+    {
+        start_dim = 1;
+    }
+    start_dim = NormalizeDim(start_dim, rank);
+    end_dim = NormalizeDim(end_dim, rank);
+    if (rank == 0)
+    {
+        outputs.assign(op->outputs.size(), Shape{1});
+        return StatusCode::Success;
+    }
+    if (start_dim < 0 || end_dim < 0 || start_dim > end_dim)
+    {
+        return StatusCode::InferParamError;
+    }
+
+    Shape output(input.begin(), input.begin() + start_dim);
+    output.push_back(std::accumulate(input.begin() + start_dim, input.begin() + end_dim + 1, 1, std::multiplies<int32_t>()));
+    output.insert(output.end(), input.begin() + end_dim + 1, input.end());
+
+    outputs.assign(op->outputs.size(), output);
+    return StatusCode::Success;
+}
+
+static StatusCode ReshapeShape(const pnnx::Operator *op, const std::vector<Shape> &inputs, std::vector<Shape> &outputs)
+{
+    const pnnx::Parameter *p = FindParam(op, "shape");
+    if (inputs.empty() || !p || p->type != 5)
+    {
+        // the target shape is computed at runtime
+        return StatusCode::FunctionNotImplement;
+    }
+
+    const int64_t count = std::accumulate(inputs[0].begin(), inputs[0].end(), int64_t(1), std::multiplies<int64_t>());
+    Shape output = p->ai;
+    int64_t known = 1;
+    int inferred = -1;
+    for (size_t i = 0; i < output.size(); ++i)
+    {
+        if (output[i] == -1)
+        {
+            if (inferred != -1)
+            {
+                return StatusCode::InferParamError;
+            }
+            inferred = i;
+        }
+        else
+        {
+            known *= output[i];
+        }
+    }
+    if (inferred != -1)
+    {
+        if (known == 0 || count % known != 0)
+        {
+            return StatusCode::InferDimMismatch;
+        }
+        output[inferred] = count / known;
+    }
+    else if (known != count)
+    {
+        return StatusCode::InferDimMismatch;
+    }
+
+    outputs.assign(op->outputs.size(), output);
+    return StatusCode::Success;
+}
+
+static StatusCode ConcatShape(const pnnx::Operator *op, const std::vector<Shape> &inputs, std::vector<Shape> &outputs)
+{
+    if (inputs.empty())
+    {
+        return StatusCode::InferInputsEmpty;
+    }
+
+    const pnnx::Parameter *p = FindParam(op, "dim");
+    const int32_t rank = inputs[0].size();
+    const int32_t dim = NormalizeDim(p ? p->i : 0, rank);
+    if (dim < 0 || dim >= rank)
+    {
+        return StatusCode::InferParamError;
+    }
+
+    Shape output = inputs[0];
+    for (size_t i = 1; i < inputs.size(); ++i)
+    {
+        if (inputs[i].size() != output.size())
+        {
+            return StatusCode::InferDimMismatch;
+        }
+        for (int32_t j = 0; j < rank; ++j)
+        {
+            if (j != dim && inputs[i][j] != output[j])
+            {
+                LOG(ERROR) << "Operator " << op->name << " concat inputs mismatch at dim " << j;
+                return StatusCode::InferDimMismatch;
+            }
+        }
+        output[dim] += inputs[i][dim];
+    }
+
+    outputs.assign(op->outputs.size(), output);
+    return StatusCode::Success;
+}
+
+static StatusCode StackShape(const pnnx::Operator *op, const std::vector<Shape> &inputs, std::vector<Shape> &outputs)
+{
+    if (inputs.empty())
+    {
+        return StatusCode::InferInputsEmpty;
+    }
+
+    const pnnx::Parameter *p = FindParam(op, "dim");
+    const int32_t rank = inputs[0].size() + 1;
+    const int32_t dim = NormalizeDim(p ? p->i : 0, rank);
+    if (dim < 0)
+    {
+        return StatusCode::InferParamError;
+    }
+    for (const Shape &s : inputs)
+    {
+        if (s != inputs[0])
+        {
+            return StatusCode::InferDimMismatch;
+        }
+    }
+
+    Shape output = inputs[0];
+    output.insert(output.begin() + dim, static_cast<int32_t>(inputs.size()));
+    outputs.assign(op->outputs.size(), output);
+    return StatusCode::Success;
+}
+
+static StatusCode PermuteShape(const pnnx::Operator *op, const std::vector<Shape> &inputs, std::vector<Shape> &outputs)
+{
+    const pnnx::Parameter *p = FindParam(op, "dims");
+    if (inputs.empty() || !p || p->ai.size() != inputs[0].size())
+    {
+        return StatusCode::InferParamError;
+    }
+
+    const int32_t rank = inputs[0].size();
+    Shape output(rank);
+    std::vector<bool> used(rank, false);
+    for (int32_t i = 0; i < rank; ++i)
+    {
+        const int32_t d = NormalizeDim(p->ai[i], rank);
+        if (d < 0 || used[d])
+        {
+            return StatusCode::InferParamError;
+        }
+        used[d] = true;
+        output[i] = inputs[0][d];
+    }
+    outputs.assign(op->outputs.size(), output);
+    return StatusCode::Success;
+}
+
+static StatusCode TransposeShape(const pnnx::Operator *op, const std::vector<Shape> &inputs, std::vector<Shape> &outputs)
+{
+    const pnnx::Parameter *dim0 = FindParam(op, "dim0");
+    const pnnx::Parameter *dim1 = FindParam(op, "dim1");
+    if (inputs.empty() || !dim0 || !dim1)
+    {
+        return StatusCode::InferParamError;
+    }
+
+    const int32_t rank = inputs[0].size();
+    const int32_t d0 = NormalizeDim(dim0->i, rank);
+    const int32_t d1 = NormalizeDim(dim1->i, rank);
+    if (d0 < 0 || d1 < 0)
+    {
+        return StatusCode::InferParamError;
+    }
+    Shape output = inputs[0];
+    std::swap(output[d0], output[d1]);
+    outputs.assign(op->outputs.size(), output);
+    return StatusCode::Success;
+}
+
+static StatusCode SqueezeShape(const pnnx::Operator *op, const std::vector<Shape> &inputs, std::vector<Shape> &outputs)
+{
+    if (inputs.empty())
+    {
+        return StatusCode::InferInputsEmpty;
+    }
+
+    const Shape &input = inputs[0];
+    const int32_t rank = input.size();
+    std::vector<int32_t> dims;
+    if (const pnnx::Parameter *p = FindParam(op, "dim"))
+    {
+        dims = p->type == 5 ? p->ai : std::vector<int32_t>{p->i};
+    }
+
+    Shape output;
+    for (int32_t i = 0; i < rank; ++i)
+    {
+        bool squeeze = input[i] == 1;
+        if (squeeze && !dims.empty())
+        {
+            squeeze = std::find_if(dims.begin(), dims.end(), [&](int32_t d) { return NormalizeDim(d, rank) == i; }) != dims.end();
+        }
+        if (!squeeze)
+        {
+            output.push_back(input[i]);
+        }
+    }
+    outputs.assign(op->outputs.size(), output);
+    return StatusCode::Success;
+}
+
+static StatusCode UnsqueezeShape(const pnnx::Operator *op, const std::vector<Shape> &inputs, std::vector<Shape> &outputs)
+{
+    const pnnx::Parameter *p = FindParam(op, "dim");
+    if (inputs.empty() || !p)
+    {
+        return StatusCode::InferParamError;
+    }
+
+    Shape output = inputs[0];
+    const int32_t dim = NormalizeDim(p->i, output.size() + 1);
+    if (dim < 0 || dim > static_cast<int32_t>(output.size()))
+    {
+        return StatusCode::InferParamError;
+    }
+    output.insert(output.begin() + dim, 1);
+    outputs.assign(op->outputs.size(), output);
+    return StatusCode::Success;
+}
+
+static StatusCode InterpolateShape(const pnnx::Operator *op, const std::vector<Shape> &inputs, std::vector<Shape> &outputs)
+{
+    if (inputs.empty() || inputs[0].size() < 3)
+    {
+        return StatusCode::InferInputsEmpty;
+    }
+
+    const Shape &input = inputs[0];
+    const size_t spatial = input.size() - 2;
+    Shape output = input;
+
+    std::vector<int32_t> size;
+    const pnnx::Parameter *scale = FindParam(op, "scale_factor");
+    if (GetInts(op, "size", spatial, size))
+    {
+        std::copy(size.begin(), size.end(), output.begin() + 2);
+    }
+    else if (scale && (scale->type == 3 || scale->type == 6 || scale->type == 2 || scale->type == 5))
+    {
+        for (size_t i = 0; i < spatial; ++i)
+        {
+            float s = 1.f;
+            if (scale->type == 3) s = scale->f;
+            if (scale->type == 2) s = scale->i;
+            if (scale->type == 6) s = scale->af.size() == 1 ? scale->af[0] : scale->af.at(i);
+            if (scale->type == 5) s = scale->ai.size() == 1 ? scale->ai[0] : scale->ai.at(i);
+            output[i + 2] = static_cast<int32_t>(std::floor(input[i + 2] * s));
+        }
+    }
+    else
+    {
+        return StatusCode::FunctionNotImplement;
+    }
+
+    outputs.assign(op->outputs.size(), output);
+    return StatusCode::Success;
+}
+
+static StatusCode PixelShuffleShape(const pnnx::Operator *op, const std::vector<Shape> &inputs, std::vector<Shape> &outputs)
+{
+    if (inputs.empty() || inputs[0].size() < 3)
+    {
+        return StatusCode::InferInputsEmpty;
+    }
+
+    Shape output = inputs[0];
+    const size_t rank = output.size();
+    if (const pnnx::Parameter *p = FindParam(op, "upscale_factor"))
+    {
+        const int32_t r = p->i;
+        if (output[rank - 3] % (r * r) != 0)
+        {
+            return StatusCode::InferDimMismatch;
+        }
+        output[rank - 3] /= r * r;
+        output[rank - 2] *= r;
+        output[rank - 1] *= r;
+    }
+    else if (const pnnx::Parameter *p = FindParam(op, "downscale_factor"))
+    {
+        const int32_t r = p->i;
+        if (output[rank - 2] % r != 0 || output[rank - 1] % r != 0)
+        {
+            return StatusCode::InferDimMismatch;
+        }
+        output[rank - 3] *= r * r;
+        output[rank - 2] /= r;
+        output[rank - 1] /= r;
+    }
+    else
+    {
+        return StatusCode::InferParamError;
+    }
+
+    outputs.assign(op->outputs.size(), output);
+    return StatusCode::Success;
+}
+
+static StatusCode ReduceShape(const pnnx::Operator *op, const std::vector<Shape> &inputs, std::vector<Shape> &outputs)
+{
+    if (inputs.empty())
+    {
+        return StatusCode::InferInputsEmpty;
+    }
+
+    const Shape &input = inputs[0];
+    const int32_t rank = input.size();
+    bool keepdim = false;
+    if (const pnnx::Parameter *p = FindParam(op, "keepdim"))
+    {
+        keepdim = p->b;
+    }
+
+    std::vector<bool> reduced(rank, false);
+    const pnnx::Parameter *dim = FindParam(op, "dim");
+    if (!dim || dim->type == 0)
+    {
+        std::fill(reduced.begin(), reduced.end(), true);
+    }
+    else
+    {
+        const std::vector<int32_t> dims = dim->type == 2 ? std::vector<int32_t>{dim->i} : dim->ai;
+        for (int32_t d : dims)
+        {
+            const int32_t normalized = NormalizeDim(d, rank);
+            if (normalized < 0)
+            {
+                return StatusCode::InferParamError;
+            }
+            reduced[normalized] = true;
+        }
+    }
+
+    Shape output;
+    for (int32_t i = 0; i < rank; ++i)
+    {
+        if (!reduced[i])
+        {
+            output.push_back(input[i]);
+        }
+        else if (keepdim)
+        {
+            output.push_back(1);
+        }
+    }
+    outputs.assign(op->outputs.size(), output);
+    return StatusCode::Success;
+}
+
+static StatusCode SliceShape(const pnnx::Operator *op, const std::vector<Shape> &inputs, std::vector<Shape> &outputs)
+{
+    const pnnx::Parameter *dim = FindParam(op, "dim");
+    const pnnx::Parameter *start = FindParam(op, "start");
+    const pnnx::Parameter *end = FindParam(op, "end");
+    if (inputs.empty() || !dim || dim->type != 2 || !start || !end || start->type != 2 || end->type != 2)
+    {
+        // multi-dim or runtime computed slices
+        return StatusCode::FunctionNotImplement;
+    }
+
+    Shape output = inputs[0];
+    const int32_t rank = output.size();
+    const int32_t d = NormalizeDim(dim->i, rank);
+    int32_t step = 1;
+    if (const pnnx::Parameter *p = FindParam(op, "step"))
+    {
+        step = p->i;
+    }
+    if (d < 0 || step <= 0)
+    {
+        return StatusCode::InferParamError;
+    }
+    const int32_t size = output[d];
+
+    int32_t s = start->i < 0 ? std::max(start->i + size, 0) : std::min(start->i, size);
+    int32_t e = end->i == INT_MAX ? size : end->i < 0 ? std::max(end->i + size, 0) : std::min(end->i, size);
+    output[d] = e > s ? (e - s + step - 1) / step : 0;
+
+    outputs.assign(op->outputs.size(), output);
+    return StatusCode::Success;
+}
+
+static StatusCode ChunkShape(const pnnx::Operator *op, const std::vector<Shape> &inputs, std::vector<Shape> &outputs)
+{
+    const pnnx::Parameter *chunks = FindParam(op, "chunks");
+    const pnnx::Parameter *dim = FindParam(op, "dim");
+    if (inputs.empty() || !chunks || !dim)
+    {
+        return StatusCode::InferParamError;
+    }
+
+    const Shape &input = inputs[0];
+    const int32_t d = NormalizeDim(dim->i, input.size());
+    if (d < 0 || chunks->i <= 0)
+    {
+        return StatusCode::InferParamError;
+    }
+    const int32_t size = input[d];
+    const int32_t step = (size + chunks->i - 1) / chunks->i;
+
+    outputs.clear();
+    for (size_t i = 0; i < op->outputs.size(); ++i)
+    {
+        Shape output = input;
+        output[d] = std::max(std::min(step, size - static_cast<int32_t>(i) * step), 0);
+        outputs.push_back(output);
+    }
+    return StatusCode::Success;
+}
+
+static StatusCode MatmulShape(const pnnx::Operator *op, const std::vector<Shape> &inputs, std::vector<Shape> &outputs)
+{
+    if (inputs.size() < 2 || inputs[0].size() < 2 || inputs[1].size() < 2)
+    {
+        return StatusCode::FunctionNotImplement;
+    }
+
+    const Shape &a = inputs[0];
+    const Shape &b = inputs[1];
+    if (a.back() != b[b.size() - 2])
+    {
+        return StatusCode::InferDimMismatch;
+    }
+
+    Shape batch;
+    if (!Broadcast({Shape(a.begin(), a.end() - 2), Shape(b.begin(), b.end() - 2)}, batch))
+    {
+        return StatusCode::InferDimMismatch;
+    }
+    batch.push_back(a[a.size() - 2]);
+    batch.push_back(b.back());
+
+    outputs.assign(op->outputs.size(), batch);
+    return StatusCode::Success;
+}
+
+static StatusCode AttentionShape(const pnnx::Operator *op, const std::vector<Shape> &inputs, std::vector<Shape> &outputs)
+{
+    if (inputs.size() < 3 || inputs[0].empty() || inputs[2].empty())
+    {
+        return StatusCode::InferInputsEmpty;
+    }
+
+    Shape output = inputs[0];
+    output.back() = inputs[2].back();
+    outputs.assign(op->outputs.size(), output);
+    return StatusCode::Success;
+}
+
+static StatusCode EmbeddingShape(const pnnx::Operator *op, const std::vector<Shape> &inputs, std::vector<Shape> &outputs)
+{
+    const pnnx::Parameter *p = FindParam(op, "embedding_dim");
+    if (inputs.empty() || !p)
+    {
+        return StatusCode::InferParamError;
+    }
+
+    Shape output = inputs[0];
+    output.push_back(p->i);
+    outputs.assign(op->outputs.size(), output);
+    return StatusCode::Success;
+}
+
+static StatusCode AttributeShape(const pnnx::Operator *op, const std::vector<Shape> &/*inputs*/, std::vector<Shape> &outputs)
+{
+    if (op->attrs.empty())
+    {
+        return StatusCode::InferParamError;
+    }
+
+    outputs.assign(op->outputs.size(), op->attrs.begin()->second.shape);
+    return StatusCode::Success;
+}
+
+static StatusCode SizeShape(const pnnx::Operator *op, const std::vector<Shape> &inputs, std::vector<Shape> &outputs,
+                            std::vector<double> &values)
+{
+    std::vector<int32_t> dim;
+    if (inputs.empty() || op->outputs.size() != 1 || !GetInts(op, "dim", 1, dim))
+    {
+        return StatusCode::InferParamError;
+    }
+    const int32_t rank = static_cast<int32_t>(inputs[0].size());
+    const int32_t d = NormalizeDim(dim[0], rank);
+    if (d < 0 || d >= rank)
+    {
+        return StatusCode::InferDimMismatch;
+    }
+
+    values.assign(1, inputs[0][d]);
+    outputs.assign(1, Shape());
+    return StatusCode::Success;
+}
+
+// the param a reshape or interpolate takes from its second and later inputs when it
+// is not exported, nullptr for other types
+static const char *ValueParam(const std::string &type)
+{
+    if (type == "Tensor.view" || type == "Tensor.reshape" || type == "torch.reshape")
+    {
+        return "shape";
+    }
+    if (type == "F.interpolate" || type == "F.upsample")
+    {
+        return "size";
+    }
+    return nullptr;
+}
+
+static void RegisterBuiltinShapeFunctions(std::map<std::string, ShapeInference::ShapeFunction> &registry)
+{
+    const char *identity_types[] = {
+        "nn.ReLU", "F.relu", "nn.ReLU6", "F.relu6", "nn.LeakyReLU", "F.leaky_relu", "nn.PReLU", "F.prelu",
+        "nn.SiLU", "F.silu", "nn.Sigmoid", "F.sigmoid", "torch.sigmoid", "nn.Tanh", "F.tanh", "torch.tanh",
+        "nn.GELU", "F.gelu", "nn.ELU", "F.elu", "nn.Hardswish", "F.hardswish", "nn.Hardsigmoid",
+        "F.hardsigmoid", "nn.Mish", "F.mish", "nn.Softplus", "F.softplus", "nn.Hardtanh", "F.hardtanh",
+        "nn.Softmax", "F.softmax", "nn.LogSoftmax", "F.log_softmax", "nn.Dropout", "F.dropout",
+        "nn.Identity", "nn.BatchNorm1d", "nn.BatchNorm2d", "nn.BatchNorm3d", "F.batch_norm", "nn.LayerNorm",
+        "F.layer_norm", "nn.GroupNorm", "F.group_norm", "nn.InstanceNorm2d", "F.instance_norm",
+        "F.normalize", "torch.clamp", "torch.clone", "torch.abs", "torch.exp", "torch.log", "torch.sqrt",
+        "torch.rsqrt", "torch.neg", "torch.square", "Tensor.contiguous", "Tensor.to", "Tensor.type_as",
+        "Tensor.clone", "torch.cumsum", "nn.ChannelShuffle", "F.channel_shuffle",
+    };
+    for (const char *type : identity_types)
+    {
+        registry[type] = IdentityShape;
+    }
+
+    const char *broadcast_types[] = {
+        "torch.add", "torch.sub", "torch.mul", "torch.div", "torch.maximum", "torch.minimum", "torch.pow",
+        "torch.where", "torch.eq", "torch.ne", "torch.lt", "torch.gt", "torch.le", "torch.ge",
+        "jennifer.FusedElementwise",
+    };
+    for (const char *type : broadcast_types)
+    {
+        registry[type] = BroadcastShape;
+    }
+
+    const char *conv_types[] = {
+        "nn.Conv1d", "nn.Conv2d", "nn.Conv3d", "F.conv1d", "F.conv2d", "F.conv3d",
+        "nn.ConvTranspose1d", "nn.ConvTranspose2d", "nn.ConvTranspose3d", "F.conv_transpose2d",
+    };
+    for (const char *type : conv_types)
+    {
+        registry[type] = ConvShape;
+    }
+
+    const char *pool_types[] = {
+        "nn.MaxPool1d", "nn.MaxPool2d", "nn.MaxPool3d", "nn.AvgPool1d", "nn.AvgPool2d", "nn.AvgPool3d",
+        "F.max_pool1d", "F.max_pool2d", "F.max_pool3d", "F.avg_pool1d", "F.avg_pool2d", "F.avg_pool3d",
+    };
+    for (const char *type : pool_types)
+    {
+        registry[type] = PoolShape;
+    }
+
+    const char *adaptive_pool_types[] = {
+        "nn.AdaptiveAvgPool1d", "nn.AdaptiveAvgPool2d", "nn.AdaptiveAvgPool3d", "nn.AdaptiveMaxPool1d",
+        "nn.AdaptiveMaxPool2d", "nn.AdaptiveMaxPool3d", "F.adaptive_avg_pool1d", "F.adaptive_avg_pool2d",
+        "F.adaptive_avg_pool3d", "F.adaptive_max_pool1d", "F.adaptive_max_pool2d", "F.adaptive_max_pool3d",
+    };
+    for (const char *type : adaptive_pool_types)
+    {
+        registry[type] = AdaptivePoolShape;
+    }
+
+    registry["nn.Linear"] = LinearShape;
+    registry["F.linear"] = LinearShape;
+    registry["torch.flatten"] = FlattenShape;
+    registry["nn.Flatten"] = FlattenShape;
+    registry["Tensor.view"] = ReshapeShape;
+    registry["Tensor.reshape"] = ReshapeShape;
+    registry["torch.reshape"] = ReshapeShape;
+    registry["torch.cat"] = ConcatShape;
+    registry["torch.stack"] = StackShape;
+    registry["torch.permute"] = PermuteShape;
+    registry["Tensor.permute"] = PermuteShape;
+    registry["torch.transpose"] = TransposeShape;
+    registry["Tensor.transpose"] = TransposeShape;
+    registry["torch.squeeze"] = SqueezeShape;
+    registry["torch.unsqueeze"] = UnsqueezeShape;
+    registry["nn.Upsample"] = InterpolateShape;
+    registry["nn.UpsamplingNearest2d"] = InterpolateShape;
+    registry["nn.UpsamplingBilinear2d"] = InterpolateShape;
+    registry["F.interpolate"] = InterpolateShape;
+    registry["F.upsample"] = InterpolateShape;
+    registry["nn.PixelShuffle"] = PixelShuffleShape;
+    registry["F.pixel_shuffle"] = PixelShuffleShape;
+    registry["nn.PixelUnshuffle"] = PixelShuffleShape;
+    registry["F.pixel_unshuffle"] = PixelShuffleShape;
+    registry["torch.mean"] = ReduceShape;
+    registry["torch.sum"] = ReduceShape;
+    registry["torch.amax"] = ReduceShape;
+    registry["torch.amin"] = ReduceShape;
+    registry["torch.prod"] = ReduceShape;
+    registry["Tensor.slice"] = SliceShape;
+    registry["torch.chunk"] = ChunkShape;
+    registry["torch.matmul"] = MatmulShape;
+    registry["torch.bmm"] = MatmulShape;
+    registry["F.scaled_dot_product_attention"] = AttentionShape;
+    registry["nn.Embedding"] = EmbeddingShape;
+    registry["pnnx.Attribute"] = AttributeShape;
+}
+
+std::map<std::string, ShapeInference::ShapeFunction> &ShapeInference::Registry()
+{
+    static std::map<std::string, ShapeFunction> *registry = [] {
+        auto *builtin = new std::map<std::string, ShapeFunction>();
+        RegisterBuiltinShapeFunctions(*builtin);
+        return builtin;
+    }();
+    return *registry;
+}
+
+void ShapeInference::RegisterShapeFunction(const std::string &type, const ShapeFunction &function)
+{
+    CHECK(function != nullptr) << "Shape function for " << type << " is empty";
+    Registry()[type] = function;
+}
+
+bool ShapeInference::HasShapeFunction(const std::string &type)
+{
+    return Registry().count(type) != 0;
+}
+
+StatusCode ShapeInference::InferOperator(const pnnx::Operator *op, const std::vector<Shape> &input_shapes,
+                                         std::vector<Shape> &output_shapes)
+{
+    const std::map<std::string, ShapeFunction> &registry = Registry();
+    auto it = registry.find(op->type);
+    if (it == registry.end())
+    {
+        return StatusCode::FunctionNotImplement;
+    }
+
+    output_shapes.clear();
+    StatusCode status = it->second(op, input_shapes, output_shapes);
+    if (status == StatusCode::Success && output_shapes.size() != op->outputs.size())
+    {
+        return StatusCode::InferOutputsEmpty;
+    }
+    return status;
+}
+
+ShapeInference::ShapeInference(const pnnx::Graph &graph) :
+    graph_(graph)
+{
+    for (size_t i = 0; i < graph_.operands.size(); ++i)
+    {
+        operand_indices_[graph_.operands[i]] = i;
+    }
+
+    for (const pnnx::Operator *op : graph_.ops)
+    {
+        if (op->type == "pnnx.Input")
+        {
+            input_operators_.push_back(op);
+        }
+        else if (op->type == "pnnx.Output")
+        {
+            output_operators_.push_back(op);
+        }
+        else if (op->type == "pnnx.Expression" || op->type == "jennifer.FusedElementwise")
+        {
+            auto expr = op->params.find("expr");
+            layer::ElementwiseProgram program;
+            if (expr != op->params.end() && expr->second.type == 4 && program.Compile(expr->second.s))
+            {
+                programs_[op] = std::move(program);
+            }
+        }
+    }
+}
+
+int ShapeInference::operand_index(const pnnx::Operand *operand) const
+{
+    auto it = operand_indices_.find(operand);
+    CHECK(it != operand_indices_.end()) << "Operand does not belong to the graph";
+    return it->second;
+}
+
+const std::vector<const pnnx::Operator *> &ShapeInference::input_operators() const
+{
+    return input_operators_;
+}
+
+const std::vector<const pnnx::Operator *> &ShapeInference::output_operators() const
+{
+    return output_operators_;
+}
+
+StatusCode ShapeInference::BindInput(const pnnx::Operand *operand, const Shape &shape,
+                                     std::map<std::string, int32_t> &symbols) const
+{
+    const Shape &declared = operand->shape;
+    if (!declared.empty() && declared.size() != shape.size())
+    {
+        LOG(ERROR) << "Input " << operand->name << " expects rank " << declared.size() << " but got " << shape.size();
+        return StatusCode::InferDimMismatch;
+    }
+
+    for (size_t i = 0; i < declared.size(); ++i)
+    {
+        if (declared[i] == kSymbolicDim)
+        {
+            auto p = operand->params.find("__shape__" + std::to_string(i));
+            CHECK(p != operand->params.end()) << "Symbolic dim of " << operand->name << " has no name";
+
+            auto bound = symbols.insert({p->second.s, shape[i]});
+            if (!bound.second && bound.first->second != shape[i])
+            {
+                LOG(ERROR) << "Symbol " << p->second.s << " is bound to " << bound.first->second << " but input "
+                           << operand->name << " has " << shape[i];
+                return StatusCode::InferDimMismatch;
+            }
+        }
+        else if (declared[i] != kUnknownDim && declared[i] != shape[i])
+        {
+            // the leading dim is the batch and may differ from the exported one
+            if (i == 0)
+            {
+                continue;
+            }
+            LOG(ERROR) << "Input " << operand->name << " dim " << i << " expects " << declared[i] << " but got " << shape[i];
+            return StatusCode::InferDimMismatch;
+        }
+    }
+    return StatusCode::Success;
+}
+
+StatusCode ShapeInference::InferExpression(const pnnx::Operator *op, const std::vector<Shape> &input_shapes,
+                                           const std::vector<const std::vector<double> *> &input_values,
+                                           std::vector<Shape> &output_shapes, std::vector<double> &values) const
+{
+    const layer::ElementwiseProgram &program = programs_.at(op);
+    if (op->outputs.size() != 1 || static_cast<size_t>(program.input_count()) > input_shapes.size())
+    {
+        return StatusCode::InferParamError;
+    }
+
+    std::vector<Shape> tensor_shapes;
+    bool scalar_values = true;
+    for (int i = 0; i < program.input_count(); ++i)
+    {
+        if (program.uses_tensor(i))
+        {
+            tensor_shapes.push_back(input_shapes[i]);
+            scalar_values = scalar_values && input_values[i]->size() == 1;
+        }
+    }
+
+    if (tensor_shapes.empty())
+    {
+        if (!program.EvaluateShape(input_shapes, values))
+        {
+            LOG(ERROR) << "Expression " << op->name << " reads a size beyond the rank of its input";
+            return StatusCode::InferDimMismatch;
+        }
+        output_shapes.assign(1, program.is_list() ? Shape{static_cast<int32_t>(values.size())} : Shape());
+        return StatusCode::Success;
+    }
+
+    Shape output;
+    if (!Broadcast(tensor_shapes, output))
+    {
+        LOG(ERROR) << "Expression " << op->name << " inputs can not be broadcast";
+        return StatusCode::InferDimMismatch;
+    }
+    output_shapes.assign(1, output);
+
+    // arithmetic over Tensor.size results is a shape value as well
+    std::vector<double> scalars;
+    if (scalar_values && program.EvaluateScalars(input_shapes, scalars))
+    {
+        std::vector<float> data(program.input_count());
+        std::vector<layer::ElementwiseOperand> operands(program.input_count());
+        for (int i = 0; i < program.input_count(); ++i)
+        {
+            if (program.uses_tensor(i))
+            {
+                data[i] = static_cast<float>((*input_values[i])[0]);
+                operands[i].data = &data[i];
+            }
+        }
+
+        const int64_t dims[3] = {1, 1, 1};
+        float result = 0.f;
+        std::vector<float> scratch;
+        program.Run(operands, dims, &result, scratch, scalars);
+        values.assign(1, result);
+    }
+    return StatusCode::Success;
+}
+
+StatusCode ShapeInference::ExportedShape(const pnnx::Operand *operand, const std::map<std::string, int32_t> &symbols,
+                                         Shape &shape) const
+{
+    shape = operand->shape;
+    for (size_t i = 0; i < shape.size(); ++i)
+    {
+        if (shape[i] == kSymbolicDim)
+        {
+            auto p = operand->params.find("__shape__" + std::to_string(i));
+            auto s = p == operand->params.end() ? symbols.end() : symbols.find(p->second.s);
+            if (s == symbols.end())
+            {
+                return StatusCode::InferDimMismatch;
+            }
+            shape[i] = s->second;
+        }
+        else if (shape[i] == kUnknownDim)
+        {
+            return StatusCode::InferDimMismatch;
+        }
+    }
+    return StatusCode::Success;
+}
+
+StatusCode ShapeInference::Infer(const std::vector<Shape> &input_shapes, std::vector<Shape> &operand_shapes,
+                                 std::map<std::string, int32_t> *symbols) const
+{
+    if (input_shapes.size() != input_operators_.size())
+    {
+        LOG(ERROR) << "Graph has " << input_operators_.size() << " inputs but got " << input_shapes.size() << " shapes";
+        return StatusCode::InferInputsEmpty;
+    }
+
+    std::map<std::string, int32_t> bindings;
+    operand_shapes.assign(graph_.operands.size(), Shape());
+    std::vector<bool> resolved(graph_.operands.size(), false);
+    // shape values, empty for operands that are not computed from shapes alone
+    std::vector<std::vector<double>> values(graph_.operands.size());
+
+    for (size_t i = 0; i < input_operators_.size(); ++i)
+    {
+        const pnnx::Operand *operand = input_operators_[i]->outputs.at(0);
+        StatusCode status = BindInput(operand, input_shapes[i], bindings);
+        if (status != StatusCode::Success)
+        {
+            return status;
+        }
+
+        const int index = operand_index(operand);
+        operand_shapes[index] = input_shapes[i];
+        resolved[index] = true;
+    }
+
+    std::vector<Shape> inputs;
+    std::vector<const std::vector<double> *> input_values;
+    std::vector<Shape> outputs;
+    std::vector<double> output_values;
+    for (const pnnx::Operator *op : graph_.ops)
+    {
+        if (op->type == "pnnx.Input" || op->type == "pnnx.Output")
+        {
+            continue;
+        }
+
+        inputs.clear();
+        input_values.clear();
+        for (const pnnx::Operand *operand : op->inputs)
+        {
+            const int index = operand_index(operand);
+            CHECK(resolved[index]) << "Operand " << operand->name << " is used before it is produced";
+            inputs.push_back(operand_shapes[index]);
+            input_values.push_back(&values[index]);
+        }
+
+        // a target shape computed at runtime is known once its values are
+        std::vector<int> target;
+        const char *value_param = ValueParam(op->type);
+        if (value_param && op->params.find(value_param) == op->params.end())
+        {
+            for (size_t i = 1; i < input_values.size(); ++i)
+            {
+                if (input_values[i]->empty())
+                {
+                    target.clear();
+                    break;
+                }
+                for (double v : *input_values[i])
+                {
+                    target.push_back(static_cast<int>(std::lround(v)));
+                }
+            }
+        }
+
+        StatusCode status;
+        output_values.clear();
+        if (programs_.find(op) != programs_.end())
+        {
+            status = InferExpression(op, inputs, input_values, outputs, output_values);
+        }
+        else if (op->type == "Tensor.size")
+        {
+            status = SizeShape(op, inputs, outputs, output_values);
+        }
+        else if (!target.empty())
+        {
+            pnnx::Operator resolved_op = *op;
+            resolved_op.params[value_param] = target;
+            status = InferOperator(&resolved_op, {inputs[0]}, outputs);
+        }
+        else
+        {
+            status = InferOperator(op, inputs, outputs);
+        }
+
+        if (status != StatusCode::Success && status != StatusCode::FunctionNotImplement)
+        {
+            LOG(ERROR) << "Infer the shape of " << op->type << " " << op->name << " failed, status "
+                       << static_cast<int>(status);
+            return status;
+        }
+
+        if (status == StatusCode::FunctionNotImplement)
+        {
+            // no shape rule for this operator, trust the exported shapes
+            outputs.resize(op->outputs.size());
+            for (size_t i = 0; i < op->outputs.size(); ++i)
+            {
+                if (ExportedShape(op->outputs[i], bindings, outputs[i]) != StatusCode::Success)
+                {
+                    LOG(ERROR) << "Can not infer the shape of " << op->outputs[i]->name << " produced by " << op->type
+                               << " " << op->name;
+                    return StatusCode::InferDimMismatch;
+                }
+
+                // the batch follows the first input when it did at export time
+                const pnnx::Operand *first = op->inputs.empty() ? nullptr : op->inputs[0];
+                if (first && !first->shape.empty() && !outputs[i].empty() && first->shape[0] == op->outputs[i]->shape[0])
+                {
+                    outputs[i][0] = inputs[0].empty() ? outputs[i][0] : inputs[0][0];
+                }
+            }
+        }
+
+        for (size_t i = 0; i < op->outputs.size(); ++i)
+        {
+            const int index = operand_index(op->outputs[i]);
+            operand_shapes[index] = outputs[i];
+            resolved[index] = true;
+        }
+        if (status == StatusCode::Success && op->outputs.size() == 1)
+        {
+            values[operand_index(op->outputs[0])] = std::move(output_values);
+        }
+    }
+
+    if (symbols)
+    {
+        *symbols = std::move(bindings);
+    }
+    return StatusCode::Success;
+}
+
+} // namespace runtime
+} // namespace jennifer
@@ -0,0 +1,83 @@
+#ifndef JENNIFER_RUNTIME_SHAPE_INFERENCE_HPP
+#define JENNIFER_RUNTIME_SHAPE_INFERENCE_HPP
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "jennifer/layer/elementwise.hpp"
+#include "jennifer/runtime/pnnx/ir.h"
+#include "jennifer/utils/common.hpp"
+
+namespace jennifer
+{
+namespace runtime
+{
+
+using Shape = std::vector<int32_t>;
+
+// Resolves the operand shapes of a pnnx graph for concrete input shapes. Exported
+// shapes encode unknown dims as -1 and symbolic %name dims as -233 with the symbol
+// stored in the operand param __shape__N. Symbols are bound from the pnnx.Input
+// operands and every operator then gets its output shapes from a per-type shape
+// function, falling back to the exported shape with the bound symbols substituted.
+//
+// Operands computed from shapes alone, Tensor.size and pnnx.Expression over size()
+// terms, also carry their values. A reshape or interpolate whose target shape is
+// such an operand is inferred as if the values were its shape or size param.
+class ShapeInference
+{
+public:
+    using ShapeFunction = std::function<utils::StatusCode(const pnnx::Operator *op,
+                                                          const std::vector<Shape> &input_shapes,
+                                                          std::vector<Shape> &output_shapes)>;
+
+    static constexpr int32_t kUnknownDim = -1;
+    static constexpr int32_t kSymbolicDim = -233;
+
+    explicit ShapeInference(const pnnx::Graph &graph);
+
+    // input_shapes follows the order of the pnnx.Input operators, operand_shapes is
+    // indexed like pnnx::Graph::operands
+    utils::StatusCode Infer(const std::vector<Shape> &input_shapes,
+                            std::vector<Shape> &operand_shapes,
+                            std::map<std::string, int32_t> *symbols = nullptr) const;
+
+    int operand_index(const pnnx::Operand *operand) const;
+
+    const std::vector<const pnnx::Operator *> &input_operators() const;
+    const std::vector<const pnnx::Operator *> &output_operators() const;
+
+    // output shapes of a single operator from its input shapes, FunctionNotImplement
+    // when the type has no shape function
+    static utils::StatusCode InferOperator(const pnnx::Operator *op, const std::vector<Shape> &input_shapes,
+                                           std::vector<Shape> &output_shapes);
+
+    static void RegisterShapeFunction(const std::string &type, const ShapeFunction &function);
+    static bool HasShapeFunction(const std::string &type);
+
+private:
+    utils::StatusCode BindInput(const pnnx::Operand *operand, const Shape &shape,
+                                std::map<std::string, int32_t> &symbols) const;
+    utils::StatusCode InferExpression(const pnnx::Operator *op, const std::vector<Shape> &input_shapes,
+                                      const std::vector<const std::vector<double> *> &input_values,
+                                      std::vector<Shape> &output_shapes, std::vector<double> &values) const;
+    utils::StatusCode ExportedShape(const pnnx::Operand *operand, const std::map<std::string, int32_t> &symbols,
+                                    Shape &shape) const;
+
+    static std::map<std::string, ShapeFunction> &Registry();
+
+    const pnnx::Graph &graph_;
+    std::map<const pnnx::Operand *, int> operand_indices_;
+    std::vector<const pnnx::Operator *> input_operators_;
+    std::vector<const pnnx::Operator *> output_operators_;
+    // pnnx.Expression and jennifer.FusedElementwise compiled once per graph
+    std::map<const pnnx::Operator *, layer::ElementwiseProgram> programs_;
+}; // class ShapeInference
+
+} // namespace runtime
+} // namespace jennifer
+
+#endif // JENNIFER_RUNTIME_SHAPE_INFERENCE_HPP
@@ -20,6 +20,8 @@ enum class StatusCode
     ParseWeightError = 6,
     ParseParamError = 7,
     ParseNullOperator = 8,
+
+    RuntimeStopped = 9,
 }; // enum class StatusCode
 
 } // namespace utils
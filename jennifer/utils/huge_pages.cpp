@@ -0,0 +1,197 @@
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <new>
+
+#include "huge_pages.hpp"
+
+namespace jennifer
+{
+namespace utils
+{
+
+namespace
+{
+
+struct Mapping
+{
+    size_t bytes;
+    bool hugetlb;
+}; // struct Mapping
+
+std::atomic<int> &Mode()
+{
+    static std::atomic<int> mode(static_cast<int>(HugePageMode::Off));
+    return mode;
+}
+
+std::mutex &MappingMutex()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+// huge page mappings by start address
+std::map<uintptr_t, Mapping> &Mappings()
+{
+    static std::map<uintptr_t, Mapping> mappings;
+    return mappings;
+}
+
+size_t RoundUp(size_t value, size_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+void *MapTransparent(size_t bytes)
+{
+    // over-map by one huge page and cut a 2 MB aligned window out of it
+    void *raw = mmap(nullptr, bytes + kHugePageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED)
+    {
+        return nullptr;
+    }
+    const uintptr_t begin = reinterpret_cast<uintptr_t>(raw);
+    const uintptr_t aligned = RoundUp(begin, kHugePageSize);
+    if (aligned != begin)
+    {
+        munmap(raw, aligned - begin);
+    }
+    const uintptr_t tail = begin + bytes + kHugePageSize - (aligned + bytes);
+    if (tail != 0)
+    {
+        munmap(reinterpret_cast<void *>(aligned + bytes), tail);
+    }
+    // without transparent huge pages the mapping keeps 4 KB pages
+    madvise(reinterpret_cast<void *>(aligned), bytes, MADV_HUGEPAGE);
+    return reinterpret_cast<void *>(aligned);
+}
+
+} // namespace
+
+void SetHugePageMode(HugePageMode mode)
+{
+    Mode() = static_cast<int>(mode);
+}
+
+HugePageMode GetHugePageMode()
+{
+    return static_cast<HugePageMode>(Mode().load());
+}
+
+void *AllocateHuge(size_t bytes)
+{
+    const HugePageMode mode = GetHugePageMode();
+    if (mode == HugePageMode::Off || bytes < kHugePageSize)
+    {
+        void *ptr = nullptr;
+        if (posix_memalign(&ptr, 64, bytes == 0 ? 1 : bytes) != 0)
+        {
+            throw std::bad_alloc();
+        }
+        return ptr;
+    }
+
+    const size_t size = RoundUp(bytes, kHugePageSize);
+    void *ptr = nullptr;
+    bool hugetlb = false;
+    if (mode == HugePageMode::Explicit)
+    {
+        ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        hugetlb = ptr != MAP_FAILED;
+        ptr = hugetlb ? ptr : nullptr;
+    }
+    if (ptr == nullptr)
+    {
+        ptr = MapTransparent(size);
+    }
+    if (ptr == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+
+    std::lock_guard<std::mutex> lock(MappingMutex());
+    Mappings()[reinterpret_cast<uintptr_t>(ptr)] = {size, hugetlb};
+    return ptr;
+}
+
+void FreeHuge(void *ptr)
+{
+    if (ptr == nullptr)
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(MappingMutex());
+        auto it = Mappings().find(reinterpret_cast<uintptr_t>(ptr));
+        if (it != Mappings().end())
+        {
+            const size_t bytes = it->second.bytes;
+            Mappings().erase(it);
+            munmap(ptr, bytes);
+            return;
+        }
+    }
+    free(ptr);
+}
+
+HugePageStats HugePageUsage()
+{
+    HugePageStats stats;
+    std::map<uintptr_t, Mapping> mappings;
+    {
+        std::lock_guard<std::mutex> lock(MappingMutex());
+        mappings = Mappings();
+    }
+    for (const auto &it : mappings)
+    {
+        stats.allocations += 1;
+        stats.mapped_bytes += it.second.bytes;
+        stats.huge_bytes += it.second.hugetlb ? it.second.bytes : 0;
+    }
+
+    // a transparent mapping is one vma of its own as long as it keeps MADV_HUGEPAGE
+    FILE *file = fopen("/proc/self/smaps", "r");
+    if (file == nullptr)
+    {
+        return stats;
+    }
+    char line[512];
+    uintptr_t begin = 0;
+    uintptr_t end = 0;
+    while (fgets(line, sizeof(line), file) != nullptr)
+    {
+        unsigned long a = 0;
+        unsigned long b = 0;
+        size_t kb = 0;
+        if (sscanf(line, "%lx-%lx ", &a, &b) == 2)
+        {
+            begin = a;
+            end = b;
+            continue;
+        }
+        if (sscanf(line, "AnonHugePages: %zu kB", &kb) != 1 || kb == 0)
+        {
+            continue;
+        }
+        size_t overlap = 0;
+        for (auto it = mappings.lower_bound(begin); it != mappings.end() && it->first < end; ++it)
+        {
+            if (!it->second.hugetlb)
+            {
+                overlap += std::min<uintptr_t>(it->first + it->second.bytes, end) - it->first;
+            }
+        }
+        stats.huge_bytes += std::min(kb << 10, overlap);
+    }
+    fclose(file);
+    return stats;
+}
+
+} // namespace utils
+} // namespace jennifer
@@ -0,0 +1,93 @@
+#ifndef JENNIFER_UTILS_HUGE_PAGES_HPP
+#define JENNIFER_UTILS_HUGE_PAGES_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace jennifer
+{
+namespace utils
+{
+
+static const size_t kHugePageSize = size_t(2) << 20;
+
+enum class HugePageMode
+{
+    // plain 64 byte aligned heap allocations
+    Off,
+    // 2 MB aligned anonymous mappings advised with MADV_HUGEPAGE, backed by
+    // transparent huge pages when the kernel has them to spare
+    Transparent,
+    // MAP_HUGETLB mappings from the reserved hugetlbfs pool, Transparent when the
+    // pool is empty
+    Explicit,
+}; // enum class HugePageMode
+
+struct HugePageStats
+{
+    // live allocations that asked for huge pages and the bytes mapped for them
+    uint64_t allocations = 0;
+    size_t mapped_bytes = 0;
+
+    // bytes of those mappings the kernel currently backs with huge pages
+    size_t huge_bytes = 0;
+}; // struct HugePageStats
+
+// mode of the allocations made from now on, Off by default
+void SetHugePageMode(HugePageMode mode);
+HugePageMode GetHugePageMode();
+
+// Allocations of at least one huge page follow the mode, smaller ones always come
+// from the heap. FreeHuge takes any pointer AllocateHuge returned.
+void *AllocateHuge(size_t bytes);
+void FreeHuge(void *ptr);
+
+// Counts the live huge page allocations, transparent ones are looked up in the
+// AnonHugePages of /proc/self/smaps.
+HugePageStats HugePageUsage();
+
+// allocator of the large buffers of the runtime: activation arenas, weights and
+// packed panels, and KV cache pages
+template <typename T>
+struct HugePageAllocator
+{
+    using value_type = T;
+
+    HugePageAllocator() = default;
+
+    template <typename U>
+    HugePageAllocator(const HugePageAllocator<U> &)
+    {
+    }
+
+    T *allocate(size_t n)
+    {
+        return static_cast<T *>(AllocateHuge(n * sizeof(T)));
+    }
+
+    void deallocate(T *ptr, size_t)
+    {
+        FreeHuge(ptr);
+    }
+
+    template <typename U>
+    bool operator==(const HugePageAllocator<U> &) const
+    {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const HugePageAllocator<U> &) const
+    {
+        return false;
+    }
+}; // struct HugePageAllocator
+
+template <typename T>
+using HugeVector = std::vector<T, HugePageAllocator<T>>;
+
+} // namespace utils
+} // namespace jennifer
+
+#endif // JENNIFER_UTILS_HUGE_PAGES_HPP
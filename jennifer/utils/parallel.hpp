@@ -0,0 +1,72 @@
+#ifndef JENNIFER_UTILS_PARALLEL_HPP
+#define JENNIFER_UTILS_PARALLEL_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace jennifer
+{
+namespace utils
+{
+
+// threads a num_threads of 0 means on the calling thread, 0 for every hardware
+// thread; a thread pinned to some of the cores sets it to their count
+inline int &DefaultThreads()
+{
+    thread_local int threads = 0;
+    return threads;
+}
+
+// num_threads when positive, the default of the calling thread otherwise
+inline int ResolveThreads(int num_threads)
+{
+    if (num_threads > 0)
+    {
+        return num_threads;
+    }
+    if (DefaultThreads() > 0)
+    {
+        return DefaultThreads();
+    }
+    const int n = static_cast<int>(std::thread::hardware_concurrency());
+    return n > 0 ? n : 1;
+}
+
+// Splits [0, count) into one contiguous range per thread and calls f(begin, end)
+// for every range, the calling thread takes the first one. Ranges are at least
+// grain long so small counts stay on the calling thread.
+template <typename F>
+void ParallelFor(int64_t count, int num_threads, int64_t grain, const F &f)
+{
+    if (count <= 0)
+    {
+        return;
+    }
+    grain = std::max<int64_t>(grain, 1);
+    const int64_t threads = std::min<int64_t>(ResolveThreads(num_threads), (count + grain - 1) / grain);
+    if (threads <= 1)
+    {
+        f(int64_t(0), count);
+        return;
+    }
+
+    const int64_t chunk = (count + threads - 1) / threads;
+    std::vector<std::thread> workers;
+    for (int64_t begin = chunk; begin < count; begin += chunk)
+    {
+        const int64_t end = std::min(begin + chunk, count);
+        workers.emplace_back([&f, begin, end]() { f(begin, end); });
+    }
+    f(int64_t(0), std::min(chunk, count));
+    for (std::thread &worker : workers)
+    {
+        worker.join();
+    }
+}
+
+} // namespace utils
+} // namespace jennifer
+
+#endif // JENNIFER_UTILS_PARALLEL_HPP
@@ -0,0 +1,68 @@
+#ifndef JENNIFER_TEST_SCALE_CHAIN_HPP
+#define JENNIFER_TEST_SCALE_CHAIN_HPP
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+
+#include "jennifer/layer/layer_factory.hpp"
+#include "jennifer/runtime/pnnx/ir.h"
+
+namespace jennifer
+{
+
+// doubles every element, shared by the runtime front-end tests; the registration is
+// an inline variable so it runs once however many test files include it
+class ScaleLayer : public layer::Layer<float>
+{
+public:
+    ScaleLayer() :
+        Layer("test.Scale")
+    {
+    }
+
+    utils::StatusCode Forward(const std::vector<std::shared_ptr<data::Tensor<float>>> &inputs,
+                              std::vector<std::shared_ptr<data::Tensor<float>>> &outputs) override
+    {
+        if (inputs.size() != outputs.size())
+        {
+            return utils::StatusCode::InferDimMismatch;
+        }
+        for (size_t i = 0; i < inputs.size(); ++i)
+        {
+            for (uint32_t j = 0; j < inputs[i]->size(); ++j)
+            {
+                outputs[i]->index(j) = inputs[i]->index(j) * 2.f;
+            }
+        }
+        return utils::StatusCode::Success;
+    }
+}; // class ScaleLayer
+
+inline layer::LayerRegistererWrapper kScaleLayer("test.Scale",
+                                                 [](const std::shared_ptr<runtime::Operator<float>> &,
+                                                    std::shared_ptr<layer::Layer<float>> &layer) {
+                                                     layer = std::make_shared<ScaleLayer>();
+                                                     return utils::StatusCode::Success;
+                                                 });
+
+inline const char *kScaleChain = "7767517\n"
+                                 "6 5\n"
+                                 "pnnx.Input    in0  0 1 0 #0=(1,3,%h,%w)f32\n"
+                                 "test.Scale    s1   1 1 0 1 #0=(1,3,%h,%w)f32 #1=(1,3,%h,%w)f32\n"
+                                 "test.Scale    s2   1 1 1 2 #1=(1,3,%h,%w)f32 #2=(1,3,%h,%w)f32\n"
+                                 "test.Scale    s3   1 1 2 3 #2=(1,3,%h,%w)f32 #3=(1,3,%h,%w)f32\n"
+                                 "test.Scale    s4   1 1 3 4 #3=(1,3,%h,%w)f32 #4=(1,3,%h,%w)f32\n"
+                                 "pnnx.Output   out0 1 0 4 #4=(1,3,%h,%w)f32\n";
+
+inline std::unique_ptr<pnnx::Graph> ParseGraph(const std::string &param)
+{
+    std::unique_ptr<pnnx::Graph> graph(new pnnx::Graph);
+    EXPECT_EQ(graph->parse(param), 0);
+    return graph;
+}
+
+} // namespace jennifer
+
+#endif // JENNIFER_TEST_SCALE_CHAIN_HPP
@@ -0,0 +1,189 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <stdexcept>
+
+#include "jennifer/runtime/async_runner.hpp"
+
+using namespace jennifer::data;
+using namespace jennifer::runtime;
+using jennifer::utils::StatusCode;
+
+namespace jennifer
+{
+
+static StatusCode DoubleAll(const std::vector<std::shared_ptr<Operand<float>>> &inputs,
+                            std::vector<std::shared_ptr<Operand<float>>> &outputs)
+{
+    outputs.resize(inputs.size());
+    for (size_t i = 0; i < inputs.size(); ++i)
+    {
+        outputs[i] = std::make_shared<Operand<float>>("out", inputs[i]->shapes, inputs[i]->data.size(), AttributeType::Float32);
+        for (size_t j = 0; j < inputs[i]->data.size(); ++j)
+        {
+            auto output = std::make_shared<Tensor<float>>(*inputs[i]->data[j]);
+            output->Transform([](float x) { return x * 2.f; });
+            outputs[i]->data[j] = output;
+        }
+    }
+    return StatusCode::Success;
+}
+
+static std::shared_ptr<Operand<float>> FilledOperand(float value)
+{
+    auto operand = std::make_shared<Operand<float>>("in", std::vector<int32_t>({1, 2, 2, 2}), 1, AttributeType::Float32);
+    operand->data[0] = std::make_shared<Tensor<float>>(2, 2, 2);
+    operand->data[0]->Fill(value);
+    return operand;
+}
+
+// completions posted here run on the test thread, like an event loop would run them
+struct PostQueue
+{
+    void Post(std::function<void()> task)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        tasks.push_back(std::move(task));
+        cv.notify_one();
+    }
+
+    void RunOne()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this] { return !tasks.empty(); });
+        std::function<void()> task = std::move(tasks.front());
+        tasks.pop_front();
+        lock.unlock();
+        task();
+    }
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::function<void()>> tasks;
+};
+
+TEST(AsyncRunnerTest, futures_and_posted_callbacks)
+{
+    PostQueue loop;
+    AsyncOptions options;
+    options.workers = 2;
+    options.post = [&loop](std::function<void()> task) { loop.Post(std::move(task)); };
+    AsyncRunner runner(DoubleAll, options);
+
+    std::vector<std::future<AsyncResult>> futures;
+    for (int i = 0; i < 8; ++i)
+    {
+        futures.push_back(runner.Submit({FilledOperand(static_cast<float>(i))}));
+    }
+    for (int i = 0; i < 8; ++i)
+    {
+        AsyncResult result = futures[i].get();
+        ASSERT_EQ(result.status, StatusCode::Success);
+        ASSERT_EQ(result.outputs.size(), 1);
+        ASSERT_EQ(result.outputs[0]->data[0]->at(1, 1, 1), 2.f * i);
+    }
+
+    const std::thread::id loop_thread = std::this_thread::get_id();
+    std::vector<float> seen;
+    for (int i = 0; i < 4; ++i)
+    {
+        runner.Submit({FilledOperand(static_cast<float>(i))}, [&](AsyncResult result) {
+            EXPECT_EQ(std::this_thread::get_id(), loop_thread);
+            seen.push_back(result.outputs[0]->data[0]->at(0, 0, 0));
+        });
+    }
+    for (int i = 0; i < 4; ++i)
+    {
+        loop.RunOne();
+    }
+    std::sort(seen.begin(), seen.end());
+    ASSERT_EQ(seen, std::vector<float>({0.f, 2.f, 4.f, 6.f}));
+    ASSERT_EQ(runner.pending(), 0);
+}
+
+TEST(AsyncRunnerTest, executor_exception_and_stop)
+{
+    auto executor = [](const std::vector<std::shared_ptr<Operand<float>>> &,
+                       std::vector<std::shared_ptr<Operand<float>>> &) -> StatusCode {
+        throw std::invalid_argument("bad input");
+    };
+    AsyncRunner runner(executor);
+
+    auto future = runner.Submit({FilledOperand(1.f)});
+    ASSERT_THROW(future.get(), std::invalid_argument);
+
+    runner.Stop();
+    auto stopped = runner.Submit({FilledOperand(1.f)});
+    ASSERT_THROW(stopped.get(), std::runtime_error);
+}
+
+TEST(AsyncRunnerTest, throwing_callback_keeps_the_worker)
+{
+    AsyncRunner runner(DoubleAll);
+    runner.Submit({FilledOperand(1.f)}, [](AsyncResult) { throw std::logic_error("callback failed"); });
+
+    // the single worker survives the callback and serves the next request
+    AsyncResult result = runner.Submit({FilledOperand(2.f)}).get();
+    ASSERT_EQ(result.outputs[0]->data[0]->at(0, 0, 0), 4.f);
+    runner.Stop();
+    ASSERT_EQ(runner.pending(), 0);
+}
+
+#ifdef JENNIFER_HAS_COROUTINES
+struct DetachedTask
+{
+    struct promise_type
+    {
+        DetachedTask get_return_object()
+        {
+            return {};
+        }
+        std::suspend_never initial_suspend() noexcept
+        {
+            return {};
+        }
+        std::suspend_never final_suspend() noexcept
+        {
+            return {};
+        }
+        void return_void()
+        {
+        }
+        void unhandled_exception()
+        {
+            std::terminate();
+        }
+    };
+};
+
+static DetachedTask DoubleTwice(AsyncRunner &runner, float value, std::vector<float> &seen)
+{
+    std::vector<std::shared_ptr<Operand<float>>> inputs = {FilledOperand(value)};
+    AsyncResult first = co_await runner.Run(inputs);
+    AsyncResult second = co_await runner.Run(first.outputs);
+    seen.push_back(second.outputs[0]->data[0]->at(0, 1, 0));
+}
+
+TEST(AsyncRunnerTest, co_await_resumes_on_the_loop)
+{
+    PostQueue loop;
+    AsyncOptions options;
+    options.post = [&loop](std::function<void()> task) { loop.Post(std::move(task)); };
+    AsyncRunner runner(DoubleAll, options);
+
+    std::vector<float> seen;
+    DoubleTwice(runner, 1.f, seen);
+    DoubleTwice(runner, 3.f, seen);
+    // every co_await resumes through the loop, two per coroutine
+    for (int i = 0; i < 4; ++i)
+    {
+        loop.RunOne();
+    }
+    std::sort(seen.begin(), seen.end());
+    ASSERT_EQ(seen, std::vector<float>({4.f, 12.f}));
+}
+#endif
+
+} // namespace jennifer
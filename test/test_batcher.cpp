@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <stdexcept>
+
+#include "jennifer/runtime/batcher.hpp"
+
+using namespace jennifer::data;
+using namespace jennifer::runtime;
+using jennifer::utils::StatusCode;
+
+namespace jennifer
+{
+
+static StatusCode DoubleExecutor(const std::shared_ptr<Operand<float>> &inputs, std::shared_ptr<Operand<float>> &outputs)
+{
+    outputs = std::make_shared<Operand<float>>("out", inputs->shapes, inputs->data.size(), AttributeType::Float32);
+    for (size_t i = 0; i < inputs->data.size(); ++i)
+    {
+        auto output = std::make_shared<Tensor<float>>(*inputs->data[i]);
+        output->Transform([](float x) { return x * 2.f; });
+        outputs->data[i] = output;
+    }
+    return StatusCode::Success;
+}
+
+TEST(BatcherTest, coalesce_full_batch)
+{
+    std::atomic<uint32_t> max_seen(0);
+    auto executor = [&](const std::shared_ptr<Operand<float>> &inputs, std::shared_ptr<Operand<float>> &outputs) {
+        EXPECT_EQ(inputs->shapes.at(0), static_cast<int32_t>(inputs->data.size()));
+        if (inputs->data.size() > max_seen)
+        {
+            max_seen = inputs->data.size();
+        }
+        return DoubleExecutor(inputs, outputs);
+    };
+
+    BatcherOptions options;
+    options.max_batch_size = 8;
+    options.max_delay = std::chrono::seconds(10);
+    DynamicBatcher batcher(executor, options);
+
+    std::vector<std::future<std::shared_ptr<Tensor<float>>>> futures;
+    for (int i = 0; i < 8; ++i)
+    {
+        auto input = std::make_shared<Tensor<float>>(3, 4, 4);
+        input->Fill(static_cast<float>(i));
+        futures.push_back(batcher.Submit(input));
+    }
+
+    for (int i = 0; i < 8; ++i)
+    {
+        auto output = futures[i].get();
+        ASSERT_EQ(output->shape(), std::vector<uint32_t>({3, 4, 4}));
+        ASSERT_EQ(output->at(1, 2, 3), 2.f * i);
+    }
+    ASSERT_EQ(max_seen, 8);
+
+    BatcherStats stats = batcher.stats();
+    ASSERT_EQ(stats.requests, 8);
+    ASSERT_EQ(stats.batches, 1);
+    ASSERT_EQ(stats.full_flushes, 1);
+}
+
+TEST(BatcherTest, flush_on_deadline)
+{
+    BatcherOptions options;
+    options.max_batch_size = 32;
+    options.max_delay = std::chrono::milliseconds(5);
+    DynamicBatcher batcher(DoubleExecutor, options);
+
+    auto input = std::make_shared<Tensor<float>>(1, 2, 2);
+    input->Fill(1.5f);
+    auto future = batcher.Submit(input);
+    ASSERT_EQ(future.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    ASSERT_EQ(future.get()->index(0), 3.f);
+
+    BatcherStats stats = batcher.stats();
+    ASSERT_EQ(stats.batches, 1);
+    ASSERT_EQ(stats.deadline_flushes, 1);
+}
+
+TEST(BatcherTest, split_by_shape)
+{
+    BatcherOptions options;
+    options.max_batch_size = 4;
+    options.max_delay = std::chrono::milliseconds(5);
+    DynamicBatcher batcher(DoubleExecutor, options);
+
+    auto f1 = batcher.Submit(std::make_shared<Tensor<float>>(1, 2, 2));
+    auto f2 = batcher.Submit(std::make_shared<Tensor<float>>(1, 3, 3));
+    ASSERT_EQ(f1.get()->size(), 4);
+    ASSERT_EQ(f2.get()->size(), 9);
+    ASSERT_EQ(batcher.stats().batches, 2);
+}
+
+TEST(BatcherTest, mixed_shapes_wait_for_the_deadline)
+{
+    BatcherOptions options;
+    options.max_batch_size = 2;
+    options.max_delay = std::chrono::milliseconds(50);
+    DynamicBatcher batcher(DoubleExecutor, options);
+
+    // three queued requests, but no two of the same shape in a row to fill a batch
+    const auto start = std::chrono::steady_clock::now();
+    auto f1 = batcher.Submit(std::make_shared<Tensor<float>>(1, 2, 2));
+    auto f2 = batcher.Submit(std::make_shared<Tensor<float>>(1, 3, 3));
+    auto f3 = batcher.Submit(std::make_shared<Tensor<float>>(1, 2, 2));
+    ASSERT_EQ(f1.get()->size(), 4);
+    ASSERT_GE(std::chrono::steady_clock::now() - start, options.max_delay);
+    ASSERT_EQ(f2.get()->size(), 9);
+    ASSERT_EQ(f3.get()->size(), 4);
+
+    BatcherStats stats = batcher.stats();
+    ASSERT_EQ(stats.batches, 3);
+    ASSERT_EQ(stats.full_flushes, 0);
+    ASSERT_EQ(stats.deadline_flushes, 3);
+}
+
+TEST(BatcherTest, executor_failure)
+{
+    auto executor = [](const std::shared_ptr<Operand<float>> &, std::shared_ptr<Operand<float>> &) {
+        return StatusCode::InferDimMismatch;
+    };
+    DynamicBatcher batcher(executor);
+
+    auto future = batcher.Submit(std::make_shared<Tensor<float>>(1, 2, 2));
+    ASSERT_THROW(future.get(), std::runtime_error);
+}
+
+TEST(BatcherTest, submit_after_stop)
+{
+    DynamicBatcher batcher(DoubleExecutor);
+    batcher.Stop();
+
+    auto future = batcher.Submit(std::make_shared<Tensor<float>>(1, 2, 2));
+    ASSERT_THROW(future.get(), std::runtime_error);
+}
+
+} // namespace jennifer
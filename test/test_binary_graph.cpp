@@ -0,0 +1,140 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+
+#include "jennifer/runtime/binary_graph.hpp"
+#include "jennifer/runtime/pnnx/store_zip.hpp"
+
+using namespace jennifer::runtime;
+
+namespace jennifer
+{
+
+static const char *kBinaryGraphParam =
+    "7767517\n"
+    "5 5\n"
+    "pnnx.Input      in0   0 1 0 #0=(1,3,%h,%w)f32\n"
+    "nn.Conv2d       conv  1 1 0 1 bias=False dilation=(1,1) groups=1 in_channels=3 kernel_size=(3,3) out_channels=8 padding=(1,1) padding_mode=zeros stride=(1,1) @weight=(8,3,3,3)f32 #0=(1,3,%h,%w)f32 #1=(1,8,%h,%w)f32\n"
+    "F.interpolate   up    1 1 1 2 align_corners=False mode=bilinear scale_factor=(2.000000e+00,2.000000e+00) #1=(1,8,%h,%w)f32 #2=(1,8,?,?)f32\n"
+    "torch.cat       cat   2 1 2 2 3 dim=1 $tensors=2 #2=(1,8,?,?)f32 #3=(1,16,?,?)f32\n"
+    "pnnx.Output     out0  1 0 3 #3=(1,16,?,?)f32\n";
+
+static void ExpectSameGraph(const pnnx::Graph &a, const pnnx::Graph &b)
+{
+    ASSERT_EQ(a.ops.size(), b.ops.size());
+    ASSERT_EQ(a.operands.size(), b.operands.size());
+    for (size_t i = 0; i < a.ops.size(); ++i)
+    {
+        const pnnx::Operator *x = a.ops[i];
+        const pnnx::Operator *y = b.ops[i];
+        ASSERT_EQ(x->type, y->type);
+        ASSERT_EQ(x->name, y->name);
+        ASSERT_EQ(x->params, y->params);
+        ASSERT_EQ(x->attrs, y->attrs);
+        ASSERT_EQ(x->inputnames, y->inputnames);
+        ASSERT_EQ(x->inputs.size(), y->inputs.size());
+        for (size_t j = 0; j < x->inputs.size(); ++j)
+        {
+            ASSERT_EQ(x->inputs[j]->name, y->inputs[j]->name);
+        }
+        ASSERT_EQ(x->outputs.size(), y->outputs.size());
+    }
+    for (size_t i = 0; i < a.operands.size(); ++i)
+    {
+        const pnnx::Operand *x = a.operands[i];
+        const pnnx::Operand *y = b.operands[i];
+        ASSERT_EQ(x->name, y->name);
+        ASSERT_EQ(x->type, y->type);
+        ASSERT_EQ(x->shape, y->shape);
+        ASSERT_EQ(x->params, y->params);
+        ASSERT_EQ(x->producer->name, y->producer->name);
+        ASSERT_EQ(x->consumers.size(), y->consumers.size());
+    }
+}
+
+TEST(BinaryGraphTest, round_trip)
+{
+    pnnx::Graph graph;
+    ASSERT_EQ(graph.parse(kBinaryGraphParam), 0);
+    graph.ops[3]->params["names"] = std::vector<std::string>{"a", "conv"};
+    graph.ops[3]->params["scales"] = std::vector<float>{0.5f, -1.f};
+    graph.ops[3]->params["flag"] = true;
+    graph.ops[3]->params["none"] = pnnx::Parameter();
+    graph.ops[3]->params["c"] = std::complex<float>(1.f, -2.f);
+
+    const std::string path = testing::TempDir() + "/jennifer_binary_graph.jbg";
+    ASSERT_TRUE(BinaryGraph::Save(graph, path));
+    ASSERT_TRUE(BinaryGraph::IsBinaryGraph(path));
+
+    BinaryGraph binary;
+    ASSERT_TRUE(binary.Open(path));
+    ASSERT_EQ(binary.header().operators.count, 5);
+    ASSERT_STREQ(binary.string(binary.operators()[1].type), "nn.Conv2d");
+    ASSERT_EQ(binary.operands()[1].producer, 1);
+
+    pnnx::Graph loaded;
+    ASSERT_TRUE(binary.ToGraph(loaded));
+    ExpectSameGraph(graph, loaded);
+    ASSERT_EQ(loaded.get_operand("0")->params.at("__shape__2").s, "h");
+
+    // a converted graph only accepts an empty target
+    ASSERT_FALSE(binary.ToGraph(loaded));
+    remove(path.c_str());
+}
+
+TEST(BinaryGraphTest, attributes_from_bin)
+{
+    const std::string param_path = testing::TempDir() + "/jennifer_binary_graph.param";
+    const std::string bin_path = testing::TempDir() + "/jennifer_binary_graph.bin";
+    const std::string path = testing::TempDir() + "/jennifer_binary_graph_weights.jbg";
+
+    pnnx::Graph graph;
+    ASSERT_EQ(graph.parse(kBinaryGraphParam), 0);
+    std::vector<char> &weight = graph.ops[1]->attrs["weight"].data;
+    weight.resize(8 * 3 * 3 * 3 * sizeof(float));
+    for (size_t i = 0; i < weight.size(); ++i)
+    {
+        weight[i] = static_cast<char>(i * 7);
+    }
+    ASSERT_EQ(graph.save(param_path, bin_path), 0);
+    ASSERT_TRUE(BinaryGraph::Save(graph, path));
+
+    BinaryGraph binary;
+    pnnx::Graph loaded;
+    ASSERT_TRUE(binary.Open(path));
+    ASSERT_TRUE(binary.ToGraph(loaded, bin_path));
+    ASSERT_EQ(loaded.ops[1]->attrs.at("weight").data, weight);
+
+    remove(param_path.c_str());
+    remove(bin_path.c_str());
+    remove(path.c_str());
+}
+
+TEST(BinaryGraphTest, reject_corrupted)
+{
+    pnnx::Graph graph;
+    ASSERT_EQ(graph.parse(kBinaryGraphParam), 0);
+    const std::string path = testing::TempDir() + "/jennifer_binary_graph_corrupted.jbg";
+    ASSERT_TRUE(BinaryGraph::Save(graph, path));
+
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    std::vector<char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    // keep the buffer 8 byte aligned
+    std::vector<uint64_t> buffer((bytes.size() + 7) / 8);
+    memcpy(buffer.data(), bytes.data(), bytes.size());
+
+    BinaryGraph binary;
+    ASSERT_TRUE(binary.Parse(buffer.data(), bytes.size()));
+    ASSERT_FALSE(binary.Parse(buffer.data(), bytes.size() / 2));
+
+    // first input reference of the conv operator points past the operands
+    const BinaryGraphHeader *header = reinterpret_cast<const BinaryGraphHeader *>(buffer.data());
+    BinaryOperator *conv = reinterpret_cast<BinaryOperator *>(reinterpret_cast<char *>(buffer.data()) + header->operators.offset) + 1;
+    uint32_t *refs = reinterpret_cast<uint32_t *>(reinterpret_cast<char *>(buffer.data()) + header->refs.offset);
+    refs[conv->inputs] = 100;
+    ASSERT_FALSE(binary.Parse(buffer.data(), bytes.size()));
+    remove(path.c_str());
+}
+
+} // namespace jennifer
@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include "jennifer/runtime/pnnx/ir.h"
+
+namespace jennifer
+{
+
+static std::string ReadText(const std::string &path)
+{
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    std::stringstream ss;
+    ss << file.rdbuf();
+    return ss.str();
+}
+
+TEST(CodegenTest, static_graph)
+{
+    const std::string cpp_path = testing::TempDir() + "/jennifer_codegen.cpp";
+    const std::string weight_path = testing::TempDir() + "/jennifer_codegen.weights";
+
+    pnnx::Graph graph;
+    ASSERT_EQ(graph.parse("7767517\n"
+                          "8 8\n"
+                          "pnnx.Input      in0   0 1 0 #0=(1,3,8,8)f32\n"
+                          "nn.Conv2d       conv  1 1 0 1 bias=True dilation=(1,1) groups=1 in_channels=3 kernel_size=(3,3) out_channels=4 padding=(1,1) padding_mode=zeros stride=(2,2) @bias=(4)f32 @weight=(4,3,3,3)f32 #0=(1,3,8,8)f32 #1=(1,4,4,4)f32\n"
+                          "nn.ReLU         relu  1 1 1 2 #1=(1,4,4,4)f32 #2=(1,4,4,4)f32\n"
+                          "pnnx.Attribute  shift 0 1 3 @data=(1,4,1,1)f32 #3=(1,4,1,1)f32\n"
+                          "pnnx.Expression expr  2 1 2 3 4 expr=add(@0,@1) #2=(1,4,4,4)f32 #3=(1,4,1,1)f32 #4=(1,4,4,4)f32\n"
+                          "torch.flatten   flat  1 1 4 5 end_dim=-1 start_dim=1 #4=(1,4,4,4)f32 #5=(1,64)f32\n"
+                          "nn.Linear       fc    1 1 5 6 bias=False in_features=64 out_features=10 @weight=(10,64)f32 #5=(1,64)f32 #6=(1,10)f32\n"
+                          "pnnx.Output     out0  1 0 6 #6=(1,10)f32\n"),
+              0);
+    for (pnnx::Operator *op : graph.ops)
+    {
+        for (auto &it : op->attrs)
+        {
+            it.second.set_float32_data(std::vector<float>(it.second.elemcount(), 0.5f));
+        }
+    }
+
+    ASSERT_EQ(graph.cpp(cpp_path, weight_path), 0);
+
+    // conv weight and bias, the attribute and the linear weight, each 16 float aligned
+    ASSERT_EQ(ReadText(weight_path).size(), (112 + 16 + 16 + 640) * sizeof(float));
+
+    const std::string source = ReadText(cpp_path);
+    ASSERT_NE(source.find("conv2d<1, 3, 8, 8, 4, 4, 4, 3, 3, 2, 2, 1, 1, 1, 1, 1>(v_0, w + 0, w + 112, v_1);"),
+              std::string::npos);
+    ASSERT_NE(source.find("fmaxf(v_1[i], 0.f)"), std::string::npos);
+    ASSERT_NE(source.find("(v_2[d1 * 16 + d2 * 4 + d3 * 1] + v_3[d1 * 1])"), std::string::npos);
+    ASSERT_NE(source.find("float* v_5 = v_4;"), std::string::npos);
+    ASSERT_NE(source.find("linear<1, 64, 10>(v_5, w + 144, nullptr, v_6);"), std::string::npos);
+    ASSERT_NE(source.find("void forward(const float* in0, float* out0)"), std::string::npos);
+
+    remove(cpp_path.c_str());
+    remove(weight_path.c_str());
+}
+
+TEST(CodegenTest, reject_dynamic_and_unsupported)
+{
+    const std::string cpp_path = testing::TempDir() + "/jennifer_codegen_rejected.cpp";
+    const std::string weight_path = testing::TempDir() + "/jennifer_codegen_rejected.weights";
+
+    pnnx::Graph dynamic;
+    ASSERT_EQ(dynamic.parse("7767517\n"
+                            "3 2\n"
+                            "pnnx.Input  in0  0 1 0 #0=(1,3,?,?)f32\n"
+                            "nn.ReLU     relu 1 1 0 1 #0=(1,3,?,?)f32 #1=(1,3,?,?)f32\n"
+                            "pnnx.Output out0 1 0 1 #1=(1,3,?,?)f32\n"),
+              0);
+    ASSERT_EQ(dynamic.cpp(cpp_path, weight_path), -1);
+
+    pnnx::Graph unsupported;
+    ASSERT_EQ(unsupported.parse("7767517\n"
+                                "3 2\n"
+                                "pnnx.Input   in0  0 1 0 #0=(1,3,4,4)f32\n"
+                                "torch.cumsum sum  1 1 0 1 dim=1 #0=(1,3,4,4)f32 #1=(1,3,4,4)f32\n"
+                                "pnnx.Output  out0 1 0 1 #1=(1,3,4,4)f32\n"),
+              0);
+    ASSERT_EQ(unsupported.cpp(cpp_path, weight_path), -1);
+
+    remove(cpp_path.c_str());
+    remove(weight_path.c_str());
+}
+
+} // namespace jennifer
@@ -0,0 +1,55 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+#include "jennifer/runtime/runtime_graph.hpp"
+#include "jennifer/utils/huge_pages.hpp"
+#include "test/scale_chain.hpp"
+
+using namespace jennifer::data;
+using namespace jennifer::runtime;
+using jennifer::utils::StatusCode;
+
+namespace jennifer
+{
+
+TEST(HugePageTest, large_buffers_map_aligned_huge_pages)
+{
+    utils::SetHugePageMode(utils::HugePageMode::Transparent);
+    const utils::HugePageStats before = utils::HugePageUsage();
+    {
+        // a buffer smaller than a huge page stays on the heap
+        utils::HugeVector<float> small(1024, 1.f);
+        utils::HugeVector<float> large(utils::kHugePageSize / sizeof(float) + 1, 1.f);
+        ASSERT_EQ(reinterpret_cast<uintptr_t>(large.data()) % utils::kHugePageSize, 0);
+        const utils::HugePageStats usage = utils::HugePageUsage();
+        ASSERT_EQ(usage.allocations, before.allocations + 1);
+        ASSERT_EQ(usage.mapped_bytes, before.mapped_bytes + 2 * utils::kHugePageSize);
+        ASSERT_LE(usage.huge_bytes, usage.mapped_bytes);
+
+        // two live 3 MB blocks of the scale chain make the activation arena
+        RuntimeGraph runtime_graph;
+        ASSERT_TRUE(runtime_graph.Init(ParseGraph(kScaleChain)));
+        auto input = std::make_shared<Operand<float>>("in0", std::vector<int32_t>{1, 3, 512, 512}, 1,
+                                                      AttributeType::Float32);
+        input->data[0] = std::make_shared<Tensor<float>>(3, 512, 512);
+        input->data[0]->Fill(1.f);
+        std::vector<std::shared_ptr<Operand<float>>> outputs;
+        ASSERT_EQ(runtime_graph.Forward({input}, outputs), StatusCode::Success);
+        ASSERT_EQ(outputs[0]->data[0]->at(2, 511, 511), 16.f);
+        ASSERT_EQ(utils::HugePageUsage().allocations, before.allocations + 2);
+    }
+    ASSERT_EQ(utils::HugePageUsage().allocations, before.allocations);
+
+    // without a reserved hugetlbfs pool explicit pages fall back to transparent ones
+    utils::SetHugePageMode(utils::HugePageMode::Explicit);
+    {
+        utils::HugeVector<float> large(utils::kHugePageSize / sizeof(float), 2.f);
+        ASSERT_EQ(reinterpret_cast<uintptr_t>(large.data()) % utils::kHugePageSize, 0);
+        ASSERT_EQ(large.back(), 2.f);
+    }
+    utils::SetHugePageMode(utils::HugePageMode::Off);
+    ASSERT_EQ(utils::HugePageUsage().allocations, before.allocations);
+}
+
+} // namespace jennifer
@@ -0,0 +1,951 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+
+#include "jennifer/layer/attention.hpp"
+#include "jennifer/layer/conv2d.hpp"
+#include "jennifer/layer/elementwise.hpp"
+#include "jennifer/layer/gemm_kernel.hpp"
+#include "jennifer/layer/interpolate.hpp"
+#include "jennifer/layer/layer_factory.hpp"
+#include "jennifer/layer/layer_norm.hpp"
+#include "jennifer/layer/softmax.hpp"
+#include "jennifer/layer/transpose.hpp"
+#include "jennifer/runtime/runtime_graph.hpp"
+
+using namespace jennifer::data;
+using namespace jennifer::runtime;
+using jennifer::utils::StatusCode;
+
+namespace jennifer
+{
+
+static std::vector<float> RandomValues(size_t count, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> uniform(-1.f, 1.f);
+    std::vector<float> values(count);
+    for (float &v : values)
+    {
+        v = uniform(rng);
+    }
+    return values;
+}
+
+// one output element at a time with explicit bounds checks
+static std::vector<float> ReferenceConv2d(const layer::Conv2dShape &s, const std::vector<float> &weight,
+                                          const std::vector<float> &bias, const std::vector<float> &input)
+{
+    std::vector<float> output(static_cast<size_t>(s.out_channels) * s.out_h * s.out_w);
+    const int group_channels = s.in_channels / s.groups;
+    const int group_out_channels = s.out_channels / s.groups;
+    for (int oc = 0; oc < s.out_channels; ++oc)
+    {
+        const int g = oc / group_out_channels;
+        for (int oh = 0; oh < s.out_h; ++oh)
+        {
+            for (int ow = 0; ow < s.out_w; ++ow)
+            {
+                double sum = bias.empty() ? 0.0 : bias[oc];
+                for (int c = 0; c < group_channels; ++c)
+                {
+                    for (int i = 0; i < s.kernel_h; ++i)
+                    {
+                        for (int j = 0; j < s.kernel_w; ++j)
+                        {
+                            const int ih = oh * s.stride_h - s.pad_h + i * s.dilation_h;
+                            const int iw = ow * s.stride_w - s.pad_w + j * s.dilation_w;
+                            if (ih < 0 || ih >= s.in_h || iw < 0 || iw >= s.in_w)
+                            {
+                                continue;
+                            }
+                            sum += weight[((oc * group_channels + c) * s.kernel_h + i) * s.kernel_w + j]
+                                   * input[((g * group_channels + c) * s.in_h + ih) * s.in_w + iw];
+                        }
+                    }
+                }
+                output[(oc * s.out_h + oh) * s.out_w + ow] = static_cast<float>(sum);
+            }
+        }
+    }
+    return output;
+}
+
+TEST(Conv2dKernelTest, specialized_match_generic)
+{
+    struct Case
+    {
+        int kernel;
+        int stride;
+        int pad;
+        int dilation;
+        int groups;
+        layer::Conv2dKernel fixed;
+    };
+    const Case cases[] = {
+        {1, 1, 0, 1, 1, layer::Conv2dDirect<1, 1, 1, 1>}, {3, 1, 1, 1, 1, layer::Conv2dDirect<3, 3, 1, 1>},
+        {3, 2, 1, 1, 2, layer::Conv2dDirect<3, 3, 2, 2>}, {5, 1, 2, 1, 1, layer::Conv2dDirect<5, 5, 1, 1>},
+        {7, 2, 3, 1, 1, layer::Conv2dDirect<7, 7, 2, 2>}, {3, 1, 2, 2, 1, nullptr},
+    };
+
+    std::vector<float> padded;
+    for (const Case &c : cases)
+    {
+        layer::Conv2dShape s;
+        s.in_channels = 6;
+        s.in_h = 13;
+        s.in_w = 19;
+        s.out_channels = 10;
+        s.kernel_h = s.kernel_w = c.kernel;
+        s.stride_h = s.stride_w = c.stride;
+        s.pad_h = s.pad_w = c.pad;
+        s.dilation_h = s.dilation_w = c.dilation;
+        s.groups = c.groups;
+        s.out_h = (s.in_h + 2 * c.pad - c.dilation * (c.kernel - 1) - 1) / c.stride + 1;
+        s.out_w = (s.in_w + 2 * c.pad - c.dilation * (c.kernel - 1) - 1) / c.stride + 1;
+
+        const std::vector<float> weight = RandomValues(s.out_channels * (s.in_channels / s.groups) * c.kernel * c.kernel, 1);
+        const std::vector<float> bias = RandomValues(s.out_channels, 2);
+        const std::vector<float> input = RandomValues(s.in_channels * s.in_h * s.in_w, 3);
+        const std::vector<float> expected = ReferenceConv2d(s, weight, bias, input);
+
+        std::vector<float> generic(expected.size());
+        layer::Conv2dDirect<0, 0, 0, 0>(s, weight.data(), bias.data(), input.data(), generic.data(), padded);
+        for (size_t i = 0; i < expected.size(); ++i)
+        {
+            ASSERT_NEAR(generic[i], expected[i], 1e-4f) << "kernel " << c.kernel << " at " << i;
+        }
+
+        if (c.fixed != nullptr)
+        {
+            std::vector<float> fixed(expected.size());
+            c.fixed(s, weight.data(), bias.data(), input.data(), fixed.data(), padded);
+            for (size_t i = 0; i < expected.size(); ++i)
+            {
+                ASSERT_NEAR(fixed[i], expected[i], 1e-4f) << "kernel " << c.kernel << " at " << i;
+            }
+        }
+    }
+}
+
+TEST(GemmKernelTest, tiled_and_gemv_match_generic)
+{
+    for (int n : {1, 3, 8, 21})
+    {
+        const int m = 13;
+        const int k = 37;
+        const std::vector<float> a = RandomValues(m * k, 4);
+        const std::vector<float> b = RandomValues(k * n, 5);
+        const std::vector<float> bias = RandomValues(m, 6);
+
+        std::vector<float> expected(m * n);
+        std::vector<float> tiled(m * n);
+        layer::GemmGeneric(m, n, k, a.data(), b.data(), bias.data(), expected.data());
+        layer::GemmTiled<4, 8>(m, n, k, a.data(), b.data(), bias.data(), tiled.data());
+        for (int i = 0; i < m * n; ++i)
+        {
+            ASSERT_NEAR(tiled[i], expected[i], 1e-4f);
+        }
+
+        if (n == 1)
+        {
+            std::vector<float> gemv(m);
+            layer::Gemv<8>(m, n, k, a.data(), b.data(), bias.data(), gemv.data());
+            for (int i = 0; i < m; ++i)
+            {
+                ASSERT_NEAR(gemv[i], expected[i], 1e-4f);
+            }
+        }
+    }
+}
+
+TEST(Conv2dLayerTest, runtime_selects_fixed_kernels)
+{
+    std::unique_ptr<pnnx::Graph> graph(new pnnx::Graph);
+    ASSERT_EQ(graph->parse("7767517\n"
+                           "5 4\n"
+                           "pnnx.Input    in0   0 1 0 #0=(1,3,%h,%w)f32\n"
+                           "nn.Conv2d     conv  1 1 0 1 bias=True dilation=(1,1) groups=1 in_channels=3 kernel_size=(3,3) out_channels=5 padding=(1,1) padding_mode=zeros stride=(2,2) @bias=(5)f32 @weight=(5,3,3,3)f32 #0=(1,3,%h,%w)f32 #1=(1,5,?,?)f32\n"
+                           "nn.Conv2d     conv2 1 1 1 2 bias=False dilation=(2,2) groups=1 in_channels=5 kernel_size=(3,3) out_channels=4 padding=(2,2) padding_mode=zeros stride=(1,1) @weight=(4,5,3,3)f32 #1=(1,5,?,?)f32 #2=(1,4,?,?)f32\n"
+                           "nn.Linear     fc    1 1 2 3 bias=True in_features=6 out_features=2 @bias=(2)f32 @weight=(2,6)f32 #2=(1,4,?,?)f32 #3=(1,4,?,2)f32\n"
+                           "pnnx.Output   out0  1 0 3 #3=(1,4,?,2)f32\n"),
+              0);
+    const std::vector<float> conv_weight = RandomValues(5 * 3 * 3 * 3, 7);
+    const std::vector<float> conv_bias = RandomValues(5, 8);
+    const std::vector<float> conv2_weight = RandomValues(4 * 5 * 3 * 3, 9);
+    const std::vector<float> fc_weight = RandomValues(2 * 6, 10);
+    const std::vector<float> fc_bias = RandomValues(2, 11);
+    graph->ops[1]->attrs["weight"].set_float32_data(conv_weight);
+    graph->ops[1]->attrs["bias"].set_float32_data(conv_bias);
+    graph->ops[2]->attrs["weight"].set_float32_data(conv2_weight);
+    graph->ops[3]->attrs["weight"].set_float32_data(fc_weight);
+    graph->ops[3]->attrs["bias"].set_float32_data(fc_bias);
+
+    RuntimeGraph runtime_graph;
+    ASSERT_TRUE(runtime_graph.Init(std::move(graph)));
+
+    // the conv output is 5 x 6 x 6, every row of the linear input has 6 features
+    const std::vector<float> input_values = RandomValues(3 * 11 * 12, 12);
+    auto input = std::make_shared<Operand<float>>("in0", std::vector<int32_t>{1, 3, 11, 12}, 1, AttributeType::Float32);
+    input->data[0] = std::make_shared<Tensor<float>>(3, 11, 12);
+    input->data[0]->Fill(input_values, true);
+
+    std::vector<std::shared_ptr<Operand<float>>> outputs;
+    ASSERT_EQ(runtime_graph.Forward({input}, outputs), StatusCode::Success);
+
+    std::shared_ptr<const ExecutionPlan> plan;
+    ASSERT_EQ(runtime_graph.Plan({{1, 3, 11, 12}}, plan), StatusCode::Success);
+    ASSERT_EQ(plan->kernels[1], "nn.Conv2d.3x3s2");
+    ASSERT_EQ(plan->kernels[2], "nn.Conv2d");
+    ASSERT_EQ(plan->kernels[3], "nn.Linear.gemm4x8");
+
+    layer::Conv2dShape s1;
+    s1.in_channels = 3;
+    s1.in_h = 11;
+    s1.in_w = 12;
+    s1.out_channels = 5;
+    s1.out_h = 6;
+    s1.out_w = 6;
+    s1.kernel_h = s1.kernel_w = 3;
+    s1.stride_h = s1.stride_w = 2;
+    s1.pad_h = s1.pad_w = 1;
+    const std::vector<float> hidden = ReferenceConv2d(s1, conv_weight, conv_bias, input_values);
+
+    layer::Conv2dShape s2 = s1;
+    s2.in_channels = 5;
+    s2.in_h = s2.in_w = 6;
+    s2.out_channels = 4;
+    s2.stride_h = s2.stride_w = 1;
+    s2.pad_h = s2.pad_w = 2;
+    s2.dilation_h = s2.dilation_w = 2;
+    const std::vector<float> conv2 = ReferenceConv2d(s2, conv2_weight, {}, hidden);
+
+    ASSERT_EQ(outputs.size(), 1);
+    ASSERT_EQ(outputs[0]->shapes, std::vector<int32_t>({1, 4, 6, 2}));
+    const std::vector<float> values = outputs[0]->data[0]->values(true);
+    for (int row = 0; row < 4 * 6; ++row)
+    {
+        for (int o = 0; o < 2; ++o)
+        {
+            float expected = fc_bias[o];
+            for (int k = 0; k < 6; ++k)
+            {
+                expected += fc_weight[o * 6 + k] * conv2[row * 6 + k];
+            }
+            ASSERT_NEAR(values[row * 2 + o], expected, 1e-4f);
+        }
+    }
+}
+
+TEST(ElementwiseProgramTest, compile_and_broadcast)
+{
+    layer::ElementwiseProgram program;
+    ASSERT_FALSE(program.Compile("size(@0)"));
+    ASSERT_FALSE(program.Compile("add([1,2],@0)"));
+    ASSERT_FALSE(program.Compile("add(@0)"));
+    ASSERT_FALSE(program.Compile("add(@0,@1"));
+    ASSERT_FALSE(program.Compile("mul(@0,2) 3"));
+
+    // the constant subexpression folds, the temporaries share one register
+    ASSERT_TRUE(program.Compile("add(mul(@0,sub(3,1)),silu(neg(@1)))"));
+    ASSERT_EQ(program.input_count(), 2);
+    ASSERT_EQ(program.instruction_count(), 4);
+    ASSERT_EQ(program.register_count(), 4);
+
+    // @1 broadcasts along the slowest dim and spans several tiles
+    const int64_t dims[3] = {3, 40, 50};
+    const std::vector<float> a = RandomValues(3 * 40 * 50, 13);
+    const std::vector<float> b = RandomValues(40 * 50, 14);
+    std::vector<layer::ElementwiseOperand> inputs(2);
+    inputs[0].data = a.data();
+    inputs[0].strides[0] = 40 * 50;
+    inputs[0].strides[1] = 50;
+    inputs[0].strides[2] = 1;
+    inputs[1].data = b.data();
+    inputs[1].strides[1] = 50;
+    inputs[1].strides[2] = 1;
+
+    std::vector<float> output(a.size());
+    std::vector<float> scratch;
+    program.Run(inputs, dims, output.data(), scratch);
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+        const float x = -b[i % (40 * 50)];
+        ASSERT_NEAR(output[i], a[i] * 2.f + x / (1.f + std::exp(-x)), 1e-5f);
+    }
+
+    // a bare input is copied and a constant fills the output
+    ASSERT_TRUE(program.Compile("@1"));
+    program.Run(inputs, dims, output.data(), scratch);
+    ASSERT_EQ(output[2 * 40 * 50 + 7], b[7]);
+    ASSERT_TRUE(program.Compile("max(-2.5,1e-1)"));
+    ASSERT_EQ(program.input_count(), 0);
+    program.Run({}, dims, output.data(), scratch);
+    ASSERT_EQ(output.back(), 0.1f);
+}
+
+TEST(ElementwiseProgramTest, shape_arithmetic)
+{
+    layer::ElementwiseProgram program;
+    ASSERT_FALSE(program.Compile("[@0,-1]"));
+
+    ASSERT_TRUE(program.Compile("[int(div(size(@0,-1),3)),mul(size(@0,1),size(@1,0)),-1]"));
+    ASSERT_TRUE(program.is_list());
+    ASSERT_EQ(program.input_count(), 2);
+    ASSERT_FALSE(program.uses_tensor(0));
+    std::vector<double> values;
+    ASSERT_TRUE(program.EvaluateShape({{2, 3, 8}, {5}}, values));
+    ASSERT_EQ(values, std::vector<double>({2, 15, -1}));
+    ASSERT_FALSE(program.EvaluateShape({{2, 3, 8}, {}}, values));
+
+    ASSERT_TRUE(program.Compile("floor(sqrt(size(@0,0)))"));
+    ASSERT_TRUE(program.EvaluateShape({{17}}, values));
+    ASSERT_EQ(values, std::vector<double>({4}));
+
+    // the sizes are evaluated once per shape and read as scalars by the tensor code
+    ASSERT_TRUE(program.Compile("sub(@0,mul(size(@1,1),0.5))"));
+    ASSERT_TRUE(program.uses_tensor(0));
+    ASSERT_FALSE(program.uses_tensor(1));
+    std::vector<double> scalars;
+    ASSERT_TRUE(program.EvaluateScalars({{3}, {1, 6}}, scalars));
+
+    const int64_t dims[3] = {1, 1, 3};
+    const std::vector<float> a = {1.f, 2.f, 3.f};
+    std::vector<layer::ElementwiseOperand> inputs(2);
+    inputs[0].data = a.data();
+    inputs[0].strides[2] = 1;
+    std::vector<float> output(3);
+    std::vector<float> scratch;
+    program.Run(inputs, dims, output.data(), scratch, scalars);
+    ASSERT_EQ(output, std::vector<float>({-2.f, -1.f, 0.f}));
+}
+
+TEST(ElementwiseLayerTest, runtime_expression_reads_sizes)
+{
+    std::unique_ptr<pnnx::Graph> graph(new pnnx::Graph);
+    ASSERT_EQ(graph->parse("7767517\n"
+                           "3 2\n"
+                           "pnnx.Input      in0   0 1 0 #0=(1,4,3,5)f32\n"
+                           "pnnx.Expression expr  1 1 0 1 expr=add(div(@0,size(@0,1)),size(@0,0)) #0=(1,4,3,5)f32 #1=(1,4,3,5)f32\n"
+                           "pnnx.Output     out0  1 0 1 #1=(1,4,3,5)f32\n"),
+              0);
+
+    // size() keeps the expression out of the fused operators
+    RuntimeGraph runtime_graph;
+    ASSERT_TRUE(runtime_graph.Init(std::move(graph)));
+    ASSERT_EQ(runtime_graph.graph().ops[1]->type, "pnnx.Expression");
+
+    auto input = std::make_shared<Operand<float>>("in0", std::vector<int32_t>{2, 4, 3, 5}, 2, AttributeType::Float32);
+    std::vector<std::vector<float>> input_values;
+    for (int b = 0; b < 2; ++b)
+    {
+        input_values.push_back(RandomValues(4 * 3 * 5, 21 + b));
+        input->data[b] = std::make_shared<Tensor<float>>(4, 3, 5);
+        input->data[b]->Fill(input_values[b], true);
+    }
+
+    std::vector<std::shared_ptr<Operand<float>>> outputs;
+    ASSERT_EQ(runtime_graph.Forward({input}, outputs), StatusCode::Success);
+    ASSERT_EQ(outputs[0]->data.size(), 2);
+    for (int b = 0; b < 2; ++b)
+    {
+        const std::vector<float> values = outputs[0]->data[b]->values(true);
+        for (int i = 0; i < 4 * 3 * 5; ++i)
+        {
+            ASSERT_NEAR(values[i], input_values[b][i] / 4.f + 2.f, 1e-6f);
+        }
+    }
+}
+
+TEST(ElementwiseLayerTest, runtime_fuses_pointwise_chain)
+{
+    std::unique_ptr<pnnx::Graph> graph(new pnnx::Graph);
+    ASSERT_EQ(graph->parse("7767517\n"
+                           "8 7\n"
+                           "pnnx.Input      in0   0 1 0 #0=(1,4,3,5)f32\n"
+                           "pnnx.Attribute  scale 0 1 1 @data=(1,4,1,1)f32 #1=(1,4,1,1)f32\n"
+                           "F.relu          relu  1 1 0 2 #0=(1,4,3,5)f32 #2=(1,4,3,5)f32\n"
+                           "torch.mul       mul   2 1 2 1 3 #2=(1,4,3,5)f32 #1=(1,4,1,1)f32 #3=(1,4,3,5)f32\n"
+                           "F.sigmoid       sig   1 1 3 4 #3=(1,4,3,5)f32 #4=(1,4,3,5)f32\n"
+                           "pnnx.Expression expr  2 1 4 0 5 expr=sub(@0,mul(@1,5.000000e-01)) #4=(1,4,3,5)f32 #0=(1,4,3,5)f32 #5=(1,4,3,5)f32\n"
+                           "nn.LeakyReLU    leaky 1 1 5 6 negative_slope=0.1 #5=(1,4,3,5)f32 #6=(1,4,3,5)f32\n"
+                           "pnnx.Output     out0  1 0 6 #6=(1,4,3,5)f32\n"),
+              0);
+    const std::vector<float> scale = {0.5f, -1.f, 2.f, 3.f};
+    graph->ops[1]->attrs["data"].set_float32_data(scale);
+
+    RuntimeGraph runtime_graph;
+    ASSERT_TRUE(runtime_graph.Init(std::move(graph)));
+    ASSERT_EQ(runtime_graph.graph().ops.size(), 4);
+    ASSERT_EQ(runtime_graph.graph().ops[2]->type, "jennifer.FusedElementwise");
+
+    // two samples share the constant scale
+    auto input = std::make_shared<Operand<float>>("in0", std::vector<int32_t>{2, 4, 3, 5}, 2, AttributeType::Float32);
+    std::vector<std::vector<float>> input_values;
+    for (int b = 0; b < 2; ++b)
+    {
+        input_values.push_back(RandomValues(4 * 3 * 5, 15 + b));
+        input->data[b] = std::make_shared<Tensor<float>>(4, 3, 5);
+        input->data[b]->Fill(input_values[b], true);
+    }
+
+    std::vector<std::shared_ptr<Operand<float>>> outputs;
+    ASSERT_EQ(runtime_graph.Forward({input}, outputs), StatusCode::Success);
+    ASSERT_EQ(outputs.size(), 1);
+    ASSERT_EQ(outputs[0]->data.size(), 2);
+    for (int b = 0; b < 2; ++b)
+    {
+        const std::vector<float> values = outputs[0]->data[b]->values(true);
+        for (int i = 0; i < 4 * 3 * 5; ++i)
+        {
+            const float x = input_values[b][i];
+            const float s = 1.f / (1.f + std::exp(-std::max(x, 0.f) * scale[i / 15]));
+            const float y = s - x * 0.5f;
+            ASSERT_NEAR(values[i], y > 0.f ? y : 0.1f * y, 1e-5f);
+        }
+    }
+}
+
+// softmax and layer norm of every [outer, axis, inner] line in double precision
+static std::vector<float> ReferenceNormalize(const std::vector<float> &input, int64_t outer, int64_t axis,
+                                             int64_t inner, bool softmax, const std::vector<float> &weight,
+                                             const std::vector<float> &bias, double eps)
+{
+    std::vector<float> output(input.size());
+    for (int64_t o = 0; o < outer; ++o)
+    {
+        for (int64_t i = 0; i < inner; ++i)
+        {
+            const float *x = input.data() + o * axis * inner + i;
+            float *y = output.data() + o * axis * inner + i;
+            double max = -INFINITY;
+            double mean = 0.0;
+            for (int64_t a = 0; a < axis; ++a)
+            {
+                max = std::max(max, static_cast<double>(x[a * inner]));
+                mean += x[a * inner];
+            }
+            mean /= axis;
+            double sum = 0.0;
+            for (int64_t a = 0; a < axis; ++a)
+            {
+                sum += softmax ? std::exp(x[a * inner] - max) : (x[a * inner] - mean) * (x[a * inner] - mean);
+            }
+            for (int64_t a = 0; a < axis; ++a)
+            {
+                y[a * inner] = static_cast<float>(
+                    softmax ? std::exp(x[a * inner] - max) / sum
+                            : (x[a * inner] - mean) / std::sqrt(sum / axis + eps) * weight[a] + bias[a]);
+            }
+        }
+    }
+    return output;
+}
+
+TEST(NormalizeKernelTest, softmax_and_layer_norm_match_reference)
+{
+    // inner > 1 with a partial run, inner == 1 with a lane tail, odd sizes
+    const int64_t views[][3] = {{3, 37, 300}, {5, 1003, 1}, {2, 7, 1}, {1, 3, 13}};
+    for (const auto &view : views)
+    {
+        const int64_t outer = view[0];
+        const int64_t axis = view[1];
+        const int64_t inner = view[2];
+        std::vector<float> input = RandomValues(outer * axis * inner, static_cast<uint32_t>(axis));
+        for (float &v : input)
+        {
+            v = v * 8.f + 3.f;
+        }
+        const std::vector<float> weight = RandomValues(axis, 5);
+        const std::vector<float> bias = RandomValues(axis, 6);
+
+        std::vector<float> output(input.size());
+        layer::SoftmaxKernel(input.data(), output.data(), outer, axis, inner, 2);
+        std::vector<float> expect = ReferenceNormalize(input, outer, axis, inner, true, weight, bias, 0.0);
+        for (size_t i = 0; i < input.size(); ++i)
+        {
+            ASSERT_NEAR(output[i], expect[i], 1e-6f + 1e-5f * expect[i]) << axis << " " << i;
+        }
+
+        layer::LayerNormKernel(input.data(), output.data(), outer, axis, inner, weight.data(), bias.data(), 1e-5f,
+                               2);
+        expect = ReferenceNormalize(input, outer, axis, inner, false, weight, bias, 1e-5);
+        for (size_t i = 0; i < input.size(); ++i)
+        {
+            ASSERT_NEAR(output[i], expect[i], 1e-4f) << axis << " " << i;
+        }
+
+        // in place without affine transform
+        const std::vector<float> ones(axis, 1.f);
+        const std::vector<float> zeros(axis, 0.f);
+        expect = ReferenceNormalize(input, outer, axis, inner, false, ones, zeros, 1e-5);
+        layer::LayerNormKernel(input.data(), input.data(), outer, axis, inner, nullptr, nullptr, 1e-5f, 1);
+        for (size_t i = 0; i < input.size(); ++i)
+        {
+            ASSERT_NEAR(input[i], expect[i], 1e-4f) << axis << " " << i;
+        }
+    }
+
+    // masked scores keep exact zeros
+    std::vector<float> scores = {1.f, -INFINITY, 2.f, -INFINITY, 0.5f, -INFINITY, -INFINITY, 3.f, 1.f};
+    layer::SoftmaxKernel(scores.data(), scores.data(), 1, 9, 1, 1);
+    ASSERT_EQ(scores[1], 0.f);
+    ASSERT_EQ(scores[5], 0.f);
+    ASSERT_NEAR(scores[0] + scores[2] + scores[4] + scores[7] + scores[8], 1.f, 1e-6f);
+}
+
+TEST(NormalizeLayerTest, runtime_layer_norm_softmax_gelu)
+{
+    std::unique_ptr<pnnx::Graph> graph(new pnnx::Graph);
+    ASSERT_EQ(graph->parse("7767517\n"
+                           "5 4\n"
+                           "pnnx.Input   in0  0 1 0 #0=(1,6,40)f32\n"
+                           "nn.LayerNorm norm 1 1 0 1 elementwise_affine=True eps=1.000000e-05 normalized_shape=(40) "
+                           "@weight=(40)f32 @bias=(40)f32 #0=(1,6,40)f32 #1=(1,6,40)f32\n"
+                           "F.softmax    sm   1 1 1 2 dim=-1 #1=(1,6,40)f32 #2=(1,6,40)f32\n"
+                           "nn.GELU      gelu 1 1 2 3 #2=(1,6,40)f32 #3=(1,6,40)f32\n"
+                           "pnnx.Output  out0 1 0 3 #3=(1,6,40)f32\n"),
+              0);
+    const std::vector<float> weight = RandomValues(40, 31);
+    const std::vector<float> bias = RandomValues(40, 32);
+    graph->ops[1]->attrs["weight"].set_float32_data(weight);
+    graph->ops[1]->attrs["bias"].set_float32_data(bias);
+
+    RuntimeGraph runtime_graph;
+    ASSERT_TRUE(runtime_graph.Init(std::move(graph)));
+
+    auto input = std::make_shared<Operand<float>>("in0", std::vector<int32_t>{2, 6, 40}, 2, AttributeType::Float32);
+    std::vector<std::vector<float>> input_values;
+    for (int b = 0; b < 2; ++b)
+    {
+        input_values.push_back(RandomValues(6 * 40, 33 + b));
+        input->data[b] = std::make_shared<Tensor<float>>(1, 6, 40);
+        input->data[b]->Fill(input_values[b], true);
+    }
+
+    std::vector<std::shared_ptr<Operand<float>>> outputs;
+    ASSERT_EQ(runtime_graph.Forward({input}, outputs), StatusCode::Success);
+    ASSERT_EQ(outputs[0]->data.size(), 2);
+    for (int b = 0; b < 2; ++b)
+    {
+        std::vector<float> expect = ReferenceNormalize(input_values[b], 6, 40, 1, false, weight, bias, 1e-5);
+        expect = ReferenceNormalize(expect, 6, 40, 1, true, weight, bias, 0.0);
+        const std::vector<float> values = outputs[0]->data[b]->values(true);
+        for (int i = 0; i < 6 * 40; ++i)
+        {
+            const double x = expect[i];
+            ASSERT_NEAR(values[i], 0.5 * x * (1.0 + std::erf(x / std::sqrt(2.0))), 1e-5f);
+        }
+    }
+}
+
+// row major [heads, len, dim] inputs, one score row at a time in double precision
+static std::vector<float> ReferenceAttention(const layer::AttentionShape &s, const std::vector<float> &q,
+                                             const std::vector<float> &k, const std::vector<float> &v,
+                                             const std::vector<float> &mask)
+{
+    std::vector<float> output(s.heads * s.q_len * s.value_dim);
+    std::vector<double> scores(s.kv_len);
+    for (int64_t h = 0; h < s.heads; ++h)
+    {
+        const int64_t kh = h / (s.heads / s.kv_heads);
+        for (int64_t i = 0; i < s.q_len; ++i)
+        {
+            double max = -INFINITY;
+            for (int64_t j = 0; j < s.kv_len; ++j)
+            {
+                double dot = 0.0;
+                for (int64_t c = 0; c < s.head_dim; ++c)
+                {
+                    dot += q[(h * s.q_len + i) * s.head_dim + c] * k[(kh * s.kv_len + j) * s.head_dim + c];
+                }
+                scores[j] = dot * s.scale + (mask.empty() ? 0.0 : mask[i * s.kv_len + j]);
+                if (s.causal && j > i + s.causal_offset)
+                {
+                    scores[j] = -INFINITY;
+                }
+                max = std::max(max, scores[j]);
+            }
+            double sum = 0.0;
+            for (int64_t j = 0; j < s.kv_len; ++j)
+            {
+                scores[j] = std::exp(scores[j] - max);
+                sum += scores[j];
+            }
+            for (int64_t c = 0; c < s.value_dim; ++c)
+            {
+                double value = 0.0;
+                for (int64_t j = 0; j < s.kv_len; ++j)
+                {
+                    value += scores[j] * v[(kh * s.kv_len + j) * s.value_dim + c];
+                }
+                output[(h * s.q_len + i) * s.value_dim + c] = static_cast<float>(value / sum);
+            }
+        }
+    }
+    return output;
+}
+
+TEST(AttentionKernelTest, tiled_match_reference)
+{
+    layer::AttentionShape shape;
+    shape.heads = 4;
+    shape.kv_heads = 2;
+    shape.q_len = 70;
+    shape.kv_len = 131;
+    shape.head_dim = 16;
+    shape.value_dim = 12;
+    shape.scale = 0.25f;
+    const std::vector<float> q = RandomValues(shape.heads * shape.q_len * shape.head_dim, 41);
+    const std::vector<float> k = RandomValues(shape.kv_heads * shape.kv_len * shape.head_dim, 42);
+    const std::vector<float> v = RandomValues(shape.kv_heads * shape.kv_len * shape.value_dim, 43);
+    const std::vector<float> mask = RandomValues(shape.q_len * shape.kv_len, 44);
+
+    auto row_major = [](const float *data, int64_t len, int64_t dim) {
+        layer::AttentionView<const float> view;
+        view.data = data;
+        view.head_stride = len * dim;
+        view.row_stride = dim;
+        view.col_stride = 1;
+        return view;
+    };
+    layer::AttentionView<const float> mask_view = row_major(mask.data(), shape.q_len, shape.kv_len);
+    mask_view.head_stride = 0;
+
+    // dense with a broadcast mask, causal aligned to the end of the keys, causal from the start
+    for (int variant = 0; variant < 3; ++variant)
+    {
+        shape.causal = variant != 0;
+        shape.causal_offset = variant == 1 ? shape.kv_len - shape.q_len : 0;
+        std::vector<float> output(shape.heads * shape.q_len * shape.value_dim);
+        layer::AttentionView<float> output_view;
+        output_view.data = output.data();
+        output_view.head_stride = shape.q_len * shape.value_dim;
+        output_view.row_stride = shape.value_dim;
+        output_view.col_stride = 1;
+        layer::AttentionKernel(shape, row_major(q.data(), shape.q_len, shape.head_dim),
+                               row_major(k.data(), shape.kv_len, shape.head_dim),
+                               row_major(v.data(), shape.kv_len, shape.value_dim),
+                               variant == 0 ? mask_view : layer::AttentionView<const float>(), output_view, 3);
+
+        const std::vector<float> expect =
+            ReferenceAttention(shape, q, k, v, variant == 0 ? mask : std::vector<float>());
+        for (size_t i = 0; i < output.size(); ++i)
+        {
+            ASSERT_NEAR(output[i], expect[i], 1e-5f) << variant << " " << i;
+        }
+    }
+}
+
+TEST(AttentionLayerTest, runtime_fuses_manual_attention)
+{
+    std::unique_ptr<pnnx::Graph> graph(new pnnx::Graph);
+    ASSERT_EQ(graph->parse("7767517\n"
+                           "8 8\n"
+                           "pnnx.Input      q     0 1 0 #0=(1,2,37,8)f32\n"
+                           "pnnx.Input      k     0 1 1 #1=(1,2,45,8)f32\n"
+                           "pnnx.Input      v     0 1 2 #2=(1,2,45,8)f32\n"
+                           "Tensor.permute  kt    1 1 1 3 dims=(0,1,3,2) #1=(1,2,45,8)f32 #3=(1,2,8,45)f32\n"
+                           "torch.matmul    qk    2 1 0 3 4 #0=(1,2,37,8)f32 #3=(1,2,8,45)f32 #4=(1,2,37,45)f32\n"
+                           "F.softmax       sm    1 1 4 5 dim=3 #4=(1,2,37,45)f32 #5=(1,2,37,45)f32\n"
+                           "torch.matmul    av    2 1 5 2 6 #5=(1,2,37,45)f32 #2=(1,2,45,8)f32 #6=(1,2,37,8)f32\n"
+                           "pnnx.Output     out0  1 0 6 #6=(1,2,37,8)f32\n"),
+              0);
+
+    RuntimeGraph runtime_graph;
+    ASSERT_TRUE(runtime_graph.Init(std::move(graph)));
+    ASSERT_EQ(runtime_graph.graph().ops.size(), 5);
+    ASSERT_EQ(runtime_graph.graph().ops[3]->type, "F.scaled_dot_product_attention");
+
+    const int32_t lens[3] = {37, 45, 45};
+    std::vector<std::shared_ptr<Operand<float>>> inputs;
+    std::vector<std::vector<float>> values[3];
+    for (int n = 0; n < 3; ++n)
+    {
+        inputs.push_back(std::make_shared<Operand<float>>(std::string(1, "qkv"[n]),
+                                                          std::vector<int32_t>{2, 2, lens[n], 8}, 2,
+                                                          AttributeType::Float32));
+        for (int b = 0; b < 2; ++b)
+        {
+            values[n].push_back(RandomValues(2 * lens[n] * 8, 50 + n * 2 + b));
+            inputs[n]->data[b] = std::make_shared<Tensor<float>>(2, lens[n], 8);
+            inputs[n]->data[b]->Fill(values[n][b], true);
+        }
+    }
+
+    std::vector<std::shared_ptr<Operand<float>>> outputs;
+    ASSERT_EQ(runtime_graph.Forward(inputs, outputs), StatusCode::Success);
+    ASSERT_EQ(outputs[0]->data.size(), 2);
+
+    layer::AttentionShape shape;
+    shape.heads = 2;
+    shape.kv_heads = 2;
+    shape.q_len = 37;
+    shape.kv_len = 45;
+    shape.head_dim = 8;
+    shape.value_dim = 8;
+    for (int b = 0; b < 2; ++b)
+    {
+        const std::vector<float> expect = ReferenceAttention(shape, values[0][b], values[1][b], values[2][b], {});
+        const std::vector<float> result = outputs[0]->data[b]->values(true);
+        for (size_t i = 0; i < expect.size(); ++i)
+        {
+            ASSERT_NEAR(result[i], expect[i], 1e-5f);
+        }
+    }
+}
+
+TEST(AttentionLayerTest, runtime_decode_matches_causal_forward)
+{
+    std::unique_ptr<pnnx::Graph> graph(new pnnx::Graph);
+    ASSERT_EQ(graph->parse("7767517\n"
+                           "5 4\n"
+                           "pnnx.Input      q     0 1 0 #0=(1,2,?,8)f32\n"
+                           "pnnx.Input      k     0 1 1 #1=(1,2,?,8)f32\n"
+                           "pnnx.Input      v     0 1 2 #2=(1,2,?,8)f32\n"
+                           "F.scaled_dot_product_attention attn 3 1 0 1 2 3 dropout_p=0.0 is_causal=True "
+                           "#0=(1,2,?,8)f32 #1=(1,2,?,8)f32 #2=(1,2,?,8)f32 #3=(1,2,?,8)f32\n"
+                           "pnnx.Output     out0  1 0 3 #3=(1,2,?,8)f32\n"),
+              0);
+    RuntimeGraph runtime_graph;
+    ASSERT_TRUE(runtime_graph.Init(std::move(graph)));
+
+    // rows [begin, end) of the (2, 20, 8) samples of every sequence as q, k and v
+    const int32_t len = 20;
+    std::vector<std::vector<float>> values[3];
+    for (int n = 0; n < 3; ++n)
+    {
+        for (int b = 0; b < 2; ++b)
+        {
+            values[n].push_back(RandomValues(2 * len * 8, 70 + n * 2 + b));
+        }
+    }
+    auto make_inputs = [&](int32_t begin, int32_t end) {
+        std::vector<std::shared_ptr<Operand<float>>> inputs;
+        for (int n = 0; n < 3; ++n)
+        {
+            inputs.push_back(std::make_shared<Operand<float>>(std::string(1, "qkv"[n]),
+                                                              std::vector<int32_t>{2, 2, end - begin, 8}, 2,
+                                                              AttributeType::Float32));
+            for (int b = 0; b < 2; ++b)
+            {
+                std::vector<float> rows;
+                for (int h = 0; h < 2; ++h)
+                {
+                    rows.insert(rows.end(), values[n][b].begin() + (h * len + begin) * 8,
+                                values[n][b].begin() + (h * len + end) * 8);
+                }
+                inputs[n]->data[b] = std::make_shared<Tensor<float>>(2, end - begin, 8);
+                inputs[n]->data[b]->Fill(rows, true);
+            }
+        }
+        return inputs;
+    };
+
+    std::vector<std::shared_ptr<Operand<float>>> outputs;
+    ASSERT_EQ(runtime_graph.Forward(make_inputs(0, len), outputs), StatusCode::Success);
+    std::vector<std::vector<float>> expect;
+    for (int b = 0; b < 2; ++b)
+    {
+        expect.push_back(outputs[0]->data[b]->values(true));
+    }
+
+    // pages of 4 tokens, so the prefill and the steps cross page boundaries
+    runtime::KVCacheConfig config;
+    config.page_tokens = 4;
+    config.max_pages = 32;
+    runtime::KVCache cache(config);
+    const std::vector<int64_t> sequences = {cache.AddSequence(), cache.AddSequence()};
+    int32_t begin = 0;
+    for (int32_t end : {11, 12, 13, 16, 17, 20})
+    {
+        ASSERT_EQ(runtime_graph.Decode(make_inputs(begin, end), sequences, cache, outputs), StatusCode::Success);
+        for (int b = 0; b < 2; ++b)
+        {
+            ASSERT_EQ(cache.length(sequences[b]), end);
+            const std::vector<float> result = outputs[0]->data[b]->values(true);
+            for (int h = 0; h < 2; ++h)
+            {
+                for (int32_t t = begin; t < end; ++t)
+                {
+                    for (int c = 0; c < 8; ++c)
+                    {
+                        ASSERT_NEAR(result[(h * (end - begin) + t - begin) * 8 + c], expect[b][(h * len + t) * 8 + c],
+                                    1e-5f);
+                    }
+                }
+            }
+        }
+        begin = end;
+    }
+
+    // 20 tokens take 5 key and 5 value pages per sequence, removal gives them back
+    ASSERT_EQ(cache.free_pages(), 32 - 2 * 10);
+    cache.RemoveSequence(sequences[0]);
+    ASSERT_EQ(cache.free_pages(), 32 - 10);
+    ASSERT_EQ(runtime_graph.Decode(make_inputs(0, 1), sequences, cache, outputs), StatusCode::InferParamError);
+}
+
+// row major [channels, in_h, in_w] input, torch upsample_nearest2d and upsample_bilinear2d
+static std::vector<float> ReferenceInterpolate(const std::vector<float> &input, int64_t channels, int64_t in_h,
+                                               int64_t in_w, int64_t out_h, int64_t out_w, bool bilinear,
+                                               bool align_corners, float factor)
+{
+    auto scale = [&](int64_t in, int64_t out) {
+        if (bilinear && align_corners)
+        {
+            return out > 1 ? double(in - 1) / double(out - 1) : 0.0;
+        }
+        return factor > 0.f ? 1.0 / factor : double(in) / double(out);
+    };
+    const double sh = scale(in_h, out_h);
+    const double sw = scale(in_w, out_w);
+    std::vector<float> output(channels * out_h * out_w);
+    for (int64_t c = 0; c < channels; ++c)
+    {
+        const float *x = input.data() + c * in_h * in_w;
+        for (int64_t h = 0; h < out_h; ++h)
+        {
+            for (int64_t w = 0; w < out_w; ++w)
+            {
+                float &y = output[(c * out_h + h) * out_w + w];
+                if (!bilinear)
+                {
+                    const int64_t ih = std::min<int64_t>(static_cast<int64_t>(std::floor(float(h * sh))), in_h - 1);
+                    const int64_t iw = std::min<int64_t>(static_cast<int64_t>(std::floor(float(w * sw))), in_w - 1);
+                    y = x[ih * in_w + iw];
+                    continue;
+                }
+                const double fh = std::max(align_corners ? h * sh : (h + 0.5) * sh - 0.5, 0.0);
+                const double fw = std::max(align_corners ? w * sw : (w + 0.5) * sw - 0.5, 0.0);
+                const int64_t h0 = std::min<int64_t>(static_cast<int64_t>(fh), in_h - 1);
+                const int64_t w0 = std::min<int64_t>(static_cast<int64_t>(fw), in_w - 1);
+                const int64_t h1 = std::min(h0 + 1, in_h - 1);
+                const int64_t w1 = std::min(w0 + 1, in_w - 1);
+                const double lh = fh - h0;
+                const double lw = fw - w0;
+                y = static_cast<float>((1 - lh) * ((1 - lw) * x[h0 * in_w + w0] + lw * x[h0 * in_w + w1]) +
+                                       lh * ((1 - lw) * x[h1 * in_w + w0] + lw * x[h1 * in_w + w1]));
+            }
+        }
+    }
+    return output;
+}
+
+TEST(InterpolateKernelTest, nearest_and_bilinear_match_reference)
+{
+    struct Case
+    {
+        int64_t in_h, in_w, out_h, out_w;
+        bool bilinear, align_corners;
+        float factor;
+    };
+    const Case cases[] = {
+        {13, 9, 26, 18, false, false, 2.f},   {5, 7, 20, 20, false, false, 0.f},  {7, 5, 10, 13, false, false, 0.f},
+        {8, 8, 3, 5, false, false, 0.f},      {9, 6, 27, 18, false, false, 3.f},  {13, 9, 26, 18, true, false, 2.f},
+        {4, 6, 9, 11, true, true, 0.f},       {11, 10, 4, 7, true, false, 0.f},   {1, 5, 3, 10, true, true, 0.f},
+    };
+    for (const Case &c : cases)
+    {
+        const int64_t channels = 3;
+        const std::vector<float> values = RandomValues(channels * c.in_h * c.in_w, 60);
+        Tensor<float> input(channels, c.in_h, c.in_w);
+        input.Fill(values, true);
+        Tensor<float> output(channels, c.out_h, c.out_w);
+        layer::InterpolateKernel(input.data_ptr(), output.data_ptr(), channels, c.in_h, c.in_w, c.out_h, c.out_w,
+                                 c.bilinear ? layer::InterpolateMode::Bilinear : layer::InterpolateMode::Nearest,
+                                 c.align_corners, c.factor, c.factor, 2);
+        const std::vector<float> expect = ReferenceInterpolate(values, channels, c.in_h, c.in_w, c.out_h, c.out_w,
+                                                               c.bilinear, c.align_corners, c.factor);
+        const std::vector<float> result = output.values(true);
+        for (size_t i = 0; i < expect.size(); ++i)
+        {
+            ASSERT_NEAR(result[i], expect[i], 1e-5f) << c.in_h << "x" << c.in_w << " to " << c.out_h << "x" << c.out_w;
+        }
+    }
+}
+
+TEST(InterpolateLayerTest, runtime_upsample_and_interpolate)
+{
+    std::unique_ptr<pnnx::Graph> graph(new pnnx::Graph);
+    ASSERT_EQ(graph->parse("7767517\n"
+                           "4 3\n"
+                           "pnnx.Input    in0 0 1 0 #0=(1,4,6,5)f32\n"
+                           "F.interpolate up  1 1 0 1 align_corners=False mode=bilinear "
+                           "scale_factor=(2.000000e+00,2.000000e+00) #0=(1,4,6,5)f32 #1=(1,4,12,10)f32\n"
+                           "nn.Upsample   up2 1 1 1 2 mode=nearest size=(17,30) #1=(1,4,12,10)f32 #2=(1,4,17,30)f32\n"
+                           "pnnx.Output   out0 1 0 2 #2=(1,4,17,30)f32\n"),
+              0);
+    RuntimeGraph runtime_graph;
+    ASSERT_TRUE(runtime_graph.Init(std::move(graph)));
+
+    auto input = std::make_shared<Operand<float>>("in0", std::vector<int32_t>{2, 4, 6, 5}, 2, AttributeType::Float32);
+    std::vector<std::vector<float>> input_values;
+    for (int b = 0; b < 2; ++b)
+    {
+        input_values.push_back(RandomValues(4 * 6 * 5, 61 + b));
+        input->data[b] = std::make_shared<Tensor<float>>(4, 6, 5);
+        input->data[b]->Fill(input_values[b], true);
+    }
+
+    std::vector<std::shared_ptr<Operand<float>>> outputs;
+    ASSERT_EQ(runtime_graph.Forward({input}, outputs), StatusCode::Success);
+    ASSERT_EQ(outputs[0]->data.size(), 2);
+    for (int b = 0; b < 2; ++b)
+    {
+        std::vector<float> expect = ReferenceInterpolate(input_values[b], 4, 6, 5, 12, 10, true, false, 2.f);
+        expect = ReferenceInterpolate(expect, 4, 12, 10, 17, 30, false, false, 0.f);
+        const std::vector<float> result = outputs[0]->data[b]->values(true);
+        ASSERT_EQ(result.size(), expect.size());
+        for (size_t i = 0; i < expect.size(); ++i)
+        {
+            ASSERT_NEAR(result[i], expect[i], 1e-5f);
+        }
+    }
+}
+
+TEST(TransposeKernelTest, permutations_match_reference)
+{
+    // row-major in and out, sizes off the 8 x 8 tiles, every order of four dims
+    const int64_t dims[4] = {3, 10, 17, 9};
+    const int64_t count = 3 * 10 * 17 * 9;
+    const std::vector<float> input = RandomValues(count, 70);
+    const int64_t in_strides[4] = {10 * 17 * 9, 17 * 9, 9, 1};
+    int32_t perm[4] = {0, 1, 2, 3};
+    do
+    {
+        int64_t shape[4];
+        int64_t src[4];
+        for (int k = 0; k < 4; ++k)
+        {
+            shape[k] = dims[perm[k]];
+            src[k] = in_strides[perm[k]];
+        }
+        const int64_t dst[4] = {shape[1] * shape[2] * shape[3], shape[2] * shape[3], shape[3], 1};
+        std::vector<float> output(count, 0.f);
+        layer::TransposeKernel(input.data(), output.data(), 4, shape, src, dst, 2);
+
+        for (int64_t n = 0; n < count; ++n)
+        {
+            int64_t rest = n;
+            int64_t from = 0;
+            int64_t to = 0;
+            for (int k = 3; k >= 0; --k)
+            {
+                from += rest % shape[k] * src[k];
+                to += rest % shape[k] * dst[k];
+                rest /= shape[k];
+            }
+            ASSERT_EQ(output[to], input[from]) << perm[0] << perm[1] << perm[2] << perm[3];
+        }
+    } while (std::next_permutation(perm, perm + 4));
+
+    // dims before the last two fold into the channels, planes are stored col by col
+    const std::vector<int64_t> strides = layer::TensorStrides({2, 3, 4, 5});
+    ASSERT_EQ(strides, std::vector<int64_t>({60, 20, 1, 4}));
+}
+
+} // namespace jennifer
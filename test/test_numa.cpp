@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <fstream>
+#include <thread>
+
+#include "jennifer/runtime/numa.hpp"
+#include "jennifer/runtime/replica_set.hpp"
+#include "test/scale_chain.hpp"
+
+using namespace jennifer::data;
+using namespace jennifer::runtime;
+using jennifer::utils::StatusCode;
+
+namespace jennifer
+{
+
+TEST(NumaTest, parse_cpu_lists_and_detect_topology)
+{
+    ASSERT_EQ(ParseCpuList("0-3,8,10-11\n"), std::vector<int32_t>({0, 1, 2, 3, 8, 10, 11}));
+    ASSERT_TRUE(ParseCpuList("3-1").empty());
+    ASSERT_TRUE(ParseCpuList("a").empty());
+
+    // node1 is listed first, node2 has no cpus and possible is not a node
+    char root[] = "/tmp/jennifer_numa_XXXXXX";
+    ASSERT_NE(mkdtemp(root), nullptr);
+    const std::string dir = root;
+    const char *nodes[][2] = {{"node1", "0\n"}, {"node0", "0\n"}, {"node2", "\n"}};
+    for (const auto &node : nodes)
+    {
+        ASSERT_EQ(mkdir((dir + "/" + node[0]).c_str(), 0755), 0);
+        std::ofstream(dir + "/" + node[0] + "/cpulist") << node[1];
+    }
+    std::ofstream(dir + "/possible") << "0-2\n";
+
+    const std::vector<NumaNode> topology = DetectNumaTopology(dir);
+    ASSERT_EQ(topology.size(), 2);
+    ASSERT_EQ(topology[0].id, 0);
+    ASSERT_EQ(topology[1].id, 1);
+    ASSERT_EQ(topology[1].cpus, std::vector<int32_t>({0}));
+
+    const std::vector<NumaNode> fallback = DetectNumaTopology(dir + "/missing");
+    ASSERT_EQ(fallback.size(), 1);
+    ASSERT_FALSE(fallback[0].cpus.empty());
+
+    // a replica per node, each pinned to cpu 0 and serving callers from many threads
+    ReplicaOptions options;
+    options.topology_root = dir;
+    ReplicaSet replicas(
+        []() {
+            std::unique_ptr<RuntimeGraph> graph(new RuntimeGraph);
+            return graph->Init(ParseGraph(kScaleChain)) ? std::move(graph) : nullptr;
+        },
+        options);
+    ASSERT_TRUE(replicas.Init());
+    ASSERT_EQ(replicas.size(), 2);
+
+    std::atomic<int> failures{0};
+    std::vector<std::thread> callers;
+    for (int t = 0; t < 4; ++t)
+    {
+        callers.emplace_back([&replicas, &failures, t]() {
+            for (int i = 0; i < 8; ++i)
+            {
+                auto input = std::make_shared<Operand<float>>("in0", std::vector<int32_t>{1, 3, 4, 5}, 1,
+                                                              AttributeType::Float32);
+                input->data[0] = std::make_shared<Tensor<float>>(3, 4, 5);
+                input->data[0]->Fill(static_cast<float>(t + i));
+                std::vector<std::shared_ptr<Operand<float>>> outputs;
+                if (replicas.Forward({input}, outputs) != StatusCode::Success
+                    || outputs[0]->data[0]->at(2, 3, 4) != 16.f * (t + i))
+                {
+                    failures += 1;
+                }
+            }
+        });
+    }
+    for (std::thread &caller : callers)
+    {
+        caller.join();
+    }
+    ASSERT_EQ(failures, 0);
+    ASSERT_EQ(replicas.served(0) + replicas.served(1), 32);
+    replicas.Stop();
+    std::vector<std::shared_ptr<Operand<float>>> outputs;
+    ASSERT_EQ(replicas.Forward({}, outputs), StatusCode::RuntimeStopped);
+
+    for (const auto &node : nodes)
+    {
+        unlink((dir + "/" + node[0] + "/cpulist").c_str());
+        rmdir((dir + "/" + node[0]).c_str());
+    }
+    unlink((dir + "/possible").c_str());
+    rmdir(root);
+}
+
+} // namespace jennifer
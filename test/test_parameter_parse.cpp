@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <string>
+
+#include "jennifer/runtime/pnnx/ir.h"
+
+namespace jennifer
+{
+
+// both parsers agree on the value or both throw
+static void ExpectSameParse(const std::string &value)
+{
+    pnnx::Parameter legacy;
+    bool legacy_throws = false;
+    try
+    {
+        legacy = pnnx::Parameter::parse_from_string_legacy(value);
+    }
+    catch (const std::exception &)
+    {
+        legacy_throws = true;
+    }
+
+    pnnx::Parameter fast;
+    bool fast_throws = false;
+    try
+    {
+        fast = pnnx::Parameter::parse_from_string(value);
+    }
+    catch (const std::exception &)
+    {
+        fast_throws = true;
+    }
+
+    ASSERT_EQ(fast_throws, legacy_throws) << "value " << value;
+    if (!legacy_throws)
+    {
+        ASSERT_EQ(fast.type, legacy.type) << "value " << value;
+        ASSERT_TRUE(fast == legacy) << "value " << value;
+    }
+}
+
+TEST(ParameterParseTest, edge_cases)
+{
+    const char *values[] = {
+        "", "None", "()", "[]", "True", "False", "(", "[", "-", "-x", "%h", "(%h,%w)", "1", "-1", "007",
+        "2147483647", "-2147483648", "2147483648", "99999999999", "1.5", "-0.0", "1e", "1e5", "1.5e",
+        "1e-3", "1.0e+2", "3.402823e+38", "1e39", "1e-40", "1e-50", "0xe", "0x1p3", "1.5f", "12abc",
+        "(1,2,3)", "(1,)", "(,)", "(1,,2)", "(1.5,2)", "(1,2.5)", "(a,1)", "(1,a)", "(-,1)", "[1e39,1]",
+        "(0xe,1)", "(2147483648)", "[-1.0e-05,2]", "(1, 2)", "( 1,2)", "(a,b,c)",
+    };
+    for (const char *value : values)
+    {
+        ExpectSameParse(value);
+    }
+}
+
+TEST(ParameterParseTest, random_tokens)
+{
+    const std::string alphabet = "0123456789--..ee,,()[]xa%";
+    const char *words[] = {"True", "False", "None", "inf", "nan", "2147483648", "1e38", "1e-45"};
+
+    std::mt19937 rng(0);
+    for (int n = 0; n < 20000; ++n)
+    {
+        std::string value;
+        const int length = static_cast<int>(rng() % 12);
+        for (int i = 0; i < length; ++i)
+        {
+            if (rng() % 16 == 0)
+            {
+                value += words[rng() % 8];
+            }
+            else
+            {
+                value += alphabet[rng() % alphabet.size()];
+            }
+        }
+        // mostly lists of numbers as exported graphs have them
+        if (n % 2 == 0)
+        {
+            value = (n % 4 == 0 ? "(" : "[") + value + (n % 4 == 0 ? ")" : "]");
+        }
+        ExpectSameParse(value);
+    }
+}
+
+} // namespace jennifer
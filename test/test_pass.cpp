@@ -0,0 +1,272 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+#include "jennifer/pass/eliminate.hpp"
+#include "jennifer/pass/fold_constants.hpp"
+#include "jennifer/pass/fuse_attention.hpp"
+#include "jennifer/pass/fuse_elementwise.hpp"
+
+namespace jennifer
+{
+
+static std::unique_ptr<pnnx::Graph> ParsePassGraph(const std::string &param)
+{
+    std::unique_ptr<pnnx::Graph> graph(new pnnx::Graph);
+    EXPECT_EQ(graph->parse(param), 0);
+    return graph;
+}
+
+static void SetAttributeData(pnnx::Graph &graph, const std::string &name, const std::vector<float> &values)
+{
+    for (pnnx::Operator *op : graph.ops)
+    {
+        if (op->name == name)
+        {
+            pnnx::Attribute &attr = op->attrs.begin()->second;
+            attr.data.resize(values.size() * sizeof(float));
+            memcpy(attr.data.data(), values.data(), attr.data.size());
+        }
+    }
+}
+
+static std::vector<float> AttributeData(const pnnx::Operand *operand)
+{
+    const pnnx::Attribute &attr = operand->producer->attrs.begin()->second;
+    std::vector<float> values(attr.data.size() / sizeof(float));
+    memcpy(values.data(), attr.data.data(), attr.data.size());
+    return values;
+}
+
+TEST(FoldConstantsTest, fold_attribute_chain)
+{
+    const std::string param = "7767517\n"
+                              "8 7\n"
+                              "pnnx.Input      in0   0 1 0 #0=(1,4)f32\n"
+                              "pnnx.Attribute  a     0 1 1 @data=(2,2)f32 #1=(2,2)f32\n"
+                              "pnnx.Attribute  b     0 1 2 @data=(4)f32 #2=(4)f32\n"
+                              "Tensor.reshape  r     1 1 1 3 shape=(4) #1=(2,2)f32 #3=(4)f32\n"
+                              "torch.add       add0  2 1 3 2 4 #3=(4)f32 #2=(4)f32 #4=(4)f32\n"
+                              "torch.add       add1  2 1 0 4 5 #0=(1,4)f32 #4=(4)f32 #5=(1,4)f32\n"
+                              "torch.mul       mul   2 1 5 5 6 #5=(1,4)f32 #5=(1,4)f32 #6=(1,4)f32\n"
+                              "pnnx.Output     out0  1 0 6 #6=(1,4)f32\n";
+    std::unique_ptr<pnnx::Graph> graph = ParsePassGraph(param);
+    SetAttributeData(*graph, "a", {1.f, 2.f, 3.f, 4.f});
+    SetAttributeData(*graph, "b", {10.f, 20.f, 30.f, 40.f});
+
+    ASSERT_EQ(pass::FoldConstants(*graph), 2);
+
+    // only the folded constant feeding add1 survives, placed before its consumer
+    ASSERT_EQ(graph->ops.size(), 5);
+    ASSERT_EQ(graph->ops[0]->type, "pnnx.Input");
+    ASSERT_EQ(graph->ops[1]->type, "pnnx.Attribute");
+    ASSERT_EQ(graph->ops[2]->name, "add1");
+    ASSERT_EQ(graph->get_operand("1"), nullptr);
+    ASSERT_EQ(graph->get_operand("2"), nullptr);
+    ASSERT_EQ(graph->get_operand("3"), nullptr);
+
+    const pnnx::Operand *folded = graph->get_operand("4");
+    ASSERT_EQ(folded->producer, graph->ops[1]);
+    ASSERT_EQ(folded->shape, std::vector<int>({4}));
+    ASSERT_EQ(AttributeData(folded), std::vector<float>({11.f, 22.f, 33.f, 44.f}));
+}
+
+TEST(FoldConstantsTest, fold_permute_slice_cat)
+{
+    const std::string param = "7767517\n"
+                              "7 7\n"
+                              "pnnx.Input      in0   0 1 0 #0=(3,2)f32\n"
+                              "pnnx.Attribute  a     0 1 1 @data=(2,3)f32 #1=(2,3)f32\n"
+                              "torch.permute   p     1 1 1 2 dims=(1,0) #1=(2,3)f32 #2=(3,2)f32\n"
+                              "Tensor.slice    s     1 1 2 3 dim=0 end=3 start=1 step=1 #2=(3,2)f32 #3=(2,2)f32\n"
+                              "torch.cat       cat   2 1 2 3 4 dim=0 #2=(3,2)f32 #3=(2,2)f32 #4=(5,2)f32\n"
+                              "torch.cat       cat2  2 1 0 4 5 dim=0 #0=(3,2)f32 #4=(5,2)f32 #5=(8,2)f32\n"
+                              "pnnx.Output     out0  1 0 5 #5=(8,2)f32\n";
+    std::unique_ptr<pnnx::Graph> graph = ParsePassGraph(param);
+    SetAttributeData(*graph, "a", {1.f, 2.f, 3.f, 4.f, 5.f, 6.f});
+
+    ASSERT_EQ(pass::FoldConstants(*graph), 3);
+
+    const pnnx::Operand *folded = graph->get_operand("4");
+    ASSERT_EQ(folded->producer->type, "pnnx.Attribute");
+    ASSERT_EQ(folded->shape, std::vector<int>({5, 2}));
+    ASSERT_EQ(AttributeData(folded), std::vector<float>({1.f, 4.f, 2.f, 5.f, 3.f, 6.f, 2.f, 5.f, 3.f, 6.f}));
+    ASSERT_EQ(graph->ops.size(), 4);
+}
+
+TEST(FoldConstantsTest, fold_expression)
+{
+    const std::string param = "7767517\n"
+                              "6 5\n"
+                              "pnnx.Input      in0   0 1 0 #0=(2,3)f32\n"
+                              "pnnx.Attribute  a     0 1 1 @data=(2,3)f32 #1=(2,3)f32\n"
+                              "pnnx.Expression e0    1 1 1 2 expr=mul(@0,size(@0,0)) #1=(2,3)f32 #2=(2,3)f32\n"
+                              "pnnx.Expression e1    1 1 1 3 expr=[size(@0,1),-1] #1=(2,3)f32 #3=(2)i64\n"
+                              "torch.add       add   2 1 0 2 4 #0=(2,3)f32 #2=(2,3)f32 #4=(2,3)f32\n"
+                              "pnnx.Output     out0  2 0 4 3 #4=(2,3)f32 #3=(2)i64\n";
+    std::unique_ptr<pnnx::Graph> graph = ParsePassGraph(param);
+    SetAttributeData(*graph, "a", {1.f, 2.f, 3.f, 4.f, 5.f, 6.f});
+
+    ASSERT_EQ(pass::FoldConstants(*graph), 2);
+    ASSERT_EQ(AttributeData(graph->get_operand("2")), std::vector<float>({2.f, 4.f, 6.f, 8.f, 10.f, 12.f}));
+
+    const pnnx::Attribute &shape = graph->get_operand("3")->producer->attrs.begin()->second;
+    ASSERT_EQ(shape.type, 5);
+    ASSERT_EQ(shape.shape, std::vector<int>({2}));
+    ASSERT_EQ(reinterpret_cast<const int64_t *>(shape.data.data())[0], 3);
+    ASSERT_EQ(reinterpret_cast<const int64_t *>(shape.data.data())[1], -1);
+}
+
+TEST(FoldConstantsTest, keep_shape_only_attribute)
+{
+    // attribute without loaded weight data cannot be evaluated
+    const std::string param = "7767517\n"
+                              "4 3\n"
+                              "pnnx.Input      in0   0 1 0 #0=(4)f32\n"
+                              "pnnx.Attribute  a     0 1 1 @data=(4)f32 #1=(4)f32\n"
+                              "torch.add       add   2 1 0 1 2 #0=(4)f32 #1=(4)f32 #2=(4)f32\n"
+                              "pnnx.Output     out0  1 0 2 #2=(4)f32\n";
+    std::unique_ptr<pnnx::Graph> graph = ParsePassGraph(param);
+    ASSERT_EQ(pass::FoldConstants(*graph), 0);
+    ASSERT_EQ(graph->ops.size(), 4);
+}
+
+TEST(EliminateTest, dead_code_from_requested_outputs)
+{
+    const std::string param = "7767517\n"
+                              "7 6\n"
+                              "pnnx.Input      in0   0 1 0 #0=(4)f32\n"
+                              "pnnx.Attribute  a     0 1 1 @data=(4)f32 #1=(4)f32\n"
+                              "F.relu          relu  1 1 0 2 #0=(4)f32 #2=(4)f32\n"
+                              "F.sigmoid       tap   1 1 0 3 #0=(4)f32 #3=(4)f32\n"
+                              "torch.mul       dead  2 1 0 1 4 #0=(4)f32 #1=(4)f32 #4=(4)f32\n"
+                              "pnnx.Output     out0  1 0 2 #2=(4)f32\n"
+                              "pnnx.Output     out1  1 0 3 #3=(4)f32\n";
+    std::unique_ptr<pnnx::Graph> graph = ParsePassGraph(param);
+    SetAttributeData(*graph, "a", {1.f, 2.f, 3.f, 4.f});
+
+    pass::EliminationReport report = pass::EliminateDeadCode(*graph, {"out0"});
+    ASSERT_EQ(report.removed_operators, 4);
+    ASSERT_EQ(report.removed_operands, 3);
+    ASSERT_EQ(report.saved_bytes, 4 * sizeof(float));
+    ASSERT_EQ(report.removed_names, std::vector<std::string>({"a", "tap", "dead", "out1"}));
+
+    ASSERT_EQ(graph->ops.size(), 3);
+    ASSERT_EQ(graph->operands.size(), 2);
+    ASSERT_EQ(graph->get_operand("0")->consumers.size(), 1);
+
+    // nothing left to remove when every output is kept
+    ASSERT_EQ(pass::EliminateDeadCode(*graph).removed_operators, 0);
+}
+
+TEST(EliminateTest, merge_common_subexpressions)
+{
+    const std::string param = "7767517\n"
+                              "9 8\n"
+                              "pnnx.Input      in0   0 1 0 #0=(4)f32\n"
+                              "pnnx.Attribute  a0    0 1 1 @data=(2,2)f32 #1=(2,2)f32\n"
+                              "pnnx.Attribute  a1    0 1 2 @data=(2,2)f32 #2=(2,2)f32\n"
+                              "Tensor.view     v1    1 1 0 3 shape=(2,2) #0=(4)f32 #3=(2,2)f32\n"
+                              "Tensor.view     v2    1 1 0 4 shape=(2,2) #0=(4)f32 #4=(2,2)f32\n"
+                              "torch.add       add1  2 1 3 1 5 #3=(2,2)f32 #1=(2,2)f32 #5=(2,2)f32\n"
+                              "torch.add       add2  2 1 4 2 6 #4=(2,2)f32 #2=(2,2)f32 #6=(2,2)f32\n"
+                              "torch.mul       mul   2 1 5 6 7 #5=(2,2)f32 #6=(2,2)f32 #7=(2,2)f32\n"
+                              "pnnx.Output     out0  1 0 7 #7=(2,2)f32\n";
+    std::unique_ptr<pnnx::Graph> graph = ParsePassGraph(param);
+    SetAttributeData(*graph, "a0", {1.f, 2.f, 3.f, 4.f});
+    SetAttributeData(*graph, "a1", {1.f, 2.f, 3.f, 4.f});
+
+    pass::EliminationReport report = pass::EliminateCommonSubexpressions(*graph);
+    ASSERT_EQ(report.removed_names, std::vector<std::string>({"a1", "v2", "add2"}));
+    ASSERT_EQ(report.saved_bytes, 4 * sizeof(float));
+
+    const pnnx::Operand *sum = graph->get_operand("5");
+    ASSERT_EQ(graph->ops.size(), 6);
+    ASSERT_EQ(sum->consumers.size(), 2);
+    ASSERT_EQ(graph->ops[4]->inputs, std::vector<pnnx::Operand *>({graph->get_operand("5"), graph->get_operand("5")}));
+
+    // the merged graph is a fixed point
+    ASSERT_EQ(pass::EliminateCommonSubexpressions(*graph).removed_operators, 0);
+}
+
+TEST(FuseElementwiseTest, fuse_single_consumer_trees)
+{
+    const std::string param = "7767517\n"
+                              "9 7\n"
+                              "pnnx.Input      in0   0 1 0 #0=(1,4,3,3)f32\n"
+                              "pnnx.Attribute  scale 0 1 1 @data=(1,4,1,1)f32 #1=(1,4,1,1)f32\n"
+                              "F.relu          relu  1 1 0 2 #0=(1,4,3,3)f32 #2=(1,4,3,3)f32\n"
+                              "torch.mul       mul   2 1 2 1 3 #2=(1,4,3,3)f32 #1=(1,4,1,1)f32 #3=(1,4,3,3)f32\n"
+                              "F.sigmoid       sig   1 1 3 4 #3=(1,4,3,3)f32 #4=(1,4,3,3)f32\n"
+                              "torch.add       add   2 1 4 0 5 #4=(1,4,3,3)f32 #0=(1,4,3,3)f32 #5=(1,4,3,3)f32\n"
+                              "nn.LeakyReLU    leaky 1 1 5 6 negative_slope=0.1 #5=(1,4,3,3)f32 #6=(1,4,3,3)f32\n"
+                              "pnnx.Output     out0  1 0 6 #6=(1,4,3,3)f32\n"
+                              "pnnx.Output     out1  1 0 3 #3=(1,4,3,3)f32\n";
+    std::unique_ptr<pnnx::Graph> graph = ParsePassGraph(param);
+
+    std::string expr;
+    ASSERT_TRUE(pass::PointwiseExpression(graph->ops[6], expr));
+    ASSERT_EQ(expr, "leaky_relu(@0,0.100000001)");
+    ASSERT_FALSE(pass::PointwiseExpression(graph->ops[1], expr));
+
+    // the mul output is also a graph output, so it ends one tree and feeds the next
+    ASSERT_EQ(pass::FuseElementwise(*graph), 5);
+    ASSERT_EQ(graph->ops.size(), 6);
+    ASSERT_EQ(graph->operands.size(), 4);
+
+    pnnx::Operator *head = graph->ops[2];
+    ASSERT_EQ(head->type, "jennifer.FusedElementwise");
+    ASSERT_EQ(head->name, "mul");
+    ASSERT_EQ(head->params.at("expr").s, "mul(relu(@0),@1)");
+    ASSERT_EQ(head->inputs, std::vector<pnnx::Operand *>({graph->get_operand("0"), graph->get_operand("1")}));
+
+    pnnx::Operator *tail = graph->ops[3];
+    ASSERT_EQ(tail->params.at("expr").s, "leaky_relu(add(sigmoid(@0),@1),0.100000001)");
+    ASSERT_EQ(tail->inputs, std::vector<pnnx::Operand *>({graph->get_operand("3"), graph->get_operand("0")}));
+    ASSERT_EQ(tail->outputs[0], graph->get_operand("6"));
+    ASSERT_EQ(graph->get_operand("6")->producer, tail);
+
+    ASSERT_EQ(graph->get_operand("0")->consumers, std::vector<pnnx::Operator *>({tail, head}));
+    ASSERT_EQ(graph->get_operand("3")->consumers.size(), 2);
+
+    // fused operators are not pointwise types themselves
+    ASSERT_EQ(pass::FuseElementwise(*graph), 0);
+}
+
+TEST(FuseAttentionTest, fuse_manual_attention)
+{
+    const std::string param = "7767517\n"
+                              "9 9\n"
+                              "pnnx.Input      q     0 1 0 #0=(1,2,5,4)f32\n"
+                              "pnnx.Input      k     0 1 1 #1=(1,2,7,4)f32\n"
+                              "pnnx.Input      v     0 1 2 #2=(1,2,7,3)f32\n"
+                              "torch.transpose kt    1 1 1 3 dim0=-1 dim1=2 #1=(1,2,7,4)f32 #3=(1,2,4,7)f32\n"
+                              "torch.matmul    qk    2 1 0 3 4 #0=(1,2,5,4)f32 #3=(1,2,4,7)f32 #4=(1,2,5,7)f32\n"
+                              "pnnx.Expression scale 1 1 4 5 expr=div(@0,2.000000e+00) #4=(1,2,5,7)f32 #5=(1,2,5,7)f32\n"
+                              "F.softmax       sm    1 1 5 6 dim=-1 #5=(1,2,5,7)f32 #6=(1,2,5,7)f32\n"
+                              "torch.matmul    av    2 1 6 2 7 #6=(1,2,5,7)f32 #2=(1,2,7,3)f32 #7=(1,2,5,3)f32\n"
+                              "pnnx.Output     out0  1 0 7 #7=(1,2,5,3)f32\n";
+    std::unique_ptr<pnnx::Graph> graph = ParsePassGraph(param);
+
+    ASSERT_EQ(pass::FuseAttention(*graph), 1);
+    ASSERT_EQ(graph->ops.size(), 5);
+    ASSERT_EQ(graph->operands.size(), 4);
+
+    pnnx::Operator *attention = graph->ops[3];
+    ASSERT_EQ(attention->type, "F.scaled_dot_product_attention");
+    ASSERT_EQ(attention->name, "av");
+    ASSERT_FLOAT_EQ(attention->params.at("scale").f, 0.5f);
+    ASSERT_FALSE(attention->params.at("is_causal").b);
+    ASSERT_EQ(attention->inputs, std::vector<pnnx::Operand *>(
+                                     {graph->get_operand("0"), graph->get_operand("1"), graph->get_operand("2")}));
+    ASSERT_EQ(graph->get_operand("7")->producer, attention);
+    ASSERT_EQ(graph->get_operand("1")->consumers, std::vector<pnnx::Operator *>({attention}));
+
+    // a softmax over another dim is not attention
+    std::unique_ptr<pnnx::Graph> other = ParsePassGraph(param);
+    other->ops[6]->params["dim"] = 2;
+    ASSERT_EQ(pass::FuseAttention(*other), 0);
+    ASSERT_EQ(other->ops.size(), 9);
+}
+
+} // namespace jennifer
@@ -0,0 +1,73 @@
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+
+#include "jennifer/runtime/pipeline.hpp"
+#include "test/scale_chain.hpp"
+
+using namespace jennifer::data;
+using namespace jennifer::runtime;
+using jennifer::utils::StatusCode;
+
+namespace jennifer
+{
+
+TEST(PipelineTest, stages_keep_frames_in_order)
+{
+    using Ranges = std::vector<std::pair<size_t, size_t>>;
+    ASSERT_EQ(PartitionStages({1, 1, 1, 1, 4}, 2), Ranges({{0, 4}, {4, 5}}));
+    ASSERT_EQ(PartitionStages({3, 1, 1, 1, 3, 3}, 3), Ranges({{0, 2}, {2, 5}, {5, 6}}));
+    ASSERT_EQ(PartitionStages({1, 2}, 4), Ranges({{0, 1}, {1, 2}}));
+
+    RuntimeGraph runtime_graph;
+    ASSERT_TRUE(runtime_graph.Init(ParseGraph(kScaleChain)));
+    auto make_input = [](float value) {
+        auto input =
+            std::make_shared<Operand<float>>("in0", std::vector<int32_t>{1, 3, 6, 4}, 1, AttributeType::Float32);
+        input->data[0] = std::make_shared<Tensor<float>>(3, 6, 4);
+        input->data[0]->Fill(value);
+        return input;
+    };
+
+    PipelineOptions options;
+    options.stages = 3;
+    options.threads_per_stage = 1;
+    options.queue_depth = 1;
+    Pipeline pipeline(runtime_graph, options);
+    ASSERT_EQ(pipeline.Init({make_input(1.f)}), StatusCode::Success);
+
+    // the stages cover every operator once, in graph order
+    const Ranges &stages = pipeline.stages();
+    ASSERT_EQ(stages.size(), 3);
+    ASSERT_EQ(stages.front().first, 0);
+    ASSERT_EQ(stages.back().second, runtime_graph.graph().ops.size());
+    for (size_t i = 1; i < stages.size(); ++i)
+    {
+        ASSERT_EQ(stages[i].first, stages[i - 1].second);
+        ASSERT_LT(stages[i].first, stages[i].second);
+    }
+    ASSERT_EQ(pipeline.stage_costs().size(), 3);
+
+    // frames in flight own their arenas and complete in submission order
+    std::vector<std::future<AsyncResult>> futures;
+    for (int i = 0; i < 16; ++i)
+    {
+        futures.push_back(pipeline.Submit({make_input(static_cast<float>(i))}));
+    }
+    for (int i = 0; i < 16; ++i)
+    {
+        AsyncResult result = futures[i].get();
+        ASSERT_EQ(result.status, StatusCode::Success);
+        ASSERT_EQ(result.outputs.size(), 1);
+        ASSERT_EQ(result.outputs[0]->data[0]->at(2, 5, 3), 16.f * i);
+    }
+
+    auto failed = pipeline.Submit({});
+    ASSERT_NE(failed.get().status, StatusCode::Success);
+
+    pipeline.Stop();
+    auto stopped = pipeline.Submit({make_input(1.f)});
+    ASSERT_THROW(stopped.get(), std::runtime_error);
+}
+
+} // namespace jennifer
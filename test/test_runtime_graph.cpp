@@ -0,0 +1,385 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include "jennifer/layer/layer_factory.hpp"
+#include "jennifer/runtime/runtime_graph.hpp"
+#include "test/scale_chain.hpp"
+
+using namespace jennifer::data;
+using namespace jennifer::runtime;
+using jennifer::utils::StatusCode;
+
+namespace jennifer
+{
+
+static layer::LayerRegistererWrapper kRejectLayer("test.Reject",
+                                                  [](const std::shared_ptr<Operator<float>> &, std::shared_ptr<layer::Layer<float>> &) {
+                                                      return StatusCode::ParseParamError;
+                                                  });
+
+TEST(ShapeInferenceTest, bind_symbols_and_propagate)
+{
+    const std::string param = "7767517\n"
+                              "7 6\n"
+                              "pnnx.Input    in0   0 1 0 #0=(1,3,%h,%w)f32\n"
+                              "nn.Conv2d     conv  1 1 0 1 bias=True dilation=(1,1) groups=1 in_channels=3 kernel_size=(3,3) out_channels=16 padding=(1,1) stride=(2,2) @bias=(16)f32 @weight=(16,3,3,3)f32 #0=(1,3,%h,%w)f32 #1=(1,16,?,?)f32\n"
+                              "nn.MaxPool2d  pool  1 1 1 2 ceil_mode=True kernel_size=(3,3) padding=(0,0) stride=(2,2) #1=(1,16,?,?)f32 #2=(1,16,?,?)f32\n"
+                              "torch.flatten flat  1 1 2 3 end_dim=-1 start_dim=1 #2=(1,16,?,?)f32 #3=(1,?)f32\n"
+                              "nn.Linear     fc    1 1 3 4 bias=True in_features=1024 out_features=10 @bias=(10)f32 @weight=(10,1024)f32 #3=(1,?)f32 #4=(1,10)f32\n"
+                              "F.softmax     prob  1 1 4 5 dim=1 #4=(1,10)f32 #5=(1,10)f32\n"
+                              "pnnx.Output   out0  1 0 5 #5=(1,10)f32\n";
+    std::unique_ptr<pnnx::Graph> graph = ParseGraph(param);
+    ShapeInference inference(*graph);
+
+    std::vector<Shape> shapes;
+    std::map<std::string, int32_t> symbols;
+    ASSERT_EQ(inference.Infer({{4, 3, 65, 33}}, shapes, &symbols), StatusCode::Success);
+    ASSERT_EQ(symbols.at("h"), 65);
+    ASSERT_EQ(symbols.at("w"), 33);
+
+    ASSERT_EQ(shapes[inference.operand_index(graph->get_operand("1"))], Shape({4, 16, 33, 17}));
+    ASSERT_EQ(shapes[inference.operand_index(graph->get_operand("2"))], Shape({4, 16, 16, 8}));
+    ASSERT_EQ(shapes[inference.operand_index(graph->get_operand("3"))], Shape({4, 2048}));
+    ASSERT_EQ(shapes[inference.operand_index(graph->get_operand("5"))], Shape({4, 10}));
+
+    ASSERT_EQ(inference.Infer({{1, 4, 64, 64}}, shapes), StatusCode::InferDimMismatch);
+}
+
+TEST(ShapeInferenceTest, exported_shape_fallback)
+{
+    std::unique_ptr<pnnx::Graph> graph = ParseGraph(kScaleChain);
+    ShapeInference inference(*graph);
+
+    std::vector<Shape> shapes;
+    ASSERT_EQ(inference.Infer({{2, 3, 8, 12}}, shapes), StatusCode::Success);
+    ASSERT_EQ(shapes[inference.operand_index(graph->get_operand("4"))], Shape({2, 3, 8, 12}));
+}
+
+TEST(ShapeInferenceTest, reject_invalid_dims)
+{
+    // every operator has an exported shape, a rejected param must not fall back to it
+    const char *ops[] = {
+        "torch.permute   op    1 1 0 1 dims=(0,1,1) #0=(2,3,4)f32 #1=(2,3,3)f32\n",
+        "torch.permute   op    1 1 0 1 dims=(0,1,3) #0=(2,3,4)f32 #1=(2,3,4)f32\n",
+        "torch.transpose op    1 1 0 1 dim0=0 dim1=3 #0=(2,3,4)f32 #1=(2,3,4)f32\n",
+        "torch.stack     op    1 1 0 1 dim=-5 #0=(2,3,4)f32 #1=(1,2,3,4)f32\n",
+        "Tensor.slice    op    1 1 0 1 dim=1 end=3 start=0 step=0 #0=(2,3,4)f32 #1=(2,3,4)f32\n",
+        "Tensor.slice    op    1 1 0 1 dim=3 end=3 start=0 step=1 #0=(2,3,4)f32 #1=(2,3,4)f32\n",
+        "torch.chunk     op    1 1 0 1 chunks=0 dim=1 #0=(2,3,4)f32 #1=(2,3,4)f32\n",
+        "torch.chunk     op    1 1 0 1 chunks=2 dim=-4 #0=(2,3,4)f32 #1=(2,3,4)f32\n",
+    };
+    for (const char *op : ops)
+    {
+        const std::string param = std::string("7767517\n"
+                                              "3 2\n"
+                                              "pnnx.Input      in0   0 1 0 #0=(2,3,4)f32\n") +
+                                  op + "pnnx.Output     out0  1 0 1 #1=(2,3,4)f32\n";
+        std::unique_ptr<pnnx::Graph> graph = ParseGraph(param);
+        ShapeInference inference(*graph);
+
+        std::vector<Shape> shapes;
+        ASSERT_EQ(inference.Infer({{2, 3, 4}}, shapes), StatusCode::InferParamError) << op;
+    }
+
+    // 5 split into chunks of 2 leaves nothing for the fourth output
+    const std::string param = "7767517\n"
+                              "3 5\n"
+                              "pnnx.Input      in0   0 1 0 #0=(5,3)f32\n"
+                              "torch.chunk     op    1 4 0 1 2 3 4 chunks=4 dim=0 #0=(5,3)f32 #1=(2,3)f32 #2=(2,3)f32 #3=(1,3)f32 #4=(0,3)f32\n"
+                              "pnnx.Output     out0  4 0 1 2 3 4 #1=(2,3)f32 #2=(2,3)f32 #3=(1,3)f32 #4=(0,3)f32\n";
+    std::unique_ptr<pnnx::Graph> graph = ParseGraph(param);
+    ShapeInference inference(*graph);
+
+    std::vector<Shape> shapes;
+    ASSERT_EQ(inference.Infer({{5, 3}}, shapes), StatusCode::Success);
+    ASSERT_EQ(shapes[inference.operand_index(graph->get_operand("3"))], Shape({1, 3}));
+    ASSERT_EQ(shapes[inference.operand_index(graph->get_operand("4"))], Shape({0, 3}));
+}
+
+TEST(ShapeInferenceTest, dynamic_reshape_from_expression)
+{
+    const std::string param = "7767517\n"
+                              "6 5\n"
+                              "pnnx.Input      in0   0 1 0 #0=(1,3,%h,%w)f32\n"
+                              "Tensor.size     size  1 1 0 1 dim=1 #0=(1,3,%h,%w)f32 #1=()i64\n"
+                              "pnnx.Expression expr  1 1 0 2 expr=[int(size(@0,0)),mul(size(@0,2),size(@0,3)),-1] #0=(1,3,%h,%w)f32 #2=(3)i64\n"
+                              "Tensor.view     view  2 1 0 2 3 #0=(1,3,%h,%w)f32 #2=(3)i64 #3=(1,?,3)f32\n"
+                              "pnnx.Expression half  1 1 1 4 expr=floor_divide(@0,2) #1=()i64 #4=()i64\n"
+                              "pnnx.Output     out0  2 0 3 4 #3=(1,?,3)f32 #4=()i64\n";
+    std::unique_ptr<pnnx::Graph> graph = ParseGraph(param);
+    ShapeInference inference(*graph);
+
+    std::vector<Shape> shapes;
+    ASSERT_EQ(inference.Infer({{4, 3, 5, 6}}, shapes), StatusCode::Success);
+    ASSERT_EQ(shapes[inference.operand_index(graph->get_operand("1"))], Shape());
+    ASSERT_EQ(shapes[inference.operand_index(graph->get_operand("2"))], Shape({3}));
+    ASSERT_EQ(shapes[inference.operand_index(graph->get_operand("3"))], Shape({4, 30, 3}));
+    ASSERT_EQ(shapes[inference.operand_index(graph->get_operand("4"))], Shape());
+}
+
+TEST(RuntimeGraphTest, plan_cache_per_shape)
+{
+    RuntimeGraph runtime_graph;
+    ASSERT_TRUE(runtime_graph.Init(ParseGraph(kScaleChain)));
+
+    std::shared_ptr<const ExecutionPlan> plan1;
+    std::shared_ptr<const ExecutionPlan> plan2;
+    std::shared_ptr<const ExecutionPlan> plan3;
+    ASSERT_EQ(runtime_graph.Plan({{1, 3, 8, 8}}, plan1), StatusCode::Success);
+    ASSERT_EQ(runtime_graph.Plan({{1, 3, 8, 8}}, plan2), StatusCode::Success);
+    ASSERT_EQ(runtime_graph.Plan({{1, 3, 16, 8}}, plan3), StatusCode::Success);
+
+    ASSERT_EQ(plan1, plan2);
+    ASSERT_NE(plan1, plan3);
+    ASSERT_EQ(runtime_graph.plan_cache().size(), 2);
+    ASSERT_EQ(runtime_graph.plan_cache().hits(), 1);
+    ASSERT_EQ(plan1->kernels[1], "test.Scale");
+
+    // s1 and s2 outputs are live together, s3 output reuses the s1 buffer and the
+    // graph output is not arena backed
+    const pnnx::Graph &graph = runtime_graph.graph();
+    const int64_t block = 3 * 8 * 8 * sizeof(float);
+    ASSERT_EQ(plan1->arena_size, 2 * block);
+    ASSERT_NE(plan1->offsets[1], plan1->offsets[2]);
+    ASSERT_EQ(plan1->offsets[1], plan1->offsets[3]);
+    ASSERT_EQ(plan1->offsets[4], -1);
+    ASSERT_EQ(graph.operands[4]->name, "4");
+}
+
+TEST(RuntimeGraphTest, forward)
+{
+    RuntimeGraph runtime_graph;
+    ASSERT_TRUE(runtime_graph.Init(ParseGraph(kScaleChain)));
+
+    for (uint32_t height : {5, 7})
+    {
+        auto input = std::make_shared<Operand<float>>("in0", std::vector<int32_t>{2, 3, static_cast<int32_t>(height), 4}, 2,
+                                                      AttributeType::Float32);
+        for (uint32_t b = 0; b < 2; ++b)
+        {
+            input->data[b] = std::make_shared<Tensor<float>>(3, height, 4);
+            input->data[b]->Fill(static_cast<float>(b + 1));
+        }
+
+        std::vector<std::shared_ptr<Operand<float>>> outputs;
+        ASSERT_EQ(runtime_graph.Forward({input}, outputs), StatusCode::Success);
+        ASSERT_EQ(outputs.size(), 1);
+        ASSERT_EQ(outputs[0]->data.size(), 2);
+        ASSERT_EQ(outputs[0]->data[1]->shape(), std::vector<uint32_t>({3, height, 4}));
+        ASSERT_EQ(outputs[0]->data[0]->at(2, height - 1, 3), 16.f);
+        ASSERT_EQ(outputs[0]->data[1]->at(0, 0, 0), 32.f);
+    }
+}
+
+TEST(RuntimeGraphTest, rejected_layer_fails_forward)
+{
+    const std::string param = "7767517\n"
+                              "3 2\n"
+                              "pnnx.Input    in0  0 1 0 #0=(1,3,4,4)f32\n"
+                              "test.Reject   r1   1 1 0 1 #0=(1,3,4,4)f32 #1=(1,3,4,4)f32\n"
+                              "pnnx.Output   out0 1 0 1 #1=(1,3,4,4)f32\n";
+    RuntimeGraph runtime_graph;
+    ASSERT_TRUE(runtime_graph.Init(ParseGraph(param)));
+
+    auto input = std::make_shared<Operand<float>>("in0", std::vector<int32_t>{1, 3, 4, 4}, 1, AttributeType::Float32);
+    input->data[0] = std::make_shared<Tensor<float>>(3, 4, 4);
+    std::vector<std::shared_ptr<Operand<float>>> outputs;
+    ASSERT_NE(runtime_graph.Forward({input}, outputs), StatusCode::Success);
+    ASSERT_NE(runtime_graph.Forward({input}, outputs), StatusCode::Success);
+}
+
+TEST(RuntimeGraphTest, concat_inputs_written_in_place)
+{
+    // 1 and 2 are joined into 3, which is joined with 4 into 5, along the channels;
+    // 2 is also read after the cat and 5 is joined along the rows, which copies
+    RuntimeGraph runtime_graph;
+    ASSERT_TRUE(runtime_graph.Init(ParseGraph("7767517\n"
+                                              "9 8\n"
+                                              "pnnx.Input  in0  0 1 0 #0=(1,3,%h,%w)f32\n"
+                                              "test.Scale  s1   1 1 0 1 #0=(1,3,%h,%w)f32 #1=(1,3,%h,%w)f32\n"
+                                              "test.Scale  s2   1 1 1 2 #1=(1,3,%h,%w)f32 #2=(1,3,%h,%w)f32\n"
+                                              "torch.cat   c1   2 1 1 2 3 dim=1 #3=(1,6,%h,%w)f32\n"
+                                              "test.Scale  s3   1 1 2 4 #2=(1,3,%h,%w)f32 #4=(1,3,%h,%w)f32\n"
+                                              "torch.cat   c2   2 1 3 4 5 dim=1 #3=(1,6,%h,%w)f32 #5=(1,9,%h,%w)f32\n"
+                                              "test.Scale  s4   1 1 5 6 #5=(1,9,%h,%w)f32 #6=(1,9,%h,%w)f32\n"
+                                              "torch.cat   c3   2 1 6 5 7 dim=-2 #6=(1,9,%h,%w)f32 #7=(1,9,?,%w)f32\n"
+                                              "pnnx.Output out0 1 0 7 #7=(1,9,?,%w)f32\n")));
+
+    std::shared_ptr<const ExecutionPlan> plan;
+    ASSERT_EQ(runtime_graph.Plan({{2, 3, 5, 4}}, plan), StatusCode::Success);
+    const int64_t plane = 5 * 4;
+    ASSERT_EQ(plan->alias_roots, std::vector<int>({-1, 5, 5, 5, 5, -1, -1, -1}));
+    ASSERT_EQ(plan->alias_offsets[2], 3 * plane);
+    ASSERT_EQ(plan->alias_offsets[4], 6 * plane);
+    // 5 and 6 are the only arena blocks, live together and 64 byte aligned
+    const size_t block = (2 * 9 * plane * sizeof(float) + 63) / 64 * 64;
+    ASSERT_EQ(plan->arena_size, 2 * block);
+
+    auto input = std::make_shared<Operand<float>>("in0", std::vector<int32_t>{2, 3, 5, 4}, 2, AttributeType::Float32);
+    for (uint32_t b = 0; b < 2; ++b)
+    {
+        input->data[b] = std::make_shared<Tensor<float>>(3, 5, 4);
+        for (uint32_t i = 0; i < input->data[b]->size(); ++i)
+        {
+            input->data[b]->index(i) = static_cast<float>(i * 7 % 11) + b;
+        }
+    }
+
+    std::vector<std::shared_ptr<Operand<float>>> outputs;
+    ASSERT_EQ(runtime_graph.Forward({input}, outputs), StatusCode::Success);
+    for (uint32_t b = 0; b < 2; ++b)
+    {
+        const Tensor<float> &x = *input->data[b];
+        const Tensor<float> &y = *outputs[0]->data[b];
+        ASSERT_EQ(y.shape(), std::vector<uint32_t>({9, 10, 4}));
+        for (uint32_t c = 0; c < 9; ++c)
+        {
+            for (uint32_t r = 0; r < 5; ++r)
+            {
+                for (uint32_t col = 0; col < 4; ++col)
+                {
+                    const float joined = x.at(c % 3, r, col) * static_cast<float>(2 << (c / 3));
+                    ASSERT_EQ(y.at(c, r, col), 2.f * joined);
+                    ASSERT_EQ(y.at(c, r + 5, col), joined);
+                }
+            }
+        }
+    }
+}
+
+TEST(RuntimeGraphTest, in_place_operators_reuse_dead_inputs)
+{
+    // 1 is read again by the add, so the softmax needs a buffer of its own; the
+    // fused relu and add overwrites the softmax output nothing else reads
+    RuntimeGraph runtime_graph;
+    ASSERT_TRUE(runtime_graph.Init(ParseGraph("7767517\n"
+                                              "7 6\n"
+                                              "pnnx.Input  in0  0 1 0 #0=(1,3,%h,%w)f32\n"
+                                              "test.Scale  s1   1 1 0 1 #0=(1,3,%h,%w)f32 #1=(1,3,%h,%w)f32\n"
+                                              "F.softmax   sm   1 1 1 2 dim=1 #1=(1,3,%h,%w)f32 #2=(1,3,%h,%w)f32\n"
+                                              "nn.ReLU     relu 1 1 2 3 #2=(1,3,%h,%w)f32 #3=(1,3,%h,%w)f32\n"
+                                              "torch.add   add  2 1 3 1 4 #3=(1,3,%h,%w)f32 #1=(1,3,%h,%w)f32 #4=(1,3,%h,%w)f32\n"
+                                              "test.Scale  s2   1 1 4 5 #4=(1,3,%h,%w)f32 #5=(1,3,%h,%w)f32\n"
+                                              "pnnx.Output out0 1 0 5 #5=(1,3,%h,%w)f32\n")));
+
+    std::shared_ptr<const ExecutionPlan> plan;
+    ASSERT_EQ(runtime_graph.Plan({{2, 3, 4, 5}}, plan), StatusCode::Success);
+    const pnnx::Graph &graph = runtime_graph.graph();
+    int scaled = -1;
+    int softmax = -1;
+    for (size_t i = 0; i < graph.operands.size(); ++i)
+    {
+        scaled = graph.operands[i]->name == "1" ? static_cast<int>(i) : scaled;
+        softmax = graph.operands[i]->name == "2" ? static_cast<int>(i) : softmax;
+    }
+    ASSERT_GE(scaled, 0);
+    ASSERT_GE(softmax, 0);
+    ASSERT_EQ(plan->alias_roots[scaled], -1);
+    ASSERT_EQ(plan->alias_roots[softmax], -1);
+    ASSERT_EQ(std::count(plan->alias_roots.begin(), plan->alias_roots.end(), softmax), 1);
+    const size_t block = (2 * 3 * 4 * 5 * sizeof(float) + 63) / 64 * 64;
+    ASSERT_EQ(plan->arena_size, 2 * block);
+
+    auto input = std::make_shared<Operand<float>>("in0", std::vector<int32_t>{2, 3, 4, 5}, 2, AttributeType::Float32);
+    for (uint32_t b = 0; b < 2; ++b)
+    {
+        input->data[b] = std::make_shared<Tensor<float>>(3, 4, 5);
+        for (uint32_t i = 0; i < input->data[b]->size(); ++i)
+        {
+            input->data[b]->index(i) = static_cast<float>(i * 5 % 7) * 0.25f - b;
+        }
+    }
+    std::vector<std::shared_ptr<Operand<float>>> outputs;
+    ASSERT_EQ(runtime_graph.Forward({input}, outputs), StatusCode::Success);
+    for (uint32_t b = 0; b < 2; ++b)
+    {
+        const Tensor<float> &x = *input->data[b];
+        for (uint32_t r = 0; r < 4; ++r)
+        {
+            for (uint32_t col = 0; col < 5; ++col)
+            {
+                float sum = 0.f;
+                for (uint32_t c = 0; c < 3; ++c)
+                {
+                    sum += std::exp(2.f * x.at(c, r, col));
+                }
+                for (uint32_t c = 0; c < 3; ++c)
+                {
+                    const float expect = 2.f * (std::exp(2.f * x.at(c, r, col)) / sum + 2.f * x.at(c, r, col));
+                    ASSERT_NEAR(outputs[0]->data[b]->at(c, r, col), expect, 1e-5f);
+                }
+            }
+        }
+    }
+}
+
+TEST(RuntimeGraphTest, view_operators_alias_their_input)
+{
+    // the unsqueeze keeps the planes of 1 and becomes a view of it, the flatten
+    // merges the planes of the permuted 3 and has to copy
+    RuntimeGraph runtime_graph;
+    ASSERT_TRUE(runtime_graph.Init(ParseGraph(
+        "7767517\n"
+        "8 7\n"
+        "pnnx.Input      in0  0 1 0 #0=(1,4,%h,%w)f32\n"
+        "test.Scale      s1   1 1 0 1 #0=(1,4,%h,%w)f32 #1=(1,4,%h,%w)f32\n"
+        "torch.unsqueeze u1   1 1 1 2 dim=1 #1=(1,4,%h,%w)f32 #2=(1,1,4,%h,%w)f32\n"
+        "torch.permute   p1   1 1 2 3 dims=(0,1,2,4,3) #2=(1,1,4,%h,%w)f32 #3=(1,1,4,%w,%h)f32\n"
+        "torch.flatten   f1   1 1 3 4 start_dim=3 #3=(1,1,4,%w,%h)f32 #4=(1,1,4,?)f32\n"
+        "nn.PixelShuffle ps   1 1 1 5 upscale_factor=2 #1=(1,4,%h,%w)f32 #5=(1,1,?,?)f32\n"
+        "F.channel_shuffle cs 1 1 1 6 groups=2 #1=(1,4,%h,%w)f32 #6=(1,4,%h,%w)f32\n"
+        "pnnx.Output     out0 3 0 4 5 6 #4=(1,1,4,?)f32 #5=(1,1,?,?)f32 #6=(1,4,%h,%w)f32\n")));
+
+    const uint32_t h = 6;
+    const uint32_t w = 5;
+    std::shared_ptr<const ExecutionPlan> plan;
+    ASSERT_EQ(runtime_graph.Plan({{2, 4, h, w}}, plan), StatusCode::Success);
+    const pnnx::Graph &graph = runtime_graph.graph();
+    std::vector<int> index(graph.operands.size());
+    for (size_t i = 0; i < graph.operands.size(); ++i)
+    {
+        index[std::stoi(graph.operands[i]->name)] = static_cast<int>(i);
+    }
+    ASSERT_EQ(plan->alias_roots[index[2]], index[1]);
+    ASSERT_EQ(plan->alias_roots[index[3]], -1);
+    ASSERT_EQ(plan->alias_roots[index[4]], -1);
+
+    auto input = std::make_shared<Operand<float>>("in0", std::vector<int32_t>{2, 4, h, w}, 2, AttributeType::Float32);
+    for (uint32_t b = 0; b < 2; ++b)
+    {
+        input->data[b] = std::make_shared<Tensor<float>>(4, h, w);
+        for (uint32_t i = 0; i < input->data[b]->size(); ++i)
+        {
+            input->data[b]->index(i) = static_cast<float>(i * 13 % 29) - b;
+        }
+    }
+    std::vector<std::shared_ptr<Operand<float>>> outputs;
+    ASSERT_EQ(runtime_graph.Forward({input}, outputs), StatusCode::Success);
+    ASSERT_EQ(outputs.size(), 3);
+    for (uint32_t b = 0; b < 2; ++b)
+    {
+        const Tensor<float> &x = *input->data[b];
+        const Tensor<float> &flat = *outputs[0]->data[b];
+        const Tensor<float> &shuffled = *outputs[1]->data[b];
+        const Tensor<float> &grouped = *outputs[2]->data[b];
+        ASSERT_EQ(flat.shape(), std::vector<uint32_t>({1, 4, w * h}));
+        ASSERT_EQ(shuffled.shape(), std::vector<uint32_t>({1, 2 * h, 2 * w}));
+        for (uint32_t c = 0; c < 4; ++c)
+        {
+            for (uint32_t r = 0; r < h; ++r)
+            {
+                for (uint32_t col = 0; col < w; ++col)
+                {
+                    const float y = 2.f * x.at(c, r, col);
+                    ASSERT_EQ(flat.at(0, c, col * h + r), y);
+                    ASSERT_EQ(shuffled.at(0, r * 2 + c / 2, col * 2 + c % 2), y);
+                    ASSERT_EQ(grouped.at(c % 2 * 2 + c / 2, r, col), y);
+                }
+            }
+        }
+    }
+}
+
+} // namespace jennifer
@@ -0,0 +1,222 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+#include "jennifer/runtime/pnnx/ir.h"
+#include "jennifer/runtime/pnnx/store_zip.hpp"
+
+namespace jennifer
+{
+
+static uint32_t ReferenceCrc32(const std::vector<char> &data)
+{
+    uint32_t x = 0xffffffff;
+    for (char c : data)
+    {
+        x ^= static_cast<uint8_t>(c);
+        for (int k = 0; k < 8; ++k)
+        {
+            x = (x & 1) ? (x >> 1) ^ 0xedb88320 : x >> 1;
+        }
+    }
+    return x ^ 0xffffffff;
+}
+
+// normally distributed f32 weights, the sign and exponent bytes are highly redundant
+static std::vector<char> RandomWeights(size_t count, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> normal(0.f, 0.02f);
+    std::vector<char> data(count * sizeof(float));
+    for (size_t i = 0; i < count; ++i)
+    {
+        const float v = normal(rng);
+        memcpy(data.data() + i * sizeof(float), &v, sizeof(float));
+    }
+    return data;
+}
+
+static std::vector<char> RandomBytes(size_t size, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::vector<char> data(size);
+    for (char &c : data)
+    {
+        c = static_cast<char>(rng());
+    }
+    return data;
+}
+
+TEST(StoreZipTest, crc32_matches_reference)
+{
+    const char *check = "123456789";
+    ASSERT_EQ(pnnx::crc32(check, 9), 0xcbf43926u);
+    ASSERT_EQ(pnnx::crc32(check, 0), 0u);
+
+    for (size_t size : {1, 15, 16, 17, 255, 4099})
+    {
+        std::vector<char> data = RandomBytes(size, static_cast<uint32_t>(size));
+        ASSERT_EQ(pnnx::crc32(data.data(), size), ReferenceCrc32(data));
+
+        // chained and combined crc of two halves
+        const size_t half = size / 2;
+        const uint32_t first = pnnx::crc32(data.data(), half);
+        const uint32_t second = pnnx::crc32(data.data() + half, size - half);
+        ASSERT_EQ(pnnx::crc32(data.data() + half, size - half, first), ReferenceCrc32(data));
+        ASSERT_EQ(pnnx::crc32_combine(first, second, size - half), ReferenceCrc32(data));
+    }
+
+    std::vector<char> large = RandomBytes(9 * 1024 * 1024 + 3, 7);
+    ASSERT_EQ(pnnx::crc32_parallel(large.data(), large.size(), 4), pnnx::crc32(large.data(), large.size()));
+}
+
+TEST(StoreZipTest, parallel_write_and_verified_read)
+{
+    const std::string path = testing::TempDir() + "/jennifer_store_zip_test.bin";
+
+    std::vector<char> large = RandomBytes(9 * 1024 * 1024 + 3, 1);
+    std::vector<char> small = RandomBytes(100, 2);
+    {
+        pnnx::StoreZipWriter szw;
+        ASSERT_EQ(szw.open(path), 0);
+        szw.set_num_threads(4);
+        ASSERT_EQ(szw.write_file("a.weight", small.data(), small.size()), 0);
+        ASSERT_EQ(szw.write_file_deferred("b.weight", large.data(), large.size()), 0);
+        ASSERT_EQ(szw.write_file_deferred("c.empty", nullptr, 0), 0);
+        ASSERT_EQ(szw.write_file_deferred("d.weight", small.data(), small.size()), 0);
+        ASSERT_EQ(szw.close(), 0);
+    }
+
+    pnnx::StoreZipReader szr;
+    ASSERT_EQ(szr.open(path), 0);
+    szr.set_verify_crc(true);
+    szr.set_num_threads(4);
+    ASSERT_EQ(szr.get_names(), std::vector<std::string>({"a.weight", "b.weight", "c.empty", "d.weight"}));
+
+    std::vector<char> data(szr.get_file_size("b.weight"));
+    ASSERT_EQ(szr.read_file("b.weight", data.data()), 0);
+    ASSERT_EQ(data, large);
+
+    data.resize(szr.get_file_size("d.weight"));
+    ASSERT_EQ(szr.read_file("d.weight", data.data()), 0);
+    ASSERT_EQ(data, small);
+    szr.close();
+
+    // flip one payload byte of a.weight, which starts right after its header
+    FILE *fp = fopen(path.c_str(), "r+b");
+    ASSERT_NE(fp, nullptr);
+    fseek(fp, 30 + 8 + 4 + 28 + 50, SEEK_SET);
+    fputc(small[50] ^ 0x5a, fp);
+    fclose(fp);
+
+    ASSERT_EQ(szr.open(path), 0);
+    szr.set_verify_crc(false);
+    data.resize(small.size());
+    ASSERT_EQ(szr.read_file("a.weight", data.data()), 0);
+    szr.set_verify_crc(true);
+    ASSERT_EQ(szr.read_file("a.weight", data.data()), -1);
+    remove(path.c_str());
+}
+
+TEST(StoreZipTest, compressed_entries)
+{
+    const std::string path = testing::TempDir() + "/jennifer_store_zip_compressed.bin";
+
+    std::vector<char> weights = RandomWeights(3 * 1024 * 1024 + 1, 3);
+    std::vector<char> zeros(5 * 1024 * 1024, 0);
+
+    uint64_t sizes[3];
+    const int methods[3] = {pnnx::STOREZIP_STORED, pnnx::STOREZIP_DEFLATE, pnnx::STOREZIP_SHUFFLE_DEFLATE};
+    for (int m = 0; m < 3; ++m)
+    {
+        {
+            pnnx::StoreZipWriter szw;
+            ASSERT_EQ(szw.open(path), 0);
+            szw.set_compression(methods[m]);
+            szw.set_num_threads(3);
+            ASSERT_EQ(szw.write_file("a.weight", weights.data(), weights.size(), sizeof(float)), 0);
+            ASSERT_EQ(szw.write_file_deferred("b.zeros", zeros.data(), zeros.size(), sizeof(float)), 0);
+            ASSERT_EQ(szw.write_file_deferred("c.empty", nullptr, 0), 0);
+            ASSERT_EQ(szw.close(), 0);
+        }
+
+        FILE *fp = fopen(path.c_str(), "rb");
+        fseek(fp, 0, SEEK_END);
+        sizes[m] = ftell(fp);
+        fclose(fp);
+
+        pnnx::StoreZipReader szr;
+        ASSERT_EQ(szr.open(path), 0);
+        szr.set_verify_crc(true);
+        ASSERT_EQ(szr.get_file_size("a.weight"), weights.size());
+        ASSERT_EQ(szr.get_file_size("b.zeros"), zeros.size());
+
+        std::vector<char> a(weights.size());
+        std::vector<char> b(zeros.size(), 1);
+        ASSERT_EQ(szr.read_files({"a.weight", "b.zeros", "c.empty"}, {a.data(), b.data(), nullptr}), 0);
+        ASSERT_EQ(a, weights);
+        ASSERT_EQ(b, zeros);
+    }
+
+    ASSERT_LT(sizes[1], sizes[0]);
+    ASSERT_LT(sizes[2], sizes[1]);
+    remove(path.c_str());
+}
+
+TEST(StoreZipTest, reject_shuffle_without_elemsize)
+{
+    const std::string path = testing::TempDir() + "/jennifer_store_zip_elemsize.bin";
+
+    std::vector<char> weights = RandomWeights(1024, 7);
+    {
+        pnnx::StoreZipWriter szw;
+        ASSERT_EQ(szw.open(path), 0);
+        szw.set_compression(pnnx::STOREZIP_SHUFFLE_DEFLATE);
+        ASSERT_EQ(szw.write_file("a.weight", weights.data(), weights.size(), sizeof(float)), 0);
+        ASSERT_EQ(szw.close(), 0);
+    }
+
+    // patch the local header compression to a shuffle without element size,
+    // it sits after the 4 byte signature, version and flag
+    const int elemsizes[2] = {0, 1};
+    for (int elemsize : elemsizes)
+    {
+        FILE *fp = fopen(path.c_str(), "r+b");
+        ASSERT_NE(fp, nullptr);
+        const uint16_t compression = pnnx::STOREZIP_SHUFFLE_DEFLATE | elemsize;
+        fseek(fp, 8, SEEK_SET);
+        fwrite(&compression, sizeof(compression), 1, fp);
+        fclose(fp);
+
+        pnnx::StoreZipReader szr;
+        ASSERT_EQ(szr.open(path), -1);
+    }
+    remove(path.c_str());
+}
+
+TEST(StoreZipTest, graph_save_load_compressed)
+{
+    const std::string param_path = testing::TempDir() + "/jennifer_store_zip_graph.param";
+    const std::string bin_path = testing::TempDir() + "/jennifer_store_zip_graph.bin";
+
+    pnnx::Graph graph;
+    ASSERT_EQ(graph.parse("7767517\n"
+                          "3 2\n"
+                          "pnnx.Input      in0   0 1 0 #0=(16)f32\n"
+                          "nn.Linear       fc    1 1 0 1 bias=False in_features=16 out_features=64 @weight=(64,16)f32 #0=(16)f32 #1=(64)f32\n"
+                          "pnnx.Output     out0  1 0 1 #1=(64)f32\n"),
+              0);
+    std::vector<char> weights = RandomWeights(64 * 16, 5);
+    graph.ops[1]->attrs["weight"].data = weights;
+    ASSERT_EQ(graph.save(param_path, bin_path, pnnx::STOREZIP_SHUFFLE_DEFLATE), 0);
+
+    pnnx::Graph loaded;
+    ASSERT_EQ(loaded.load(param_path, bin_path), 0);
+    ASSERT_EQ(loaded.ops[1]->attrs["weight"].data, weights);
+    remove(param_path.c_str());
+    remove(bin_path.c_str());
+}
+
+} // namespace jennifer
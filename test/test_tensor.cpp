@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 
 #include "jennifer/data/tensor.hpp"
+#include "jennifer/data/tensor_expression.hpp"
 
 using namespace jennifer::data;
 
@@ -190,4 +191,52 @@ TYPED_TEST(TensorTest, flatten1)
     ASSERT_EQ(f3.index(8), 8);
 }
 
+TYPED_TEST(TensorTest, expression_broadcast)
+{
+    Tensor<TypeParam> a(2, 3, 4);
+    Tensor<TypeParam> b(1, 3, 4);
+    Tensor<TypeParam> c(2, 1, 1);
+    a.RandomUniform(-1, 1);
+    b.RandomUniform(-1, 1);
+    c.RandomUniform(-1, 1);
+
+    // b repeats over the channels, c is one value per channel
+    Tensor<TypeParam> out(2, 3, 4);
+    Assign(out, a * b + c * TypeParam(2) - 1);
+    Tensor<TypeParam> fused = Evaluate(Fma(a, b, -c) / Maximum(c, 0.5));
+    ASSERT_EQ(fused.shape(), std::vector<uint32_t>({2, 3, 4}));
+    for (uint32_t ch = 0; ch < 2; ++ch)
+    {
+        for (uint32_t r = 0; r < 3; ++r)
+        {
+            for (uint32_t col = 0; col < 4; ++col)
+            {
+                const TypeParam x = a.at(ch, r, col);
+                const TypeParam y = b.at(0, r, col);
+                const TypeParam z = c.at(ch, 0, 0);
+                ASSERT_NEAR(out.at(ch, r, col), x * y + z * 2 - 1, 1e-5);
+                ASSERT_NEAR(fused.at(ch, r, col), (x * y - z) / std::max<TypeParam>(z, 0.5), 1e-5);
+            }
+        }
+    }
+}
+
+TYPED_TEST(TensorTest, expression_in_place_parallel)
+{
+    Tensor<TypeParam> a(8, 64, 128);
+    Tensor<TypeParam> b(8, 64, 128);
+    a.RandomNormal();
+    b.RandomNormal();
+    const std::vector<TypeParam> before = a.values();
+    const std::vector<TypeParam> other = b.values();
+
+    // the output may be an operand, every thread writes its own range
+    Assign(a, Minimum(a * a, b) + a, 4);
+    const std::vector<TypeParam> after = a.values();
+    for (size_t i = 0; i < after.size(); ++i)
+    {
+        ASSERT_EQ(after[i], std::min(before[i] * before[i], other[i]) + before[i]);
+    }
+}
+
 } // namespace jennifer
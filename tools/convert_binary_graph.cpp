@@ -0,0 +1,46 @@
+#include <glog/logging.h>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include "jennifer/runtime/binary_graph.hpp"
+
+// Converts a pnnx .param text graph to the binary graph format. Attribute weights
+// stay in the .bin zip, which is used as is with the converted graph.
+
+int main(int argc, char *argv[])
+{
+    google::InitGoogleLogging(argv[0]);
+    if (argc != 3)
+    {
+        fprintf(stderr, "usage: %s model.pnnx.param model.jbg\n", argv[0]);
+        return 1;
+    }
+
+    std::ifstream file(argv[1], std::ios::in | std::ios::binary);
+    if (!file.good())
+    {
+        fprintf(stderr, "can not open %s\n", argv[1]);
+        return 1;
+    }
+    std::stringstream text;
+    text << file.rdbuf();
+
+    pnnx::Graph graph;
+    if (graph.parse(text.str()) != 0)
+    {
+        fprintf(stderr, "can not parse %s\n", argv[1]);
+        return 1;
+    }
+
+    if (!jennifer::runtime::BinaryGraph::Save(graph, argv[2]))
+    {
+        fprintf(stderr, "can not write %s\n", argv[2]);
+        return 1;
+    }
+
+    fprintf(stdout, "%s: %d operators, %d operands\n", argv[2], static_cast<int>(graph.ops.size()),
+            static_cast<int>(graph.operands.size()));
+    return 0;
+}
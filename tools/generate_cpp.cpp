@@ -0,0 +1,42 @@
+#include <glog/logging.h>
+
+#include <cstdio>
+
+#include "jennifer/pass/eliminate.hpp"
+#include "jennifer/pass/fold_constants.hpp"
+#include "jennifer/runtime/pnnx/ir.h"
+
+// Generates a standalone C++ translation unit for a static shape pnnx graph. The
+// graph is constant folded and cleaned up first, the same way RuntimeGraph::Init
+// prepares it, so the generated forward only keeps the operators that compute.
+
+int main(int argc, char *argv[])
+{
+    google::InitGoogleLogging(argv[0]);
+    if (argc != 5)
+    {
+        fprintf(stderr, "usage: %s model.pnnx.param model.pnnx.bin model.cpp model.weights\n", argv[0]);
+        return 1;
+    }
+
+    pnnx::Graph graph;
+    if (graph.load(argv[1], argv[2]) != 0)
+    {
+        fprintf(stderr, "can not load %s %s\n", argv[1], argv[2]);
+        return 1;
+    }
+
+    const int folded = jennifer::pass::FoldConstants(graph);
+    jennifer::pass::EliminationReport report = jennifer::pass::EliminateCommonSubexpressions(graph);
+    report += jennifer::pass::EliminateDeadCode(graph);
+
+    if (graph.cpp(argv[3], argv[4]) != 0)
+    {
+        fprintf(stderr, "can not generate %s\n", argv[3]);
+        return 1;
+    }
+
+    fprintf(stdout, "%s: %d operators, %d folded, %d eliminated\n", argv[3], static_cast<int>(graph.ops.size()), folded,
+            report.removed_operators);
+    return 0;
+}
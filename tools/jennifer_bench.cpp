@@ -0,0 +1,324 @@
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "jennifer/runtime/runtime_graph.hpp"
+#include "jennifer/utils/huge_pages.hpp"
+#include "jennifer/utils/parallel.hpp"
+
+// Latency and throughput of a pnnx model on this machine. Inputs are uniform
+// random tensors shaped like the pnnx.Input operands. Every point of the thread
+// and concurrency sweep runs concurrency clients, each driving a model instance of
+// its own with threads ParallelFor threads, for warmup and then timed iterations.
+//
+//   jennifer_bench --param=model.pnnx.param --bin=model.pnnx.bin --threads=1,2,4 --concurrency=1,2 --csv
+
+DEFINE_string(param, "", "pnnx .param or converted binary graph");
+DEFINE_string(bin, "", "pnnx .bin weights");
+DEFINE_string(input_shapes, "", "shape of every input, e.g. 1,3,224,224;1,16, needed for dynamic dims");
+DEFINE_string(threads, "0", "ParallelFor threads per instance to sweep, 0 for every hardware thread");
+DEFINE_string(concurrency, "1", "clients to sweep, each with a model instance of its own");
+DEFINE_int32(warmup, 5, "untimed iterations per client");
+DEFINE_int32(iterations, 50, "timed iterations per client");
+DEFINE_string(huge_pages, "off", "off, transparent or explicit backing of arenas and weights");
+DEFINE_bool(csv, false, "print comma separated rows");
+
+using namespace jennifer;
+using namespace jennifer::runtime;
+
+using Shape = std::vector<int32_t>;
+
+static std::vector<int32_t> ParseList(const std::string &text, char separator)
+{
+    std::vector<int32_t> values;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, separator))
+    {
+        if (!item.empty())
+        {
+            values.push_back(static_cast<int32_t>(std::strtol(item.c_str(), nullptr, 10)));
+        }
+    }
+    return values;
+}
+
+// the exported shapes of the pnnx.Input operands unless given on the command line
+static bool InputShapes(const RuntimeGraph &graph, std::vector<Shape> &shapes)
+{
+    std::vector<std::string> given;
+    std::stringstream stream(FLAGS_input_shapes);
+    std::string item;
+    while (std::getline(stream, item, ';'))
+    {
+        given.push_back(item);
+    }
+
+    shapes.clear();
+    for (const pnnx::Operator *op : graph.graph().ops)
+    {
+        if (op->type != "pnnx.Input" || op->outputs.empty())
+        {
+            continue;
+        }
+        const size_t index = shapes.size();
+        shapes.push_back(index < given.size() ? ParseList(given[index], ',') : op->outputs[0]->shape);
+        const Shape &shape = shapes.back();
+        if (shape.empty() || std::any_of(shape.begin(), shape.end(), [](int32_t dim) { return dim <= 0; }))
+        {
+            fprintf(stderr, "input %s has a dynamic or empty shape, set it with --input_shapes\n", op->name.c_str());
+            return false;
+        }
+    }
+    if (!given.empty() && given.size() != shapes.size())
+    {
+        fprintf(stderr, "--input_shapes has %d shapes but the model has %d inputs\n", static_cast<int>(given.size()),
+                static_cast<int>(shapes.size()));
+        return false;
+    }
+    return !shapes.empty();
+}
+
+// one tensor per sample like the runtime lays them out, dims beyond three folded
+// into the channels
+static std::shared_ptr<Operand<float>> RandomInput(const std::string &name, const Shape &shape)
+{
+    std::vector<uint32_t> sample(shape.begin() + 1, shape.end());
+    while (sample.size() > 3)
+    {
+        sample[1] *= sample[0];
+        sample.erase(sample.begin());
+    }
+    if (sample.empty())
+    {
+        sample.push_back(1);
+    }
+
+    auto operand = std::make_shared<Operand<float>>(name, shape, shape[0], AttributeType::Float32);
+    for (int32_t b = 0; b < shape[0]; ++b)
+    {
+        operand->data[b] = std::make_shared<data::Tensor<float>>(sample);
+        operand->data[b]->RandomUniform(-1.f, 1.f);
+    }
+    return operand;
+}
+
+struct Point
+{
+    int threads = 0;
+    int concurrency = 0;
+    double p50 = 0, p90 = 0, p99 = 0, max = 0;
+    double requests_per_second = 0;
+    double samples_per_second = 0;
+    int failures = 0;
+}; // struct Point
+
+static double Percentile(const std::vector<double> &sorted, double fraction)
+{
+    const size_t rank = static_cast<size_t>(fraction * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(rank, sorted.size() - 1)];
+}
+
+static Point Measure(std::vector<std::unique_ptr<RuntimeGraph>> &instances, const std::vector<Shape> &shapes,
+                     int threads, int concurrency)
+{
+    Point point;
+    point.threads = threads;
+    point.concurrency = concurrency;
+
+    std::vector<std::vector<double>> latencies(concurrency);
+    std::atomic<int> failures{0};
+
+    // the clock starts once every client has warmed up
+    std::mutex mutex;
+    std::condition_variable cv;
+    int ready = 0;
+    bool go = false;
+    std::chrono::steady_clock::time_point start;
+
+    std::vector<std::thread> clients;
+    for (int c = 0; c < concurrency; ++c)
+    {
+        clients.emplace_back([&, c]() {
+            utils::DefaultThreads() = threads;
+            RuntimeGraph &graph = *instances[c];
+            std::vector<std::shared_ptr<Operand<float>>> inputs;
+            for (size_t i = 0; i < shapes.size(); ++i)
+            {
+                inputs.push_back(RandomInput("in" + std::to_string(i), shapes[i]));
+            }
+            std::vector<std::shared_ptr<Operand<float>>> outputs;
+            for (int i = 0; i < FLAGS_warmup; ++i)
+            {
+                graph.Forward(inputs, outputs);
+            }
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                ready += 1;
+                if (ready == concurrency)
+                {
+                    start = std::chrono::steady_clock::now();
+                    go = true;
+                    cv.notify_all();
+                }
+                cv.wait(lock, [&] { return go; });
+            }
+
+            latencies[c].reserve(FLAGS_iterations);
+            for (int i = 0; i < FLAGS_iterations; ++i)
+            {
+                const auto begin = std::chrono::steady_clock::now();
+                if (graph.Forward(inputs, outputs) != utils::StatusCode::Success)
+                {
+                    failures += 1;
+                }
+                latencies[c].push_back(
+                    std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count());
+            }
+        });
+    }
+    for (std::thread &client : clients)
+    {
+        client.join();
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<double> all;
+    for (const std::vector<double> &client : latencies)
+    {
+        all.insert(all.end(), client.begin(), client.end());
+    }
+    std::sort(all.begin(), all.end());
+    if (!all.empty())
+    {
+        point.p50 = Percentile(all, 0.50);
+        point.p90 = Percentile(all, 0.90);
+        point.p99 = Percentile(all, 0.99);
+        point.max = all.back();
+    }
+    point.requests_per_second = all.size() / seconds;
+    point.samples_per_second = point.requests_per_second * shapes[0][0];
+    point.failures = failures;
+    return point;
+}
+
+int main(int argc, char *argv[])
+{
+    gflags::SetUsageMessage("jennifer_bench --param=model.pnnx.param --bin=model.pnnx.bin [--threads=1,2,4] "
+                            "[--concurrency=1,2] [--input_shapes=1,3,224,224]");
+    gflags::ParseCommandLineFlags(&argc, &argv, true);
+    google::InitGoogleLogging(argv[0]);
+
+    if (FLAGS_param.empty() || FLAGS_bin.empty())
+    {
+        fprintf(stderr, "usage: %s --param=model.pnnx.param --bin=model.pnnx.bin\n", argv[0]);
+        return 1;
+    }
+    if (FLAGS_huge_pages == "transparent")
+    {
+        utils::SetHugePageMode(utils::HugePageMode::Transparent);
+    }
+    else if (FLAGS_huge_pages == "explicit")
+    {
+        utils::SetHugePageMode(utils::HugePageMode::Explicit);
+    }
+    else if (FLAGS_huge_pages != "off")
+    {
+        fprintf(stderr, "unknown --huge_pages mode %s\n", FLAGS_huge_pages.c_str());
+        return 1;
+    }
+
+    const std::vector<int32_t> thread_sweep = ParseList(FLAGS_threads, ',');
+    const std::vector<int32_t> concurrency_sweep = ParseList(FLAGS_concurrency, ',');
+    if (thread_sweep.empty() || *std::min_element(thread_sweep.begin(), thread_sweep.end()) < 0)
+    {
+        fprintf(stderr, "--threads needs values of 0 or more\n");
+        return 1;
+    }
+    if (concurrency_sweep.empty() || FLAGS_iterations <= 0
+        || *std::min_element(concurrency_sweep.begin(), concurrency_sweep.end()) <= 0)
+    {
+        fprintf(stderr, "--concurrency and --iterations need positive values\n");
+        return 1;
+    }
+
+    // an instance per concurrent client, loaded once for the whole sweep
+    std::vector<std::unique_ptr<RuntimeGraph>> instances;
+    const int max_concurrency = *std::max_element(concurrency_sweep.begin(), concurrency_sweep.end());
+    const auto load_start = std::chrono::steady_clock::now();
+    for (int i = 0; i < max_concurrency; ++i)
+    {
+        instances.emplace_back(new RuntimeGraph(FLAGS_param, FLAGS_bin));
+        if (!instances.back()->Init())
+        {
+            fprintf(stderr, "can not load %s %s\n", FLAGS_param.c_str(), FLAGS_bin.c_str());
+            return 1;
+        }
+    }
+    const double load_ms =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - load_start).count() /
+        max_concurrency;
+
+    std::vector<Shape> shapes;
+    if (!InputShapes(*instances[0], shapes))
+    {
+        return 1;
+    }
+
+    std::string shape_text;
+    for (const Shape &shape : shapes)
+    {
+        shape_text += shape_text.empty() ? "" : ";";
+        for (size_t i = 0; i < shape.size(); ++i)
+        {
+            shape_text += (i == 0 ? "" : ",") + std::to_string(shape[i]);
+        }
+    }
+
+    if (FLAGS_csv)
+    {
+        fprintf(stdout, "threads,concurrency,p50_ms,p90_ms,p99_ms,max_ms,requests_per_s,samples_per_s,failures\n");
+    }
+    else
+    {
+        fprintf(stdout, "model %s, %d operators, loaded in %.1f ms\n", FLAGS_param.c_str(),
+                static_cast<int>(instances[0]->graph().ops.size()), load_ms);
+        fprintf(stdout, "inputs %s, %d warmup and %d timed iterations per client, %d hardware threads\n",
+                shape_text.c_str(), FLAGS_warmup, FLAGS_iterations,
+                static_cast<int>(std::thread::hardware_concurrency()));
+        fprintf(stdout, "%8s %12s %10s %10s %10s %10s %12s %12s %9s\n", "threads", "concurrency", "p50 ms", "p90 ms",
+                "p99 ms", "max ms", "requests/s", "samples/s", "failures");
+    }
+
+    int failures = 0;
+    for (int32_t threads : thread_sweep)
+    {
+        for (int32_t concurrency : concurrency_sweep)
+        {
+            const Point point = Measure(instances, shapes, threads, concurrency);
+            failures += point.failures;
+            const char *format = FLAGS_csv ? "%d,%d,%.3f,%.3f,%.3f,%.3f,%.2f,%.2f,%d\n"
+                                           : "%8d %12d %10.3f %10.3f %10.3f %10.3f %12.2f %12.2f %9d\n";
+            fprintf(stdout, format, utils::ResolveThreads(point.threads), point.concurrency, point.p50, point.p90,
+                    point.p99, point.max, point.requests_per_second, point.samples_per_second, point.failures);
+        }
+    }
+    if (failures != 0)
+    {
+        fprintf(stderr, "%d iterations failed\n", failures);
+        return 1;
+    }
+    return 0;
+}